@@ -184,6 +184,9 @@ DecodeBuffer::DecodeBuffer()
 	readBuffer = 0;
 	m_channels = destinationBufferSize = readBufferSize = 0;
 	m_bufferSizeCheckCounter = m_totalCheckSize = m_smallerReadCounter = 0;
+	m_ownDestination = 0;
+	m_ownDestinationSize = m_ownChannels = 0;
+	m_destinationBorrowed = false;
 }
 
 
@@ -205,7 +208,10 @@ void DecodeBuffer::check_buffers_capacity(uint size, uint channels)
 	}*/
 	
 		
-	if (destinationBufferSize < size || m_channels < channels) {
+	if (m_destinationBorrowed) {
+		// the caller of use_destination() has to provide enough room
+		Q_ASSERT(destinationBufferSize >= size && m_channels >= channels);
+	} else if (destinationBufferSize < size || m_channels < channels) {
 		
 		delete_destination_buffers();
 
@@ -230,6 +236,38 @@ void DecodeBuffer::check_buffers_capacity(uint size, uint channels)
 	}
 }
 
+/**
+ * 	Makes the readers decode into \a buffers (e.g. the write space of the
+ *	ring buffers of a ReadSource) instead of into the destination buffers
+ *	of this DecodeBuffer, till release_destination() is called.
+ *	\a buffers has to hold \a size frames for each of \a channels.
+ */
+void DecodeBuffer::use_destination(audio_sample_t** buffers, uint size, uint channels)
+{
+	Q_ASSERT(!m_destinationBorrowed);
+	
+	m_ownDestination = destination;
+	m_ownDestinationSize = destinationBufferSize;
+	m_ownChannels = m_channels;
+	
+	destination = buffers;
+	destinationBufferSize = size;
+	m_channels = channels;
+	m_destinationBorrowed = true;
+}
+
+void DecodeBuffer::release_destination()
+{
+	if (!m_destinationBorrowed) {
+		return;
+	}
+	
+	destination = m_ownDestination;
+	destinationBufferSize = m_ownDestinationSize;
+	m_channels = m_ownChannels;
+	m_destinationBorrowed = false;
+}
+
 void DecodeBuffer::delete_destination_buffers()
 {
 	if (destination) {
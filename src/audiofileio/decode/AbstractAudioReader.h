@@ -31,11 +31,14 @@ class DecodeBuffer {
 public:
 	DecodeBuffer();
 	~DecodeBuffer() {
+		release_destination();
 		delete_destination_buffers();
 		delete_readbuffer();
 	}
 	
 	void check_buffers_capacity(uint size, uint channels);
+	void use_destination(audio_sample_t** buffers, uint size, uint channels);
+	void release_destination();
 	
 	audio_sample_t** destination;
 	audio_sample_t* readBuffer;
@@ -48,6 +51,12 @@ private:
 	quint64 m_totalCheckSize;
 	uint m_bufferSizeCheckCounter;
 	
+	// our own destination buffers while use_destination() is in effect
+	audio_sample_t** m_ownDestination;
+	uint m_ownDestinationSize;
+	uint m_ownChannels;
+	bool m_destinationBorrowed;
+	
 	void delete_destination_buffers();
 	void delete_readbuffer();
 	void delete_resample_buffers();
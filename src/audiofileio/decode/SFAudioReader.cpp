@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QString>
 
 #include "Utils.h"
+#include "Mixer.h"
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
 #include "Debugger.h"
@@ -123,24 +124,7 @@ nframes_t SFAudioReader::read_private(DecodeBuffer* buffer, nframes_t frameCount
 	int framesRead = sf_readf_float(m_sf, buffer->readBuffer, frameCount);
 	
 	// De-interlace
-	switch (m_channels) {
-		case 1:
-			memcpy(buffer->destination[0], buffer->readBuffer, framesRead * sizeof(audio_sample_t));
-			break;	
-		case 2:
-			for (int f = 0; f < framesRead; f++) {
-				int pos = f*2;
-				buffer->destination[0][f] = buffer->readBuffer[pos];
-				buffer->destination[1][f] = buffer->readBuffer[pos + 1];
-			}
-			break;	
-		default:
-			for (int f = 0; f < framesRead; f++) {
-				for (int c = 0; c < m_channels; c++) {
-					buffer->destination[c][f] = buffer->readBuffer[f * m_channels + c];
-				}
-			}
-	}
+	Mixer::deinterleave(buffer->destination, buffer->readBuffer, m_channels, framesRead);
 	
 	return framesRead;
 }
@@ -235,7 +235,7 @@ int AddRemove::do_action()
 	}
 	
 	if (m_instantanious) {
-		tsar().process_event_slot_signal(m_doActionEvent);
+		process_event(m_doActionEvent);
 		return 1;
 	}
 	
@@ -244,7 +244,7 @@ int AddRemove::do_action()
 			PMESG("Using Thread Save add/remove");
 			tsar().add_event(m_doActionEvent);
 		} else {
-			tsar().process_event_slot_signal(m_doActionEvent);
+			process_event(m_doActionEvent);
 		}
 	} else {
 		tsar().add_event(m_doActionEvent);
@@ -263,7 +263,7 @@ int AddRemove::undo_action()
 	}
 	
 	if (m_instantanious) {
-		tsar().process_event_slot_signal(m_undoActionEvent);
+		process_event(m_undoActionEvent);
 		return 1;
 	}
 	
@@ -272,7 +272,7 @@ int AddRemove::undo_action()
 			PMESG("Using Thread Save add/remove");
 			tsar().add_event(m_undoActionEvent);
 		} else {
-			tsar().process_event_slot_signal(m_undoActionEvent);
+			process_event(m_undoActionEvent);
 		}
 	} else {
 		PMESG("Using direct add/remove/signaling");
@@ -282,11 +282,28 @@ int AddRemove::undo_action()
 	return 1;
 }
 
+/**
+ * 	Calls the slot and emits the signal of \a event directly, unless
+	events added to Tsar earlier are still waiting to be processed, these
+	must not be overtaken, so then \a event is queued behind them.
+ */
+void AddRemove::process_event(TsarEvent& event)
+{
+	if (tsar().has_pending_events()) {
+		PMESG("Tsar events pending, using Thread Save add/remove");
+		tsar().add_event(event);
+		return;
+	}
+	
+	tsar().process_event_slot_signal(event);
+}
+
 /**
  * 	Set's the command as instantanious
  
 	The do/undo actions will call the slot and emit the signal (if they exist) 
  	directly, and thus bypassing the RT thread save nature of Tsar.
+	Events that were added to Tsar before are still processed first.
  */
 void AddRemove::set_instantanious(bool instant)
 {
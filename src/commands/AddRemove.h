@@ -73,6 +73,8 @@ private :
 	const char*	m_doSignal;
 	const char*	m_undoSignal;
 	bool		m_instantanious;
+
+	void process_event(TsarEvent& event);
 };
 
 #endif
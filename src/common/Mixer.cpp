@@ -23,11 +23,18 @@
 #include "Mixer.h"
 #include "defines.h"
 #include <cmath> // used for fabs
+#include <cstring>
 
 Mixer::compute_peak_t			Mixer::compute_peak 		= 0;
 Mixer::apply_gain_to_buffer_t		Mixer::apply_gain_to_buffer 	= 0;
 Mixer::mix_buffers_with_gain_t		Mixer::mix_buffers_with_gain 	= 0;
 Mixer::mix_buffers_no_gain_t		Mixer::mix_buffers_no_gain 	= 0;
+Mixer::compute_stereo_correlation_t	Mixer::compute_stereo_correlation = 0;
+Mixer::mix_buffers_with_gain_ramp_t	Mixer::mix_buffers_with_gain_ramp = 0;
+Mixer::pan_and_mix_stereo_t		Mixer::pan_and_mix_stereo 	= 0;
+Mixer::apply_gain_ramp_to_buffer_t	Mixer::apply_gain_ramp_to_buffer = 0;
+Mixer::interleave_t			Mixer::interleave		= 0;
+Mixer::deinterleave_t			Mixer::deinterleave		= 0;
 
 
 
@@ -60,6 +67,573 @@ void default_mix_buffers_no_gain (audio_sample_t* dst, const audio_sample_t* src
         }
 }
 
+void default_compute_stereo_correlation (const audio_sample_t* left, const audio_sample_t* right, nframes_t nframes, float* lr, float* ll, float* rr)
+{
+        float a1a2 = 0.0f, a1sq = 0.0f, a2sq = 0.0f;
+
+        for (nframes_t i = 0; i < nframes; i++) {
+                a1a2 += left[i] * right[i];
+                a1sq += left[i] * left[i];
+                a2sq += right[i] * right[i];
+        }
+
+        *lr = a1a2;
+        *ll = a1sq;
+        *rr = a2sq;
+}
+
+void default_mix_buffers_with_gain_ramp (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+
+        for (nframes_t i = 0; i < nframes; i++) {
+                dst[i] += src[i] * (startGain + float(i) * step);
+        }
+}
+
+void default_pan_and_mix_stereo (audio_sample_t* dstL, audio_sample_t* dstR, const audio_sample_t* srcL, const audio_sample_t* srcR, nframes_t nframes, float gainLeft, float gainRight)
+{
+        for (nframes_t i = 0; i < nframes; i++) {
+                dstL[i] += srcL[i] * gainLeft;
+                dstR[i] += srcR[i] * gainRight;
+        }
+}
+
+void default_apply_gain_ramp_to_buffer (audio_sample_t* buf, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+
+        for (nframes_t i = 0; i < nframes; i++) {
+                buf[i] *= (startGain + float(i) * step);
+        }
+}
+
+void default_interleave (audio_sample_t* dst, audio_sample_t* const* src, int channels, nframes_t nframes)
+{
+        if (channels == 1) {
+                memcpy(dst, src[0], nframes * sizeof(audio_sample_t));
+                return;
+        }
+
+        for (int c = 0; c < channels; c++) {
+                const audio_sample_t* s = src[c];
+                for (nframes_t f = 0; f < nframes; f++) {
+                        dst[f * channels + c] = s[f];
+                }
+        }
+}
+
+void default_deinterleave (audio_sample_t* const* dst, const audio_sample_t* src, int channels, nframes_t nframes)
+{
+        if (channels == 1) {
+                memcpy(dst[0], src, nframes * sizeof(audio_sample_t));
+                return;
+        }
+
+        for (int c = 0; c < channels; c++) {
+                audio_sample_t* d = dst[c];
+                for (nframes_t f = 0; f < nframes; f++) {
+                        d[f] = src[f * channels + c];
+                }
+        }
+}
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+#include <immintrin.h>
+
+static inline float x86_sse_horizontal_sum(__m128 v)
+{
+        __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuf);
+        shuf = _mm_movehl_ps(shuf, sums);
+        sums = _mm_add_ss(sums, shuf);
+        return _mm_cvtss_f32(sums);
+}
+
+void x86_sse_compute_stereo_correlation (const audio_sample_t* left, const audio_sample_t* right, nframes_t nframes, float* lr, float* ll, float* rr)
+{
+        __m128 vlr = _mm_setzero_ps();
+        __m128 vll = _mm_setzero_ps();
+        __m128 vrr = _mm_setzero_ps();
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                __m128 l = _mm_loadu_ps(left + i);
+                __m128 r = _mm_loadu_ps(right + i);
+                vlr = _mm_add_ps(vlr, _mm_mul_ps(l, r));
+                vll = _mm_add_ps(vll, _mm_mul_ps(l, l));
+                vrr = _mm_add_ps(vrr, _mm_mul_ps(r, r));
+        }
+
+        float a1a2 = x86_sse_horizontal_sum(vlr);
+        float a1sq = x86_sse_horizontal_sum(vll);
+        float a2sq = x86_sse_horizontal_sum(vrr);
+
+        for (; i < nframes; i++) {
+                a1a2 += left[i] * right[i];
+                a1sq += left[i] * left[i];
+                a2sq += right[i] * right[i];
+        }
+
+        *lr = a1a2;
+        *ll = a1sq;
+        *rr = a2sq;
+}
+
+__attribute__((target("avx")))
+void x86_avx_compute_stereo_correlation (const audio_sample_t* left, const audio_sample_t* right, nframes_t nframes, float* lr, float* ll, float* rr)
+{
+        __m256 vlr = _mm256_setzero_ps();
+        __m256 vll = _mm256_setzero_ps();
+        __m256 vrr = _mm256_setzero_ps();
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                __m256 l = _mm256_loadu_ps(left + i);
+                __m256 r = _mm256_loadu_ps(right + i);
+                vlr = _mm256_add_ps(vlr, _mm256_mul_ps(l, r));
+                vll = _mm256_add_ps(vll, _mm256_mul_ps(l, l));
+                vrr = _mm256_add_ps(vrr, _mm256_mul_ps(r, r));
+        }
+
+        float a1a2 = x86_sse_horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(vlr), _mm256_extractf128_ps(vlr, 1)));
+        float a1sq = x86_sse_horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(vll), _mm256_extractf128_ps(vll, 1)));
+        float a2sq = x86_sse_horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(vrr), _mm256_extractf128_ps(vrr, 1)));
+
+        for (; i < nframes; i++) {
+                a1a2 += left[i] * right[i];
+                a1sq += left[i] * left[i];
+                a2sq += right[i] * right[i];
+        }
+
+        *lr = a1a2;
+        *ll = a1sq;
+        *rr = a2sq;
+}
+
+
+/* SSE fused functions, the basic SSE set lives in sse_functions.S */
+
+void x86_sse_mix_buffers_with_gain_ramp (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+        __m128 vstart = _mm_set1_ps(startGain);
+        __m128 vstep = _mm_set1_ps(step);
+        __m128 vindex = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        __m128 vfour = _mm_set1_ps(4.0f);
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                __m128 gain = _mm_add_ps(vstart, _mm_mul_ps(vindex, vstep));
+                __m128 d = _mm_loadu_ps(dst + i);
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(src + i), gain));
+                _mm_storeu_ps(dst + i, d);
+                vindex = _mm_add_ps(vindex, vfour);
+        }
+
+        for (; i < nframes; i++) {
+                dst[i] += src[i] * (startGain + float(i) * step);
+        }
+}
+
+void x86_sse_pan_and_mix_stereo (audio_sample_t* dstL, audio_sample_t* dstR, const audio_sample_t* srcL, const audio_sample_t* srcR, nframes_t nframes, float gainLeft, float gainRight)
+{
+        __m128 gl = _mm_set1_ps(gainLeft);
+        __m128 gr = _mm_set1_ps(gainRight);
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                _mm_storeu_ps(dstL + i, _mm_add_ps(_mm_loadu_ps(dstL + i), _mm_mul_ps(_mm_loadu_ps(srcL + i), gl)));
+                _mm_storeu_ps(dstR + i, _mm_add_ps(_mm_loadu_ps(dstR + i), _mm_mul_ps(_mm_loadu_ps(srcR + i), gr)));
+        }
+
+        for (; i < nframes; i++) {
+                dstL[i] += srcL[i] * gainLeft;
+                dstR[i] += srcR[i] * gainRight;
+        }
+}
+
+void x86_sse_apply_gain_ramp_to_buffer (audio_sample_t* buf, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+        __m128 vstart = _mm_set1_ps(startGain);
+        __m128 vstep = _mm_set1_ps(step);
+        __m128 vindex = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        __m128 vfour = _mm_set1_ps(4.0f);
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                __m128 gain = _mm_add_ps(vstart, _mm_mul_ps(vindex, vstep));
+                _mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(buf + i), gain));
+                vindex = _mm_add_ps(vindex, vfour);
+        }
+
+        for (; i < nframes; i++) {
+                buf[i] *= (startGain + float(i) * step);
+        }
+}
+
+/* Stereo is (de)interleaved with unpack/shuffle, other channel counts in
+ * groups of 4 channels by transposing 4 frames x 4 channels blocks, the
+ * channels left over are copied one by one. */
+
+void x86_sse_interleave (audio_sample_t* dst, audio_sample_t* const* src, int channels, nframes_t nframes)
+{
+        if (channels == 1) {
+                memcpy(dst, src[0], nframes * sizeof(audio_sample_t));
+                return;
+        }
+
+        if (channels == 2) {
+                const audio_sample_t* l = src[0];
+                const audio_sample_t* r = src[1];
+                nframes_t f = 0;
+
+                for (; f + 4 <= nframes; f += 4) {
+                        __m128 vl = _mm_loadu_ps(l + f);
+                        __m128 vr = _mm_loadu_ps(r + f);
+                        _mm_storeu_ps(dst + 2 * f, _mm_unpacklo_ps(vl, vr));
+                        _mm_storeu_ps(dst + 2 * f + 4, _mm_unpackhi_ps(vl, vr));
+                }
+
+                for (; f < nframes; f++) {
+                        dst[2 * f] = l[f];
+                        dst[2 * f + 1] = r[f];
+                }
+                return;
+        }
+
+        int c = 0;
+
+        for (; c + 4 <= channels; c += 4) {
+                const audio_sample_t* s0 = src[c];
+                const audio_sample_t* s1 = src[c + 1];
+                const audio_sample_t* s2 = src[c + 2];
+                const audio_sample_t* s3 = src[c + 3];
+                audio_sample_t* d = dst + c;
+                nframes_t f = 0;
+
+                for (; f + 4 <= nframes; f += 4) {
+                        __m128 r0 = _mm_loadu_ps(s0 + f);
+                        __m128 r1 = _mm_loadu_ps(s1 + f);
+                        __m128 r2 = _mm_loadu_ps(s2 + f);
+                        __m128 r3 = _mm_loadu_ps(s3 + f);
+                        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                        _mm_storeu_ps(d + f * channels, r0);
+                        _mm_storeu_ps(d + (f + 1) * channels, r1);
+                        _mm_storeu_ps(d + (f + 2) * channels, r2);
+                        _mm_storeu_ps(d + (f + 3) * channels, r3);
+                }
+
+                for (; f < nframes; f++) {
+                        d[f * channels] = s0[f];
+                        d[f * channels + 1] = s1[f];
+                        d[f * channels + 2] = s2[f];
+                        d[f * channels + 3] = s3[f];
+                }
+        }
+
+        for (; c < channels; c++) {
+                const audio_sample_t* s = src[c];
+                for (nframes_t f = 0; f < nframes; f++) {
+                        dst[f * channels + c] = s[f];
+                }
+        }
+}
+
+void x86_sse_deinterleave (audio_sample_t* const* dst, const audio_sample_t* src, int channels, nframes_t nframes)
+{
+        if (channels == 1) {
+                memcpy(dst[0], src, nframes * sizeof(audio_sample_t));
+                return;
+        }
+
+        if (channels == 2) {
+                audio_sample_t* l = dst[0];
+                audio_sample_t* r = dst[1];
+                nframes_t f = 0;
+
+                for (; f + 4 <= nframes; f += 4) {
+                        __m128 a = _mm_loadu_ps(src + 2 * f);
+                        __m128 b = _mm_loadu_ps(src + 2 * f + 4);
+                        _mm_storeu_ps(l + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                        _mm_storeu_ps(r + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                }
+
+                for (; f < nframes; f++) {
+                        l[f] = src[2 * f];
+                        r[f] = src[2 * f + 1];
+                }
+                return;
+        }
+
+        int c = 0;
+
+        for (; c + 4 <= channels; c += 4) {
+                audio_sample_t* d0 = dst[c];
+                audio_sample_t* d1 = dst[c + 1];
+                audio_sample_t* d2 = dst[c + 2];
+                audio_sample_t* d3 = dst[c + 3];
+                const audio_sample_t* s = src + c;
+                nframes_t f = 0;
+
+                for (; f + 4 <= nframes; f += 4) {
+                        __m128 r0 = _mm_loadu_ps(s + f * channels);
+                        __m128 r1 = _mm_loadu_ps(s + (f + 1) * channels);
+                        __m128 r2 = _mm_loadu_ps(s + (f + 2) * channels);
+                        __m128 r3 = _mm_loadu_ps(s + (f + 3) * channels);
+                        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                        _mm_storeu_ps(d0 + f, r0);
+                        _mm_storeu_ps(d1 + f, r1);
+                        _mm_storeu_ps(d2 + f, r2);
+                        _mm_storeu_ps(d3 + f, r3);
+                }
+
+                for (; f < nframes; f++) {
+                        d0[f] = s[f * channels];
+                        d1[f] = s[f * channels + 1];
+                        d2[f] = s[f * channels + 2];
+                        d3[f] = s[f * channels + 3];
+                }
+        }
+
+        for (; c < channels; c++) {
+                audio_sample_t* d = dst[c];
+                for (nframes_t f = 0; f < nframes; f++) {
+                        d[f] = src[f * channels + c];
+                }
+        }
+}
+
+/* AVX functions */
+
+__attribute__((target("avx")))
+float x86_avx_compute_peak (const audio_sample_t* buf, nframes_t nsamples, float current)
+{
+        const __m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        __m256 vmax = _mm256_set1_ps(current);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nsamples; i += 8) {
+                vmax = _mm256_max_ps(vmax, _mm256_and_ps(_mm256_loadu_ps(buf + i), absmask));
+        }
+
+        __m128 m = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+        current = _mm_cvtss_f32(m);
+
+        for (; i < nsamples; i++) {
+                current = f_max(current, fabsf(buf[i]));
+        }
+
+        return current;
+}
+
+__attribute__((target("avx")))
+void x86_avx_apply_gain_to_buffer (audio_sample_t* buf, nframes_t nframes, float gain)
+{
+        __m256 g = _mm256_set1_ps(gain);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                _mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(buf + i), g));
+        }
+
+        for (; i < nframes; i++) {
+                buf[i] *= gain;
+        }
+}
+
+__attribute__((target("avx")))
+void x86_avx_mix_buffers_with_gain (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float gain)
+{
+        __m256 g = _mm256_set1_ps(gain);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                __m256 d = _mm256_loadu_ps(dst + i);
+                _mm256_storeu_ps(dst + i, _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+        }
+
+        for (; i < nframes; i++) {
+                dst[i] += src[i] * gain;
+        }
+}
+
+__attribute__((target("avx")))
+void x86_avx_mix_buffers_no_gain (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes)
+{
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+        }
+
+        for (; i < nframes; i++) {
+                dst[i] += src[i];
+        }
+}
+
+__attribute__((target("avx")))
+void x86_avx_mix_buffers_with_gain_ramp (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+        __m256 vstart = _mm256_set1_ps(startGain);
+        __m256 vstep = _mm256_set1_ps(step);
+        __m256 vindex = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        __m256 veight = _mm256_set1_ps(8.0f);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                __m256 gain = _mm256_add_ps(vstart, _mm256_mul_ps(vindex, vstep));
+                __m256 d = _mm256_loadu_ps(dst + i);
+                _mm256_storeu_ps(dst + i, _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(src + i), gain)));
+                vindex = _mm256_add_ps(vindex, veight);
+        }
+
+        for (; i < nframes; i++) {
+                dst[i] += src[i] * (startGain + float(i) * step);
+        }
+}
+
+__attribute__((target("avx")))
+void x86_avx_pan_and_mix_stereo (audio_sample_t* dstL, audio_sample_t* dstR, const audio_sample_t* srcL, const audio_sample_t* srcR, nframes_t nframes, float gainLeft, float gainRight)
+{
+        __m256 gl = _mm256_set1_ps(gainLeft);
+        __m256 gr = _mm256_set1_ps(gainRight);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                _mm256_storeu_ps(dstL + i, _mm256_add_ps(_mm256_loadu_ps(dstL + i), _mm256_mul_ps(_mm256_loadu_ps(srcL + i), gl)));
+                _mm256_storeu_ps(dstR + i, _mm256_add_ps(_mm256_loadu_ps(dstR + i), _mm256_mul_ps(_mm256_loadu_ps(srcR + i), gr)));
+        }
+
+        for (; i < nframes; i++) {
+                dstL[i] += srcL[i] * gainLeft;
+                dstR[i] += srcR[i] * gainRight;
+        }
+}
+
+__attribute__((target("avx")))
+void x86_avx_apply_gain_ramp_to_buffer (audio_sample_t* buf, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+        __m256 vstart = _mm256_set1_ps(startGain);
+        __m256 vstep = _mm256_set1_ps(step);
+        __m256 vindex = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        __m256 veight = _mm256_set1_ps(8.0f);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                __m256 gain = _mm256_add_ps(vstart, _mm256_mul_ps(vindex, vstep));
+                _mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(buf + i), gain));
+                vindex = _mm256_add_ps(vindex, veight);
+        }
+
+        for (; i < nframes; i++) {
+                buf[i] *= (startGain + float(i) * step);
+        }
+}
+
+
+/* AVX (de)interleave, only stereo is done 8 frames at a time, the other
+ * channel counts don't gain over the SSE transposes. */
+
+__attribute__((target("avx")))
+void x86_avx_interleave (audio_sample_t* dst, audio_sample_t* const* src, int channels, nframes_t nframes)
+{
+        if (channels != 2) {
+                x86_sse_interleave(dst, src, channels, nframes);
+                return;
+        }
+
+        const audio_sample_t* l = src[0];
+        const audio_sample_t* r = src[1];
+        nframes_t f = 0;
+
+        for (; f + 8 <= nframes; f += 8) {
+                __m256 vl = _mm256_loadu_ps(l + f);
+                __m256 vr = _mm256_loadu_ps(r + f);
+                // l0 r0 l1 r1 | l4 r4 l5 r5 and l2 r2 l3 r3 | l6 r6 l7 r7
+                __m256 lo = _mm256_unpacklo_ps(vl, vr);
+                __m256 hi = _mm256_unpackhi_ps(vl, vr);
+                _mm256_storeu_ps(dst + 2 * f, _mm256_permute2f128_ps(lo, hi, 0x20));
+                _mm256_storeu_ps(dst + 2 * f + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+        }
+
+        for (; f < nframes; f++) {
+                dst[2 * f] = l[f];
+                dst[2 * f + 1] = r[f];
+        }
+}
+
+__attribute__((target("avx")))
+void x86_avx_deinterleave (audio_sample_t* const* dst, const audio_sample_t* src, int channels, nframes_t nframes)
+{
+        if (channels != 2) {
+                x86_sse_deinterleave(dst, src, channels, nframes);
+                return;
+        }
+
+        audio_sample_t* l = dst[0];
+        audio_sample_t* r = dst[1];
+        nframes_t f = 0;
+
+        for (; f + 8 <= nframes; f += 8) {
+                __m256 a = _mm256_loadu_ps(src + 2 * f);
+                __m256 b = _mm256_loadu_ps(src + 2 * f + 8);
+                // l0 r0 l1 r1 | l4 r4 l5 r5 and l2 r2 l3 r3 | l6 r6 l7 r7
+                __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+                __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+                _mm256_storeu_ps(l + f, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm256_storeu_ps(r + f, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+
+        for (; f < nframes; f++) {
+                l[f] = src[2 * f];
+                r[f] = src[2 * f + 1];
+        }
+}
+
+
+/* AVX2 + FMA functions, only the ones that benefit from fused multiply-add */
+
+__attribute__((target("avx2,fma")))
+void x86_fma_mix_buffers_with_gain (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float gain)
+{
+        __m256 g = _mm256_set1_ps(gain);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_loadu_ps(src + i), g, _mm256_loadu_ps(dst + i)));
+        }
+
+        for (; i < nframes; i++) {
+                dst[i] += src[i] * gain;
+        }
+}
+
+__attribute__((target("avx2,fma")))
+void x86_fma_pan_and_mix_stereo (audio_sample_t* dstL, audio_sample_t* dstR, const audio_sample_t* srcL, const audio_sample_t* srcR, nframes_t nframes, float gainLeft, float gainRight)
+{
+        __m256 gl = _mm256_set1_ps(gainLeft);
+        __m256 gr = _mm256_set1_ps(gainRight);
+        nframes_t i = 0;
+
+        for (; i + 8 <= nframes; i += 8) {
+                _mm256_storeu_ps(dstL + i, _mm256_fmadd_ps(_mm256_loadu_ps(srcL + i), gl, _mm256_loadu_ps(dstL + i)));
+                _mm256_storeu_ps(dstR + i, _mm256_fmadd_ps(_mm256_loadu_ps(srcR + i), gr, _mm256_loadu_ps(dstR + i)));
+        }
+
+        for (; i < nframes; i++) {
+                dstL[i] += srcL[i] * gainLeft;
+                dstR[i] += srcR[i] * gainRight;
+        }
+}
+
+#endif
+
 
 #if defined (__APPLE__) && defined (BUILD_VECLIB_OPTIMIZATIONS)
 #include <Accelerate/Accelerate.h>
@@ -94,4 +668,11 @@ void veclib_mix_buffers_no_gain (audio_sample_t * dst, const audio_sample_t * sr
 	vDSP_vsma(src, 1, &gain, dst, 1, dst, 1, nframes);
 }
 
+void veclib_compute_stereo_correlation (const audio_sample_t* left, const audio_sample_t* right, nframes_t nframes, float* lr, float* ll, float* rr)
+{
+	vDSP_dotpr(left, 1, right, 1, lr, nframes);
+	vDSP_svesq(const_cast<audio_sample_t*>(left), 1, ll, nframes);
+	vDSP_svesq(const_cast<audio_sample_t*>(right), 1, rr, nframes);
+}
+
 #endif
@@ -64,6 +64,12 @@ float default_compute_peak			(const audio_sample_t*  buf, nframes_t nsamples, fl
 void  default_apply_gain_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float gain);
 void  default_mix_buffers_with_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float gain);
 void  default_mix_buffers_no_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes);
+void  default_compute_stereo_correlation	(const audio_sample_t*  left, const audio_sample_t*  right, nframes_t nframes, float* lr, float* ll, float* rr);
+void  default_mix_buffers_with_gain_ramp	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float startGain, float endGain);
+void  default_pan_and_mix_stereo		(audio_sample_t*  dstL, audio_sample_t*  dstR, const audio_sample_t*  srcL, const audio_sample_t*  srcR, nframes_t nframes, float gainLeft, float gainRight);
+void  default_apply_gain_ramp_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float startGain, float endGain);
+void  default_interleave			(audio_sample_t*  dst, audio_sample_t* const* src, int channels, nframes_t nframes);
+void  default_deinterleave			(audio_sample_t* const* dst, const audio_sample_t*  src, int channels, nframes_t nframes);
 
 
 #if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
@@ -76,6 +82,28 @@ extern "C"
         void  x86_sse_mix_buffers_with_gain	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float gain);
         void  x86_sse_mix_buffers_no_gain	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes);
 }
+
+/* SSE / AVX / FMA intrinsics, select at runtime with FPU::has_sse() / has_avx() / has_fma() */
+void  x86_sse_compute_stereo_correlation	(const audio_sample_t*  left, const audio_sample_t*  right, nframes_t nframes, float* lr, float* ll, float* rr);
+void  x86_sse_mix_buffers_with_gain_ramp	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float startGain, float endGain);
+void  x86_sse_pan_and_mix_stereo		(audio_sample_t*  dstL, audio_sample_t*  dstR, const audio_sample_t*  srcL, const audio_sample_t*  srcR, nframes_t nframes, float gainLeft, float gainRight);
+void  x86_sse_apply_gain_ramp_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float startGain, float endGain);
+void  x86_sse_interleave			(audio_sample_t*  dst, audio_sample_t* const* src, int channels, nframes_t nframes);
+void  x86_sse_deinterleave			(audio_sample_t* const* dst, const audio_sample_t*  src, int channels, nframes_t nframes);
+
+float x86_avx_compute_peak			(const audio_sample_t*  buf, nframes_t nsamples, float current);
+void  x86_avx_apply_gain_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float gain);
+void  x86_avx_mix_buffers_with_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float gain);
+void  x86_avx_mix_buffers_no_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes);
+void  x86_avx_compute_stereo_correlation	(const audio_sample_t*  left, const audio_sample_t*  right, nframes_t nframes, float* lr, float* ll, float* rr);
+void  x86_avx_mix_buffers_with_gain_ramp	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float startGain, float endGain);
+void  x86_avx_pan_and_mix_stereo		(audio_sample_t*  dstL, audio_sample_t*  dstR, const audio_sample_t*  srcL, const audio_sample_t*  srcR, nframes_t nframes, float gainLeft, float gainRight);
+void  x86_avx_apply_gain_ramp_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float startGain, float endGain);
+void  x86_avx_interleave			(audio_sample_t*  dst, audio_sample_t* const* src, int channels, nframes_t nframes);
+void  x86_avx_deinterleave			(audio_sample_t* const* dst, const audio_sample_t*  src, int channels, nframes_t nframes);
+
+void  x86_fma_mix_buffers_with_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float gain);
+void  x86_fma_pan_and_mix_stereo		(audio_sample_t*  dstL, audio_sample_t*  dstR, const audio_sample_t*  srcL, const audio_sample_t*  srcR, nframes_t nframes, float gainLeft, float gainRight);
 #endif
 
 #if defined (__APPLE__)  && defined (BUILD_VECLIB_OPTIMIZATIONS)
@@ -84,6 +112,7 @@ float veclib_compute_peak              (const audio_sample_t* buf, nframes_t nsa
 void  veclib_apply_gain_to_buffer      (audio_sample_t* buf, nframes_t nframes, float gain);
 void  veclib_mix_buffers_with_gain     (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float gain);
 void  veclib_mix_buffers_no_gain       (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes);
+void  veclib_compute_stereo_correlation (const audio_sample_t* left, const audio_sample_t* right, nframes_t nframes, float* lr, float* ll, float* rr);
 
 #endif
 
@@ -94,11 +123,29 @@ public:
         typedef void  (*apply_gain_to_buffer_t)		(audio_sample_t* , nframes_t, float);
         typedef void  (*mix_buffers_with_gain_t)	(audio_sample_t* , const audio_sample_t* , nframes_t, float);
         typedef void  (*mix_buffers_no_gain_t)		(audio_sample_t* , const audio_sample_t* , nframes_t);
+        typedef void  (*compute_stereo_correlation_t)	(const audio_sample_t* , const audio_sample_t* , nframes_t, float*, float*, float*);
+        typedef void  (*mix_buffers_with_gain_ramp_t)	(audio_sample_t* , const audio_sample_t* , nframes_t, float, float);
+        typedef void  (*pan_and_mix_stereo_t)		(audio_sample_t* , audio_sample_t* , const audio_sample_t* , const audio_sample_t* , nframes_t, float, float);
+        typedef void  (*apply_gain_ramp_to_buffer_t)	(audio_sample_t* , nframes_t, float, float);
+        typedef void  (*interleave_t)			(audio_sample_t* , audio_sample_t* const* , int, nframes_t);
+        typedef void  (*deinterleave_t)			(audio_sample_t* const* , const audio_sample_t* , int, nframes_t);
 
         static compute_peak_t		compute_peak;
         static apply_gain_to_buffer_t	apply_gain_to_buffer;
         static mix_buffers_with_gain_t	mix_buffers_with_gain;
         static mix_buffers_no_gain_t	mix_buffers_no_gain;
+        // sums of left*right, left*left and right*right over nframes
+        static compute_stereo_correlation_t	compute_stereo_correlation;
+        // dst += src * gain, gain linearly ramping from startGain to endGain
+        static mix_buffers_with_gain_ramp_t	mix_buffers_with_gain_ramp;
+        // dstL += srcL * gainLeft and dstR += srcR * gainRight in one pass
+        static pan_and_mix_stereo_t		pan_and_mix_stereo;
+        // buf *= gain, gain linearly ramping from startGain to endGain
+        static apply_gain_ramp_to_buffer_t	apply_gain_ramp_to_buffer;
+        // dst[frame * channels + chan] = src[chan][frame]
+        static interleave_t			interleave;
+        // dst[chan][frame] = src[frame * channels + chan]
+        static deinterleave_t			deinterleave;
 };
 
 #endif
@@ -0,0 +1,261 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+// This file is only compiled into the traverso executable when building
+// with WANT_RT_CHECK, the functions below replace the ones of the C library
+// for the whole process.
+
+#include "TRealtimeChecker.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#if defined (__GLIBC__)
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// No Debugger.h here, the memory leak detection would interpose
+// the same functions as we do.
+
+
+#define RT_CHECK_MAX_FRAMES		32
+#define RT_CHECK_REPORTED_SITES		512
+
+// The realtime section the calling thread is in, 0 if none
+static __thread const char* rtSection = 0;
+// Set while reporting, the reporting itself isn't checked
+static __thread int rtReporting = 0;
+
+// The call sites reported so far, only accessed while holding reportLock
+static void* reportedSites[RT_CHECK_REPORTED_SITES];
+static int reportedSiteCount = 0;
+static volatile int reportLock = 0;
+
+
+void rt_check_enter(const char* section)
+{
+	rtSection = section;
+}
+
+void rt_check_leave()
+{
+	rtSection = 0;
+}
+
+#if defined (__GLIBC__)
+
+extern "C" {
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+	void __libc_free(void* ptr);
+	ssize_t __read(int fd, void* buf, size_t count);
+	ssize_t __write(int fd, const void* buf, size_t count);
+	int __poll(struct pollfd* fds, nfds_t nfds, int timeout);
+	int __nanosleep(const struct timespec* req, struct timespec* rem);
+	int _IO_puts(const char* str);
+}
+
+typedef int (*mutex_lock_function)(pthread_mutex_t* mutex);
+
+// The pthread_mutex_lock() we replace, resolved at startup
+static mutex_lock_function realMutexLock = 0;
+
+static void write_string(const char* str)
+{
+	__write(STDERR_FILENO, str, strlen(str));
+}
+
+/**
+ * @return true if the call site, the caller of the interposed function,
+ *	wasn't reported before.
+ */
+static bool register_site(void* site)
+{
+	bool found = false;
+
+	while (__sync_lock_test_and_set(&reportLock, 1)) {}
+
+	for (int i=0; i<reportedSiteCount; ++i) {
+		if (reportedSites[i] == site) {
+			found = true;
+			break;
+		}
+	}
+
+	if (!found && reportedSiteCount < RT_CHECK_REPORTED_SITES) {
+		reportedSites[reportedSiteCount++] = site;
+	}
+
+	__sync_lock_release(&reportLock);
+
+	return !found;
+}
+
+static inline bool in_realtime_section()
+{
+	return rtSection && !rtReporting;
+}
+
+static void __attribute__((noinline)) report_violation(const char* function)
+{
+	rtReporting = 1;
+
+	void* frames[RT_CHECK_MAX_FRAMES];
+	int count = backtrace(frames, RT_CHECK_MAX_FRAMES);
+
+	// frames[0] is this function, frames[1] the interposed one
+	if (count > 2 && register_site(frames[2])) {
+		write_string("RT CHECK: ");
+		write_string(function);
+		write_string("() called in realtime section \"");
+		write_string(rtSection);
+		write_string("\"\n");
+		backtrace_symbols_fd(frames + 1, count - 1, STDERR_FILENO);
+		write_string("\n");
+	}
+
+	rtReporting = 0;
+}
+
+// backtrace() loads libgcc the first time it is called, do that at startup
+static void __attribute__((constructor)) prepare_checker()
+{
+	realMutexLock = (mutex_lock_function) dlsym(RTLD_NEXT, "pthread_mutex_lock");
+
+	void* frames[1];
+	backtrace(frames, 1);
+}
+
+#define RT_CHECK_CALL(function) \
+	if (in_realtime_section()) { \
+		report_violation(function); \
+	}
+
+
+extern "C" {
+
+void* malloc(size_t size)
+{
+	RT_CHECK_CALL("malloc")
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	RT_CHECK_CALL("calloc")
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	RT_CHECK_CALL("realloc")
+	return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+	if (ptr) {
+		RT_CHECK_CALL("free")
+	}
+	__libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+	RT_CHECK_CALL("pthread_mutex_lock")
+
+	// dlsym() could lock a mutex while resolving the real function
+	if (!realMutexLock) {
+		int result;
+		while ((result = pthread_mutex_trylock(mutex)) == EBUSY) {
+			sched_yield();
+		}
+		return result;
+	}
+
+	return realMutexLock(mutex);
+}
+
+ssize_t read(int fd, void* buf, size_t count)
+{
+	RT_CHECK_CALL("read")
+	return __read(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count)
+{
+	RT_CHECK_CALL("write")
+	return __write(fd, buf, count);
+}
+
+int poll(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+	RT_CHECK_CALL("poll")
+	return __poll(fds, nfds, timeout);
+}
+
+int nanosleep(const struct timespec* req, struct timespec* rem)
+{
+	RT_CHECK_CALL("nanosleep")
+	return __nanosleep(req, rem);
+}
+
+int usleep(useconds_t usecs)
+{
+	RT_CHECK_CALL("usleep")
+	struct timespec req;
+	req.tv_sec = usecs / 1000000;
+	req.tv_nsec = (usecs % 1000000) * 1000;
+	return __nanosleep(&req, 0);
+}
+
+// printf() and puts() write through the internal write() of the
+// C library, so they have to be interposed themselves.
+int printf(const char* format, ...)
+{
+	RT_CHECK_CALL("printf")
+	va_list args;
+	va_start(args, format);
+	int result = vprintf(format, args);
+	va_end(args);
+	return result;
+}
+
+int puts(const char* str)
+{
+	RT_CHECK_CALL("puts")
+	return _IO_puts(str);
+}
+
+}
+
+#endif
+
+//eof
@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TREALTIME_CHECKER_H
+#define TREALTIME_CHECKER_H
+
+/**
+ * Developer tool, enabled with the WANT_RT_CHECK build option.
+ *
+ * Code between RT_CHECK_ENTER() and RT_CHECK_LEAVE() is the realtime
+ * part of the calling thread, e.g. the processing of an audio cycle.
+ * The checker interposes malloc() and friends, pthread_mutex_lock(), the
+ * blocking read(), write(), poll(), nanosleep() and usleep() system calls,
+ * and printf() and puts(), and prints the call with a stack trace to stderr
+ * when one of them is called in the realtime part of a thread.
+ * Each call site is only reported once.
+ *
+ * The interposition needs glibc, on other platforms nothing is reported.
+ */
+
+#if defined (RT_CHECK)
+
+void rt_check_enter(const char* section);
+void rt_check_leave();
+
+#define RT_CHECK_ENTER(section)	rt_check_enter(section)
+#define RT_CHECK_LEAVE()	rt_check_leave()
+
+#else
+
+#define RT_CHECK_ENTER(section)
+#define RT_CHECK_LEAVE()
+
+#endif
+
+#endif
+
+//eof
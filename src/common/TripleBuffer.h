@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <QAtomicInt>
+
+/**
+ * Lock free single producer / single consumer triple buffer.
+ *
+ * The producer (typically the audio thread) fills write_buffer() and calls
+ * publish(), the consumer (typically the GUI thread) calls update() and reads
+ * read_buffer(). Neither side ever waits on the other, the consumer always
+ * sees the most recently published snapshot, older ones are simply dropped.
+ *
+ * T should be a plain value type, memory for all 3 instances is owned by
+ * the TripleBuffer, so publishing never allocates.
+ */
+
+template<class T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: m_writeIndex(0)
+		, m_readIndex(2)
+		, m_middle(1)
+	{}
+
+	T& write_buffer() {return m_buffers[m_writeIndex];}
+	const T& read_buffer() const {return m_buffers[m_readIndex];}
+
+	// producer side: make the write buffer the new 'latest' snapshot
+	void publish() {
+		int old = m_middle.fetchAndStoreOrdered(m_writeIndex | NEW_DATA);
+		m_writeIndex = old & INDEX_MASK;
+	}
+
+	// consumer side: returns true if a new snapshot was published
+	// since the previous call, read_buffer() then points to it.
+	bool update() {
+		if (!(int(m_middle) & NEW_DATA)) {
+			return false;
+		}
+		int old = m_middle.fetchAndStoreOrdered(m_readIndex);
+		m_readIndex = old & INDEX_MASK;
+		return true;
+	}
+
+private:
+	enum {
+		INDEX_MASK = 0x3,
+		NEW_DATA = 0x4
+	};
+
+	T		m_buffers[3];
+	int		m_writeIndex;
+	int		m_readIndex;
+	QAtomicInt	m_middle;
+};
+
+#endif
+
+//eof
@@ -34,6 +34,11 @@ $Id: Tsar.cpp,v 1.4 2008/02/11 10:11:52 r_sijrier Exp $
 // in case we run with memory leak detection enabled!
 #include "Debugger.h"
 
+// The events of each queue processed in one audio cycle are bounded both in
+// count and in time, what's left is processed in the next cycle(s).
+#define MAX_EVENTS_PER_CYCLE	50
+#define CYCLE_BUDGET_USECS	250
+
 /**
  * 	\class Tsar
  * 	\brief Tsar (Thread Save Add and Remove) is a singleton class to call  
@@ -66,6 +71,13 @@ Tsar::Tsar()
 	m_events.append(new RingBufferNPT<TsarEvent>(audioThreadEventsBufferSize));
 
 	m_retryCount = 0;
+
+	for (int i=0; i<COALESCE_SLOTS; ++i) {
+		m_coalescePending[i] = 0;
+		m_freeCoalesceIndices.append(i);
+	}
+
+	reset_statistics();
 	
 #if defined (THREAD_CHECK)
 	m_threadId = QThread::currentThreadId ();
@@ -93,22 +105,86 @@ void Tsar::timerEvent(QTimerEvent *event)
  * 	Use this function to add events to the event queue when 
  * 	called from the GUI thread.
  *
+ *	If the queue is full, the event is kept aside and added by the
+ *	Tsar timer as soon as there is room, in the order they were added.
+ *
  *	Note: This function should be called ONLY from the GUI thread! 
  * @param event  The event to add to the event queue
+ * @return true if the event went into the queue directly, false if it
+ *	has to wait for the audio thread to catch up.
  */
 bool Tsar::add_event(TsarEvent& event )
 {
 #if defined (THREAD_CHECK)
 	Q_ASSERT_X(m_threadId == QThread::currentThreadId (), "Tsar::add_event", "Adding event from other then GUI thread!!");
 #endif
-	if (m_events.at(0)->write(&event, 1) == 1) {
-		m_eventCounter++;
+	event.time = get_microseconds();
+	m_eventCounter++;
+
+	if (m_overflowEvents.isEmpty() && m_events.at(0)->write(&event, 1) == 1) {
 		return true;
 	}
-	m_retryCount = 0;
+
+	m_overflowEvents.enqueue(event);
+	m_overflowCount++;
+
 	return false;
 }
 
+/**
+ * 	Adds the event like add_event(), unless the same slot is still waiting
+ *	to be called on the same caller with the same argument. When that call
+ *	is made, it sees the latest state anyway, so the event can be dropped.
+ *	Use this for events that are added at a high rate, e.g. while dragging.
+ *
+ *	Note: This function should be called ONLY from the GUI thread! 
+ */
+bool Tsar::add_coalesced_event(TsarEvent& event)
+{
+	CoalesceKey key(event.caller, qMakePair(event.slotindex, event.argument));
+	int index = m_coalesceIndices.value(key, -1);
+
+	if (index < 0 && !m_freeCoalesceIndices.isEmpty()) {
+		index = m_freeCoalesceIndices.takeLast();
+		m_coalesceIndices.insert(key, index);
+	}
+
+	if (index >= 0) {
+		if (t_atomic_int_get(&m_coalescePending[index])) {
+			m_coalescedCount++;
+			return true;
+		}
+		t_atomic_int_set(&m_coalescePending[index], 1);
+	}
+
+	event.coalesceIndex = index;
+
+	return add_event(event);
+}
+
+void Tsar::flush_overflow_events()
+{
+	while (!m_overflowEvents.isEmpty()) {
+		if (m_events.at(0)->write(&m_overflowEvents.head(), 1) != 1) {
+			return;
+		}
+		m_overflowEvents.dequeue();
+	}
+}
+
+/**
+ * 	Returns true while events added with add_event() still have to be
+ *	processed, or their signals still have to be emitted. A slot that is
+ *	called directly with process_event_slot_signal() would overtake them,
+ *	so in that case the event has to go through add_event() as well.
+ *
+ *	Note: This function should be called ONLY from the GUI thread! 
+ */
+bool Tsar::has_pending_events() const
+{
+	return !m_overflowEvents.isEmpty() || m_events.at(0)->read_space() > 0 || oldEvents->read_space() > 0;
+}
+
 /**
  * 	Use this function to add events to the event queue when  
  * 	called from the audio processing (real time) thread
@@ -123,6 +199,8 @@ void Tsar::add_rt_event( TsarEvent& event )
 #if defined (THREAD_CHECK)
 	Q_ASSERT_X(m_threadId != QThread::currentThreadId (), "Tsar::add_rt_event", "Adding event from NON-RT Thread!!");
 #endif
+	event.time = get_microseconds();
+	event.coalesceIndex = -1;
 	m_events.at(1)->write(&event, 1);
 }
 
@@ -133,21 +211,48 @@ void Tsar::process_events( )
 {
 //#define profile
 
+	trav_time_t cycleStart = get_microseconds();
+
 	for (int i=0; i<m_events.size(); ++i) {
 		RingBufferNPT<TsarEvent>* newEvents = m_events.at(i);
 		
 		int processedCount = 0;
 		int newEventCount = newEvents->read_space();
+
+		if (newEventCount > m_maxQueueDepth) {
+			m_maxQueueDepth = newEventCount;
+		}
 	
-		while((newEventCount > 0) && (processedCount < 50)) {
+		while(newEventCount > 0) {
+			// at least one event per queue, so each queue makes progress
+			trav_time_t now = get_microseconds();
+			if (processedCount > 0 && (processedCount >= MAX_EVENTS_PER_CYCLE || now - cycleStart > CYCLE_BUDGET_USECS)) {
+				m_deferredCycles++;
+				break;
+			}
 #if defined (profile)
 			trav_time_t starttime = get_microseconds();
 #endif
 			TsarEvent event;
 			
 			newEvents->read(&event, 1);
+
+			// clear the pending flag before the call, an event added
+			// after this point may change the state again
+			if (event.coalesceIndex >= 0) {
+				t_atomic_int_set(&m_coalescePending[event.coalesceIndex], 0);
+			}
 	
 			process_event_slot(event);
+
+			if (event.slotindex > -1) {
+				int latency = int(now - event.time);
+				if (latency > m_maxSlotLatency) {
+					m_maxSlotLatency = latency;
+				}
+				m_slotLatencySum += latency;
+				m_slotLatencyCount++;
+			}
 			
 			oldEvents->write(&event, 1);
 			
@@ -167,13 +272,30 @@ void Tsar::process_events( )
 
 void Tsar::finish_processed_events( )
 {
+	flush_overflow_events();
 	
+	trav_time_t now = get_microseconds();
+
 	while(oldEvents->read_space() >= 1 ) {
 		TsarEvent event;
 		// Read one TsarEvent from the processed events ringbuffer 'queue'
 		oldEvents->read(&event, 1);
 		
 		process_event_signal(event);
+
+		if (event.signalindex > -1 && int(now - event.time) > m_maxSignalLatency) {
+			m_maxSignalLatency = int(now - event.time);
+		}
+
+		// the slot was called, recycle the coalesce slot unless
+		// a new event for it is pending already
+		if (event.coalesceIndex >= 0 && !t_atomic_int_get(&m_coalescePending[event.coalesceIndex])) {
+			CoalesceKey key(event.caller, qMakePair(event.slotindex, event.argument));
+			if (m_coalesceIndices.value(key, -1) == event.coalesceIndex) {
+				m_coalesceIndices.remove(key);
+				m_freeCoalesceIndices.append(event.coalesceIndex);
+			}
+		}
 		
 		--m_eventCounter;
 // 		printf("finish_processed_objects:: Count is %d\n", m_eventCounter);
@@ -264,10 +386,63 @@ TsarEvent Tsar::create_event( QObject* caller, void* argument, const char* slotS
 	}
 	
 	event.valid = true;
+	event.time = 0;
+	event.coalesceIndex = -1;
 	
 	return event;
 }
 
+/**
+ * @return The queue statistics collected since the last reset_statistics().
+ *	The slot latency is the time between adding an event and the audio
+ *	thread calling its slot, the signal latency the time between adding
+ *	an event and emitting its signal in the GUI thread, both in usecs.
+ *	Deferred cycles are audio cycles which ran out of their event budget.
+ */
+Tsar::Statistics Tsar::get_statistics() const
+{
+	Statistics statistics;
+
+	statistics.maxQueueDepth = m_maxQueueDepth;
+	statistics.maxSlotLatency = m_maxSlotLatency;
+	statistics.averageSlotLatency = m_slotLatencyCount ? int(m_slotLatencySum / m_slotLatencyCount) : 0;
+	statistics.maxSignalLatency = m_maxSignalLatency;
+	statistics.deferredCycles = m_deferredCycles;
+	statistics.overflowCount = m_overflowCount;
+	statistics.coalescedCount = m_coalescedCount;
+
+	return statistics;
+}
+
+QString Tsar::get_statistics_text() const
+{
+	Statistics statistics = get_statistics();
+
+	QString text = tr("Event queue: max depth %1, deferred cycles %2, overflows %3, coalesced %4")
+		.arg(statistics.maxQueueDepth).arg(statistics.deferredCycles)
+		.arg(statistics.overflowCount).arg(statistics.coalescedCount);
+	text += "\n" + tr("Event latency (avg/max): %1 / %2 us, signal latency (max): %3 us")
+		.arg(statistics.averageSlotLatency).arg(statistics.maxSlotLatency)
+		.arg(statistics.maxSignalLatency);
+
+	return text;
+}
+
+/**
+ * Only call this when the audio thread isn't processing events
+ */
+void Tsar::reset_statistics()
+{
+	m_maxQueueDepth = 0;
+	m_maxSlotLatency = 0;
+	m_slotLatencySum = 0;
+	m_slotLatencyCount = 0;
+	m_deferredCycles = 0;
+	m_maxSignalLatency = 0;
+	m_overflowCount = 0;
+	m_coalescedCount = 0;
+}
+
 /**
 *	This function can be used to process the events 'slot' part.
 *	Usefull when you have a Tsar event, but don't want/need to use tsar
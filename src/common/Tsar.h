@@ -26,11 +26,22 @@ $Id: Tsar.h,v 1.4 2008/02/11 10:11:52 r_sijrier Exp $
 #include <QObject>
 #include <QBasicTimer>
 #include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QQueue>
 #include "RingBufferNPT.h"
+#include "defines.h"
 
 #define THREAD_SAVE_INVOKE(caller, argument, slotSignature)  { \
 		TsarEvent event = tsar().create_event(caller, argument, #slotSignature, ""); \
-		while (!tsar().add_event(event)) { printf("THREAD_SAVE_INVOKE: failed to add event, trying again\n");} \
+		tsar().add_event(event); \
+	}
+
+/* Like THREAD_SAVE_INVOKE, but the event is dropped when the same slot is
+   still waiting to be called on the same caller with the same argument */
+#define THREAD_SAVE_INVOKE_COALESCED(caller, argument, slotSignature)  { \
+		TsarEvent event = tsar().create_event(caller, argument, #slotSignature, ""); \
+		tsar().add_coalesced_event(event); \
 	}
 
 #define RT_THREAD_EMIT(cal, arg, signalSignature) {\
@@ -68,6 +79,10 @@ struct TsarEvent {
 	int signalindex;
 	
 	bool valid;
+
+// Set by Tsar when the event is added
+	trav_time_t	time;
+	int		coalesceIndex;
 };
 
 class Tsar : public QObject
@@ -78,10 +93,26 @@ public:
 	TsarEvent create_event(QObject* caller, void* argument, const char* slotSignature, const char* signalSignature);
 	
 	bool add_event(TsarEvent& event);
+	bool add_coalesced_event(TsarEvent& event);
 	void add_rt_event(TsarEvent& event);
 	void process_event_slot(const TsarEvent& event);
 	void process_event_signal(const TsarEvent& event);
 	void process_event_slot_signal(const TsarEvent& event);
+	bool has_pending_events() const;
+
+	struct Statistics {
+		int	maxQueueDepth;
+		int	maxSlotLatency;
+		int	averageSlotLatency;
+		int	maxSignalLatency;
+		int	deferredCycles;
+		int	overflowCount;
+		int	coalescedCount;
+	};
+
+	Statistics get_statistics() const;
+	QString get_statistics_text() const;
+	void reset_statistics();
 
 protected:
         void timerEvent(QTimerEvent *event);
@@ -97,18 +128,41 @@ private:
 	// is allowed to call process_events() !!
 	friend class AudioDevice;
 
+	typedef QPair<QObject*, QPair<int, void*> > CoalesceKey;
+
+	static const int COALESCE_SLOTS = 512;
+
 	QList<RingBufferNPT<TsarEvent>*>	m_events;
 	RingBufferNPT<TsarEvent>*		oldEvents;
         QBasicTimer                             m_timer;
 	int 	m_eventCounter;
 	int 	m_retryCount;
 
+	// gui thread: events that didn't fit in the queue, and the
+	// pending flags of coalesced events, cleared by the audio thread
+	QQueue<TsarEvent>		m_overflowEvents;
+	QHash<CoalesceKey, int>		m_coalesceIndices;
+	QList<int>			m_freeCoalesceIndices;
+	volatile int			m_coalescePending[COALESCE_SLOTS];
+
+	// written by the audio thread
+	int		m_maxQueueDepth;
+	int		m_maxSlotLatency;
+	qint64		m_slotLatencySum;
+	int		m_slotLatencyCount;
+	int		m_deferredCycles;
+	// written by the gui thread
+	int		m_maxSignalLatency;
+	int		m_overflowCount;
+	int		m_coalescedCount;
+
 #if defined (THREAD_CHECK)
 	unsigned long	m_threadId;
 #endif
 
 	void process_events();
         void finish_processed_events();
+	void flush_overflow_events();
 };
 
 // use this function to access the context pointer
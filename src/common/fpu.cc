@@ -27,6 +27,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include <fpu.h>
 
+#if defined (ARCH_X86) && defined (__GNUC__)
+#include <cpuid.h>
+#endif
+
 FPU::FPU ()
 {
         unsigned long cpuflags = 0;
@@ -72,6 +76,32 @@ FPU::FPU ()
                 _flags = Flags (_flags | HasSSE2);
         }
 
+#if defined (ARCH_X86) && defined (__GNUC__)
+        unsigned int eax, ebx, ecx, edx;
+
+        if (__get_cpuid (1, &eax, &ebx, &ecx, &edx)) {
+                // AVX needs cpu support _and_ the OS saving the ymm registers
+                // on context switches (OSXSAVE + XCR0 bits 1 and 2)
+                if ((ecx & (1<<28)) && (ecx & (1<<27))) {
+                        unsigned int xcr0_lo, xcr0_hi;
+                        asm volatile ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+                        if ((xcr0_lo & 0x6) == 0x6) {
+                                _flags = Flags (_flags | HasAVX);
+                                if (ecx & (1<<12)) {
+                                        _flags = Flags (_flags | HasFMA);
+                                }
+                        }
+                }
+        }
+
+        if (has_avx() && __get_cpuid_max (0, 0) >= 7) {
+                __cpuid_count (7, 0, eax, ebx, ecx, edx);
+                if (ebx & (1<<5)) {
+                        _flags = Flags (_flags | HasAVX2);
+                }
+        }
+#endif
+
         if (cpuflags & (1 << 24)) {
 
                 char* fxbuf = 0;
@@ -53,6 +53,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TInputEventDispatcher.h"
 
 #include "AbstractAudioReader.h"
+#include "TScratchArena.h"
 
 #include <commands.h>
 
@@ -384,7 +385,7 @@ void AudioClip::set_track_end_location(const TimeRef& location)
 		// sorted on the clips track start location.
 		if (m_track) {
                         if (m_sheet && m_sheet->is_transport_rolling()) {
-                                THREAD_SAVE_INVOKE(m_track, this, clip_position_changed(AudioClip*));
+                                THREAD_SAVE_INVOKE_COALESCED(m_track, this, clip_position_changed(AudioClip*));
                         } else {
                                 m_track->clip_position_changed(this);
                         }
@@ -460,51 +461,73 @@ int AudioClip::process(nframes_t nframes)
 	
 	Q_ASSERT(m_readSource);
 	
-	AudioBus* bus = m_sheet->get_clip_render_bus();
-	bus->silence_buffers(nframes);
-	
 	TimeRef mix_pos;
 	int channelcount = get_channel_count();
-	audio_sample_t* mixdown[channelcount];
 	uint framesToProcess = nframes;
-
-
+	
 	int outputRate = m_readSource->get_output_rate();
-	TimeRef transportLocation = m_sheet->get_transport_location();
+	// Delay compensation: a Track whose audio is delayed by plugins
+	// (its own, or those of the buses it sends to) plays its clips ahead
+	// of the transport, so it arrives in time at the master out.
+	TimeRef transportLocation = m_sheet->get_transport_location() + TimeRef(m_track->get_path_latency(), outputRate);
 	TimeRef upperRange = transportLocation + TimeRef(framesToProcess, outputRate);
 	
+	// Most clips of a Track are not under the transport, don't touch
+	// any buffer for those.
+	if ( ! ((m_trackStartLocation < upperRange) && (m_trackEndLocation > transportLocation)) ) {
+		return 0;
+	}
+	
+	// the scratch arena is sized for at most MAX_CHANNELS, only mono
+	// and stereo clips are mixed into the Track anyway
+	if (channelcount > TScratchArena::MAX_CHANNELS) {
+		return 0;
+	}
+	
+	// the clip is rendered into buffers of its own, mixdown points
+	// to the part of them that overlaps with the clip
+	TScratchArena::Scope scratch;
+	audio_sample_t** buffers = scratch.allocate<audio_sample_t*>(channelcount);
+	audio_sample_t** mixdown = scratch.allocate<audio_sample_t*>(channelcount);
+	
+	if (!buffers || !mixdown) {
+		return 0;
+	}
+	
+	for (int chan=0; chan<channelcount; ++chan) {
+		buffers[chan] = scratch.allocate<audio_sample_t>(nframes);
+		if (!buffers[chan]) {
+			return 0;
+		}
+		memset(buffers[chan], 0, nframes * sizeof(audio_sample_t));
+	}
 	
-	if ( (m_trackStartLocation < upperRange) && (m_trackEndLocation > transportLocation) ) {
-		if (transportLocation < m_trackStartLocation) {
-			// Using to_frame() for both the m_trackStartLocation and transportLocation seems to round 
-			// better then using (m_trackStartLocation - transportLocation).to_frame()
-			// TODO : find out why!
-			uint offset = (m_trackStartLocation).to_frame(outputRate) - transportLocation.to_frame(outputRate);
-			mix_pos = m_sourceStartLocation;
+	if (transportLocation < m_trackStartLocation) {
+		// Using to_frame() for both the m_trackStartLocation and transportLocation seems to round 
+		// better then using (m_trackStartLocation - transportLocation).to_frame()
+		// TODO : find out why!
+		uint offset = (m_trackStartLocation).to_frame(outputRate) - transportLocation.to_frame(outputRate);
+		mix_pos = m_sourceStartLocation;
 // 			printf("offset %d\n", offset);
-			
-			for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-				audio_sample_t* buf = bus->get_buffer(chan, framesToProcess);
-				mixdown[chan] = buf + offset;
-			}
-			framesToProcess = framesToProcess - offset;
-		} else {
-			mix_pos = (transportLocation - m_trackStartLocation + m_sourceStartLocation);
+		
+		for (int chan=0; chan<channelcount; ++chan) {
+			mixdown[chan] = buffers[chan] + offset;
+		}
+		framesToProcess = framesToProcess - offset;
+	} else {
+		mix_pos = (transportLocation - m_trackStartLocation + m_sourceStartLocation);
 // 			printf("else: Setting mix pos to start location %d\n", mix_pos.to_frame(96000));
-			
-			for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-				mixdown[chan] = bus->get_buffer(chan, framesToProcess);
-			}
+		
+		for (int chan=0; chan<channelcount; ++chan) {
+			mixdown[chan] = buffers[chan];
 		}
-		if (m_trackEndLocation < upperRange) {
-			// Using to_frame() for both the upperRange and m_trackEndLocation seems to round 
-			// better then using (upperRange - m_trackEndLocation).to_frame()
-			// TODO : find out why!
-			framesToProcess -= upperRange.to_frame(outputRate) - m_trackEndLocation.to_frame(outputRate);
+	}
+	if (m_trackEndLocation < upperRange) {
+		// Using to_frame() for both the upperRange and m_trackEndLocation seems to round 
+		// better then using (upperRange - m_trackEndLocation).to_frame()
+		// TODO : find out why!
+		framesToProcess -= upperRange.to_frame(outputRate) - m_trackEndLocation.to_frame(outputRate);
 // 			printf("if (m_trackEndLocation < upperRange): framesToProcess %d\n", framesToProcess);
-		}
-	} else {
-		return 0;
 	}
 
 	uint read_frames = 0;
@@ -531,7 +554,7 @@ int AudioClip::process(nframes_t nframes)
 	
 
 	apill_foreach(FadeCurve* fade, FadeCurve, m_fades) {
-                fade->process(bus, nframes);
+                fade->process(buffers, channelcount, nframes);
 	}
 	
 	TimeRef endlocation = mix_pos + TimeRef(read_frames, get_rate());
@@ -542,11 +565,11 @@ int AudioClip::process(nframes_t nframes)
 	// NEVER EVER FORGET that the mixing should be done on the WHOLE buffer, not just part of it
 	// so use an unmodified nframes variable!!!!!!!!!!!!!!!!!!!!!!!!!!!1
 	if (channelcount == 1) {
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(0, nframes), bus->get_buffer(0, nframes), nframes);
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(1, nframes), bus->get_buffer(0, nframes), nframes);
+                Mixer::mix_buffers_no_gain(processBus->get_buffer(0, nframes), buffers[0], nframes);
+                Mixer::mix_buffers_no_gain(processBus->get_buffer(1, nframes), buffers[0], nframes);
 	} else if (channelcount == 2) {
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(0, nframes), bus->get_buffer(0, nframes), nframes);
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(1, nframes), bus->get_buffer(1, nframes), nframes);
+                Mixer::mix_buffers_no_gain(processBus->get_buffer(0, nframes), buffers[0], nframes);
+                Mixer::mix_buffers_no_gain(processBus->get_buffer(1, nframes), buffers[1], nframes);
 	}
 	
 	return 1;
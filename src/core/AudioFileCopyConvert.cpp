@@ -31,6 +31,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "ReadSource.h"
 #include "WriteSource.h"
 #include "Peak.h"
+#include "Mixer.h"
 #include "defines.h"
 
 AudioFileCopyConvert::AudioFileCopyConvert()
@@ -138,11 +139,7 @@ void AudioFileCopyConvert::process_task(CopyTask task)
 		
 		task.readsource->file_read(&decodebuffer, task.spec->pos, nframes);
 			
-		for (uint x = 0; x < nframes; ++x) {
-			for (int y = 0; y < task.spec->channels; ++y) {
-				task.spec->dataF[y + x*task.spec->channels] = decodebuffer.destination[y][x];
-			}
-		}
+		Mixer::interleave(task.spec->dataF, decodebuffer.destination, task.spec->channels, nframes);
 		
 		// due the fact peak generating does _not_ happen in writesource->process
 		// but in a function used by DiskIO, we have to hack the peak processing 
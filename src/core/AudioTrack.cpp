@@ -37,6 +37,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <limits.h>
 #include "AddRemove.h"
 #include "PCommand.h"
+#include "TScratchArena.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -82,6 +83,7 @@ void AudioTrack::init()
         m_isArmed = false;
         m_fader->set_gain(1.0);
         m_processBus = m_sheet->get_render_bus();
+        m_mixdownFallback.resize(m_processBus->get_channel_count());
 }
 
 QDomNode AudioTrack::get_state( QDomDocument doc, bool istemplate)
@@ -261,6 +263,7 @@ int AudioTrack::process( nframes_t nframes )
         int processResult = 0;
 
         if ( (m_isMuted || m_mutedBySolo) && ( ! m_isArmed) ) {
+                process_silent_post_sends(nframes);
                 return 0;
         }
 
@@ -270,7 +273,6 @@ int AudioTrack::process( nframes_t nframes )
         m_processBus->silence_buffers(nframes);
 
         int result;
-        float panFactor;
 
         // Read in clip data into process bus.
         apill_foreach(AudioClip* clip, AudioClip, m_clips) {
@@ -290,6 +292,13 @@ int AudioTrack::process( nframes_t nframes )
                 processResult |= result;
         }
 
+        // Nothing was mixed into the process bus, and without plugins
+        // there can't be a tail either, so there is nothing left to do.
+        if (m_processBus->is_silent(nframes) && !m_pluginChain->has_plugins()) {
+                process_silent_post_sends(nframes);
+                return 0;
+        }
+
         // Then do the pre-send:
         process_pre_sends(nframes);
 
@@ -298,28 +307,22 @@ int AudioTrack::process( nframes_t nframes )
         m_pluginChain->process_pre_fader(m_processBus, nframes);
 
 
-        // Obviously fader here, pan, gain, gain automation
-        if ( (m_processBus->get_channel_count() >= 1) && (m_pan > 0) )  {
-                panFactor = 1 - m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(0, nframes), nframes, panFactor);
-        }
-
-        if ( (m_processBus->get_channel_count() >= 2) && (m_pan < 0) )  {
-                panFactor = 1 + m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(1, nframes), nframes, panFactor);
-        }
-
-
+        // Obviously fader here, pan, gain and gain automation in one pass
         // gain automation curve only understands audio_sample_t** atm
         // so wrap the process buffers into a audio_sample_t**
-        audio_sample_t* mixdown[m_processBus->get_channel_count()];
+        TScratchArena::Scope scratch;
+        audio_sample_t** mixdown = scratch.allocate<audio_sample_t*>(m_processBus->get_channel_count());
+        if (!mixdown) {
+                // never skip gain and pan, fall back to the preallocated wrapper
+                mixdown = m_mixdownFallback.data();
+        }
         for(int chan=0; chan<m_processBus->get_channel_count(); chan++) {
                 mixdown[chan] = m_processBus->get_buffer(chan, nframes);
         }
 
-        TimeRef location = m_sheet->get_transport_location();
+        TimeRef location = m_sheet->get_transport_location() + TimeRef(m_pathLatency, audiodevice().get_sample_rate());
         TimeRef endlocation = location + TimeRef(nframes, audiodevice().get_sample_rate());
-        m_fader->process_gain(mixdown, location, endlocation, nframes, m_processBus->get_channel_count());
+        m_fader->process_gain_and_pan(mixdown, location, endlocation, nframes, m_processBus->get_channel_count(), m_pan);
 
 
         // Post fader plugins now
@@ -334,6 +337,8 @@ int AudioTrack::process( nframes_t nframes )
 
         // And finally do the post sends
                 process_post_sends(nframes);
+        } else {
+                process_silent_post_sends(nframes);
         }
 
         return processResult;
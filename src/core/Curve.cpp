@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <AddRemove.h>
 #include "Mixer.h"
 #include "Information.h"
+#include "TScratchArena.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -132,7 +133,8 @@ int Curve::process(
 	const TimeRef& endlocation,
 	nframes_t nframes,
 	uint channels,
-	float makeupgain
+	float makeupgain,
+	const float* channelgains
 	)
 {
 	// Do nothing if there are no nodes!
@@ -142,25 +144,35 @@ int Curve::process(
 	
 	// Check if we are beyond the last node and only apply gain if != 1.0
 	if (endlocation > qint64(get_range())) {
-		float gain = ((CurveNode*)m_nodes.last())->value * makeupgain;
-		
-		if (gain == 1.0f) {
-			return 0;
-		}
+		float value = ((CurveNode*)m_nodes.last())->value * makeupgain;
+		int result = 0;
 		
 		for (uint chan=0; chan<channels; ++chan) {
-			Mixer::apply_gain_to_buffer(buffer[chan], nframes, gain);
+			float gain = channelgains ? value * channelgains[chan] : value;
+			if (gain != 1.0f) {
+				Mixer::apply_gain_to_buffer(buffer[chan], nframes, gain);
+				result = 1;
+			}
 		}
 		
-		return 1;
+		return result;
+	}
+	
+	TScratchArena::Scope scratch;
+	audio_sample_t* gains = scratch.allocate<audio_sample_t>(nframes);
+	
+	if (!gains) {
+		return 0;
 	}
 	
-	// Calculate the vector, an apply to the buffer including the makeup gain.
-        get_vector(startlocation.universal_frame(), endlocation.universal_frame(), m_session->mixdown, nframes);
+	// Calculate the vector, an apply to the buffer including the makeup gain
+	// and the (optional) per channel gain, e.g. the pan factor.
+        get_vector(startlocation.universal_frame(), endlocation.universal_frame(), gains, nframes);
 	
 	for (uint chan=0; chan<channels; ++chan) {
+		float gain = channelgains ? makeupgain * channelgains[chan] : makeupgain;
 		for (nframes_t n = 0; n < nframes; ++n) {
-                        buffer[chan][n] *= (m_session->mixdown[n] * makeupgain);
+                        buffer[chan][n] *= (gains[n] * gain);
 		}
 	}
 	
@@ -52,7 +52,7 @@ public:
 
 	QDomNode get_state(QDomDocument doc, const QString& name);
 	virtual int set_state( const QDomNode& node );
-	int process(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, float makeupgain=1.0f);
+	int process(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, float makeupgain=1.0f, const float* channelgains=0);
 	
 	TCommand* add_node(CurveNode* node, bool historable=true);
 	TCommand* remove_node(CurveNode* node, bool historable=true);
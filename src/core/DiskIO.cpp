@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "DiskIO.h"
 #include "Sheet.h"
 #include <QThread>
+#include <QCoreApplication>
 
 #if defined (Q_WS_X11)
 
@@ -85,22 +86,19 @@ const char *to_prio[] = { "none", "realtime", "best-effort", "idle", };
 
 
 // DiskIOThread is a private class to be used by
-// DiskIO only for processing read/write buffers
+// DiskIOService only for processing read/write buffers
 // in a seperate thread.
 class DiskIOThread : public QThread
 {
 public:
-	DiskIOThread(DiskIO* diskio)
-	: QThread(diskio),
-	  m_diskio(diskio)
+	DiskIOThread()
+	: QThread()
         {
 #ifndef Q_WS_MAC
 // 		setStackSize(20000);
 #endif
 	}
 
-	DiskIO*		m_diskio;
-
 protected:
 	void run()
 	{
@@ -132,50 +130,173 @@ protected:
 
 
 
-/** 	\class DiskIO 
- *	\brief handles all the read's and write's of AudioSources in it's private thread.
- *	
- *	Each Sheet class has it's own DiskIO instance. 
+DiskIOService::DiskIOService()
+{
+	m_framebuffer = 0;
+	m_framebufferSize = 0;
+	m_decodebuffer = new DecodeBuffer;
+	m_resampleDecodeBuffer = new DecodeBuffer;
+	
+	m_diskThread = new DiskIOThread();
+	m_diskThread->start();
+}
+
+DiskIOService::~DiskIOService()
+{
+	PENTERDES;
+	
+	foreach(DiskIO* diskio, m_diskios) {
+		destroy_diskio(diskio);
+	}
+	
+	stop();
+	
+	delete m_diskThread;
+	delete [] m_framebuffer;
+	delete m_decodebuffer;
+	delete m_resampleDecodeBuffer;
+}
+
+/**
+ * 	Creates the DiskIO for \a sheet, running in the disk thread of this service.
+ *	Destroy it with destroy_diskio() only.
+ */
+DiskIO* DiskIOService::create_diskio(Sheet* sheet)
+{
+	DiskIO* diskio = new DiskIO(sheet, this);
+	m_diskios.append(diskio);
+	
+	return diskio;
+}
+
+/**
+ * 	Destroys \a diskio from within the disk thread, so it is never deleted
+ *	while it is processing its sources, nor receives any pending events afterwards.
+ */
+void DiskIOService::destroy_diskio(DiskIO* diskio)
+{
+	if (! m_diskios.removeAll(diskio)) {
+		return;
+	}
+	
+	// interupt do_work() if it is running
+	diskio->prepare_for_seek();
+
+	if (QThread::currentThread() == m_diskThread) {
+		// A blocking queued call to ourselves would never return, but
+		// nothing of diskio can be running now, so delete it right here.
+		delete diskio;
+		return;
+	}
+
+	if (m_diskThread->isRunning()) {
+		// Hand diskio over to our own thread from within the disk
+		// thread, it can be deleted safely from here after that.
+		QMetaObject::invokeMethod(diskio, "release", Qt::BlockingQueuedConnection);
+	}
+
+	delete diskio;
+}
+
+int DiskIOService::stop()
+{
+	PENTER;
+	int res = 0;
+
+	// Exit the diskthreads event loop
+	m_diskThread->exit(0);
+
+	// Wait for the Thread to return from it's event loop. 1000 ms should be (more then) enough,
+	// if not, terminate this thread and print a warning!
+	if ( ! m_diskThread->wait(2000) ) {
+		qWarning("DiskIO :: Still running after 2 second wait, terminating!");
+		m_diskThread->terminate();
+		res = -1;
+	}
+
+	return res;
+}
+
+QThread* DiskIOService::get_thread() const
+{
+	return m_diskThread;
+}
+
+/**
+ * 	Only to be called from the disk thread
+ * @return A buffer large enough to hold DiskIO::writebuffertime seconds of audio
+ */
+audio_sample_t* DiskIOService::get_framebuffer()
+{
+	nframes_t size = audiodevice().get_sample_rate() * DiskIO::writebuffertime;
+
+	// allocated the first time a DiskIO needs it, which is when
+	// one of the Sheets is recording
+	if (size > m_framebufferSize) {
+		delete [] m_framebuffer;
+		m_framebuffer = new audio_sample_t[size];
+		m_framebufferSize = size;
+	}
+
+	return m_framebuffer;
+}
+
+
+
+/** 	\class DiskIO
+ *	\brief handles all the read's and write's of AudioSources in the disk thread of the Project.
+ *
+ *	Each Sheet class has it's own DiskIO instance, created by the DiskIOService of the Project.
  * 	The DiskIO manages all the AudioSources related to a Sheet, and makes sure the RingBuffers
  * 	from the AudioSources are processed in time. (It at least tries very hard)
  */
-DiskIO::DiskIO(Sheet* sheet)
+DiskIO::DiskIO(Sheet* sheet, DiskIOService* service)
 	: m_sheet(sheet)
+	, m_service(service)
 {
-	m_diskThread = new DiskIOThread(this);
         m_lastdoWorkReadTime = get_microseconds();
 	m_stopWork = m_seeking = m_sampleRateChanged = 0;
 	m_resampleQuality = config().get_property("Conversion", "RTResamplingConverterType", DEFAULT_RESAMPLE_QUALITY).toInt();
 	m_readBufferFillStatus = m_writeBufferFillStatus = 0;
 	m_hardDiskOverLoadCounter = 0;
+	m_seekPrefillFrames = 0;
+	m_lastSeekTime = 0;
+	m_active = false;
+	m_readBuffersAllocated = false;
 	
-	// TODO This is a LARGE buffer, any ideas how to make it smaller ??
-	framebuffer[0] = new audio_sample_t[audiodevice().get_sample_rate() * writebuffertime];
-	
-	m_decodebuffer = new DecodeBuffer;
-	m_resampleDecodeBuffer = new DecodeBuffer;
-
         // Move this instance to the workthread
-        moveToThread(m_diskThread);
-        m_workTimer.moveToThread(m_diskThread);
+        moveToThread(m_service->get_thread());
+        m_workTimer.moveToThread(m_service->get_thread());
 
         connect(&m_workTimer, SIGNAL(timeout()), this, SLOT(do_work()));
-
-        m_diskThread->start();
 }
 
 DiskIO::~DiskIO()
 {
 	PENTERDES;
-	stop();
-	delete [] framebuffer[0];
-	delete m_decodebuffer;
-	delete m_resampleDecodeBuffer;
+}
+
+// Internal function, called in the disk thread by DiskIOService::destroy_diskio()
+void DiskIO::release()
+{
+	m_workTimer.stop();
+	m_workTimer.moveToThread(QCoreApplication::instance()->thread());
+	moveToThread(QCoreApplication::instance()->thread());
+}
+
+DecodeBuffer* DiskIO::get_resample_decode_buffer()
+{
+	return m_service->get_resample_decode_buffer();
 }
 
 /**
 * 	Seek's all the ReadSources readbuffers to the new position.
 *	Call prepare_seek() first, to interupt do_work() if it was running.
+*
+*	Only the ReadSources audible at (or shortly after) the new position get
+*	their buffers filled before seekFinished() is emitted, and only with
+*	the first "seekprefillperiods" audio periods. The remaining part of all
+*	buffers is filled afterwards by do_work(), audible sources first.
 * 
 * @param position The position to seek too 
 */
@@ -187,32 +308,72 @@ void DiskIO::seek()
 	Q_ASSERT_X(m_sheet->threadId != QThread::currentThreadId (), "DiskIO::seek", "Error, running in gui thread!!!!!");
 #endif
 
+	trav_time_t seekStartTime = get_microseconds();
+	
 	mutex.lock();
 	
 	m_stopWork = 0;
 	m_seeking = true;
 	
+	int periods = config().get_property("Hardware", "seekprefillperiods", 8).toInt();
+	m_seekPrefillFrames = qMax(1, periods) * audiodevice().get_buffer_size();
+	
 	TimeRef location = m_sheet->get_new_transport_location();
+	TimeRef prefillLength(m_seekPrefillFrames, audiodevice().get_sample_rate());
+	QList<ReadSource*> audibleSources;
+	QList<ReadSource*> otherSources;
 
 	foreach(ReadSource* source, m_readSources) {
 		if (m_sampleRateChanged) {
 			source->set_diskio(this);
 		}
-		source->rb_seek_to_file_position(location);
+		// clips on tracks with plugin latency are played ahead of the
+		// transport, seek them there so that costs no extra buffering.
+		TimeRef sourceLocation = location + source->get_read_ahead();
+		source->rb_seek_to_file_position(sourceLocation);
+		
+		if (source->is_audible_between(sourceLocation, sourceLocation + prefillLength)) {
+			audibleSources.append(source);
+		} else {
+			otherSources.append(source);
+		}
 	}
 	
+	// do_work() processes the sources in this order when their buffers
+	// are equally empty, so the audible ones are refilled first.
+	m_readSources = audibleSources + otherSources;
+	
 	m_sampleRateChanged = false;
 	
+	foreach(ReadSource* source, audibleSources) {
+		if (m_stopWork) {
+			break;
+		}
+		// resyncing sources are filled by do_work()
+		if (source->get_buffer_status()->needSync) {
+			continue;
+		}
+		source->process_ringbuffer(m_service->get_decode_buffer(), m_seeking);
+	}
+	
 	mutex.unlock();
 
-	// Now, fill the buffers like normal
-	do_work();
-	
         t_atomic_int_set(&m_readBufferFillStatus, 0);
 
 	m_seeking = false;
+	
+	m_lastSeekTime = get_microseconds() - seekStartTime;
+	PMESG("DiskIO:: seek prefilled %d of %d sources in %d usecs", audibleSources.size(), m_readSources.size(), int(m_lastSeekTime));
 
 	emit seekFinished();
+	
+	// Now, fill the remaining part of the buffers like normal
+	// while transport is (re)started
+	do_work();
+	
+	if (! m_stopWork) {
+		PMESG("DiskIO:: seek refill finished after %d usecs", int(get_microseconds() - seekStartTime));
+	}
 }
 
 
@@ -247,12 +408,12 @@ void DiskIO::do_work( )
 				return;
 			}
 	
-			source->process_ringbuffer(m_decodebuffer, m_seeking);
+			source->process_ringbuffer(m_service->get_decode_buffer(), m_seeking);
 		}
 		
 		for (int i=0; i<m_processableWriteSources.size(); ++i) {
 			WriteSource* source = m_processableWriteSources.at(i);
-			source->process_ringbuffer(framebuffer[0]);
+			source->process_ringbuffer(m_service->get_framebuffer());
 		}
 		
 		if (whilecount++ > 2000) {
@@ -348,7 +509,7 @@ int DiskIO::there_are_processable_sources( )
 	
 	
 	if (syncSources.size() > 0) { 
-		syncSources.at(0)->sync(m_decodebuffer);
+		syncSources.at(0)->sync(m_service->get_decode_buffer());
 		return 1;
 	}
 	
@@ -357,31 +518,9 @@ int DiskIO::there_are_processable_sources( )
 }
 
 
-// Internal function
-int DiskIO::stop( )
-{
-	PENTER;
-	int res = 0;
-
-	// Stop any processing in do_work()
-	m_stopWork = 1;
-
-	// Exit the diskthreads event loop
-	m_diskThread->exit(0);
-
-	// Wait for the Thread to return from it's event loop. 1000 ms should be (more then) enough,
-	// if not, terminate this thread and print a warning!
-	if ( ! m_diskThread->wait(2000) ) {
-		qWarning("DiskIO :: Still running after 2 second wait, terminating!");
-		m_diskThread->terminate();
-		res = -1;
-	}
-
-	return res;
-}
-
 /**
- *      Registers the ReadSource source. The source's RingBuffer will be initialized at this point.
+ *      Registers the ReadSource source. The source's RingBuffer will be initialized at this point
+ *	if the read buffers of this DiskIO are allocated, see set_active().
  *
  *	Note: This function is thread save. 
  * @param source The ReadSource to register
@@ -394,10 +533,10 @@ void DiskIO::register_read_source (ReadSource* source )
 		return;
 	}
 	
-	source->set_diskio(this);
-	
 	QMutexLocker locker(&mutex);
 
+	source->set_diskio(this);
+	
 	m_readSources.append(source);
 }
 
@@ -510,6 +649,12 @@ int DiskIO::get_read_buffers_fill_status( )
 void DiskIO::start_io( )
 {
 //	Q_ASSERT_X(m_sheet->threadId != QThread::currentThreadId (), "DiskIO::start_io", "Error, running in gui thread!!!!!");
+	// The transport of a Sheet that isn't active can be started
+	// too, e.g. by jack transport, it needs its read buffers then.
+	mutex.lock();
+	allocate_read_buffers();
+	mutex.unlock();
+	
         m_workTimer.start(UPDATE_INTERVAL);
 }
 
@@ -517,6 +662,60 @@ void DiskIO::stop_io( )
 {
 //	Q_ASSERT_X(m_sheet->threadId != QThread::currentThreadId (), "DiskIO::stop_io", "Error, running in gui thread!!!!!");
 // 	m_workTimer.stop();
+	QMutexLocker locker(&mutex);
+	
+	if (!m_active && !m_sheet->is_transport_rolling()) {
+		free_read_buffers();
+	}
+}
+
+/**
+ * 	Allocates the read buffers of all ReadSources when \a active, frees them
+ *	otherwise. The Project only keeps the buffers of its active Sheet, so
+ *	Sheets that are never played don't hold a second of audio per clip.
+ *	The buffers of a Sheet with a rolling transport are freed when it stops.
+ */
+void DiskIO::set_active(bool active)
+{
+	PENTER;
+	
+	QMutexLocker locker(&mutex);
+	
+	m_active = active;
+	
+	if (m_active) {
+		allocate_read_buffers();
+	} else if (!m_sheet->is_transport_rolling()) {
+		free_read_buffers();
+	}
+}
+
+// Internal function, call with mutex locked
+void DiskIO::allocate_read_buffers()
+{
+	if (m_readBuffersAllocated) {
+		return;
+	}
+	
+	m_readBuffersAllocated = true;
+	
+	foreach(ReadSource* source, m_readSources) {
+		source->prepare_rt_buffers();
+	}
+}
+
+// Internal function, call with mutex locked
+void DiskIO::free_read_buffers()
+{
+	if (!m_readBuffersAllocated) {
+		return;
+	}
+	
+	m_readBuffersAllocated = false;
+	
+	foreach(ReadSource* source, m_readSources) {
+		source->free_rt_buffers();
+	}
 }
 
 void DiskIO::set_resample_quality(int quality)
@@ -29,10 +29,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include "defines.h"
 
+class QThread;
 class ReadSource;
 class WriteSource;
 class AudioSource;
 class DiskIOThread;
+class DiskIOService;
 class Sheet;
 class DecodeBuffer;
 
@@ -48,7 +50,7 @@ class DiskIO : public QObject
 	Q_OBJECT
 
 public:
-	DiskIO(Sheet* sheet);
+	DiskIO(Sheet* sheet, DiskIOService* service);
 	~DiskIO();
 	
 	static const int writebuffertime = 5;
@@ -56,6 +58,7 @@ public:
 
 	void prepare_for_seek();
 	void output_rate_changed(int rate);
+	void set_active(bool active);
 
 	void register_read_source(ReadSource* source);
 	void register_write_source(WriteSource* source);
@@ -70,10 +73,14 @@ public:
 	int get_read_buffers_fill_status();
 	int get_output_rate() {return m_outputRate;}
 	int get_resample_quality() {return m_resampleQuality;}
-	DecodeBuffer* get_resample_decode_buffer() {return m_resampleDecodeBuffer;}
+	nframes_t get_seek_prefill_frames() const {return m_seekPrefillFrames;}
+	trav_time_t get_last_seek_time() const {return m_lastSeekTime;}
+	bool read_buffers_allocated() const {return m_readBuffersAllocated;}
+	DecodeBuffer* get_resample_decode_buffer();
 
 private:
 	Sheet* 			m_sheet;
+	DiskIOService*		m_service;
 	volatile size_t		m_stopWork;
 	QList<ReadSource*>	m_readSources;
 	QList<WriteSource*>	m_writeSources;
@@ -81,7 +88,6 @@ private:
 	QList<WriteSource*>	m_processableWriteSources;
 	QList<QPair<BufferStatus*, ReadSource*> > m_readersStatus;
 	QList<QPair<int, WriteSource*> > m_writersStatus;
-	DiskIOThread*		m_diskThread;
         QTimer			m_workTimer;
         QMutex			mutex;
 	volatile int		m_readBufferFillStatus;
@@ -93,20 +99,19 @@ private:
 	int			m_resampleQuality;
 	bool			m_sampleRateChanged;
 	int			m_hardDiskOverLoadCounter;
-	audio_sample_t*		framebuffer[2];
-	audio_sample_t*		m_readbuffer;
-	DecodeBuffer*		m_decodebuffer;
-	DecodeBuffer*		m_resampleDecodeBuffer;
 	int			m_outputRate;
+	nframes_t		m_seekPrefillFrames;
+	trav_time_t		m_lastSeekTime;
+	bool			m_active;
+	bool			m_readBuffersAllocated;
 
 	
 	void update_time_usage();
+	void allocate_read_buffers();
+	void free_read_buffers();
 	
-        int stop();
 	int there_are_processable_sources();
 
-	friend class DiskIOThread;
-
 public slots:
 	void seek();
 	void start_io();
@@ -114,6 +119,7 @@ public slots:
 
 private slots:
         void do_work();
+	void release();
 
 signals:
 	void seekFinished();
@@ -122,6 +128,38 @@ signals:
 
 };
 
+
+/**
+ * Runs the one disk thread shared by the DiskIO instances of all the Sheets
+ * of a Project, and owns the buffers they process their sources with.
+ * The DiskIO instances are created and destroyed through the service, they
+ * all live in its thread so their work is never done concurrently.
+ */
+class DiskIOService
+{
+public:
+	DiskIOService();
+	~DiskIOService();
+	
+	DiskIO* create_diskio(Sheet* sheet);
+	void destroy_diskio(DiskIO* diskio);
+	
+	QThread* get_thread() const;
+	audio_sample_t* get_framebuffer();
+	DecodeBuffer* get_decode_buffer() const {return m_decodebuffer;}
+	DecodeBuffer* get_resample_decode_buffer() const {return m_resampleDecodeBuffer;}
+	
+private:
+	DiskIOThread*		m_diskThread;
+	QList<DiskIO*>		m_diskios;
+	audio_sample_t*		m_framebuffer;
+	nframes_t		m_framebufferSize;
+	DecodeBuffer*		m_decodebuffer;
+	DecodeBuffer*		m_resampleDecodeBuffer;
+	
+	int stop();
+};
+
 #endif
 
 //eof
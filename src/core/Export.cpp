@@ -78,6 +78,7 @@ ExportSpecification::ExportSpecification()
 	normvalue = 1.0;
 	peakvalue = 0.0;
 	isCdExport = false;
+	freewheel = false;
 }
 
 int ExportSpecification::is_valid()
@@ -92,6 +92,7 @@ struct ExportSpecification
 	TimeRef		resumeTransportLocation;
 	bool		renderfinished;
 	bool		isCdExport;
+	bool		freewheel; /* render in the audio thread, driver freewheeling */
         QList<Marker*>  markers;
 	
 	ExportThread* 	thread;
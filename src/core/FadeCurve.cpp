@@ -32,6 +32,7 @@ $Id: FadeCurve.cpp,v 1.36 2008/11/07 10:43:08 r_sijrier Exp $
 #include <AddRemove.h>
 #include "AudioDevice.h"
 #include "AudioBus.h"
+#include "TScratchArena.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -167,7 +168,7 @@ int FadeCurve::set_state( const QDomNode & node )
 }
 
 
-void FadeCurve::process(AudioBus *bus, nframes_t nframes)
+void FadeCurve::process(audio_sample_t** buffers, uint channels, nframes_t nframes)
 {
 
         if (is_bypassed()) {
@@ -175,7 +176,14 @@ void FadeCurve::process(AudioBus *bus, nframes_t nframes)
 	}
 	
 	
-        audio_sample_t* mixdown[bus->get_channel_count()];
+        TScratchArena::Scope scratch;
+        audio_sample_t** mixdown = scratch.allocate<audio_sample_t*>(channels);
+        audio_sample_t* gains = scratch.allocate<audio_sample_t>(nframes);
+
+        if (!mixdown || !gains) {
+                return;
+        }
+
         int outputRate = audiodevice().get_sample_rate();
         uint framesToProcess = nframes;
 
@@ -204,16 +212,15 @@ void FadeCurve::process(AudioBus *bus, nframes_t nframes)
                         mix_pos = TimeRef();
 //                        printf("offset %d\n", offset);
 
-                        for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-                                audio_sample_t* buf = bus->get_buffer(chan, framesToProcess);
-                                mixdown[chan] = buf + offset;
+                        for (uint chan=0; chan<channels; ++chan) {
+                                mixdown[chan] = buffers[chan] + offset;
                         }
                         framesToProcess = framesToProcess - offset;
                 } else {
                         mix_pos = (transportLocation - trackStartLocation);
 
-                        for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-                                mixdown[chan] = bus->get_buffer(chan, framesToProcess);
+                        for (uint chan=0; chan<channels; ++chan) {
+                                mixdown[chan] = buffers[chan];
                         }
                 }
                 if (trackEndLocation < upperRange) {
@@ -230,11 +237,11 @@ void FadeCurve::process(AudioBus *bus, nframes_t nframes)
 
         upperRange = mix_pos + TimeRef(framesToProcess, outputRate);
 
-        get_vector(mix_pos.universal_frame(), upperRange.universal_frame(), m_session->gainbuffer, framesToProcess);
+        get_vector(mix_pos.universal_frame(), upperRange.universal_frame(), gains, framesToProcess);
 
-        for (int chan=0; chan<bus->get_channel_count(); ++chan) {
+        for (uint chan=0; chan<channels; ++chan) {
                 for (nframes_t frame = 0; frame < framesToProcess; ++frame) {
-                        mixdown[chan][frame] *= m_session->gainbuffer[frame];
+                        mixdown[chan][frame] *= gains[frame];
                 }
         }
 }
@@ -36,8 +36,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Debugger.h"
 
 #define NORMALIZE_CHUNK_SIZE	10000
+// version of the legacy one file per channel peak files
 #define PEAKFILE_MAJOR_VERSION	1
 #define PEAKFILE_MINOR_VERSION	4
+// the first cached level stored 8 bit log scaled (8192 frames per peak)
+#define FIRST_COMPACT_LEVEL	7
 
 int Peak::zoomStep[] = {
 	// non-cached zoomlevels.
@@ -46,13 +49,16 @@ int Peak::zoomStep[] = {
  	64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576 
 };
 
-QHash<int, int> Peak::chacheIndexLut;
+// filled before main(), the waveform render threads read it concurrently
+QHash<int, int> Peak::chacheIndexLut = Peak::calculate_lut_data();
+Peak::ReleaseFunction Peak::releaseFunction = 0;
 
 Peak::Peak(AudioSource* source)
 {
 	PENTERCONS;
 	
 	m_peaksAvailable = m_permanentFailure = m_interuptPeakBuild = false;
+	m_decodeBuffer = 0;
 	
 	QString sourcename = source->get_name();
 	QString path;
@@ -64,13 +70,17 @@ Peak::Peak(AudioSource* source)
 		path = path.replace("audiosources", "peakfiles");
 	}
 	
+	m_peakFileName = path + sourcename + ".tpk";
+	m_sourceFileName = source->get_filename();
+	
 	for (uint chan = 0; chan < source->get_channel_count(); ++ chan) {
 		ChannelData* data = new Peak::ChannelData;
 		
-		data->fileName = sourcename + "-ch" + QByteArray::number(chan) + ".peak";
-		data->fileName.prepend(path);
+		data->legacyFileName = sourcename + "-ch" + QByteArray::number(chan) + ".peak";
+		data->legacyFileName.prepend(path);
+		data->tempFileName = data->legacyFileName + ".tmp";
+		data->normFileName = data->legacyFileName + ".norm";
 		data->pd = 0;
-		data->peakreader = 0;
 		
 		m_channelData.append(data);
 	}
@@ -85,40 +95,49 @@ Peak::Peak(AudioSource* source)
 		// peak data creation, no m_source needed!
 		m_source = 0;
 	}
+
+	m_microViewCache.setMaxCost(MICROVIEW_CACHE_SIZE);
 }
 
 Peak::~Peak()
 {
 	PENTERDES;
 	
+	if (releaseFunction) {
+		releaseFunction(this);
+	}
+	
 	if (m_source) {
 		delete m_source;
 	}
 	
 	foreach(ChannelData* data, m_channelData) {
+		// an interrupted build leaves its temporary files behind
+		if (data->file.isOpen()) {
+			data->file.close();
+			QFile::remove(data->tempFileName);
+		}
 		if (data->normFile.isOpen()) {
+			data->normFile.close();
 			QFile::remove(data->normFileName);
 		}
-#if QT_VERSION < 0x040400
-#if defined Q_WS_X11 || defined Q_WS_MAC
-		if (data->memory) {
-			uchar *start = data->memory - data->maps[data->memory].first;
-			int len = data->maps[data->memory].second;
-			if (-1 == munmap(start, len)) {
-			}
-			data->maps.remove(data->memory);
-		}
-#endif
-#endif
-		if (data->peakreader) {
-			delete data->peakreader;
+		if (data->pd) {
+			delete data->pd;
 		}
 		delete data;
 	}
+	
+	if (m_decodeBuffer) {
+		delete m_decodeBuffer;
+	}
 }
 
 void Peak::close()
 {
+	if (releaseFunction) {
+		releaseFunction(this);
+	}
+	
 	pp().free_peak(this);
 }
 
@@ -128,88 +147,28 @@ int Peak::read_header()
 	
 	Q_ASSERT(m_source);
 	
-	foreach(ChannelData* data, m_channelData) {
-		
-		data->file.setFileName(data->fileName);
-		
-		if (! data->file.open(QIODevice::ReadOnly)) {
-			if (QFile::exists(data->fileName)) {
-				m_permanentFailure = true;
-			}
-				
-			QString errorstring = FileHelper::fileerror_to_string(data->file.error());
-			qWarning("Couldn't open peak file for reading! (%s, Error: %s)", QS_C(data->fileName), QS_C(errorstring));
-			return -1;
-		}
-		
-		QFileInfo file(m_source->get_filename());
-		QFileInfo peakFile(data->fileName);
-		
-		QDateTime fileModTime = file.lastModified();
-		QDateTime peakModTime = peakFile.lastModified();
-		
-		if (fileModTime > peakModTime) {
-			PERROR("Source and Peak file modification time do not match");
-			printf("SourceFile modification time is %s\n", fileModTime.toString().toAscii().data());
-			printf("PeakFile modification time is %s\n", peakModTime.toString().toAscii().data());
-			return -1;
-		}
-		
-		
-		data->file.seek(0);
+	// without the source there is nothing to check the peak file against
+	if (!QFile::exists(m_sourceFileName)) {
+		PERROR("Peak: source file %s doesn't exist (anymore)", QS_C(m_sourceFileName));
+		return -1;
+	}
 	
-		data->file.read(data->headerdata.label, sizeof(data->headerdata.label));
-		data->file.read((char*)data->headerdata.version, sizeof(data->headerdata.version));
-	
-		if (	(data->headerdata.label[0]!='T') ||
-			(data->headerdata.label[1]!='R') ||
-			(data->headerdata.label[2]!='A') ||
-			(data->headerdata.label[3]!='V') ||
-			(data->headerdata.label[4]!='P') ||
-			(data->headerdata.label[5]!='F') ||
-			(data->headerdata.version[0] != PEAKFILE_MAJOR_VERSION) ||
-			(data->headerdata.version[1] != PEAKFILE_MINOR_VERSION)) {
-				printf("This file either isn't a Traverso Peak file, or the version doesn't match!\n");
-				data->file.close();
-				return -1;
+	if (m_peakFile.open(m_peakFileName, TPeakFile::source_fingerprint(m_sourceFileName)) < 0) {
+		if (QFile::exists(m_peakFileName) && !QFileInfo(m_peakFileName).isReadable()) {
+			m_permanentFailure = true;
+			qWarning("Couldn't open peak file for reading! (%s)", QS_C(m_peakFileName));
 		}
-		
-		data->file.read((char*)data->headerdata.peakDataOffsets, sizeof(data->headerdata.peakDataOffsets));
-		data->file.read((char*)data->headerdata.peakDataSizeForLevel, sizeof(data->headerdata.peakDataSizeForLevel));
-		data->file.read((char*)&data->headerdata.normValuesDataOffset, sizeof(data->headerdata.normValuesDataOffset));
-		data->file.read((char*)&data->headerdata.headerSize, sizeof(data->headerdata.headerSize));
-		
-		data->peakreader = new PeakDataReader(data);
-		data->peakdataDecodeBuffer = new DecodeBuffer;
+		return -1;
 	}
 	
-	m_peaksAvailable = true;
-		
-	return 1;
-}
-
-int Peak::write_header(ChannelData* data)
-{
-	PENTER;
-	
-	data->file.seek(0);
-
-	data->headerdata.label[0] = 'T';
-	data->headerdata.label[1] = 'R';
-	data->headerdata.label[2] = 'A';
-	data->headerdata.label[3] = 'V';
-	data->headerdata.label[4] = 'P';
-	data->headerdata.label[5] = 'F';
-	data->headerdata.version[0] = PEAKFILE_MAJOR_VERSION;
-	data->headerdata.version[1] = PEAKFILE_MINOR_VERSION;
+	if (!m_decodeBuffer) {
+		m_decodeBuffer = new DecodeBuffer;
+	}
 	
-	data->file.write((char*)data->headerdata.label, sizeof(data->headerdata.label));
-	data->file.write((char*)data->headerdata.version, sizeof(data->headerdata.version));
-	data->file.write((char*)data->headerdata.peakDataOffsets, sizeof(data->headerdata.peakDataOffsets));
-	data->file.write((char*)data->headerdata.peakDataSizeForLevel, sizeof(data->headerdata.peakDataSizeForLevel));
-	data->file.write((char*) &data->headerdata.normValuesDataOffset, sizeof(data->headerdata.normValuesDataOffset));
-	data->file.write((char*) &data->headerdata.headerSize, sizeof(data->headerdata.headerSize));
+	build_max_amplitude_index();
 	
+	m_peaksAvailable = true;
+		
 	return 1;
 }
 
@@ -220,6 +179,26 @@ void Peak::start_peak_loading()
 }
 
 
+/**
+ * Thread save variant of calculate_peaks(), copies the peak data into \a buffer
+ * which must be able to hold \a peakDataCount values.
+ * @return The amount of peak data copied, or one of NO_PEAKDATA_FOUND, NO_PEAK_FILE
+ *	or PERMANENT_FAILURE
+ */
+int Peak::read_peaks(int chan, float* buffer, TimeRef startlocation, int peakDataCount, qreal framesPerPeak)
+{
+	QMutexLocker locker(&m_readMutex);
+
+	float* peakdata;
+	int produced = calculate_peaks(chan, &peakdata, startlocation, peakDataCount, framesPerPeak);
+
+	if (produced > 0) {
+		memcpy(buffer, peakdata, qMin(produced, peakDataCount) * sizeof(float));
+	}
+
+	return produced;
+}
+
 int Peak::calculate_peaks(
 	int chan,
 	float ** buffer,
@@ -243,7 +222,6 @@ int Peak::calculate_peaks(
 		return NO_PEAKDATA_FOUND;
 	}
 	
-	ChannelData* data = m_channelData.at(chan);
 	int produced = 0;
 	
 // 	PROFILE_START;
@@ -256,25 +234,20 @@ int Peak::calculate_peaks(
 			return NO_PEAKDATA_FOUND;
 		}
 		
-		
 		nframes_t startPos = startlocation.to_frame(44100);
 		
 		int index = cache_index_lut()->value(nearestpow2, -1);
-		if(index >= 0) {
-// 			printf("index %d\n", index);
+		if (index < 0) {
+			return NO_PEAKDATA_FOUND;
 		}
 		
-		int offset = qRound(startPos / nearestpow2) * 2;
-        int truncate = 0;
-
-		// Check if this zoom level has as many data as requested.
-		if ( (peakDataCount + offset) > data->headerdata.peakDataSizeForLevel[index]) {
-			truncate = peakDataCount - (data->headerdata.peakDataSizeForLevel[index] - offset);
-// 			pixelcount = data->headerdata.peakDataSizeForLevel[index] - offset;
+		int offset = (startPos / nearestpow2) * 2;
+		
+		if (m_peakData.size() < peakDataCount) {
+			m_peakData.resize(peakDataCount);
 		}
 		
-		nframes_t readposition = data->headerdata.headerSize + (data->headerdata.peakDataOffsets[index] + offset) * sizeof(peak_data_t);
-		produced = data->peakreader->read_from(data->peakdataDecodeBuffer, readposition, peakDataCount);
+		produced = m_peakFile.read_peaks(chan, index, offset, peakDataCount, m_peakData.data());
 		
 		if (produced != peakDataCount) {
 			PERROR("Could not read in all peak data, peakDataCount is %d, read count is %d", peakDataCount, produced);
@@ -286,87 +259,233 @@ int Peak::calculate_peaks(
 			return NO_PEAKDATA_FOUND;
 		}
 		
-// 		for (int i=(pixelcount-truncate); i<(pixelcount); ++i) {
-// 			data->peakdataDecodeBuffer->destination[0][i] = 0;
-// 		}
-// 		
-		*buffer = data->peakdataDecodeBuffer->destination[0];
+		*buffer = m_peakData.data();
 		
 		return produced;
 
 	// Micro view mode
 	} else {
-		// Calculate the amount of frames to be read
-                nframes_t toRead = qRound(peakDataCount * framesPerPeak * qreal(m_source->get_file_rate()) / qreal(44100));
-		
-		nframes_t readFrames = m_source->file_read(data->peakdataDecodeBuffer, startlocation, toRead);
+		produced = calculate_micro_view_peaks(chan, startlocation, peakDataCount, framesPerPeak);
 
-		if (readFrames == 0) {
+		if (produced == 0) {
 			return NO_PEAKDATA_FOUND;
 		}
-		
-		if ( readFrames != toRead) {
-			PWARN("Unable to read nframes %d (only %d available)", toRead, readFrames);
+
+		*buffer = m_peakData.data();
+
+		return produced;
+	}
+
+	return 0;
+}
+
+
+static inline void scan_samples(const audio_sample_t* samples, int from, int to, audio_sample_t& upper, audio_sample_t& lower)
+{
+	for (int i=from; i<to; ++i) {
+		if (samples[i] > upper) {
+			upper = samples[i];
+		}
+		if (samples[i] < lower) {
+			lower = samples[i];
 		}
+	}
+}
 
-		int count = 0;
-		audio_sample_t sample;
-		
-		// MicroView needs a buffer to store the calculated peakdata
-		// our decodebuffer's readbuffer is large enough for this purpose
-		// and it's no problem to use it at this point in the process chain.
-		float* peakdata = data->peakdataDecodeBuffer->readBuffer;
+/**
+ * Returns the cached micro view block \a index, decoding it and building
+ * its peak pyramid if it isn't cached (anymore).
+ * The returned block is only valid till the next call, as inserting a new
+ * block can push older ones out of the cache.
+ */
+Peak::MicroViewBlock* Peak::get_micro_view_block(qint64 index)
+{
+	MicroViewBlock* block = m_microViewCache.object(index);
+	if (block) {
+		return block;
+	}
 
-		ProcessData pd;
-		// the stepSize depends on the real file sample rate, Peak assumes 44100 Hz
-		// so if the file sample rate differs, the stepSize becomes the ratio of 
-		// the file sample rate and 44100
-		pd.stepSize = TimeRef(qreal(44100) / m_source->get_file_rate(), m_source->get_file_rate());
-		pd.processRange = TimeRef(framesPerPeak, m_source->get_file_rate());
+	int channels = m_channelData.size();
+	DecodeBuffer* decodeBuffer = m_decodeBuffer;
+	TimeRef location(nframes_t(index * MICROVIEW_BLOCK_SIZE), m_source->get_file_rate());
 
-		for (uint i=0; i < readFrames; i++) {
-		
-			pd.processLocation += pd.stepSize;
-		
-			sample = data->peakdataDecodeBuffer->destination[chan][i];
-		
-			pd.normValue = f_max(pd.normValue, fabsf(sample));
-		
-			if (sample > pd.peakUpperValue) {
-				pd.peakUpperValue = sample;
+	nframes_t readFrames = m_source->file_read(decodeBuffer, location, MICROVIEW_BLOCK_SIZE);
+	if (readFrames == 0) {
+		return 0;
+	}
+
+	block = new MicroViewBlock;
+	block->frames = readFrames;
+	block->samples.resize(channels * MICROVIEW_BLOCK_SIZE);
+	int cost = block->samples.size();
+
+	for (int chan=0; chan<channels; ++chan) {
+		memcpy(block->samples.data() + chan * MICROVIEW_BLOCK_SIZE, decodeBuffer->destination[chan], readFrames * sizeof(audio_sample_t));
+	}
+
+	// the first level is build from the samples, each next level from
+	// the previous one. The last bucket of a level can be partial, it's
+	// never used as a whole by scan_micro_view_range() though.
+	for (int level=0; level<MICROVIEW_LEVELS; ++level) {
+		int bucketSize = MICROVIEW_FIRST_BUCKET_SIZE << level;
+		int stride = MICROVIEW_BLOCK_SIZE / bucketSize;
+		int buckets = (readFrames + bucketSize - 1) / bucketSize;
+
+		block->maxima[level].resize(channels * stride);
+		block->minima[level].resize(channels * stride);
+		cost += 2 * channels * stride;
+
+		for (int chan=0; chan<channels; ++chan) {
+			audio_sample_t* maxima = block->maxima[level].data() + chan * stride;
+			audio_sample_t* minima = block->minima[level].data() + chan * stride;
+
+			if (level == 0) {
+				const audio_sample_t* samples = block->samples.constData() + chan * MICROVIEW_BLOCK_SIZE;
+				for (int b=0; b<buckets; ++b) {
+					audio_sample_t upper = -10.0;
+					audio_sample_t lower = 10.0;
+					scan_samples(samples, b * bucketSize, qMin(nframes_t((b + 1) * bucketSize), readFrames), upper, lower);
+					maxima[b] = upper;
+					minima[b] = lower;
+				}
+				continue;
 			}
-		
-			if (sample < pd.peakLowerValue) {
-				pd.peakLowerValue = sample;
+
+			int prevStride = stride * 2;
+			int prevBuckets = (readFrames + (bucketSize / 2) - 1) / (bucketSize / 2);
+			const audio_sample_t* prevMaxima = block->maxima[level - 1].constData() + chan * prevStride;
+			const audio_sample_t* prevMinima = block->minima[level - 1].constData() + chan * prevStride;
+
+			for (int b=0; b<buckets; ++b) {
+				maxima[b] = prevMaxima[2 * b];
+				minima[b] = prevMinima[2 * b];
+				if (2 * b + 1 < prevBuckets) {
+					maxima[b] = f_max(maxima[b], prevMaxima[2 * b + 1]);
+					if (prevMinima[2 * b + 1] < minima[b]) {
+						minima[b] = prevMinima[2 * b + 1];
+					}
+				}
 			}
-		
-			if (pd.processLocation >= pd.nextDataPointLocation) {
-		
-				if (pd.peakUpperValue > fabs(pd.peakLowerValue)) {
-					peakdata[count] = pd.peakUpperValue;
-				} else {
-					peakdata[count] = pd.peakLowerValue;
+		}
+	}
+
+	m_microViewCache.insert(index, block, qMax(1, int(cost * sizeof(audio_sample_t) / 1024)));
+
+	return block;
+}
+
+/**
+ * Updates \a upper and \a lower with the extremes of the frames in [start, end)
+ * of channel \a chan, using the buckets of pyramid \a level (or only samples
+ * if \a level < 0) for the part of the range they fully cover.
+ * @return false if not all frames in the range could be read.
+ */
+bool Peak::scan_micro_view_range(int chan, qint64 start, qint64 end, int level, audio_sample_t& upper, audio_sample_t& lower)
+{
+	while (start < end) {
+		qint64 index = start / MICROVIEW_BLOCK_SIZE;
+		MicroViewBlock* block = get_micro_view_block(index);
+		if (!block) {
+			return false;
+		}
+
+		qint64 blockStart = index * MICROVIEW_BLOCK_SIZE;
+		int from = int(start - blockStart);
+		int to = int(qMin(end - blockStart, qint64(block->frames)));
+		if (from >= to) {
+			// end of the source reached
+			return false;
+		}
+
+		const audio_sample_t* samples = block->samples.constData() + chan * MICROVIEW_BLOCK_SIZE;
+		int firstBucket = 0;
+		int lastBucket = 0;
+
+		if (level >= 0) {
+			int bucketSize = MICROVIEW_FIRST_BUCKET_SIZE << level;
+			firstBucket = (from + bucketSize - 1) / bucketSize;
+			lastBucket = to / bucketSize;
+
+			if (firstBucket < lastBucket) {
+				int stride = MICROVIEW_BLOCK_SIZE / bucketSize;
+				const audio_sample_t* maxima = block->maxima[level].constData() + chan * stride;
+				const audio_sample_t* minima = block->minima[level].constData() + chan * stride;
+
+				for (int b=firstBucket; b<lastBucket; ++b) {
+					upper = f_max(upper, maxima[b]);
+					if (minima[b] < lower) {
+						lower = minima[b];
+					}
 				}
-				
-				pd.peakUpperValue = -10.0;
-				pd.peakLowerValue = 10.0;
-			
-				pd.nextDataPointLocation += pd.processRange;
-				count++;
+
+				// the unaligned head and tail
+				scan_samples(samples, from, firstBucket * bucketSize, upper, lower);
+				scan_samples(samples, lastBucket * bucketSize, to, upper, lower);
 			}
 		}
-		
-// 		printf("framesPerPeak, peakDataCount, generated, readFrames %f, %d, %d, %d\n", framesPerPeak, peakDataCount, count, readFrames);
-		
-// 		PROFILE_END("Peak calculate_peaks");		
-		
-		// Assign the supplied buffer to the 'real' peakdata buffer.
-		*buffer = peakdata;
-		
-		return count;
+
+		if (firstBucket >= lastBucket) {
+			scan_samples(samples, from, to, upper, lower);
+		}
+
+		start = blockStart + to;
 	}
 
-	return 0;
+	return true;
+}
+
+/**
+ * Calculates the micro view peak data from the micro view cache into
+ * m_peakData. Each peak value is the sample with the largest
+ * magnitude of the frames it covers.
+ * @return The amount of peak data calculated.
+ */
+int Peak::calculate_micro_view_peaks(int chan, TimeRef startlocation, int peakDataCount, qreal framesPerPeak)
+{
+	int rate = m_source->get_file_rate();
+	// Peak assumes 44100 Hz, so if the file sample rate differs
+	// the frames per peak scale with the ratio of both.
+	qreal fileFramesPerPeak = framesPerPeak * qreal(rate) / qreal(44100);
+	qint64 startFrame = startlocation.to_frame(rate);
+
+	// use the coarsest pyramid level that still has 2 buckets per peak,
+	// at the deepest zoom levels the samples are used directly.
+	int level = -1;
+	for (int l=MICROVIEW_LEVELS - 1; l>=0; --l) {
+		if (2 * (MICROVIEW_FIRST_BUCKET_SIZE << l) <= fileFramesPerPeak) {
+			level = l;
+			break;
+		}
+	}
+
+	if (m_peakData.size() < peakDataCount) {
+		m_peakData.resize(peakDataCount);
+	}
+	float* peakdata = m_peakData.data();
+
+	int count = 0;
+	for (; count < peakDataCount; ++count) {
+		qint64 from = startFrame + qint64(ceil(count * fileFramesPerPeak));
+		qint64 to = startFrame + qint64(ceil((count + 1) * fileFramesPerPeak));
+		if (to <= from) {
+			to = from + 1;
+		}
+
+		audio_sample_t upper = -10.0;
+		audio_sample_t lower = 10.0;
+
+		if (!scan_micro_view_range(chan, from, to, level, upper, lower)) {
+			break;
+		}
+
+		if (upper > fabsf(lower)) {
+			peakdata[count] = upper;
+		} else {
+			peakdata[count] = lower;
+		}
+	}
+
+	return count;
 }
 
 
@@ -375,56 +494,109 @@ int Peak::prepare_processing(int rate)
 	PENTER;
 	
 	foreach(ChannelData* data, m_channelData) {
-		
-		data->normFileName = data->fileName;
-		data->normFileName.append(".norm");
-		
-		// Create read/write enabled file
-		data->file.setFileName(data->fileName);
-		
-		if (! data->file.open(QIODevice::ReadWrite)) {
-			PWARN("Couldn't open peak file for writing! (%s)", data->fileName.toAscii().data());
+
+		// Create the temporary peak data file, only the first cached
+		// zoom level is written to it during processing
+		data->file.setFileName(data->tempFileName);
+
+		if (! data->file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+			PWARN("Couldn't open peak file for writing! (%s)", data->tempFileName.toAscii().data());
 			m_permanentFailure  = true;
 			return -1;
 		}
-		
+
 		// Create the temporary normalization data file
 		data->normFile.setFileName(data->normFileName);
-		
-		if (! data->normFile.open(QIODevice::ReadWrite)) {
+
+		if (! data->normFile.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
 			PWARN("Couldn't open normalization data file for writing! (%s)", data->normFileName.toAscii().data());
 			m_permanentFailure  = true;
 			return -1;
 		}
-		
-		// We need to know the headerSize.
-		data->headerdata.headerSize = 
-					sizeof(data->headerdata.label) + 
-					sizeof(data->headerdata.version) + 
-					sizeof(data->headerdata.peakDataOffsets) + 
-					sizeof(data->headerdata.peakDataSizeForLevel) +
-					sizeof(data->headerdata.normValuesDataOffset) + 
-					sizeof(data->headerdata.headerSize);
-					
-		// Now seek to the start position, so we can write the peakdata to it in the process function
-		data->file.seek(data->headerdata.headerSize);
-		
+
 		data->pd = new Peak::ProcessData;
 		data->pd->stepSize = TimeRef(nframes_t(1), rate);
 		data->pd->processRange = TimeRef(nframes_t(64), 44100);
 	}
-	
-	
+
+
 	return 1;
 }
 
 
+/**
+ * Appends the zoom levels following the first one to \a levels, each level
+ * having half the size of the previous one. Peak data is stored as pairs of
+ * upper and (negated) lower values, every pair of a level holds the maxima
+ * of 2 pairs of the previous level.
+ */
+void Peak::build_levels(QList<QVector<peak_data_t> >& levels)
+{
+	while (levels.size() < CACHED_ZOOM_LEVELS) {
+		const QVector<peak_data_t> prev = levels.last();
+		int prevPairs = prev.size() / 2;
+		QVector<peak_data_t> next(((prevPairs + 1) / 2) * 2);
+
+		for (int pair=0; pair<prevPairs; pair+=2) {
+			peak_data_t upper = prev.at(pair * 2);
+			peak_data_t lower = prev.at(pair * 2 + 1);
+
+			if (pair + 1 < prevPairs) {
+				upper = qMax(upper, prev.at(pair * 2 + 2));
+				lower = qMax(lower, prev.at(pair * 2 + 3));
+			}
+
+			next[pair] = upper;
+			next[pair + 1] = lower;
+		}
+
+		levels.append(next);
+	}
+}
+
+
+/**
+ * Builds the cached zoom levels from the first level of each channel in
+ * \a channelLevels and writes them, together with \a channelNormValues,
+ * to the peak file of this Peak.
+ */
+int Peak::write_peak_file(QList<QList<QVector<peak_data_t> > >& channelLevels, QList<QVector<audio_sample_t> >& channelNormValues)
+{
+	// all channels need the same amount of normalization data
+	int normDataCount = channelNormValues.at(0).size();
+	for (int chan=1; chan<channelNormValues.size(); ++chan) {
+		normDataCount = qMin(normDataCount, channelNormValues.at(chan).size());
+	}
+
+	for (int chan=0; chan<channelLevels.size(); ++chan) {
+		build_levels(channelLevels[chan]);
+		channelNormValues[chan].resize(normDataCount);
+	}
+
+	if (!QFile::exists(m_sourceFileName)) {
+		PERROR("Peak: source file %s doesn't exist (anymore), not writing %s", QS_C(m_sourceFileName), QS_C(m_peakFileName));
+		return -1;
+	}
+	
+	int firstCompactLevel = CACHED_ZOOM_LEVELS;
+	if (config().get_property("Peaks", "CompactCoarseLevels", true).toBool()) {
+		firstCompactLevel = FIRST_COMPACT_LEVEL;
+	}
+
+	return TPeakFile::write(m_peakFileName, TPeakFile::source_fingerprint(m_sourceFileName),
+				channelLevels, channelNormValues, firstCompactLevel);
+}
+
+
 int Peak::finish_processing()
 {
 	PENTER;
-	
+
+	QList<QList<QVector<peak_data_t> > > channelLevels;
+	QList<QVector<audio_sample_t> > channelNormValues;
+
 	foreach(ChannelData* data, m_channelData) {
-		
+
 		if (data->pd->processLocation < data->pd->nextDataPointLocation) {
 			peak_data_t peakvalue = (peak_data_t)(data->pd->peakUpperValue * MAX_DB_VALUE);
 			data->file.write((char*)&peakvalue, sizeof(peak_data_t));
@@ -432,99 +604,145 @@ int Peak::finish_processing()
 			data->file.write((char*)&peakvalue, sizeof(peak_data_t));
 			data->pd->processBufferSize += 2;
 		}
-		
-		int totalBufferSize = 0;
-		
-		data->headerdata.peakDataSizeForLevel[0] = data->pd->processBufferSize;
-		totalBufferSize += data->pd->processBufferSize;
-		
-		for( int i = SAVING_ZOOM_FACTOR + 1; i < ZOOM_LEVELS+1; ++i) {
-			data->headerdata.peakDataSizeForLevel[i - SAVING_ZOOM_FACTOR] = data->headerdata.peakDataSizeForLevel[i - SAVING_ZOOM_FACTOR - 1] / 2;
-			totalBufferSize += data->headerdata.peakDataSizeForLevel[i - SAVING_ZOOM_FACTOR];
-		}
-		
-		
-		data->file.seek(data->headerdata.headerSize);
-		
-		// The routine below uses a different total buffer size calculation
-		// which might end up with a size >= totalbufferSize !!!
-		// Need to look into that, for now + 2 seems to work...
-		peak_data_t* saveBuffer = new peak_data_t[totalBufferSize + 1*sizeof(peak_data_t)];
-		
-		int read = data->file.read((char*)saveBuffer, sizeof(peak_data_t) * data->pd->processBufferSize) / sizeof(peak_data_t);
-		
+
+		QVector<peak_data_t> firstLevel(data->pd->processBufferSize);
+
+		data->file.seek(0);
+
+		int read = data->file.read((char*)firstLevel.data(), sizeof(peak_data_t) * firstLevel.size()) / sizeof(peak_data_t);
+
 		if (read != data->pd->processBufferSize) {
 			PERROR("couldn't read in all saved data?? (%d read)", read);
+			firstLevel.resize(qMax(0, read) & ~1);
 		}
-		
-		
-		int prevLevelBufferPos = 0;
-		int nextLevelBufferPos;
-		data->headerdata.peakDataSizeForLevel[0] = data->pd->processBufferSize;
-		data->headerdata.peakDataOffsets[0] = 0;
-		
-		for (int i = SAVING_ZOOM_FACTOR+1; i < ZOOM_LEVELS+1; ++i) {
-		
-			int prevLevelSize = data->headerdata.peakDataSizeForLevel[i - SAVING_ZOOM_FACTOR - 1];
-			data->headerdata.peakDataOffsets[i - SAVING_ZOOM_FACTOR] = data->headerdata.peakDataOffsets[i - SAVING_ZOOM_FACTOR - 1] + prevLevelSize;
-			prevLevelBufferPos = data->headerdata.peakDataOffsets[i - SAVING_ZOOM_FACTOR - 1];
-			nextLevelBufferPos = data->headerdata.peakDataOffsets[i - SAVING_ZOOM_FACTOR];
-			
-			
-			int count = 0;
-			
-			do {
-				Q_ASSERT(nextLevelBufferPos <= totalBufferSize);
-				saveBuffer[nextLevelBufferPos] = (peak_data_t) f_max(saveBuffer[prevLevelBufferPos], saveBuffer[prevLevelBufferPos + 2]);
-				saveBuffer[nextLevelBufferPos + 1] = (peak_data_t) f_max(saveBuffer[prevLevelBufferPos + 1], saveBuffer[prevLevelBufferPos + 3]);
-				nextLevelBufferPos += 2;
-				prevLevelBufferPos += 4;
-				count+=4;
-			}
-			while (count < prevLevelSize);
-		}
-		
-		data->file.seek(data->headerdata.headerSize);
-		
-		int written = data->file.write((char*)saveBuffer, sizeof(peak_data_t) * totalBufferSize) / sizeof(peak_data_t);
-		
-		if (written != totalBufferSize) {
-			PERROR("could not write complete buffer! (only %d)", written);
-	// 		return -1;
-		}
-		
+
+		QVector<audio_sample_t> normValues(data->pd->normDataCount);
+
 		data->normFile.seek(0);
-		
-		read = data->normFile.read((char*)saveBuffer, sizeof(audio_sample_t) * data->pd->normDataCount) / sizeof(audio_sample_t);
-		
+
+		read = data->normFile.read((char*)normValues.data(), sizeof(audio_sample_t) * normValues.size()) / sizeof(audio_sample_t);
+
 		if (read != data->pd->normDataCount) {
 			PERROR("Could not read in all (%d) norm. data, only %d", data->pd->normDataCount, read);
+			normValues.resize(qMax(0, read));
 		}
-		
-		data->headerdata.normValuesDataOffset = data->headerdata.headerSize + totalBufferSize * sizeof(peak_data_t);
-		
+
+		channelLevels.append(QList<QVector<peak_data_t> >() << firstLevel);
+		channelNormValues.append(normValues);
+
+		data->file.close();
 		data->normFile.close();
-		
-		if (!QFile::remove(data->normFileName)) {
-			PERROR("Failed to remove temp. norm. data file! (%s)", data->normFileName.toAscii().data()); 
+
+		if (!QFile::remove(data->tempFileName) || !QFile::remove(data->normFileName)) {
+			PERROR("Failed to remove temp. peak data files! (%s)", data->tempFileName.toAscii().data());
 		}
-		
-		written = data->file.write((char*)saveBuffer, sizeof(audio_sample_t) * read) / sizeof(audio_sample_t);
-		
-		write_header(data);
-		
-		data->file.close();
-		
-		delete [] saveBuffer;
+
 		delete data->pd;
 		data->pd = 0;
-		
 	}
-	
+
+	if (write_peak_file(channelLevels, channelNormValues) < 0) {
+		m_permanentFailure = true;
+		return -1;
+	}
+
+	// peak files in the legacy format are obsolete now
+	foreach(ChannelData* data, m_channelData) {
+		if (QFile::exists(data->legacyFileName)) {
+			QFile::remove(data->legacyFileName);
+		}
+	}
+
 	emit finished();
-	
+
+	return 1;
+
+}
+
+
+/**
+ * Converts the per channel peak files of the legacy format (version 1.4)
+ * into a peak file of the current format, so existing projects don't need
+ * to rebuild their peak data from the audio sources.
+ * @return 1 if the legacy files were converted, -1 otherwise
+ */
+int Peak::convert_legacy_peak_files()
+{
+	PENTER;
+
+	QDateTime sourceModTime = QFileInfo(m_sourceFileName).lastModified();
+	QList<QList<QVector<peak_data_t> > > channelLevels;
+	QList<QVector<audio_sample_t> > channelNormValues;
+
+	foreach(ChannelData* data, m_channelData) {
+		QFile file(data->legacyFileName);
+
+		if (!file.open(QIODevice::ReadOnly)) {
+			return -1;
+		}
+
+		// legacy peak files were only valid till the source got modified
+		if (sourceModTime > QFileInfo(file).lastModified()) {
+			return -1;
+		}
+
+		char label[6];
+		int version[2];
+		int peakDataOffsets[ZOOM_LEVELS - SAVING_ZOOM_FACTOR];
+		int peakDataSizeForLevel[ZOOM_LEVELS - SAVING_ZOOM_FACTOR];
+		int normValuesDataOffset;
+		int headerSize;
+
+		file.read(label, sizeof(label));
+		file.read((char*)version, sizeof(version));
+		file.read((char*)peakDataOffsets, sizeof(peakDataOffsets));
+		file.read((char*)peakDataSizeForLevel, sizeof(peakDataSizeForLevel));
+		file.read((char*)&normValuesDataOffset, sizeof(normValuesDataOffset));
+
+		if (	(file.read((char*)&headerSize, sizeof(headerSize)) != sizeof(headerSize)) ||
+			(memcmp(label, "TRAVPF", sizeof(label)) != 0) ||
+			(version[0] != PEAKFILE_MAJOR_VERSION) ||
+			(version[1] != PEAKFILE_MINOR_VERSION)) {
+				return -1;
+		}
+
+		// The legacy writer had one zoom level more than its header had
+		// room for, the offset of the last level overwrote the size of the
+		// first one. The real size of the first level is the offset of the
+		// second one, all following levels are rebuild from it.
+		int firstLevelSize = peakDataOffsets[1];
+
+		if (firstLevelSize <= 0 || normValuesDataOffset < headerSize) {
+			return -1;
+		}
+
+		QVector<peak_data_t> firstLevel(firstLevelSize);
+
+		file.seek(headerSize);
+		if (file.read((char*)firstLevel.data(), firstLevelSize * sizeof(peak_data_t)) != qint64(firstLevelSize * sizeof(peak_data_t))) {
+			return -1;
+		}
+
+		channelLevels.append(QList<QVector<peak_data_t> >() << firstLevel);
+
+		// The chunk boundaries of the legacy normalization values drift
+		// away from multiples of NORMALIZE_CHUNK_SIZE, so they can't be
+		// used by get_max_amplitude(). The converted file gets none, which
+		// makes get_max_amplitude() scan the source itself instead.
+		channelNormValues.append(QVector<audio_sample_t>());
+	}
+
+	if (write_peak_file(channelLevels, channelNormValues) < 0) {
+		return -1;
+	}
+
+	PMESG("Converted legacy peak files of %s", QS_C(m_sourceFileName));
+
+	foreach(ChannelData* data, m_channelData) {
+		QFile::remove(data->legacyFileName);
+	}
+
 	return 1;
-	
 }
 
 
@@ -569,6 +787,8 @@ void Peak::process(uint channel, audio_sample_t* buffer, nframes_t nframes)
 			pd->nextDataPointLocation += pd->processRange;
 		}
 		
+		pd->normProcessedFrames++;
+		
 		if (pd->normProcessedFrames == NORMALIZE_CHUNK_SIZE) {
 			int written = data->normFile.write((char*)&pd->normValue, sizeof(audio_sample_t)) / sizeof(audio_sample_t);
 			
@@ -580,8 +800,6 @@ void Peak::process(uint channel, audio_sample_t* buffer, nframes_t nframes)
 			pd->normProcessedFrames = 0;
 			pd->normDataCount++;
 		}
-		
-		pd->normProcessedFrames++;
 	}
 }
 
@@ -594,6 +812,11 @@ int Peak::create_from_scratch()
 	
 	int ret = -1;
 	
+	if (convert_legacy_peak_files() > 0) {
+		emit finished();
+		return 1;
+	}
+	
 	if (prepare_processing(m_source->get_file_rate()) < 0) {
 		return ret;
 	}
@@ -664,74 +887,157 @@ out:
 }
 
 
-audio_sample_t Peak::get_max_amplitude(TimeRef startlocation, TimeRef endlocation)
+/**
+ * Builds the max amplitude index from the normalization values of all
+ * channels. Level 0 holds the highest absolute sample value of all channels
+ * for each NORMALIZE_CHUNK_SIZE frames, each next level the maximum of 2
+ * values of the previous one, so the maximum of any range of chunks can be
+ * found by looking at no more than 2 values per level.
+ */
+void Peak::build_max_amplitude_index()
 {
-	foreach(ChannelData* data, m_channelData) {
-		if (!data->file.isOpen() || !m_peaksAvailable) {
-			printf("either the file is not open, or no peak data available\n");
-			return 0.0f;
+	int count = m_peakFile.get_norm_value_count();
+
+	m_maxAmplitudeIndex.fill(0.0f, count);
+	m_maxAmplitudeLevelOffsets.clear();
+	m_maxAmplitudeLevelOffsets.append(0);
+
+	QVector<audio_sample_t> normValues(count);
+
+	for (int chan = 0; chan < m_channelData.size(); ++chan) {
+		int read = m_peakFile.read_norm_values(chan, 0, count, normValues.data());
+
+		if (read != count) {
+			PERROR("Could not read in all (%d) norm. data, only %d", count, read);
 		}
-	}
-	int rate = m_source->get_file_rate();
-	nframes_t startframe = startlocation.to_frame(rate);
-	nframes_t endframe = endlocation.to_frame(rate);
-	int startpos = startframe / NORMALIZE_CHUNK_SIZE;
-	uint count = (endframe / NORMALIZE_CHUNK_SIZE) - startpos;
-	
-	uint buffersize = count < NORMALIZE_CHUNK_SIZE*2 ? NORMALIZE_CHUNK_SIZE*2 : count;
-	audio_sample_t* readbuffer =  new audio_sample_t[buffersize];
-	
-	audio_sample_t maxamp = 0;
-	DecodeBuffer decodebuffer;
-	// Read in the part not fully occupied by a cached normalize value
-	// at the left hand part and run compute_peak on it.
-	if (startframe != 0) {
-		startpos += 1;
-		int toRead = (int) ((startpos * NORMALIZE_CHUNK_SIZE) - startframe);
-		
-		int read = m_source->file_read(&decodebuffer, startframe, toRead);
-		
-		for (uint chan = 0; chan < m_source->get_channel_count(); ++ chan) {
-			maxamp = Mixer::compute_peak(decodebuffer.destination[chan], read, maxamp);
+
+		for (int i=0; i<read; ++i) {
+			m_maxAmplitudeIndex[i] = f_max(m_maxAmplitudeIndex.at(i), normValues.at(i));
 		}
 	}
-	
-	
-	// Read in the part not fully occupied by a cached normalize value
-	// at the right hand part and run compute_peak on it.
-	float f = (float) endframe / NORMALIZE_CHUNK_SIZE;
-	int endpos = (int) f;
-	int toRead = (int) ((f - (endframe / NORMALIZE_CHUNK_SIZE)) * NORMALIZE_CHUNK_SIZE);
-	int read = m_source->file_read(&decodebuffer, endframe - toRead, toRead);
-	
-	if (read > 0) {
-		for (uint chan = 0; chan < m_source->get_channel_count(); ++ chan) {
-			maxamp = Mixer::compute_peak(decodebuffer.destination[chan], read, maxamp);
+
+	int levelStart = 0;
+	int levelSize = count;
+
+	while (levelSize > 1) {
+		int nextSize = (levelSize + 1) / 2;
+		int nextStart = m_maxAmplitudeIndex.size();
+
+		m_maxAmplitudeLevelOffsets.append(nextStart);
+		m_maxAmplitudeIndex.resize(nextStart + nextSize);
+
+		for (int i=0; i<nextSize; ++i) {
+			audio_sample_t value = m_maxAmplitudeIndex.at(levelStart + 2 * i);
+			if (2 * i + 1 < levelSize) {
+				value = f_max(value, m_maxAmplitudeIndex.at(levelStart + 2 * i + 1));
+			}
+			m_maxAmplitudeIndex[nextStart + i] = value;
 		}
+
+		levelStart = nextStart;
+		levelSize = nextSize;
 	}
-	
-	// Now that we have covered both boundary situations,
-	// read in the cached normvalues, and calculate the highest value!
-	count = endpos - startpos;
-	
-	foreach(ChannelData* data, m_channelData) {
-		data->file.seek(data->headerdata.normValuesDataOffset + (startpos * sizeof(audio_sample_t)));
-	
-		int read = data->file.read((char*)readbuffer, sizeof(audio_sample_t) * count) / sizeof(audio_sample_t);
-	
-		if (read != (int)count) {
-                        printf("Peak::get_max_amplitude: could only read %d, %d requested\n", read, count);
+
+	m_maxAmplitudeLevelOffsets.append(m_maxAmplitudeIndex.size());
+}
+
+/**
+ * @return The highest absolute sample value of all channels in the
+ *	chunks [\a first, \a last) of NORMALIZE_CHUNK_SIZE frames.
+ */
+audio_sample_t Peak::max_amplitude_for_chunks(int first, int last)
+{
+	audio_sample_t maxamp = 0.0f;
+	const audio_sample_t* index = m_maxAmplitudeIndex.constData();
+
+	for (int level=0; first < last; ++level) {
+		const audio_sample_t* values = index + m_maxAmplitudeLevelOffsets.at(level);
+
+		if (first & 1) {
+			maxamp = f_max(maxamp, values[first]);
+			++first;
 		}
-	
-		maxamp = Mixer::compute_peak(readbuffer, read, maxamp);
+		if (last & 1) {
+			--last;
+			maxamp = f_max(maxamp, values[last]);
+		}
+
+		first /= 2;
+		last /= 2;
 	}
-	
-	delete [] readbuffer;
-	
+
+	return maxamp;
+}
+
+/**
+ * @return The highest absolute sample value of all channels in the frames
+ *	[\a startframe, \a endframe), read from the micro view cache. Only
+ *	the part between the first and last bucket edge of the coarsest micro
+ *	view level is read from the buckets, both ends are scanned sample by
+ *	sample.
+ */
+audio_sample_t Peak::max_amplitude_for_frames(qint64 startframe, qint64 endframe)
+{
+	audio_sample_t maxamp = 0.0f;
+
+	if (startframe >= endframe) {
+		return maxamp;
+	}
+
+	const int level = MICROVIEW_LEVELS - 1;
+	const qint64 bucketSize = MICROVIEW_FIRST_BUCKET_SIZE << level;
+	qint64 alignedStart = ((startframe + bucketSize - 1) / bucketSize) * bucketSize;
+	qint64 alignedEnd = (endframe / bucketSize) * bucketSize;
+
+	if (alignedStart >= alignedEnd) {
+		alignedStart = alignedEnd = endframe;
+	}
+
+	for (int chan = 0; chan < m_channelData.size(); ++chan) {
+		audio_sample_t upper = 0.0f;
+		audio_sample_t lower = 0.0f;
+
+		scan_micro_view_range(chan, startframe, alignedStart, -1, upper, lower);
+		scan_micro_view_range(chan, alignedStart, alignedEnd, level, upper, lower);
+		scan_micro_view_range(chan, alignedEnd, endframe, -1, upper, lower);
+
+		maxamp = f_max(maxamp, f_max(upper, -lower));
+	}
+
 	return maxamp;
 }
 
+audio_sample_t Peak::get_max_amplitude(TimeRef startlocation, TimeRef endlocation)
+{
+	QMutexLocker locker(&m_readMutex);
+
+	if (!m_peakFile.is_open() || !m_peaksAvailable) {
+		printf("either the file is not open, or no peak data available\n");
+		return 0.0f;
+	}
 
+	int rate = m_source->get_file_rate();
+	qint64 startframe = startlocation.to_frame(rate);
+	qint64 endframe = endlocation.to_frame(rate);
+
+	// the chunks fully covered by the range, the partial chunks at both
+	// ends (and a last chunk without normalization value) are read from
+	// the source through the micro view cache. Peak files converted from
+	// the legacy format have no normalization values, the whole range is
+	// read from the source for them.
+	int firstChunk = int((startframe + NORMALIZE_CHUNK_SIZE - 1) / NORMALIZE_CHUNK_SIZE);
+	int lastChunk = int(qMin(endframe / NORMALIZE_CHUNK_SIZE, qint64(m_peakFile.get_norm_value_count())));
+
+	if (firstChunk >= lastChunk) {
+		return max_amplitude_for_frames(startframe, endframe);
+	}
+
+	audio_sample_t maxamp = max_amplitude_for_chunks(firstChunk, lastChunk);
+	maxamp = f_max(maxamp, max_amplitude_for_frames(startframe, qint64(firstChunk) * NORMALIZE_CHUNK_SIZE));
+	maxamp = f_max(maxamp, max_amplitude_for_frames(qint64(lastChunk) * NORMALIZE_CHUNK_SIZE, endframe));
+
+	return maxamp;
+}
 
 
 /******** PEAK BUILD THREAD CLASS **********/
@@ -857,101 +1163,29 @@ void PPThread::run()
 
 
 
-PeakDataReader::PeakDataReader(Peak::ChannelData* data)
-{
-	m_d = data;
-	m_nframes = m_d->file.size();
-	m_readPos = 0;
-}
-
-
-nframes_t PeakDataReader::read_from(DecodeBuffer* buffer, nframes_t start, nframes_t count)
+QHash<int, int> Peak::calculate_lut_data()
 {
-// 	printf("read_from:: before_seek from %d, framepos is %d\n", start, m_readPos);
-	
-	if (!seek(start)) {
-		return 0;
-	}
-	
-	return read(buffer, count);
-}
-
-
-bool PeakDataReader::seek(nframes_t start)
-{
-	if (m_readPos != start) {
-		Q_ASSERT(m_d->file.isOpen());
-	
-	
-		if (start >= m_nframes) {
-			return false;
-		}
-	
-		if (!m_d->file.seek(start)) {
-			qWarning("PeakDataReader: could not seek to data point %d within %s", start, QS_C(m_d->fileName));
-			return false;
-		}
-		
-		m_readPos = start;
-	}
-	
-	return true;
-}
-
-
-nframes_t PeakDataReader::read(DecodeBuffer* buffer, nframes_t count)
-{
-	if ( ! (count && (m_readPos < m_nframes)) ) {
-		return 0;
-	}
-		
-	// Make sure the read buffer is big enough for this read
-	buffer->check_buffers_capacity(count*3, 1);
-	
-	Q_ASSERT(m_d->file.isOpen());
-	
-	int framesRead = 0;
-	peak_data_t* readbuffer;
-	
-	framesRead = m_d->file.read((char*)buffer->readBuffer, sizeof(peak_data_t) * count) / sizeof(peak_data_t);
-	readbuffer = (peak_data_t*)(buffer->readBuffer);
-
-	for (int f = 0; f < framesRead; f++) {
-		buffer->destination[0][f] = float(readbuffer[f]);
-	}
-	
-	m_readPos += framesRead;
-	
-	return framesRead;
-}
-
-void Peak::calculate_lut_data()
-{
-	chacheIndexLut.insert(64     , 0);
-	chacheIndexLut.insert(128    , 1);
-	chacheIndexLut.insert(256    , 2);
-	chacheIndexLut.insert(512    , 3);
-	chacheIndexLut.insert(1024   , 4);
-	chacheIndexLut.insert(2048   , 5);
-	chacheIndexLut.insert(4096   , 6);
-	chacheIndexLut.insert(8192   , 7);
-	chacheIndexLut.insert(16384  , 8);
-	chacheIndexLut.insert(32768  , 9);
-	chacheIndexLut.insert(65536  , 10);
-	chacheIndexLut.insert(131072 , 11);
-	chacheIndexLut.insert(262144 , 12);
-	chacheIndexLut.insert(524288 , 13);
-	chacheIndexLut.insert(1048576, 14);
+	QHash<int, int> lut;
+	lut.insert(64     , 0);
+	lut.insert(128    , 1);
+	lut.insert(256    , 2);
+	lut.insert(512    , 3);
+	lut.insert(1024   , 4);
+	lut.insert(2048   , 5);
+	lut.insert(4096   , 6);
+	lut.insert(8192   , 7);
+	lut.insert(16384  , 8);
+	lut.insert(32768  , 9);
+	lut.insert(65536  , 10);
+	lut.insert(131072 , 11);
+	lut.insert(262144 , 12);
+	lut.insert(524288 , 13);
+	lut.insert(1048576, 14);
+
+	return lut;
 }
 
 int Peak::max_zoom_value()
 {
 	return 1048576;
 }
-
-Peak::ChannelData::~ ChannelData()
-{
-	if (peakdataDecodeBuffer) {
-		delete peakdataDecodeBuffer;
-	}
-}
@@ -30,15 +30,17 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QFile>
 #include <QHash>
 #include <QPair>
+#include <QCache>
+#include <QVector>
 
 #include "defines.h"
+#include "TPeakFile.h"
 
 class ReadSource;
 class AudioSource;
 class Peak;
 class PPThread;
 class DecodeBuffer;
-class PeakDataReader;
 
 class PeakProcessor : public QObject
 {
@@ -98,6 +100,7 @@ public:
 	static const int ZOOM_LEVELS = 22;
 	static const int SAVING_ZOOM_FACTOR = 8;
 	static const int MAX_ZOOM_USING_SOURCEFILE = SAVING_ZOOM_FACTOR - 1;
+	static const int CACHED_ZOOM_LEVELS = ZOOM_LEVELS - SAVING_ZOOM_FACTOR + 1;
 	// Use ~ 1/4 the range of peak_data_t (== short) so we have headroom
 	// for samples in the range [-4, +4] or + 12 dB
 	static const int MAX_DB_VALUE = 8000;
@@ -114,9 +117,14 @@ public:
 	void process(uint channel, audio_sample_t* buffer, nframes_t frames);
 	int prepare_processing(int rate);
 	int finish_processing();
-	int calculate_peaks(int chan, float** buffer, TimeRef startlocation, int peakDataCount, qreal framesPerPeak);
+	int read_peaks(int chan, float* buffer, TimeRef startlocation, int peakDataCount, qreal framesPerPeak);
 
 	void close();
+
+	// Called by close() and the destructor, so objects using the Peak from
+	// other threads (the waveform renderer) can finish with it first
+	typedef void (*ReleaseFunction)(Peak* peak);
+	static void set_release_function(ReleaseFunction function) {releaseFunction = function;}
 	
 	void start_peak_loading();
 
@@ -130,7 +138,15 @@ private:
 	bool 		m_peaksAvailable;
 	bool		m_permanentFailure;
 	bool		m_interuptPeakBuild;
+	// read_peaks() and get_max_amplitude() share the peak file reader and
+	// decode buffer, and may be called from waveform render threads
+	QMutex		m_readMutex;
+	TPeakFile	m_peakFile;
+	QString		m_peakFileName;
+	QString		m_sourceFileName;
+	DecodeBuffer*	m_decodeBuffer;
 	static QHash<int, int> chacheIndexLut;
+	static ReleaseFunction releaseFunction;
 	
 	struct ProcessData {
 		ProcessData() {
@@ -155,68 +171,73 @@ private:
 		int			normDataCount;
 	};
 	
-	struct PeakHeaderData {
-		int headerSize;
-		int normValuesDataOffset;
-		int peakDataOffsets[ZOOM_LEVELS - SAVING_ZOOM_FACTOR];
-		int peakDataSizeForLevel[ZOOM_LEVELS - SAVING_ZOOM_FACTOR];
-		char label[6];	//TPFxxx -> Traverso Peak File version x.x.x
-		int version[2];
-	};
-
 	struct ChannelData {
-		ChannelData() {
-			peakdataDecodeBuffer = 0;
-		}
-		~ChannelData();
-		QString		fileName;
+		// the temporary files the level 0 peak data and the
+		// normalization data are written to during processing
+		QString		tempFileName;
 		QString		normFileName;
 		QFile 		file;
 		QFile		normFile;
-		PeakHeaderData	headerdata;
-		PeakDataReader*	peakreader;
 		ProcessData* 	pd;
-		DecodeBuffer*	peakdataDecodeBuffer;
-		QHash<uchar *, QPair<int /*offset*/, int /*handle|len*/> > maps;
+		// peak file of the (pre 2.0) one file per channel format
+		QString		legacyFileName;
 	};
 	
 	QList<ChannelData* >	m_channelData;
+
+	// Micro view (framesPerPeak < 64) cache: decoded audio is kept in
+	// blocks of MICROVIEW_BLOCK_SIZE frames, each with a small pyramid of
+	// peak data at 4, 8, 16 and 32 frames per bucket, so zooming and
+	// scrolling in the micro view doesn't decode the source over and over.
+	static const int MICROVIEW_BLOCK_SIZE = 16384;
+	static const int MICROVIEW_LEVELS = 4;
+	static const int MICROVIEW_FIRST_BUCKET_SIZE = 4;
+	static const int MICROVIEW_CACHE_SIZE = 4096; // KiB, per Peak
+
+	struct MicroViewBlock {
+		nframes_t		frames;
+		// per channel MICROVIEW_BLOCK_SIZE samples
+		QVector<audio_sample_t>	samples;
+		// per channel (MICROVIEW_BLOCK_SIZE / bucketsize) values
+		QVector<audio_sample_t>	maxima[MICROVIEW_LEVELS];
+		QVector<audio_sample_t>	minima[MICROVIEW_LEVELS];
+	};
+
+	QCache<qint64, MicroViewBlock>	m_microViewCache;
+	// calculated peak data returned by calculate_peaks()
+	QVector<float>			m_peakData;
+
+	MicroViewBlock* get_micro_view_block(qint64 index);
+	bool scan_micro_view_range(int chan, qint64 start, qint64 end, int level, audio_sample_t& upper, audio_sample_t& lower);
+	int calculate_micro_view_peaks(int chan, TimeRef startlocation, int peakDataCount, qreal framesPerPeak);
+	
+	// Max amplitude index: the normalization values of all channels
+	// combined, followed by levels of halving size holding the maximum
+	// of 2 values of the previous level.
+	QVector<audio_sample_t>	m_maxAmplitudeIndex;
+	QVector<int>		m_maxAmplitudeLevelOffsets;
+
+	void build_max_amplitude_index();
+	audio_sample_t max_amplitude_for_chunks(int first, int last);
+	audio_sample_t max_amplitude_for_frames(qint64 startframe, qint64 endframe);
 	
+	int calculate_peaks(int chan, float** buffer, TimeRef startlocation, int peakDataCount, qreal framesPerPeak);
 	int create_from_scratch();
 	int read_header();
-	int write_header(ChannelData* data);
-	static void calculate_lut_data();
+	int convert_legacy_peak_files();
+	int write_peak_file(QList<QList<QVector<peak_data_t> > >& channelLevels, QList<QVector<audio_sample_t> >& channelNormValues);
+	static void build_levels(QList<QVector<peak_data_t> >& levels);
+	static QHash<int, int> calculate_lut_data();
 
 	friend class PeakProcessor;
-	friend class PeakDataReader;
 
 signals:
 	void finished();
 	void progress(int m_progress);
 };
 
-class PeakDataReader
-{
-public:
-	PeakDataReader(Peak::ChannelData* data);
-	~PeakDataReader(){};
-
-	nframes_t read_from(DecodeBuffer* buffer, nframes_t start, nframes_t count);
-
-private:
-	Peak::ChannelData* m_d;
-	nframes_t	m_readPos;
-	nframes_t	m_nframes;
-
-	bool seek(nframes_t start);
-	nframes_t read(DecodeBuffer* buffer, nframes_t frameCount);
-};
-
 inline QHash< int, int > * Peak::cache_index_lut()
 {
-	if(chacheIndexLut.isEmpty()) {
-		calculate_lut_data();
-	}
 	return &chacheIndexLut;
 }
 
@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Information.h"
 #include "TInputEventDispatcher.h"
 #include "ResourcesManager.h"
+#include "DiskIO.h"
 #include "Export.h"
 #include "AudioDevice.h"
 #include "TConfig.h"
@@ -74,6 +75,8 @@ Project::Project(const QString& title)
 	PENTERCONS;
         m_name = title;
 	m_exportThread = 0;
+        m_exportCaptureBus = 0;
+        m_exportSwitchedDriver = false;
         m_activeSheet = 0;
         m_spectralMeter = 0;
         m_correlationMeter = 0;
@@ -90,6 +93,7 @@ Project::Project(const QString& title)
 	m_bitDepth = audiodevice().get_bit_depth();
 
 	m_resourcesManager = new ResourcesManager(this);
+	m_diskioService = new DiskIOService();
 	m_hs = new QUndoStack(pm().get_undogroup());
 
         m_audiodeviceClient = new TAudioDeviceClient("sheet_" + QByteArray::number(get_id()));
@@ -134,6 +138,8 @@ Project::~Project()
 
         delete m_masterOut;
         delete m_hs;
+        // last, removed Sheets in the history stack still use it
+        delete m_diskioService;
 }
 
 
@@ -1165,6 +1171,12 @@ void Project::set_current_session(qint64 id)
         Sheet* sheet = qobject_cast<Sheet*>(m_activeSession);
 
         if (sheet && (m_activeSheet != sheet)) {
+                // only the active Sheet keeps the read buffers of its clips
+                if (m_activeSheet && m_sheets.contains(m_activeSheet)) {
+                        m_activeSheet->get_diskio()->set_active(false);
+                }
+                sheet->get_diskio()->set_active(true);
+
                 m_activeSheet = sheet;
                 m_activeSheetId = sheet->get_id();
                 set_parent_session(m_activeSheet);
@@ -1185,9 +1197,6 @@ int Project::export_project(ExportSpecification* spec)
 {
 	PENTER;
 
-        // lets first disconnect from audio device!
-        disconnect_from_audio_device();
-	
 	if (!m_exportThread) {
 		m_exportThread = new ExportThread(this);
 	}
@@ -1205,6 +1214,13 @@ int Project::export_project(ExportSpecification* spec)
 		}
 	}
 	
+	spec->freewheel = start_freewheel_export();
+
+	if (!spec->freewheel) {
+		// lets first disconnect from audio device!
+		disconnect_from_audio_device();
+	}
+
 	spec->progress = 0;
 	spec->running = true;
 	spec->stop = false;
@@ -1226,7 +1242,6 @@ int Project::start_export(ExportSpecification* spec)
         spec->blocksize = audiodevice().get_buffer_size(); //32768;
 
 	spec->dataF = new audio_sample_t[spec->blocksize * spec->channels];
-	audio_sample_t* readbuffer = new audio_sample_t[spec->blocksize * spec->channels];
 
 	overallExportProgress = renderedSheets = 0;
 	sheetsToRender.clear();
@@ -1251,7 +1266,6 @@ int Project::start_export(ExportSpecification* spec)
 		emit exportStartedForSheet(sheet);
 		spec->resumeTransport = false;
                 spec->resumeTransportLocation = sheet->get_transport_location();
-		sheet->readbuffer = readbuffer;
 		
 		if (spec->normalize) {
                         // start one render pass in mode "CALC_NORM_FACTOR"
@@ -1310,7 +1324,6 @@ int Project::start_export(ExportSpecification* spec)
 	overallExportProgress = 0;
 	
 	delete [] spec->dataF;
-	delete [] readbuffer;
 	spec->dataF = 0;
 
 	emit exportFinished();
@@ -1320,7 +1333,78 @@ int Project::start_export(ExportSpecification* spec)
 
 void Project::export_finished()
 {
-        connect_to_audio_device();
+        if (m_exportCaptureBus) {
+                stop_freewheel_export();
+        } else {
+                connect_to_audio_device();
+        }
+}
+
+/**
+ * Prepares the AudioDevice to render the export in the audio thread,
+ * through the same process() chain as playback, as fast as possible.
+ * The export then captures what the Master bus sends to its first
+ * output, which makes it identical to what is heard during playback.
+ *
+ * Only the Null and File Driver can freewheel, other drivers (but Jack)
+ * are replaced by the Null Driver until stop_freewheel_export().
+ * Set "Export", "Freewheel" to false to render in the export thread.
+ * While freewheeling the audio thread gives up it's realtime priority and
+ * CPU affinity (see AudioDeviceThread::set_freewheel_scheduling()), they
+ * are restored by stop_freewheel_export().
+ *
+ * @return true if the export will be rendered freewheeling
+ */
+bool Project::start_freewheel_export()
+{
+        m_exportCaptureBus = 0;
+        m_exportSwitchedDriver = false;
+
+        if (!config().get_property("Export", "Freewheel", true).toBool()) {
+                return false;
+        }
+
+        QString driverType = audiodevice().get_driver_type();
+
+        // Jack has its own freewheel mode, which is not supported (yet)
+        if (driverType == "Jack") {
+                return false;
+        }
+
+        QList<TSend*> sends = m_masterOut->get_post_sends();
+        if (sends.isEmpty()) {
+                return false;
+        }
+
+        if (!(driverType == "Null Driver" || driverType == "File Driver")) {
+                AudioDeviceSetup ads = audiodevice().get_device_setup();
+                ads.driverType = "Null Driver";
+                audiodevice().set_parameters(ads);
+                m_exportSwitchedDriver = true;
+        }
+
+        // the hardware buses are updated for the new driver now
+        AudioBus* bus = sends.first()->get_bus();
+        if (!bus || !bus->is_valid()) {
+                stop_freewheel_export();
+                return false;
+        }
+
+        m_exportCaptureBus = bus;
+        audiodevice().set_freewheel(true);
+
+        return true;
+}
+
+void Project::stop_freewheel_export()
+{
+        audiodevice().set_freewheel(false);
+        m_exportCaptureBus = 0;
+
+        if (m_exportSwitchedDriver) {
+                m_exportSwitchedDriver = false;
+                audiodevice().set_parameters(audiodevice().get_device_setup());
+        }
 }
 
 /* returns the total time of the data that will be written to CD */
@@ -1668,6 +1752,7 @@ void Project::sheet_removed(Sheet *sheet)
 
 {
         m_sheets.removeAll(sheet);
+        sheet->get_diskio()->set_active(false);
 
         if (m_sheets.size() > 0) {
                 set_current_session(m_sheets.last()->get_id());
@@ -1761,6 +1846,14 @@ int Project::process( nframes_t nframes )
         // Mix the result into the AudioDevice "physical" buffers
         m_masterOut->process(nframes);
 
+        // A Sheet rendering a freewheel export captures what we just sent
+        // to the output
+        if (m_exportCaptureBus) {
+                apill_foreach(Sheet* sheet, Sheet, m_RtSheets) {
+                        sheet->freewheel_export_cycle(m_exportCaptureBus, nframes);
+                }
+        }
+
         return result;
 }
 
@@ -35,6 +35,7 @@ class AudioChannel;
 class Sheet;
 class Track;
 class ResourcesManager;
+class DiskIOService;
 struct ExportSpecification;
 class ExportThread;
 class TAudioDeviceClient;
@@ -84,6 +85,7 @@ public :
         QStringList get_input_buses_for(TBusTrack* busTrack);
 	
 	ResourcesManager* get_audiosource_manager() const;
+	DiskIOService* get_diskio_service() const {return m_diskioService;}
 	QString get_title() const;
 	QString get_engineer() const;
 	QString get_description() const;
@@ -170,8 +172,11 @@ private:
         TSession*               m_activeSession;
         APILinkedList           m_RtSheets;
 	ResourcesManager* 	m_resourcesManager;
+        DiskIOService*          m_diskioService;
         ExportThread*           m_exportThread;
         TAudioDeviceClient*	m_audiodeviceClient;
+        AudioBus*               m_exportCaptureBus;
+        bool                    m_exportSwitchedDriver;
         SpectralMeter*          m_spectralMeter;
         CorrelationMeter*       m_correlationMeter;
 
@@ -214,6 +219,8 @@ private:
 	int create_peakfiles_dir();
 
         void prepare_audio_device(QDomDocument doc);
+        bool start_freewheel_export();
+        void stop_freewheel_export();
 	
 	friend class ProjectManager;
 
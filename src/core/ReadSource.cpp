@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "ProjectManager.h"
 #include "Project.h"
 #include "AudioClip.h"
+#include "AudioTrack.h"
 #include "DiskIO.h"
 #include "Utils.h"
 #include "Sheet.h"
@@ -494,6 +495,11 @@ void ReadSource::process_ringbuffer(DecodeBuffer* buffer, bool seeking)
 		return;
 	}
 	
+	// the buffers are freed while our Sheet isn't active
+	if (m_buffers.isEmpty()) {
+		return;
+	}
+	
 	// Do nothing if we passed the lenght of the AudioFile.
 	if (m_rbFileReadPos >= m_length) {
 // 		printf("returning, m_rbFileReadPos > m_length! (%d >  %d)\n", m_rbFileReadPos.to_frame(get_rate()), m_audioReader->get_nframes());
@@ -512,8 +518,14 @@ void ReadSource::process_ringbuffer(DecodeBuffer* buffer, bool seeking)
 	int toRead = m_chunkSize;
 	
 	if (seeking) {
-		toRead = writeSpace;
-// 		printf("doing a full seek buffer fill\n");
+		// Only fill the minimum needed to start playback, the rest of
+		// the buffer is filled by the next DiskIO::do_work() calls.
+		int readSpace = m_buffers.at(0)->read_space();
+		int prefill = qMin(int(m_diskio->get_seek_prefill_frames()), int(m_bufferSize));
+		toRead = qMin(writeSpace, prefill - readSpace);
+		if (toRead <= 0) {
+			return;
+		}
 	} else if (m_syncInProgress) {
 		// Currently, we fill the buffer completely.
 		// For some reason, filling it with 1/4 at a time
@@ -540,6 +552,28 @@ void ReadSource::process_ringbuffer(DecodeBuffer* buffer, bool seeking)
 		m_audioReader->set_converter_type(m_diskio->get_resample_quality());
 	}
 	
+	// When the write space of the ringbuffers doesn't wrap within toRead
+	// frames, let the reader decode (and deinterleave) straight into it.
+	RingBufferNPT<audio_sample_t>::rw_vector vec;
+	size_t contiguous = toRead;
+	
+	for (int i=0; i<m_buffers.size(); ++i) {
+		m_buffers.at(i)->get_write_vector(&vec);
+		m_writeVectors[i] = vec.buf[0];
+		contiguous = qMin(contiguous, vec.len[0]);
+	}
+	
+	if (contiguous == size_t(toRead)) {
+		buffer->use_destination(m_writeVectors.data(), toRead, m_channelCount);
+		nframes_t toWrite = rb_file_read(buffer, toRead);
+		buffer->release_destination();
+		
+		for (int i=m_buffers.size()-1; i>=0; --i) {
+			m_buffers.at(i)->increment_write_ptr(toWrite);
+		}
+		return;
+	}
+	
 	// Read in the samples from source
 	nframes_t toWrite = rb_file_read(buffer, toRead);
 	
@@ -552,6 +586,21 @@ void ReadSource::process_ringbuffer(DecodeBuffer* buffer, bool seeking)
 }
 
 
+/**
+ * @return How far ahead of the transport the clip of this ReadSource is
+ *	played to compensate the latency of the plugins on its path.
+ */
+TimeRef ReadSource::get_read_ahead() const
+{
+	AudioTrack* track = m_clip ? m_clip->get_track() : 0;
+
+	if (!track) {
+		return TimeRef();
+	}
+
+	return TimeRef(track->get_path_latency(), m_outputRate);
+}
+
 void ReadSource::start_resync(TimeRef& position)
 {
 // 	printf("starting resync!\n");
@@ -583,7 +632,7 @@ void ReadSource::sync(DecodeBuffer* buffer)
 		return;
 	}
 	
-	if (!m_needSync) {
+	if (!m_needSync || m_buffers.isEmpty()) {
 		return;
 	}
 	
@@ -629,18 +678,47 @@ void ReadSource::prepare_rt_buffers( )
 	for (int i=0; i<m_channelCount; ++i) {
 		m_buffers.append(new RingBufferNPT<float>(m_bufferSize));
 	}
+	m_writeVectors.resize(m_channelCount);
 
         // FIXME: does this really make sense to do still ? :
         TimeRef synclocation = m_clip->get_sheet()->get_transport_location();
         start_resync(synclocation);
 }
 
+/**
+ * 	Frees the read buffers, rb_read() returns no data till
+ *	prepare_rt_buffers() was called again. Only to be called while
+ *	the transport of our Sheet isn't rolling.
+ */
+void ReadSource::free_rt_buffers()
+{
+	PENTER;
+	
+	m_rbReady = 0;
+	m_needSync = 0;
+	m_syncInProgress = 0;
+	
+	for (int i=0; i<m_buffers.size();++i) {
+		delete m_buffers.at(i);
+	}
+	
+	m_buffers.clear();
+}
+
 BufferStatus* ReadSource::get_buffer_status()
 {
 	if (m_channelCount == 0) {
 		return m_bufferstatus;
 	}
 	
+	if (m_buffers.isEmpty()) {
+		m_bufferstatus->fillStatus =  100;
+		m_bufferstatus->needSync = false;
+		m_bufferstatus->bufferUnderRun = false;
+		m_bufferstatus->priority = 0;
+		return m_bufferstatus;
+	}
+	
 	int freespace = m_buffers.at(0)->write_space();
 	
 // 	printf("m_rbFileReadPos, m_length %lld, %lld\n", m_rbFileReadPos.universal_frame(), m_length.universal_frame());
@@ -664,6 +742,19 @@ BufferStatus* ReadSource::get_buffer_status()
 	return m_bufferstatus;
 }
 
+/**
+ * @return true if the AudioClip of this ReadSource plays (part of) the
+ *	track range [\a start, \a end)
+ */
+bool ReadSource::is_audible_between(const TimeRef& start, const TimeRef& end) const
+{
+	if (m_channelCount == 0 || !m_active || !m_clip) {
+		return false;
+	}
+	
+	return m_clip->get_track_start_location() < end && m_clip->get_track_end_location() > start;
+}
+
 void ReadSource::set_active(bool active)
 {
         if (active) {
@@ -694,7 +785,9 @@ void ReadSource::set_diskio(DiskIO * diskio)
 		m_audioReader->set_converter_type(m_diskio->get_resample_quality());
 	}
 	
-	prepare_rt_buffers();
+	if (m_diskio->read_buffers_allocated()) {
+		prepare_rt_buffers();
+	}
 }
 
 QString ReadSource::get_error_string() const
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "AudioSource.h"
 
 #include <QDomDocument>
+#include <QVector>
 
 
 class ResampleAudioReader;
@@ -72,12 +73,15 @@ public :
 	nframes_t get_nframes() const;
 	int get_file_rate() const;
 	int get_output_rate() const {return m_outputRate;}
+	TimeRef get_read_ahead() const;
 	const TimeRef& get_length() const {return m_length;}
 	
 	void sync(DecodeBuffer* buffer);
 	void process_ringbuffer(DecodeBuffer* buffer, bool seeking=false);
 	void prepare_rt_buffers();
+	void free_rt_buffers();
 	BufferStatus* get_buffer_status();
+	bool is_audible_between(const TimeRef& start, const TimeRef& end) const;
 	
 	void set_output_rate(int rate);
 	
@@ -104,6 +108,7 @@ private:
 	int			m_outputRate;
 	
 	BufferStatus*		m_bufferstatus;
+	QVector<audio_sample_t*> m_writeVectors;
 	
 	int ref() { return m_refcount++;}
 	
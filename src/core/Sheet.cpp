@@ -59,6 +59,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Marker.h"
 #include "TInputEventDispatcher.h"                       
 #include "TSend.h"
+#include "TScratchArena.h"
 #include <Plugin.h>
 #include <PluginChain.h>
 
@@ -119,13 +120,10 @@ Sheet::~Sheet()
 {
 	PENTERDES;
 
-	delete [] mixdown;
-	delete [] gainbuffer;
-
-	delete m_diskio;
+	m_project->get_diskio_service()->destroy_diskio(m_diskio);
         delete m_masterOut;
 	delete m_renderBus;
-	delete m_clipRenderBus;
+	delete m_renderArena;
 	delete m_hs;
         delete m_audiodeviceClient;
         delete m_snaplist;
@@ -141,7 +139,7 @@ void Sheet::init()
 
 	QObject::tr("Sheet");
 
-	m_diskio = new DiskIO(this);
+	m_diskio = m_project->get_diskio_service()->create_diskio(this);
 	m_currentSampleRate = audiodevice().get_sample_rate();
 	m_diskio->output_rate_changed(m_currentSampleRate);
 	int converter_type = config().get_property("Conversion", "RTResamplingConverterType", DEFAULT_RESAMPLE_QUALITY).toInt();
@@ -164,8 +162,6 @@ void Sheet::init()
 	connect(this, SIGNAL(transportStarted()), m_diskio, SLOT(start_io()));
 	connect(this, SIGNAL(transportStopped()), m_diskio, SLOT(stop_io()));
 
-	mixdown = gainbuffer = 0;
-
         BusConfig busConfig;
         busConfig.name = "Sheet Render Bus";
         busConfig.channelcount = 2;
@@ -173,8 +169,8 @@ void Sheet::init()
         busConfig.isInternalBus = true;
         m_renderBus = new AudioBus(busConfig);
 
-        busConfig.name = "Sheet Clip Render Bus";
-        m_clipRenderBus = new AudioBus(busConfig);
+        // the arena the export thread processes with
+        m_renderArena = new TScratchArena(false);
 
         m_masterOut = new MasterOutSubGroup(this, tr("Sheet Master"));
         m_masterOut->set_gain(0.5);
@@ -185,6 +181,9 @@ void Sheet::init()
 	m_realtimepath = false;
 	m_changed = m_rendering = m_recording = m_prepareRecording = false;
         m_stopTransport = m_seeking = m_startSeek = 0;
+	m_freewheelExport = FREEWHEEL_IDLE;
+	m_freewheelSpec = 0;
+	m_freewheelCycle = false;
 	
 	m_skipTimer.setSingleShot(true);
 	
@@ -439,6 +438,7 @@ int Sheet::prepare_export(ExportSpecification* spec)
 	m_transportLocation = spec->startLocation;
 	
         resize_buffer(spec->blocksize);
+        m_renderArena->reserve(spec->blocksize);
 	
 	renderDecodeBuffer = new DecodeBuffer;
 
@@ -489,7 +489,11 @@ int Sheet::start_export(ExportSpecification* spec)
 
                 m_project->set_export_message(message);
 
-                while(render(spec) > 0) {}
+                if (spec->freewheel) {
+                        render_freewheel(spec);
+                } else {
+                        while(render(spec) > 0) {}
+                }
 
                 peakvalue = f_max(peakvalue, spec->peakvalue);
                 spec->peakvalue = peakvalue;
@@ -505,53 +509,146 @@ int Sheet::start_export(ExportSpecification* spec)
 }
 
 int Sheet::render(ExportSpecification* spec)
+{
+        int progress = spec->progress;
+
+	m_renderArena->begin_cycle();
+
+	/* do the usual stuff */
+
+	process_export(spec->blocksize);
+
+	/* and now export the results */
+
+        int result = export_cycle(spec, m_masterOut->get_process_bus(), spec->blocksize);
+
+	m_renderArena->end_cycle();
+
+        // only update the progress info if progress is higher then the
+        // old progress value, to avoid a flood of progress changed signals!
+        if (spec->progress > progress) {
+                m_project->set_sheet_export_progress(spec->progress);
+        }
+
+        return result;
+}
+
+/**
+ * Renders the range of \a spec in the audio thread, using the same
+ * process() chain as playback, while the driver is freewheeling.
+ * Each cycle Project::process() hands the output of the Master bus to
+ * freewheel_export_cycle(), this function waits till the range is done.
+ *
+ * When the audio thread stops running cycles the export is abandoned,
+ * but only once the audio thread is known to be out of export_cycle(),
+ * after that the caller may free the export resources.
+ */
+int Sheet::render_freewheel(ExportSpecification* spec)
+{
+        int progress = spec->progress;
+        int stalled = 0;
+        TimeRef pos = spec->pos;
+
+        m_freewheelSpec = spec;
+        m_freewheelExport = FREEWHEEL_RUNNING;
+
+        while (m_freewheelExport != FREEWHEEL_IDLE) {
+                spec->thread->sleep_for(20);
+
+                if (spec->progress > progress) {
+                        progress = spec->progress;
+                        m_project->set_sheet_export_progress(progress);
+                }
+
+                // the audio thread stopped running cycles (driver failure,
+                // or we got disconnected), don't wait forever.
+                if (spec->pos == pos) {
+                        if (++stalled > 100) {
+                                // fails while the audio thread is exporting,
+                                // retry once it left export_cycle()
+                                if (m_freewheelExport.testAndSetOrdered(FREEWHEEL_RUNNING, FREEWHEEL_IDLE)) {
+                                        PERROR("Freewheel export stalled, giving up");
+                                        spec->breakout = true;
+                                        return -1;
+                                }
+                        }
+                } else {
+                        stalled = 0;
+                        pos = spec->pos;
+                }
+        }
+
+        return 1;
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+/**
+ * Exports the output of one freewheeling cycle, read from \a bus, if
+ * process() rendered this cycle for the export.
+ * Ends the freewheel export when the range has been rendered.
+ */
+int Sheet::freewheel_export_cycle(AudioBus* bus, nframes_t nframes)
+{
+        if (!m_freewheelCycle) {
+                return 0;
+        }
+
+        // render_freewheel() gave up on us in the mean time
+        if (!m_freewheelExport.testAndSetOrdered(FREEWHEEL_RUNNING, FREEWHEEL_EXPORTING)) {
+                return 0;
+        }
+
+        if (export_cycle(m_freewheelSpec, bus, nframes) <= 0) {
+                m_freewheelExport = FREEWHEEL_IDLE;
+                return 0;
+        }
+
+        m_freewheelExport = FREEWHEEL_RUNNING;
+
+        return 1;
+}
+
+/**
+ * Copies the first \a nframes frames of \a bus into the export buffer
+ * of \a spec, and normalizes and writes them depending on the render pass.
+ * @return 1 if there is more to render, 0 when done, -1 on write failure
+ */
+int Sheet::export_cycle(ExportSpecification* spec, AudioBus* bus, nframes_t nframes)
 {
 	int chn;
-	uint32_t x;
-        int progress = 0;
 
         nframes_t diff = (spec->cdTrackEnd - spec->pos).to_frame(audiodevice().get_sample_rate());
-	nframes_t nframes = spec->blocksize;
 	nframes_t this_nframes = std::min(diff, nframes);
 
 	if (!spec->running || spec->stop || this_nframes == 0) {
-		process_export (nframes);
-		/*		PWARN("Finished Rendering for this sheet");
-				PWARN("running is %d", spec->running);
-				PWARN("stop is %d", spec->stop);
-                                PWARN("this_nframes is %d", this_nframes);*/
                 return 0;
 	}
 
-	/* do the usual stuff */
-
-	process_export(nframes);
-
-	/* and now export the results */
-
 	nframes = this_nframes;
 
-	memset (spec->dataF, 0, sizeof (spec->dataF[0]) * nframes * spec->channels);
-
 	/* foreach output channel ... */
 
-	float* buf;
-	AudioBus* masterOutBus = m_masterOut->get_process_bus();
+	TScratchArena::Scope scratch;
+	audio_sample_t** buffers = scratch.allocate<audio_sample_t*>(spec->channels);
 
-	for (chn = 0; chn < spec->channels; ++chn) {
-		buf = masterOutBus->get_buffer(chn, nframes);
+	if (!buffers) {
+		return -1;
+	}
 
-		if (!buf) {
+	for (chn = 0; chn < spec->channels; ++chn) {
+		if (chn < bus->get_channel_count()) {
+			buffers[chn] = bus->get_buffer(chn, nframes);
+		} else {
 			// Seem we are exporting at least to Stereo from an AudioBus with only one channel...
 			// Use the first channel..
-			buf = masterOutBus->get_buffer(0, nframes);
-		}
-
-		for (x = 0; x < nframes; ++x) {
-			spec->dataF[chn+(x*spec->channels)] = buf[x];
+			buffers[chn] = bus->get_buffer(0, nframes);
 		}
 	}
 
+	Mixer::interleave(spec->dataF, buffers, spec->channels, nframes);
+
 
 	int bufsize = spec->blocksize * spec->channels;
 	if (spec->normalize) {
@@ -572,13 +669,10 @@ int Sheet::render(ExportSpecification* spec)
 
 	spec->pos.add_frames(nframes, audiodevice().get_sample_rate());
 
-        progress = (int) (double( 100 * (spec->pos - spec->cdTrackStart).universal_frame()) / (spec->totalTime.universal_frame()));
+        int progress = (int) (double( 100 * (spec->pos - spec->cdTrackStart).universal_frame()) / (spec->totalTime.universal_frame()));
 
-        // only update the progress info if progress is higher then the
-        // old progress value, to avoid a flood of progress changed signals!
         if (progress > spec->progress) {
                 spec->progress = progress;
-                m_project->set_sheet_export_progress(progress);
         }
 
         return 1;
@@ -702,6 +796,14 @@ void Sheet::solo_track(Track *track)
 //
 int Sheet::process( nframes_t nframes )
 {
+	// Rendering an export while the driver freewheels: the transport
+	// is stopped, but the Tracks are processed as if it was rolling.
+	m_freewheelCycle = (m_freewheelExport == FREEWHEEL_RUNNING);
+
+	if (m_freewheelCycle) {
+		return process_tracks(nframes);
+	}
+
 	if (m_startSeek) {
                 printf("process: starting seek\n");
 		start_seek();
@@ -727,6 +829,14 @@ int Sheet::process( nframes_t nframes )
 		return 0;
 	}
 
+	return process_tracks(nframes);
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+int Sheet::process_tracks( nframes_t nframes )
+{
 	// zero the m_masterOut buffers
         m_masterOut->get_process_bus()->silence_buffers(nframes);
         apill_foreach(TBusTrack* busTrack, TBusTrack, m_rtBusTracks) {
@@ -736,6 +846,14 @@ int Sheet::process( nframes_t nframes )
 
 	int processResult = 0;
 
+	// Plugins report their latency while running, so the delay
+	// compensation follows changes of it cycle by cycle.
+        apill_foreach(TBusTrack* busTrack, TBusTrack, m_rtBusTracks) {
+                busTrack->update_path_latency(m_rtBusTracks);
+        }
+        apill_foreach(AudioTrack* track, AudioTrack, m_rtAudioTracks) {
+                track->update_path_latency(m_rtBusTracks);
+        }
 
 	// Process all Tracks.
         apill_foreach(AudioTrack* track, AudioTrack, m_rtAudioTracks) {
@@ -767,8 +885,6 @@ int Sheet::process_export( nframes_t nframes )
                 busTrack->get_process_bus()->silence_buffers(nframes);
         }
 
-        memset (mixdown, 0, sizeof (audio_sample_t) * nframes);
-
 	// Process all Tracks.
         apill_foreach(AudioTrack* track, AudioTrack, m_rtAudioTracks) {
 		track->process(nframes);
@@ -791,16 +907,9 @@ int Sheet::process_export( nframes_t nframes )
 
 void Sheet::resize_buffer(nframes_t size)
 {
-	if (mixdown)
-		delete [] mixdown;
-	if (gainbuffer)
-		delete [] gainbuffer;
-	mixdown = new audio_sample_t[size];
-	gainbuffer = new audio_sample_t[size];
         QList<AudioBus*> buses;
         buses.append(m_masterOut->get_process_bus());
         buses.append(m_renderBus);
-        buses.append(m_clipRenderBus);
         foreach(AudioBus* bus, buses) {
                 for(int i=0; i<bus->get_channel_count(); i++) {
                         if (AudioChannel* chan = bus->get_channel(i)) {
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TSession.h"
 #include <QDomNode>
 #include <QTimer>
+#include <QAtomicInt>
 #include "defines.h"
 #include "APILinkedList.h"
 
@@ -35,6 +36,7 @@ class WriteSource;
 class AudioTrack;
 class AudioClip;
 class DiskIO;
+class TScratchArena;
 class AudioClipManager;
 class TAudioDeviceClient;
 class AudioBus;
@@ -70,7 +72,6 @@ public:
 	DiskIO*	get_diskio() const;
 	AudioClipManager* get_audioclip_manager() const;
 	AudioBus* get_render_bus() const {return m_renderBus;}
-	AudioBus* get_clip_render_bus() const {return m_clipRenderBus;}
         AudioTrack* get_audio_track_for_index(int index);
         QString get_audio_sources_dir() const;
         TimeRef get_last_location() const;
@@ -95,6 +96,7 @@ public:
 	int prepare_export(ExportSpecification* spec);
 	int render(ExportSpecification* spec);
         int start_export(ExportSpecification* spec);
+	int freewheel_export_cycle(AudioBus* bus, nframes_t nframes);
 
         void solo_track(Track* track);
 	void create(int tracksToCreate);
@@ -107,7 +109,6 @@ public:
         bool is_recording() const {return m_recording;}
 	bool is_smaller_then(APILinkedListNode* node) {Q_UNUSED(node); return false;}
 
-        audio_sample_t*		readbuffer;
         DecodeBuffer*		renderDecodeBuffer;
 
 #if defined (THREAD_CHECK)
@@ -121,7 +122,7 @@ private:
 	WriteSource*		m_exportSource;
         TAudioDeviceClient*	m_audiodeviceClient;
         AudioBus*		m_renderBus;
-	AudioBus*		m_clipRenderBus;
+	TScratchArena*		m_renderArena;
 	DiskIO*			m_diskio;
 	AudioClipManager*	m_acmanager;
 	QList<TimeRef>		m_xposList;
@@ -137,6 +138,11 @@ private:
 	volatile size_t		m_seeking;
 	volatile size_t		m_startSeek;
         volatile size_t		m_stopTransport;
+	// FREEWHEEL_* states, only the audio thread moves it to and out of
+	// FREEWHEEL_EXPORTING, see render_freewheel()
+	QAtomicInt		m_freewheelExport;
+	ExportSpecification*	m_freewheelSpec;
+	bool			m_freewheelCycle;
 
 
         QString 	m_artists;
@@ -149,9 +155,18 @@ private:
 	bool		m_prepareRecording;
 	bool		m_readyToRecord;
 	
+	enum {
+		FREEWHEEL_IDLE,
+		FREEWHEEL_RUNNING,
+		FREEWHEEL_EXPORTING	// audio thread is inside export_cycle()
+	};
+
 	void init();
 
 	int finish_audio_export();
+	int render_freewheel(ExportSpecification* spec);
+	int export_cycle(ExportSpecification* spec, AudioBus* bus, nframes_t nframes);
+	int process_tracks(nframes_t nframes);
 	void start_seek();
         void initiate_seek_start(TimeRef location);
 	void start_transport_rolling(bool realtime);
@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Utils.h"
 #include "TSession.h"
 #include "AudioDevice.h"
+#include "TScratchArena.h"
 
 TBusTrack::TBusTrack(TSession* session, const QString& name, int channelCount)
         : Track(session)
@@ -97,6 +98,7 @@ void TBusTrack::create_process_bus()
         busConfig.isInternalBus = true;
         busConfig.id = m_id;
         m_processBus = new AudioBus(busConfig);
+        m_mixdownFallback.resize(m_processBus->get_channel_count());
 }
 
 void TBusTrack::set_name( const QString & name )
@@ -108,6 +110,14 @@ void TBusTrack::set_name( const QString & name )
 int TBusTrack::process(nframes_t nframes)
 {
         if (m_isMuted || (get_gain() == 0.0f) ) {
+                process_silent_post_sends(nframes);
+                return 0;
+        }
+
+        // No Track did send anything to us, skip the whole chain unless
+        // plugins (e.g. a reverb tail) could still produce audio
+        if (m_processBus->is_silent(nframes) && !m_pluginChain->has_plugins()) {
+                process_silent_post_sends(nframes);
                 return 0;
         }
 
@@ -115,30 +125,21 @@ int TBusTrack::process(nframes_t nframes)
 
         m_pluginChain->process_pre_fader(m_processBus, nframes);
 
-        m_fader->process(m_processBus, nframes);
-
-        float panFactor;
-
-        if ( (m_processBus->get_channel_count() >= 1) && (m_pan > 0) )  {
-                panFactor = 1 - m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(0, nframes), nframes, panFactor);
-        }
-
-        if ( (m_processBus->get_channel_count() >= 2) && (m_pan < 0) )  {
-                panFactor = 1 + m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(1, nframes), nframes, panFactor);
-        }
-
 	// gain automation curve only understands audio_sample_t** atm
 	// so wrap the process buffers into a audio_sample_t**
-	audio_sample_t* mixdown[m_processBus->get_channel_count()];
+	TScratchArena::Scope scratch;
+	audio_sample_t** mixdown = scratch.allocate<audio_sample_t*>(m_processBus->get_channel_count());
+	if (!mixdown) {
+		// never skip gain and pan, fall back to the preallocated wrapper
+		mixdown = m_mixdownFallback.data();
+	}
 	for(int chan=0; chan<m_processBus->get_channel_count(); chan++) {
 		mixdown[chan] = m_processBus->get_buffer(chan, nframes);
 	}
 
 	TimeRef location = m_session->get_transport_location();
 	TimeRef endlocation = location + TimeRef(nframes, audiodevice().get_sample_rate());
-	m_fader->process_gain(mixdown, location, endlocation, nframes, m_processBus->get_channel_count());
+	m_fader->process_gain_and_pan(mixdown, location, endlocation, nframes, m_processBus->get_channel_count(), m_pan);
 
 
         m_pluginChain->process_post_fader(m_processBus, nframes);
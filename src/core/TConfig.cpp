@@ -129,6 +129,9 @@ void TConfig::set_audiodevice_driver_properties()
 	QHash<QString, QVariant> hardwareconfigs;
 	hardwareconfigs.insert("jackslave", get_property("Hardware", "jackslave", false));
 	hardwareconfigs.insert("numberofperiods", get_property("Hardware", "numberofperiods", 3));
+	hardwareconfigs.insert("filedriverinput", get_property("Hardware", "filedriverinput", ""));
+	hardwareconfigs.insert("filedriveroutput", get_property("Hardware", "filedriveroutput", ""));
+	hardwareconfigs.insert("filedriverfreewheel", get_property("Hardware", "filedriverfreewheel", false));
 	
 	audiodevice().set_driver_properties(hardwareconfigs);
 }
@@ -0,0 +1,453 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TPeakFile.h"
+
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <cmath>
+
+#include "Debugger.h"
+
+#define PEAKFILE_LABEL		"TRAVPK"
+#define PEAKFILE_MAJOR_VERSION	2
+#define PEAKFILE_MINOR_VERSION	1
+
+// amount of bytes sampled at the start, middle and end of a source file
+#define FINGERPRINT_CHUNK_SIZE	65536
+
+// peak_data_t range used by Peak, including its headroom
+static const int MAX_PEAK_VALUE = 32767;
+
+
+/**
+ * Encodes \a value as a signed 8 bit code: 0 for 0, otherwise the sign
+ * and 1 + the log scaled magnitude (1 - 127). Upper peaks of a bucket
+ * below zero and lower peaks of a bucket above zero are negative, so the
+ * sign can't be dropped. Steps are ~0.7 dB, plenty for coarse zoom levels.
+ */
+static inline unsigned char log8_encode(peak_data_t value)
+{
+	if (value == 0) {
+		return 0;
+	}
+
+	int magnitude = qAbs(int(value));
+	int code = 1 + int(log(double(magnitude)) / log(double(MAX_PEAK_VALUE)) * 126.0 + 0.5);
+	code = qMin(code, 127);
+
+	return (unsigned char) (signed char) (value < 0 ? -code : code);
+}
+
+struct Log8DecodeTable {
+	Log8DecodeTable() {
+		// LOG_8, positive values only
+		unsignedValues[0] = 0.0f;
+		for (int code=1; code<256; ++code) {
+			unsignedValues[code] = float(exp((code - 1) / 254.0 * log(double(MAX_PEAK_VALUE))));
+		}
+		// LOG_8_SIGNED, indexed by the byte as stored
+		for (int byte=0; byte<256; ++byte) {
+			int code = (signed char) byte;
+			int magnitude = qMin(qAbs(code), 127);
+			float value = magnitude ? float(exp((magnitude - 1) / 126.0 * log(double(MAX_PEAK_VALUE)))) : 0.0f;
+			signedValues[byte] = code < 0 ? -value : value;
+		}
+	}
+	float unsignedValues[256];
+	float signedValues[256];
+};
+
+static const Log8DecodeTable& log8_decode_table()
+{
+	static Log8DecodeTable table;
+	return table;
+}
+
+
+TPeakFile::TPeakFile()
+	: m_dataStart(0)
+	, m_channels(0)
+	, m_normValueCount(0)
+	, m_cachedLevel(-1)
+	, m_cachedBlock(-1)
+{
+}
+
+TPeakFile::~TPeakFile()
+{
+	close();
+}
+
+/**
+ * Opens the peak file \a fileName for reading.
+ * @return 1 on success, -1 if the file couldn't be opened, isn't a
+ *	peak file of this version, or wasn't created for a source with
+ *	fingerprint \a fingerprint.
+ */
+int TPeakFile::open(const QString& fileName, const QByteArray& fingerprint)
+{
+	close();
+
+	// the source couldn't be read, nothing can match it
+	if (fingerprint.isEmpty()) {
+		return -1;
+	}
+
+	m_file.setFileName(fileName);
+
+	if (!m_file.open(QIODevice::ReadOnly)) {
+		return -1;
+	}
+
+	QDataStream stream(&m_file);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	char label[6];
+	qint32 major, minor;
+	stream.readRawData(label, sizeof(label));
+	stream >> major >> minor;
+
+	if (memcmp(label, PEAKFILE_LABEL, sizeof(label)) != 0 || major != PEAKFILE_MAJOR_VERSION) {
+		printf("TPeakFile: %s either isn't a Traverso Peak file, or the version doesn't match!\n", QS_C(fileName));
+		close();
+		return -1;
+	}
+
+	QByteArray storedFingerprint;
+	qint32 channels, levelCount, blockSize, normValueCount;
+	stream >> storedFingerprint >> channels >> levelCount >> blockSize >> normValueCount;
+
+	if (storedFingerprint != fingerprint) {
+		PERROR("TPeakFile: %s doesn't match its audio source (anymore)", QS_C(fileName));
+		close();
+		return -1;
+	}
+
+	if (blockSize != BLOCK_SIZE || channels <= 0 || levelCount <= 0) {
+		PERROR("TPeakFile: %s has an invalid header", QS_C(fileName));
+		close();
+		return -1;
+	}
+
+	m_channels = channels;
+	m_normValueCount = normValueCount;
+
+	for (int i=0; i<levelCount; ++i) {
+		Level level;
+		qint32 format, size, blockCount;
+		stream >> format >> size >> blockCount;
+
+		if (format != LINEAR_16 && format != LOG_8 && format != LOG_8_SIGNED) {
+			PERROR("TPeakFile: %s uses an unknown level format %d", QS_C(fileName), format);
+			close();
+			return -1;
+		}
+
+		level.format = format;
+		level.size = size;
+		level.blockOffsets.resize(blockCount);
+		level.blockSizes.resize(blockCount);
+
+		for (int b=0; b<blockCount; ++b) {
+			qint64 offset;
+			qint32 compressedSize;
+			stream >> offset >> compressedSize;
+			level.blockOffsets[b] = offset;
+			level.blockSizes[b] = compressedSize;
+		}
+
+		m_levels.append(level);
+	}
+
+	if (stream.status() != QDataStream::Ok) {
+		PERROR("TPeakFile: %s has a truncated header", QS_C(fileName));
+		close();
+		return -1;
+	}
+
+	m_dataStart = m_file.pos();
+
+	return 1;
+}
+
+void TPeakFile::close()
+{
+	if (m_file.isOpen()) {
+		m_file.close();
+	}
+
+	m_levels.clear();
+	m_cachedLevel = m_cachedBlock = -1;
+}
+
+int TPeakFile::load_block(int level, int block)
+{
+	if (level == m_cachedLevel && block == m_cachedBlock) {
+		return 1;
+	}
+
+	const Level& l = m_levels.at(level);
+
+	if (block >= l.blockOffsets.size()) {
+		return -1;
+	}
+
+	if (!m_file.seek(m_dataStart + l.blockOffsets.at(block))) {
+		PERROR("TPeakFile: could not seek to block %d of level %d", block, level);
+		return -1;
+	}
+
+	QByteArray data = qUncompress(m_file.read(l.blockSizes.at(block)));
+
+	int blockValues = qMin(BLOCK_SIZE, l.size - block * BLOCK_SIZE);
+	int valueSize = (l.format == LINEAR_16) ? sizeof(peak_data_t) : 1;
+
+	if (data.size() != blockValues * m_channels * valueSize) {
+		PERROR("TPeakFile: block %d of level %d is corrupt", block, level);
+		m_cachedLevel = m_cachedBlock = -1;
+		return -1;
+	}
+
+	m_cachedValues.resize(blockValues * m_channels);
+	float* values = m_cachedValues.data();
+
+	if (l.format != LINEAR_16) {
+		const float* table = (l.format == LOG_8) ? log8_decode_table().unsignedValues : log8_decode_table().signedValues;
+		const unsigned char* codes = (const unsigned char*) data.constData();
+		for (int i=0; i<m_cachedValues.size(); ++i) {
+			values[i] = table[codes[i]];
+		}
+	} else {
+		const peak_data_t* peaks = (const peak_data_t*) data.constData();
+		for (int i=0; i<m_cachedValues.size(); ++i) {
+			values[i] = float(peaks[i]);
+		}
+	}
+
+	m_cachedLevel = level;
+	m_cachedBlock = block;
+
+	return 1;
+}
+
+/**
+ * Copies \a count peak values of channel \a chan and zoom level \a level,
+ * starting at value \a offset into \a buffer.
+ * @return The amount of values copied, less then \a count at the end of the data
+ */
+int TPeakFile::read_peaks(int chan, int level, int offset, int count, float* buffer)
+{
+	if (!m_file.isOpen() || level < 0 || level >= m_levels.size() || chan >= m_channels) {
+		return 0;
+	}
+
+	int size = m_levels.at(level).size;
+	int produced = 0;
+
+	while (produced < count && offset < size) {
+		int block = offset / BLOCK_SIZE;
+
+		if (load_block(level, block) < 0) {
+			break;
+		}
+
+		int blockStart = block * BLOCK_SIZE;
+		int blockValues = qMin(BLOCK_SIZE, size - blockStart);
+		int toCopy = qMin(count - produced, blockValues - (offset - blockStart));
+
+		memcpy(buffer + produced,
+		       m_cachedValues.constData() + chan * blockValues + (offset - blockStart),
+		       toCopy * sizeof(float));
+
+		produced += toCopy;
+		offset += toCopy;
+	}
+
+	return produced;
+}
+
+int TPeakFile::read_norm_values(int chan, int start, int count, audio_sample_t* buffer)
+{
+	if (!m_file.isOpen() || chan >= m_channels || start >= m_normValueCount) {
+		return 0;
+	}
+
+	count = qMin(count, m_normValueCount - start);
+	qint64 position = m_dataStart + (qint64(chan) * m_normValueCount + start) * sizeof(audio_sample_t);
+
+	if (!m_file.seek(position)) {
+		return 0;
+	}
+
+	return m_file.read((char*)buffer, count * sizeof(audio_sample_t)) / sizeof(audio_sample_t);
+}
+
+/**
+ * Writes a peak file for a source with fingerprint \a fingerprint.
+ * \a channelLevels holds the peak data of each zoom level of each channel,
+ * levels starting at \a firstLog8Level are stored 8 bit log scaled.
+ * The file is written next to \a fileName first and then renamed, so
+ * readers never see a partially written file.
+ * @return 1 on success, -1 on failure
+ */
+int TPeakFile::write(
+	const QString& fileName,
+	const QByteArray& fingerprint,
+	const QList<QList<QVector<peak_data_t> > >& channelLevels,
+	const QList<QVector<audio_sample_t> >& channelNormValues,
+	int firstLog8Level)
+{
+	PENTER;
+
+	int channels = channelLevels.size();
+	if (channels == 0 || channelNormValues.size() != channels || fingerprint.isEmpty()) {
+		return -1;
+	}
+
+	int levelCount = channelLevels.at(0).size();
+	int normValueCount = channelNormValues.at(0).size();
+
+	// compress all blocks first, their sizes are part of the header
+	QList<QList<QByteArray> > blocks;
+
+	for (int level=0; level<levelCount; ++level) {
+		int size = channelLevels.at(0).at(level).size();
+		bool log8 = level >= firstLog8Level;
+		QList<QByteArray> levelBlocks;
+
+		for (int blockStart=0; blockStart<size; blockStart+=BLOCK_SIZE) {
+			int blockValues = qMin(BLOCK_SIZE, size - blockStart);
+			QByteArray raw;
+			raw.resize(blockValues * channels * (log8 ? 1 : sizeof(peak_data_t)));
+
+			for (int chan=0; chan<channels; ++chan) {
+				const peak_data_t* peaks = channelLevels.at(chan).at(level).constData() + blockStart;
+
+				if (log8) {
+					unsigned char* codes = (unsigned char*) raw.data() + chan * blockValues;
+					for (int i=0; i<blockValues; ++i) {
+						codes[i] = log8_encode(peaks[i]);
+					}
+				} else {
+					memcpy(raw.data() + chan * blockValues * sizeof(peak_data_t), peaks, blockValues * sizeof(peak_data_t));
+				}
+			}
+
+			levelBlocks.append(qCompress(raw));
+		}
+
+		blocks.append(levelBlocks);
+	}
+
+	QString partFileName = fileName + ".part";
+	QFile file(partFileName);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		PWARN("Couldn't open peak file for writing! (%s)", QS_C(partFileName));
+		return -1;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	stream.writeRawData(PEAKFILE_LABEL, 6);
+	stream << qint32(PEAKFILE_MAJOR_VERSION) << qint32(PEAKFILE_MINOR_VERSION);
+	stream << fingerprint << qint32(channels) << qint32(levelCount) << qint32(BLOCK_SIZE) << qint32(normValueCount);
+
+	// block offsets are relative to the end of the header,
+	// the normalization data comes first.
+	qint64 offset = qint64(channels) * normValueCount * sizeof(audio_sample_t);
+
+	for (int level=0; level<levelCount; ++level) {
+		const QList<QByteArray>& levelBlocks = blocks.at(level);
+		int format = (level >= firstLog8Level) ? LOG_8_SIGNED : LINEAR_16;
+
+		stream << qint32(format) << qint32(channelLevels.at(0).at(level).size()) << qint32(levelBlocks.size());
+
+		foreach(const QByteArray& block, levelBlocks) {
+			stream << offset << qint32(block.size());
+			offset += block.size();
+		}
+	}
+
+	for (int chan=0; chan<channels; ++chan) {
+		stream.writeRawData((const char*) channelNormValues.at(chan).constData(), normValueCount * sizeof(audio_sample_t));
+	}
+
+	foreach(const QList<QByteArray>& levelBlocks, blocks) {
+		foreach(const QByteArray& block, levelBlocks) {
+			stream.writeRawData(block.constData(), block.size());
+		}
+	}
+
+	file.close();
+
+	if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+		PERROR("Failed to write peak file %s", QS_C(partFileName));
+		QFile::remove(partFileName);
+		return -1;
+	}
+
+	QFile::remove(fileName);
+
+	if (!QFile::rename(partFileName, fileName)) {
+		PERROR("Failed to rename %s to %s", QS_C(partFileName), QS_C(fileName));
+		QFile::remove(partFileName);
+		return -1;
+	}
+
+	return 1;
+}
+
+/**
+ * Returns a fingerprint of the contents of the audio file \a fileName.
+ * Hashing the complete file would take about as long as building the
+ * peak data itself, so only its size and its start, middle and end are used.
+ * @return The fingerprint, empty if \a fileName couldn't be read. An empty
+ *	fingerprint never matches a peak file, nor is one written with it.
+ */
+QByteArray TPeakFile::source_fingerprint(const QString& fileName)
+{
+	QFile file(fileName);
+
+	if (!file.open(QIODevice::ReadOnly)) {
+		return QByteArray();
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	qint64 size = file.size();
+
+	hash.addData(QByteArray::number(size));
+
+	qint64 positions[3] = {0, size / 2 - FINGERPRINT_CHUNK_SIZE / 2, size - FINGERPRINT_CHUNK_SIZE};
+
+	for (int i=0; i<3; ++i) {
+		if (!file.seek(qMax(qint64(0), positions[i]))) {
+			break;
+		}
+		hash.addData(file.read(FINGERPRINT_CHUNK_SIZE));
+	}
+
+	return hash.result();
+}
+
+//eof
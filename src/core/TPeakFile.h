@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TPEAK_FILE_H
+#define TPEAK_FILE_H
+
+#include <QFile>
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+
+#include "defines.h"
+
+/**
+ * Single file, multichannel container for the peak data of one audio source.
+ *
+ * The file starts with a header holding the zoom level layout and a block
+ * index, followed by the normalization values of all channels and then the
+ * peak data blocks of all zoom levels. A block holds BLOCK_SIZE peak values
+ * of each channel, channel after channel, and is stored zlib compressed.
+ * Coarse zoom levels can be stored as signed 8 bit log scaled values instead of
+ * 16 bit linear ones.
+ *
+ * A peak file is tied to its source by a fingerprint of the source file's
+ * contents, not by modification times, so copied or moved projects keep
+ * their peak data.
+ *
+ * The header is written with QDataStream, the peak and normalization data
+ * itself is stored in host byte order, as it always was.
+ */
+class TPeakFile
+{
+public:
+	TPeakFile();
+	~TPeakFile();
+
+	enum LevelFormat {
+		LINEAR_16 = 0,
+		LOG_8 = 1,		// version 2.0 files, negative values were stored as 0
+		LOG_8_SIGNED = 2
+	};
+
+	static const int BLOCK_SIZE = 8192;
+
+	int open(const QString& fileName, const QByteArray& fingerprint);
+	void close();
+	bool is_open() const {return m_file.isOpen();}
+	int get_norm_value_count() const {return m_normValueCount;}
+
+	int read_peaks(int chan, int level, int offset, int count, float* buffer);
+	int read_norm_values(int chan, int start, int count, audio_sample_t* buffer);
+
+	static int write(const QString& fileName,
+			 const QByteArray& fingerprint,
+			 const QList<QList<QVector<peak_data_t> > >& channelLevels,
+			 const QList<QVector<audio_sample_t> >& channelNormValues,
+			 int firstLog8Level);
+
+	static QByteArray source_fingerprint(const QString& fileName);
+
+private:
+	struct Level {
+		int		format;
+		int		size;
+		QVector<qint64>	blockOffsets;
+		QVector<int>	blockSizes;
+	};
+
+	QFile		m_file;
+	qint64		m_dataStart;
+	int		m_channels;
+	int		m_normValueCount;
+	QList<Level>	m_levels;
+
+	// the last decompressed block, all channels
+	int		m_cachedLevel;
+	int		m_cachedBlock;
+	QVector<float>	m_cachedValues;
+
+	int load_block(int level, int block);
+};
+
+#endif
+
+//eof
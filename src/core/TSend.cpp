@@ -27,6 +27,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Utils.h"
 #include "Track.h"
 
+#include <cstring>
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
 
 TSend::TSend(Track* track)
         : m_track(track)
@@ -42,6 +48,13 @@ TSend::TSend(Track* track, AudioBus* bus)
         m_bus = bus;
         m_id = create_id();
         init();
+        update_delay_buffers();
+}
+
+TSend::~TSend()
+{
+        m_type = 0;
+        update_delay_buffers();
 }
 
 void TSend::init()
@@ -49,6 +62,91 @@ void TSend::init()
         m_type = POSTSEND;
         m_gain = 1.0;
         m_pan = 0.0;
+        m_appliedGain[0] = m_appliedGain[1] = -1.0f;
+        m_delayBuffers = 0;
+        m_delayChannels = 0;
+        m_delay = 0;
+        m_delayWritePos = 0;
+        m_delaySilentFrames = DELAY_BUFFER_SIZE;
+}
+
+void TSend::set_type(int type)
+{
+        m_type = type;
+        update_delay_buffers();
+}
+
+/**
+ * Allocates the delay line of a post send once it's bus is known, or
+ * frees it for other send types. Not to be called from the audio thread.
+ */
+void TSend::update_delay_buffers()
+{
+        bool needed = (m_type == POSTSEND && m_bus);
+
+        if (needed && !m_delayBuffers) {
+                m_delayChannels = m_bus->get_channel_count();
+                m_delayBuffers = new audio_sample_t*[m_delayChannels];
+                for (int i = 0; i < m_delayChannels; ++i) {
+                        m_delayBuffers[i] = new audio_sample_t[DELAY_BUFFER_SIZE];
+                        memset(m_delayBuffers[i], 0, DELAY_BUFFER_SIZE * sizeof(audio_sample_t));
+                }
+        } else if (!needed && m_delayBuffers) {
+                for (int i = 0; i < m_delayChannels; ++i) {
+                        delete [] m_delayBuffers[i];
+                }
+                delete [] m_delayBuffers;
+                m_delayBuffers = 0;
+                m_delayChannels = 0;
+                m_delay = 0;
+        }
+}
+
+/**
+ * Sets the delay, clamped to MAX_DELAY, without delay line the delay
+ * stays 0.
+ */
+void TSend::set_delay(nframes_t delay)
+{
+        m_delay = has_delay_buffers() ? qMin(delay, nframes_t(MAX_DELAY)) : 0;
+}
+
+/**
+ * Writes the first \a nframes of \a bus into the delay line, or silence
+ * if \a silent is true. Runs every cycle, also without delay, so the
+ * history is there as soon as a delay is set.
+ */
+void TSend::write_delay(AudioBus* bus, nframes_t nframes, bool silent)
+{
+        // the whole line holds silence already, only move on
+        if (silent && m_delaySilentFrames >= DELAY_BUFFER_SIZE) {
+                m_delayWritePos = (m_delayWritePos + nframes) & (DELAY_BUFFER_SIZE - 1);
+                return;
+        }
+
+        nframes_t first = qMin(nframes, DELAY_BUFFER_SIZE - m_delayWritePos);
+        int channels = qMin(m_delayChannels, bus->get_channel_count());
+
+        for (int i = 0; i < m_delayChannels; ++i) {
+                audio_sample_t* ring = m_delayBuffers[i];
+
+                if (silent || i >= channels) {
+                        memset(ring + m_delayWritePos, 0, first * sizeof(audio_sample_t));
+                        memset(ring, 0, (nframes - first) * sizeof(audio_sample_t));
+                } else {
+                        audio_sample_t* src = bus->get_buffer(i, nframes);
+                        memcpy(ring + m_delayWritePos, src, first * sizeof(audio_sample_t));
+                        memcpy(ring, src + first, (nframes - first) * sizeof(audio_sample_t));
+                }
+        }
+
+        m_delayWritePos = (m_delayWritePos + nframes) & (DELAY_BUFFER_SIZE - 1);
+
+        if (silent) {
+                m_delaySilentFrames = qMin(m_delaySilentFrames + nframes, nframes_t(DELAY_BUFFER_SIZE));
+        } else {
+                m_delaySilentFrames = 0;
+        }
 }
 
 QDomNode TSend::get_state( QDomDocument doc)
@@ -108,6 +206,7 @@ int TSend::set_state( const QDomNode & node )
                 return -1;
         }
 
+        update_delay_buffers();
 
         return 1;
 }
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #define TSEND_H
 
 #include "APILinkedList.h"
+#include "defines.h"
 
 #include <QDomElement>
 
@@ -35,11 +36,17 @@ class TSend : public APILinkedListNode
 public:
         TSend(Track* track);
         TSend(Track* track, AudioBus* bus);
+        ~TSend();
+
+        // Post sends delay what they mix into their bus by up to
+        // MAX_DELAY frames, see Track::update_path_latency()
+        static const nframes_t DELAY_BUFFER_SIZE = 16384;
+        static const nframes_t MAX_DELAY = DELAY_BUFFER_SIZE / 2;
 
         QDomNode get_state( QDomDocument doc);
         int set_state( const QDomNode& node );
 
-        void set_type(int type) {m_type = type;}
+        void set_type(int type);
         void set_gain(float gain);
         void set_pan(float pan);
 
@@ -59,6 +66,20 @@ public:
         float get_pan() const {return m_pan;}
         float get_gain() const {return m_gain;}
 
+        // gain per channel (pan law included) mixed into the bus in the
+        // previous process cycle, used by Track::process_send() to ramp
+        float get_applied_gain(int channel) const {return m_appliedGain[channel];}
+        void set_applied_gain(int channel, float gain) {m_appliedGain[channel] = gain;}
+
+
+        // audio thread
+        void set_delay(nframes_t delay);
+        nframes_t get_delay() const {return m_delay;}
+        void write_delay(AudioBus* bus, nframes_t nframes, bool silent);
+        bool is_delay_output_silent(nframes_t nframes) const {return m_delaySilentFrames >= m_delay + nframes;}
+        nframes_t get_delay_read_position(nframes_t nframes) const {return (m_delayWritePos - nframes - m_delay) & (DELAY_BUFFER_SIZE - 1);}
+        audio_sample_t* get_delay_buffer(int channel) const {return m_delayBuffers[channel];}
+        bool has_delay_buffers() const {return m_delayChannels > 0;}
 
         bool is_smaller_then(APILinkedListNode* node) {return true;}
 
@@ -69,8 +90,17 @@ private:
         int             m_type;
         float           m_gain;
         float           m_pan;
+        float           m_appliedGain[2];
+
+        // one ring buffer per bus channel, for post sends only
+        audio_sample_t** m_delayBuffers;
+        int             m_delayChannels;
+        nframes_t       m_delay;
+        nframes_t       m_delayWritePos;
+        nframes_t       m_delaySilentFrames;
 
         void init();
+        void update_delay_buffers();
 };
 
 #endif // TSEND_H
@@ -94,9 +94,6 @@ public:
 	void add_child_session(TSession* child);
 	void remove_child_session(TSession* child);
 
-	audio_sample_t* 	mixdown;
-	audio_sample_t*		gainbuffer;
-
 	enum Mode {
 		EDIT = 1,
 		EFFECTS = 2
@@ -54,6 +54,7 @@ Themer* Themer::instance()
 }
 
 Themer::Themer()
+	: m_generation(0)
 {
 	m_watcher = new QFileSystemWatcher(this);
 
@@ -362,6 +363,7 @@ void Themer::load( )
         m_cursors.insert("UD", QCursor(find_pixmap(":/cursorHoldUd")));
 
         validate_loaded_theme();
+	resolve_tokens();
 
 	QFile cf("/home/remon/.traverso/themes/style.qss");
 	if (cf.open(QIODevice::ReadOnly))
@@ -449,6 +451,60 @@ QCursor Themer::get_cursor(const QString & name) const
 	return m_cursors.value(name);
 }
 
+// Returns a token for the theme element "name", the token stays valid
+// for the lifetime of the Themer, across theme reloads.
+int Themer::get_token(const QString& name)
+{
+	QHash<QString, int>::const_iterator it = m_tokens.constFind(name);
+	if (it != m_tokens.constEnd()) {
+		return it.value();
+	}
+
+	int token = m_tokenNames.size();
+	m_tokens.insert(name, token);
+	m_tokenNames.append(name);
+	m_tokenColors.append(QColor());
+	m_tokenFonts.append(QFont());
+	m_tokenProperties.append(QVariant());
+	resolve_token(token);
+
+	return token;
+}
+
+QVariant Themer::get_property(int token, const QVariant& defaultValue) const
+{
+	const QVariant& value = m_tokenProperties.at(token);
+	if (!value.isValid()) {
+		return defaultValue;
+	}
+	return value;
+}
+
+QBrush Themer::get_brush(int token, QPoint start, QPoint stop) const
+{
+	return get_brush(m_tokenNames.at(token), start, stop);
+}
+
+void Themer::resolve_token(int token)
+{
+	const QString& name = m_tokenNames.at(token);
+
+	// a token can be a color, a font or a property, so don't
+	// complain here about the parts that don't exist.
+	m_tokenColors[token] = m_colors.value(name, m_defaultColors.value(name, QColor(Qt::blue)));
+	m_tokenFonts[token] = m_fonts.value(name);
+	m_tokenProperties[token] = m_properties.value(name);
+}
+
+// Called each time the theme changed, before themeLoaded() is emitted
+void Themer::resolve_tokens()
+{
+	for (int i=0; i<m_tokenNames.size(); ++i) {
+		resolve_token(i);
+	}
+	++m_generation;
+}
+
 void Themer::reload_on_themefile_change(const QString&)
 {
 	m_colors.clear();
@@ -666,5 +722,6 @@ QList<QString> Themer::get_colors()
 void Themer::set_new_theme_color(const QString &name, const QColor &color)
 {
         m_colors.insert(name, color);
+        resolve_tokens();
         emit themeLoaded();
 }
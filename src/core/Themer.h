@@ -32,6 +32,8 @@
 #include <QString>
 #include <QVariant>
 #include <QPalette>
+#include <QVector>
+#include <QBrush>
 
 class QFileSystemWatcher;
 
@@ -57,6 +59,14 @@ public:
 	QCursor get_cursor(const QString& name) const;
 	QBrush get_brush(const QString& name, QPoint start = QPoint(0,0), QPoint stop = QPoint(0,0)) const;
 	QLinearGradient get_gradient(const QString& name) const;
+
+	// Token based lookups for paint paths, see ThemeElement.
+	int get_token(const QString& name);
+	QColor get_color(int token) const {return m_tokenColors.at(token);}
+	QFont get_font(int token) const {return m_tokenFonts.at(token);}
+	QVariant get_property(int token, const QVariant& defaultValue=0) const;
+	QBrush get_brush(int token, QPoint start = QPoint(0,0), QPoint stop = QPoint(0,0)) const;
+	int get_generation() const {return m_generation;}
 	
 	static Themer* instance();
 	
@@ -77,7 +87,16 @@ private:
 	QPalette 		m_systempallete;
 	QString			m_currentTheme;
 
+	QHash<QString, int>	m_tokens;
+	QVector<QString>	m_tokenNames;
+	QVector<QColor>		m_tokenColors;
+	QVector<QFont>		m_tokenFonts;
+	QVector<QVariant>	m_tokenProperties;
+	int			m_generation;
+
 	QColor get_default_color(const QString& name);
+	void resolve_token(int token);
+	void resolve_tokens();
 
 	static Themer* m_instance;
         
@@ -92,5 +111,62 @@ signals:
 // use this function to get the Colormanager object
 Themer* themer();
 
+
+/**
+ * Caches the color, brush and font of one theme element for use in
+ * paint paths. The name is resolved to a Themer token on first use,
+ * after that a lookup is an integer compare against the Themer's
+ * generation, which changes each time a theme is (re)loaded.
+ *
+ * Typically used as a function local static in a paint() method:
+ *
+ *	static ThemeElement contour("AudioClip:contour");
+ *	painter->setPen(contour.color());
+ */
+class ThemeElement
+{
+public:
+	ThemeElement(const QString& name)
+		: m_name(name)
+		, m_token(-1)
+		, m_generation(-1)
+		, m_brushGeneration(-1)
+	{}
+
+	const QColor& color() {sync(); return m_color;}
+	const QFont& font() {sync(); return m_font;}
+	const QBrush& brush() {
+		sync();
+		// only resolved on request, the Themer warns about missing brushes
+		if (m_brushGeneration != m_generation) {
+			m_brush = themer()->get_brush(m_token);
+			m_brushGeneration = m_generation;
+		}
+		return m_brush;
+	}
+
+private:
+	QString	m_name;
+	int	m_token;
+	int	m_generation;
+	int	m_brushGeneration;
+	QColor	m_color;
+	QBrush	m_brush;
+	QFont	m_font;
+
+	void sync() {
+		Themer* t = themer();
+		if (m_generation == t->get_generation()) {
+			return;
+		}
+		if (m_token < 0) {
+			m_token = t->get_token(m_name);
+		}
+		m_color = t->get_color(m_token);
+		m_font = t->get_font(m_token);
+		m_generation = t->get_generation();
+	}
+};
+
 #endif
 
@@ -33,6 +33,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Utils.h"
 #include "TBusTrack.h"
 #include "TSend.h"
+#include "TScratchArena.h"
+#include "Information.h"
 
 #include "Debugger.h"
 
@@ -43,6 +45,8 @@ Track::Track(TSession* session)
 	m_isSolo = m_mutedBySolo = m_isMuted = false;
 	m_showTrackVolumeAutomation = false;
 	m_preSendOn = false;
+        m_pathLatency = 0;
+        m_pathLatencyClamped = false;
         m_inputBus = 0;
         m_channelCount = 2;
 
@@ -54,6 +58,8 @@ Track::Track(TSession* session)
         if (project) {
                 connect(this, SIGNAL(routingConfigurationChanged()), project, SLOT(track_property_changed()));
         }
+
+        connect(this, SIGNAL(pathLatencyClamped()), this, SLOT(path_latency_clamped()));
 }
 
 Track::~Track()
@@ -420,6 +426,20 @@ void Track::process_post_sends(nframes_t nframes)
         }
 }
 
+/**
+ * Keeps the delay lines of the post sends running in a cycle this Track
+ * doesn't send anything, silence goes in and what was still in the line
+ * is mixed into the bus. Call it on every path that skips process_post_sends().
+ */
+void Track::process_silent_post_sends(nframes_t nframes)
+{
+        apill_foreach(TSend* postSend, TSend, m_postSends) {
+                if (postSend->has_delay_buffers()) {
+                        process_send(postSend, nframes, true);
+                }
+        }
+}
+
 void Track::process_pre_sends(nframes_t nframes)
 {
         apill_foreach(TSend* preSend, TSend, m_preSends) {
@@ -427,37 +447,159 @@ void Track::process_pre_sends(nframes_t nframes)
         }
 }
 
-void Track::process_send(TSend *send, nframes_t nframes)
+/**
+ * Sets the path latency, the delay between the input of this Track and the
+ * master out, to the latency of its own plugins plus the largest path
+ * latency of the bus tracks it sends to. Called from the audio thread each
+ * cycle, so a chain of buses settles after one cycle per bus.
+ *
+ * Post sends to paths with less latency are delayed by the difference, so
+ * the outputs of all paths line up again. The delay lines of the sends
+ * can't hold more than TSend::MAX_DELAY frames, so the path latency is
+ * clamped to that, pathLatencyClamped() is emitted when that happens.
+ */
+void Track::update_path_latency(APILinkedList& busTracks)
+{
+        nframes_t sendLatency = 0;
+
+        apill_foreach(TSend* send, TSend, m_postSends) {
+                sendLatency = qMax(sendLatency, send_path_latency(send, busTracks));
+        }
+
+        apill_foreach(TSend* send, TSend, m_postSends) {
+                send->set_delay(sendLatency - send_path_latency(send, busTracks));
+        }
+
+        // buses feeding each other in a loop would add up forever
+        nframes_t pathLatency = m_pluginChain->get_latency() + sendLatency;
+        bool clamped = pathLatency > TSend::MAX_DELAY;
+
+        if (clamped && !m_pathLatencyClamped) {
+                RT_THREAD_EMIT(this, 0, pathLatencyClamped());
+        }
+
+        m_pathLatencyClamped = clamped;
+        m_pathLatency = qMin(pathLatency, nframes_t(TSend::MAX_DELAY));
+}
+
+void Track::path_latency_clamped()
+{
+        info().warning(tr("%1: The plugin latency is more than %2 frames, it can't be compensated completely")
+                       .arg(m_name).arg(TSend::MAX_DELAY));
+}
+
+nframes_t Track::send_path_latency(TSend* send, APILinkedList& busTracks)
+{
+        apill_foreach(TBusTrack* busTrack, TBusTrack, busTracks) {
+                if (busTrack != this && busTrack->get_process_bus() == send->get_bus()) {
+                        return busTrack->get_path_latency();
+                }
+        }
+
+        return 0;
+}
+
+// Mixes the process bus into the send's bus. The pan law and send gain are
+// folded into one gain per channel, stereo sends are mixed in a single pass
+// over both channels and gain changes ramp over the block instead of jumping.
+// Delayed post sends mix from their delay line, in 2 parts if it wraps.
+// With \a silentInput the process bus is taken as silent, whatever is in it.
+void Track::process_send(TSend *send, nframes_t nframes, bool silentInput)
 {
-        AudioChannel* sender;
-        AudioChannel* receiver;
-        float gainFactor;
-        float panFactor;
+        bool silent = silentInput || m_processBus->is_silent(nframes);
+
+        // what went into the delay line before the silence still has to come out
+        if (send->has_delay_buffers()) {
+                send->write_delay(m_processBus, nframes, silent);
+                if (send->get_delay()) {
+                        silent = send->is_delay_output_silent(nframes);
+                }
+        }
+
+        // mixing silence into the receiver would only mark it non silent
+        if (silent) {
+                return;
+        }
 
         AudioBus* receiverBus = send->get_bus();
-        for (int i=0; i<m_processBus->get_channel_count(); i++) {
-                sender = m_processBus->get_channel(i);
-                receiver = receiverBus->get_channel(i);
-                if (sender && receiver) {
-                        panFactor = 1.0f;
-                        // Left channel
-                        if (i == 0) {
-                                panFactor = 1 - send->get_pan();
-                        }
-                        // Right channel
-                        if (i == 1) {
-                                panFactor = 1 + send->get_pan();
-                        }
+        int channels = qMin(m_processBus->get_channel_count(), receiverBus->get_channel_count());
+        float pan = send->get_pan();
+        float gain = send->get_gain();
+        float gainFactor[2];
+        bool ramp = false;
+
+        // Left and right channel
+        gainFactor[0] = (1 - pan) * gain;
+        gainFactor[1] = (1 + pan) * gain;
+
+        for (int i=0; i<2; i++) {
+                float previous = send->get_applied_gain(i);
+                if (previous >= 0.0f && previous != gainFactor[i]) {
+                        ramp = true;
+                }
+        }
 
-                        gainFactor = panFactor * send->get_gain();
+        TScratchArena::Scope scratch;
+        audio_sample_t** src = scratch.allocate<audio_sample_t*>(channels);
+        if (!src) {
+                // the fader doesn't use it while sends are processed, and
+                // it holds as many pointers as the process bus has channels
+                src = m_mixdownFallback.data();
+        }
 
-                        if (gainFactor == 1.0f) {
-                                Mixer::mix_buffers_no_gain(receiver->get_buffer(nframes), sender->get_buffer(nframes), nframes);
-                        } else {
-                                Mixer::mix_buffers_with_gain(receiver->get_buffer(nframes), sender->get_buffer(nframes), nframes, gainFactor);
+        if (send->get_delay()) {
+                nframes_t readPos = send->get_delay_read_position(nframes);
+                nframes_t first = qMin(nframes, TSend::DELAY_BUFFER_SIZE - readPos);
+
+                for (int i=0; i<channels; i++) {
+                        src[i] = send->get_delay_buffer(i) + readPos;
+                }
+                mix_send(send, src, channels, 0, first, nframes, gainFactor, ramp);
+
+                if (first < nframes) {
+                        for (int i=0; i<channels; i++) {
+                                src[i] = send->get_delay_buffer(i);
                         }
+                        mix_send(send, src, channels, first, nframes - first, nframes, gainFactor, ramp);
                 }
+        } else {
+                for (int i=0; i<channels; i++) {
+                        src[i] = m_processBus->get_buffer(i, nframes);
+                }
+                mix_send(send, src, channels, 0, nframes, nframes, gainFactor, ramp);
+        }
+
+        send->set_applied_gain(0, gainFactor[0]);
+        send->set_applied_gain(1, gainFactor[1]);
+}
+
+// Mixes \a count frames of \a src into the send's bus, starting at frame
+// \a offset of the \a nframes long cycle. Gain ramps are interpolated
+// over the cycle, not the part.
+void Track::mix_send(TSend* send, audio_sample_t** src, int channels, nframes_t offset, nframes_t count, nframes_t nframes, float* gainFactor, bool ramp)
+{
+        AudioBus* receiverBus = send->get_bus();
+
+        if (channels == 2 && !ramp) {
+                Mixer::pan_and_mix_stereo(receiverBus->get_buffer(0, nframes) + offset, receiverBus->get_buffer(1, nframes) + offset,
+                                          src[0], src[1], count, gainFactor[0], gainFactor[1]);
+                return;
+        }
 
+        for (int i=0; i<channels; i++) {
+                audio_sample_t* dst = receiverBus->get_buffer(i, nframes) + offset;
+                float channelGain = i < 2 ? gainFactor[i] : send->get_gain();
+                float previous = i < 2 ? send->get_applied_gain(i) : -1.0f;
+
+                if (ramp && previous >= 0.0f && previous != channelGain) {
+                        float startGain = previous + (channelGain - previous) * offset / nframes;
+                        float endGain = previous + (channelGain - previous) * (offset + count) / nframes;
+                        Mixer::mix_buffers_with_gain_ramp(dst, src[i], count, startGain, endGain);
+                } else if (channelGain == 1.0f) {
+                        Mixer::mix_buffers_no_gain(dst, src[i], count);
+                } else {
+                        Mixer::mix_buffers_with_gain(dst, src[i], count, channelGain);
+                }
         }
 }
 
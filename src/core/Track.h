@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #ifndef TRACK_H
 #define TRACK_H
 
+#include <QVector>
+
 #include "ProcessingData.h"
 #include "defines.h"
 
@@ -81,6 +83,9 @@ public:
         QList<TSend*> get_pre_sends() const;
         TSend* get_send(qint64 sendId);
 
+        nframes_t get_path_latency() const {return m_pathLatency;}
+        void update_path_latency(APILinkedList& busTracks);
+
 
 protected:
         VUMonitors      m_vumonitors;
@@ -91,20 +96,29 @@ protected:
         bool            m_isSolo;
 	bool		m_showTrackVolumeAutomation;
 	bool		m_preSendOn;
+        nframes_t       m_pathLatency;
+        bool            m_pathLatencyClamped;
 
         APILinkedList   m_postSends;
         APILinkedList   m_preSends;
 
         AudioBus*       m_inputBus;
         QString         m_busInName;
+        // wraps the process bus buffers for the fader when the scratch
+        // arena is exhausted, sized to the bus channel count at creation,
+        // process_send() uses it the same way, outside the fader
+        QVector<audio_sample_t*> m_mixdownFallback;
 
         void process_post_sends(nframes_t nframes);
+        void process_silent_post_sends(nframes_t nframes);
         void process_pre_sends(nframes_t nframes);
         virtual void add_input_bus(AudioBus* bus);
         void remove_input_bus(AudioBus* bus);
 
 private:
-        void process_send(TSend* send, nframes_t nframes);
+        void process_send(TSend* send, nframes_t nframes, bool silentInput=false);
+        void mix_send(TSend* send, audio_sample_t** src, int channels, nframes_t offset, nframes_t count, nframes_t nframes, float* gainFactor, bool ramp);
+        nframes_t send_path_latency(TSend* send, APILinkedList& busTracks);
 
 public slots:
         TCommand* solo();
@@ -118,12 +132,14 @@ private slots:
         void private_remove_pre_send(TSend*);
         void private_add_input_bus(AudioBus*);
         void private_remove_input_bus(AudioBus*);
+        void path_latency_clamped();
 
 signals:
         void soloChanged(bool isSolo);
 	void preSendChanged(bool preSendOn);
 	void automationVisibilityChanged();
         void routingConfigurationChanged();
+        void pathLatencyClamped();
 };
 
 #endif // TRACK_H
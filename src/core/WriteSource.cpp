@@ -31,6 +31,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Peak.h"
 #include "Utils.h"
 #include "DiskIO.h"
+#include "Mixer.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -405,43 +406,58 @@ void WriteSource::set_process_peaks( bool process )
 
 int WriteSource::rb_file_write(nframes_t cnt)
 {
-	uint read = 0;
+	nframes_t read = cnt;
 	int chan;
 	
-	audio_sample_t* readbuffer[m_channelCount];
+	RingBufferNPT<audio_sample_t>::rw_vector vectors[m_channelCount];
+	audio_sample_t* src[m_channelCount];
 	
 	for (chan=0; chan<m_channelCount; ++chan) {
+		m_buffers.at(chan)->get_read_vector(&vectors[chan]);
+		read = qMin(read, nframes_t(vectors[chan].len[0] + vectors[chan].len[1]));
+	}
+	
+	if (read != cnt) {
+		printf("WriteSource::rb_file_write() : could only process %d frames, %d were requested!\n", read, cnt);
+	}
+	
+	if (read == 0) {
+		return 0;
+	}
+	
+	// Interlace data straight from the ring buffers into the dataF buffer.
+	// The buffers of all channels are read in lock step, but take the part
+	// up to the first wrap around of any of them per pass anyway.
+	nframes_t done = 0;
+	
+	while (done < read) {
+		nframes_t chunk = read - done;
 		
-		readbuffer[chan] = new audio_sample_t[cnt * m_channelCount];
-
-		read = m_buffers.at(chan)->read(readbuffer[chan], cnt);
-		
-		if (read != cnt) {
-			printf("WriteSource::rb_file_write() : could only process %d frames, %d were requested!\n", read, cnt);
+		for (chan=0; chan<m_channelCount; ++chan) {
+			const RingBufferNPT<audio_sample_t>::rw_vector& vec = vectors[chan];
+			if (done < vec.len[0]) {
+				src[chan] = vec.buf[0] + done;
+				chunk = qMin(chunk, nframes_t(vec.len[0] - done));
+			} else {
+				src[chan] = vec.buf[1] + (done - vec.len[0]);
+			}
 		}
 		
-		m_peak->process(chan, readbuffer[chan], read);
-	}
-
-	if (read > 0) {
-		if (m_channelCount == 1) {
-			m_spec->dataF = readbuffer[0];
-		} else {
-			// Interlace data into dataF buffer!
-			for (uint f=0; f<read; f++) {
-				for (chan = 0; chan < m_channelCount; chan++) {
-					m_spec->dataF[f * m_channelCount + chan] = readbuffer[chan][f];
-				}
-			}
+		Mixer::interleave(m_spec->dataF + done * m_channelCount, src, m_channelCount, chunk);
+		
+		for (chan=0; chan<m_channelCount; ++chan) {
+			m_peak->process(chan, src[chan], chunk);
 		}
 		
-		process(read);
+		done += chunk;
 	}
 	
 	for (chan=0; chan<m_channelCount; ++chan) {
-		delete [] readbuffer[chan];
+		m_buffers.at(chan)->increment_read_ptr(read);
 	}
 	
+	process(read);
+	
 	return read;
 }
 
@@ -45,6 +45,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <time.h>
 
 #include "AudioDevice.h"
+#include "fpu.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -469,6 +470,63 @@ void AlsaDriver::setup_io_function_pointers()
 		break;
 	}
 
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+	// the SSE2 versions give the same output, the noise shaped dither
+	// and the byte swapped formats stay with the plain C versions
+	FPU fpu;
+	if (fpu.has_sse2() && !quirk_bswap) {
+		switch (playback_sample_bytes) {
+		case 2:
+			switch (dither) {
+			case Rectangular:
+				write_via_copy = x86_sse2_sample_move_dither_rect_d16_sS;
+				break;
+			case Triangular:
+				write_via_copy = x86_sse2_sample_move_dither_tri_d16_sS;
+				break;
+			case None:
+				write_via_copy = x86_sse2_sample_move_d16_sS;
+				break;
+			default:
+				break;
+			}
+			break;
+
+		case 3:
+			switch (dither) {
+			case Rectangular:
+				write_via_copy = x86_sse2_sample_move_dither_rect_d24_sS;
+				break;
+			case Triangular:
+				write_via_copy = x86_sse2_sample_move_dither_tri_d24_sS;
+				break;
+			case None:
+				write_via_copy = x86_sse2_sample_move_d24_sS;
+				break;
+			default:
+				break;
+			}
+			break;
+
+		case 4:
+			switch (dither) {
+			case Rectangular:
+				write_via_copy = x86_sse2_sample_move_dither_rect_d32u24_sS;
+				break;
+			case Triangular:
+				write_via_copy = x86_sse2_sample_move_dither_tri_d32u24_sS;
+				break;
+			case None:
+				write_via_copy = x86_sse2_sample_move_d32u24_sS;
+				break;
+			default:
+				break;
+			}
+			break;
+		}
+	}
+#endif
+
 	switch (capture_sample_bytes) {
 	case 2:
 		read_via_copy = quirk_bswap?
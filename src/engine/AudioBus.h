@@ -93,6 +93,22 @@ public:
 		}
 	}
 
+	/**
+	 *        Check if nothing was written into any of the AudioChannels
+	 *        buffers since they were silenced, processing them can be skipped
+	 * @param nframes size of the buffer
+	 * @return true if all channels are silent
+	 */
+	bool is_silent(nframes_t nframes) const
+	{
+                for (int i=0; i<m_channels.size(); ++i) {
+                        if (!m_channels.at(i)->is_silent(nframes)) {
+                                return false;
+                        }
+		}
+                return true;
+	}
+
         bool is_smaller_then(APILinkedListNode* node) {return true;}
 
 private:
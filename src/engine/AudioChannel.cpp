@@ -24,6 +24,7 @@
 
 #include "Tsar.h"
 #include "Utils.h"
+#include "TScratchArena.h"
 
 #ifdef USE_MLOCK
 #include <sys/mman.h>
@@ -52,6 +53,7 @@ AudioChannel::AudioChannel(const QString& name, uint channelNumber, int type, qi
         m_monitoring = true;
         m_buffer = 0;
         m_bufferSize = 0;
+        m_silentFrames = 0;
         mlocked = 0;
         if (id == 0) {
                 m_id = create_id();
@@ -90,12 +92,15 @@ void AudioChannel::set_buffer_size( nframes_t size )
         }
 #endif /* USE_MLOCK */
 
+        Q_ASSERT_X(!TScratchArena::in_realtime_cycle(), "AudioChannel::set_buffer_size", "Called in the audio thread");
+
         if (m_buffer) {
                 delete [] m_buffer;
         }
 
         m_buffer = new audio_sample_t[size];
         m_bufferSize = size;
+        m_silentFrames = 0;
         silence_buffer(size);
 
 #ifdef USE_MLOCK
@@ -111,7 +116,9 @@ void AudioChannel::process_monitoring(VUMonitor* monitor)
 {
         Q_ASSERT(m_bufferSize > 0);
         float peakValue = 0;
-        peakValue = Mixer::compute_peak( m_buffer, m_bufferSize, peakValue );
+        if (!is_silent(m_bufferSize)) {
+                peakValue = Mixer::compute_peak( m_buffer, m_bufferSize, peakValue );
+        }
 
         if (monitor) {
                 monitor->process(peakValue);
@@ -153,6 +160,7 @@ void AudioChannel::remove_monitor(VUMonitor *monitor)
 void AudioChannel::read_from_hardware_port(audio_sample_t *buf, nframes_t nframes)
 {
         memcpy (m_buffer, buf, sizeof(audio_sample_t) * nframes);
+        m_silentFrames = 0;
         if (m_monitoring) {
                 process_monitoring();
                 audiodevice().send_to_master_out(this, m_bufferSize);
@@ -162,18 +170,30 @@ void AudioChannel::read_from_hardware_port(audio_sample_t *buf, nframes_t nframe
 
 /**
  *
- * @return The highest peak value since the previous call to this function,
+ * @return The highest peak value since the previous call to set_read(),
+ *		 or 0.0 if the audio thread didn't publish a new snapshot since then.
  *		 call this at least 10 times each second to keep data consistent
  */
 audio_sample_t VUMonitor::get_peak_value( )
 {
-        if (m_flag) {
+        m_snapshots.update();
+
+        const VUMonitorSnapshot& snapshot = m_snapshots.read_buffer();
+        if (snapshot.cycle == m_readCycle) {
                 return 0.0;
         }
 
-        float result = m_peak;
+        return snapshot.peak;
+}
 
-        return result;
+/**
+ * Marks the current snapshot as read, the audio thread will start
+ * collecting a new peak value on it's next cycle.
+ */
+void VUMonitor::set_read()
+{
+        m_readCycle = m_snapshots.read_buffer().cycle;
+        m_readFlag = 1;
 }
 
 //eof
@@ -28,37 +28,57 @@ $Id: AudioChannel.h,v 1.8 2008/11/24 21:11:04 r_sijrier Exp $
 #include "Mixer.h"
 #include "RingBuffer.h"
 #include "APILinkedList.h"
+#include "TripleBuffer.h"
 
 class RingBuffer;
 class AudioDevice;
 
+struct VUMonitorSnapshot
+{
+        VUMonitorSnapshot() : peak(0.0f), cycle(0) {}
+
+        audio_sample_t  peak;
+        uint            cycle;
+};
+
 class VUMonitor : public APILinkedListNode
 {
 public:
         VUMonitor() {
-                m_flag = 0;
+                m_peak = 0.0f;
+                m_cycle = 0;
+                m_readCycle = 0;
         }
         ~VUMonitor() {}
 
         bool is_smaller_then(APILinkedListNode* /*node*/) {return true;}
 
+        // Called once per audio cycle, publishes the highest peak since
+        // the last set_read() as a new snapshot for the GUI thread.
         void process(float peakValue) {
-                if (m_flag) {
+                if (m_readFlag.fetchAndStoreOrdered(0)) {
                         m_peak = 0.0f;
-                        m_flag = 0;
                 }
 
                 if (peakValue > m_peak) {
                         m_peak = peakValue;
                 }
+
+                VUMonitorSnapshot& snapshot = m_snapshots.write_buffer();
+                snapshot.peak = m_peak;
+                snapshot.cycle = ++m_cycle;
+                m_snapshots.publish();
         }
 
         audio_sample_t get_peak_value();
-        inline void set_read() {m_flag = 1;}
+        void set_read();
 
 private:
-        int    m_flag;
-        audio_sample_t m_peak;
+        TripleBuffer<VUMonitorSnapshot> m_snapshots;
+        QAtomicInt      m_readFlag;
+        audio_sample_t  m_peak;
+        uint            m_cycle;
+        uint            m_readCycle;
 };
 
 class AudioChannel : public QObject
@@ -69,16 +89,27 @@ public:
         AudioChannel(const QString& name, uint channelNumber, int type, qint64 id=0);
         ~AudioChannel();
 
+        // Anyone getting the buffer might write into it, so it's no longer
+        // known to be silent.
         audio_sample_t* get_buffer(nframes_t ) {
+                m_silentFrames = 0;
                 return m_buffer;
 	}
 
 	void set_latency(unsigned int latency);
 
         void silence_buffer(nframes_t nframes) {
+                if (nframes <= m_silentFrames) {
+                        return;
+                }
                 memset (m_buffer, 0, sizeof (audio_sample_t) * nframes);
+                m_silentFrames = nframes;
 	}
 
+        // true if the first nframes of the buffer are known to be zero, i.e.
+        // nobody got hold of the buffer since the last silence_buffer()
+        bool is_silent(nframes_t nframes) const {return nframes <= m_silentFrames;}
+
 	void set_buffer_size(nframes_t size);
         void set_monitoring(bool monitor);
         void process_monitoring(VUMonitor* monitor=0);
@@ -96,6 +127,7 @@ private:
         APILinkedList           m_monitors;
         audio_sample_t* 	m_buffer;
         uint 			m_bufferSize;
+        nframes_t               m_silentFrames;
 	uint 			m_latency;
 	uint 			m_number;
         qint64                  m_id;
@@ -47,11 +47,13 @@ RELAYTOOL_JACK
 
 
 #include "TAudioDriver.h"
+#include "TFileDriver.h"
 #include "TAudioDeviceClient.h"
 #include "AudioChannel.h"
 #include "AudioBus.h"
 #include "Tsar.h"
 #include "Mixer.h"
+#include "TRealtimeChecker.h"
 
 //#include <sys/mman.h>
 #include <QDebug>
@@ -151,6 +153,7 @@ AudioDevice& audiodevice()
 }
 
 AudioDevice::AudioDevice()
+	: m_scratchArena(true)
 {
 	m_runAudioThread = false;
         m_driver = 0;
@@ -160,6 +163,8 @@ AudioDevice::AudioDevice()
         m_rate = 44100;
 	m_xrunCount = 0;
 	m_cpuTime = new RingBufferNPT<trav_time_t>(4096);
+	m_cycleWakeupDelay = 0;
+	m_cycleProcessed = false;
 
 	m_driverType = tr("No Driver Loaded");
 
@@ -189,6 +194,7 @@ AudioDevice::AudioDevice()
 
 	
         m_availableDrivers << "Null Driver";
+        m_availableDrivers << "File Driver";
 	
 	// tsar is a singleton, so initialization is done on first tsar() call
 	// Tsar makes use of a QTimer to cleanup the processed events.
@@ -235,6 +241,8 @@ void AudioDevice::set_buffer_size( nframes_t size )
                 m_channels.at(i)->set_buffer_size(m_bufferSize);
         }
 
+	m_scratchArena.reserve(m_bufferSize);
+
 }
 
 void AudioDevice::set_sample_rate( nframes_t rate )
@@ -249,6 +257,8 @@ void AudioDevice::set_bit_depth( uint depth )
 
 int AudioDevice::run_cycle( nframes_t nframes, float delayed_usecs )
 {
+	m_scratchArena.begin_cycle();
+
         if (m_masterOutBus) {
                 m_masterOutBus->silence_buffers(nframes);
         }
@@ -263,12 +273,20 @@ int AudioDevice::run_cycle( nframes_t nframes, float delayed_usecs )
 	/* run as many cycles as it takes to consume nframes (Should be 1 cycle!!)*/
 	for (left = nframes; left >= m_bufferSize; left -= m_bufferSize) {
 		if (run_one_cycle (m_bufferSize, delayed_usecs) < 0) {
+			m_scratchArena.end_cycle();
 			qCritical ("cycle execution failure, exiting");
 			return -1;
 		}
 	}
 
+	m_scratchArena.end_cycle();
+
+	RT_CHECK_ENTER("AudioDevice::post_process");
 	post_process();
+	RT_CHECK_LEAVE();
+
+	m_cycleWakeupDelay = delayed_usecs;
+	m_cycleProcessed = true;
 
 	return 1;
 }
@@ -281,9 +299,13 @@ int AudioDevice::run_one_cycle( nframes_t nframes, float  )
 		return -1;
 	}
 
+	// the driver read and write may block (poll) on purpose,
+	// only the processing itself has to be realtime safe
+	RT_CHECK_ENTER("AudioDevice::run_one_cycle");
         apill_foreach(TAudioDeviceClient* client, TAudioDeviceClient, m_clients) {
 		client->process(nframes);
 	}
+	RT_CHECK_LEAVE();
 	
         if (m_driver->write(nframes) < 0) {
 		qDebug("driver write failed!");
@@ -294,8 +316,13 @@ int AudioDevice::run_one_cycle( nframes_t nframes, float  )
 	return 0;
 }
 
-void AudioDevice::delay( float  )
+/**
+ * Called by the driver after it recovered from an xrun
+ * @param delay The length of the xrun in usecs, 0 if unknown
+ */
+void AudioDevice::delay( float delay )
 {
+	m_telemetry.record_xrun(get_microseconds(), delay);
 }
 
 
@@ -322,6 +349,10 @@ void AudioDevice::set_parameters(AudioDeviceSetup ads)
 
 	shutdown();
 
+	// the audio thread is stopped now, so this is safe
+	m_telemetry.reset(float(m_bufferSize) / m_rate * 1000000.0f);
+	m_cycleProcessed = false;
+
         if (create_driver(ads.driverType, ads.capture, ads.playback, ads.cardDevice) < 0) {
                 set_parameters(m_fallBackSetup);
 		return;
@@ -329,12 +360,14 @@ void AudioDevice::set_parameters(AudioDeviceSetup ads)
 	
         m_driver->attach();
         
+	// the driver could have changed the buffer size
+	m_scratchArena.reserve(m_bufferSize);
 	
 	emit driverParamsChanged();
 
 	m_runAudioThread = 1;
 	
-        if ((ads.driverType == "ALSA") || (ads.driverType == "Null Driver")) {
+        if ((ads.driverType == "ALSA") || (ads.driverType == "Null Driver") || (ads.driverType == "File Driver")) {
 		
 		printf("Starting AudioDeviceThread..... ");
 		
@@ -474,6 +507,18 @@ int AudioDevice::create_driver(QString driverType, bool capture, bool playback,
 		return 1;
 	}
 
+	if (driverType == "File Driver") {
+		m_driver = new TFileDriver(this, m_rate, m_bufferSize);
+		if (m_driver->setup(capture, playback, cardDevice) < 0) {
+			message(tr("Audiodevice: Failed to create the File Driver"), WARNING);
+			delete m_driver;
+			m_driver = 0;
+			return -1;
+		}
+		m_driverType = driverType;
+		return 1;
+	}
+
 	return -1;
 }
 
@@ -809,6 +854,23 @@ void AudioDevice::remove_client( TAudioDeviceClient * client )
         THREAD_SAVE_INVOKE_AND_EMIT_SIGNAL(this, client, private_remove_client(TAudioDeviceClient*), clientRemoved(TAudioDeviceClient*));
 }
 
+/**
+ * Makes the Null and File Driver run their cycles back to back, as fast
+ * as the clients can process them, instead of at the period rate.
+ * Has no effect on drivers that are clocked by sound hardware.
+ */
+void AudioDevice::set_freewheel(bool freewheel)
+{
+	if (m_driver) {
+		m_driver->set_freewheel(freewheel);
+	}
+}
+
+bool AudioDevice::is_freewheeling() const
+{
+	return m_driver && m_driver->is_freewheeling();
+}
+
 void AudioDevice::mili_sleep(int msec)
 {
         m_audioThread->mili_sleep(msec);
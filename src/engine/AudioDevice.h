@@ -34,6 +34,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include "RingBufferNPT.h"
 #include "APILinkedList.h"
+#include "TAudioTelemetry.h"
+#include "TScratchArena.h"
 #include "defines.h"
 
 class AudioDeviceThread;
@@ -121,6 +123,9 @@ public:
 	int shutdown();
 	
 	trav_time_t get_cpu_time();
+	void set_freewheel(bool freewheel);
+	bool is_freewheeling() const;
+	TAudioTelemetry& get_telemetry() {return m_telemetry;}
 
 
 private:
@@ -134,6 +139,7 @@ private:
 	friend class AlsaDriver;
 	friend class PADriver;
         friend class TAudioDriver;
+	friend class TFileDriver;
 	friend class PulseAudioDriver;
 	friend class AudioDeviceThread;
 #if defined (COREAUDIO_SUPPORT)
@@ -158,6 +164,10 @@ private:
 #endif
 
 	RingBufferNPT<trav_time_t>*	m_cpuTime;
+	TAudioTelemetry		m_telemetry;
+	TScratchArena		m_scratchArena;
+	float			m_cycleWakeupDelay;
+	bool			m_cycleProcessed;
 	volatile size_t		m_runAudioThread;
 	trav_time_t		m_cycleStartTime;
 	trav_time_t		m_lastCpuReadTime;
@@ -195,6 +205,12 @@ private:
 	{
 		trav_time_t runcycleTime = time - m_cycleStartTime;
 		m_cpuTime->write(&runcycleTime, 1);
+		// only cycles that went through run_cycle(), not the
+		// ones the driver had to restart after an xrun
+		if (m_cycleProcessed) {
+			m_telemetry.record_cycle(m_cycleWakeupDelay, runcycleTime);
+			m_cycleProcessed = false;
+		}
 	}
 
         TAudioDriver* get_driver() const {return m_driver;}
@@ -106,7 +106,14 @@ void AudioDeviceThread::run()
 		return;
 	}
 
+	bool freewheeling = false;
+
 	while (m_device->run_audio_thread()) {
+		if (m_device->get_driver()->is_freewheeling() != freewheeling) {
+			freewheeling = !freewheeling;
+			set_freewheel_scheduling(freewheeling);
+		}
+
 		if (m_device->get_driver()->run_cycle() < 0) {
 			PERROR("Driver cycle error, exiting!");
 			break;
@@ -147,10 +154,41 @@ int AudioDeviceThread::become_realtime( bool realtime )
 }
 
 
+/**
+ * Freewheeling cycles run back to back, and an export does it's disk I/O
+ * in this thread. Like Jack does, drop the realtime priority and the CPU
+ * affinity while freewheeling, so the rest of the system isn't starved,
+ * and restore them afterwards.
+ */
+void AudioDeviceThread::set_freewheel_scheduling(bool freewheel)
+{
+#if defined (Q_WS_X11) || defined (Q_WS_MAC)
+	if (freewheel) {
+		struct sched_param param;
+		param.sched_priority = 0;
+		if (pthread_setschedparam (pthread_self(), SCHED_OTHER, &param) != 0) {
+			PWARN("Unable to drop realtime priority for freewheeling\n");
+		}
+		run_on_cpu(-1);
+	} else {
+		run_on_cpu(0);
+		if (m_realTime) {
+			become_realtime(true);
+		}
+	}
+#else
+	Q_UNUSED(freewheel);
+#endif
+}
+
+
 #if defined (Q_WS_X11)
 typedef int* (*setaffinity_func_type)(pid_t,unsigned int,cpu_set_t *);
 #endif
 
+/**
+ * Binds the calling thread to \a cpu, or allows all CPUs if \a cpu is -1
+ */
 void AudioDeviceThread::run_on_cpu( int cpu )
 {
 #if defined (Q_WS_X11)
@@ -162,7 +200,13 @@ void AudioDeviceThread::run_on_cpu( int cpu )
 	if (setaffinity_func != NULL) {
 		cpu_set_t mask;
 		CPU_ZERO(&mask);
-		CPU_SET(cpu, &mask);
+		if (cpu < 0) {
+			for (int i = 0; i < CPU_SETSIZE; ++i) {
+				CPU_SET(i, &mask);
+			}
+		} else {
+			CPU_SET(cpu, &mask);
+		}
 		if (setaffinity_func(0, sizeof(mask), &mask)) {
 			PWARN("Unable to set CPU affinity\n");
 		} else {
@@ -36,6 +36,7 @@ public:
         int become_realtime(bool realtime);
 
         void run_on_cpu(int cpu);
+        void set_freewheel_scheduling(bool freewheel);
 
 	void mili_sleep(int msec) {msleep(msec);}
 
@@ -24,6 +24,11 @@ $Id: Driver.cpp,v 1.6 2007/03/19 11:18:57 r_sijrier Exp $
 #include "AudioDevice.h"
 #include "AudioChannel.h"
 
+#if defined (Q_WS_X11)
+#include <time.h>
+#include <errno.h>
+#endif
+
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
 #include "Debugger.h"
@@ -34,6 +39,9 @@ TAudioDriver::TAudioDriver( AudioDevice* dev , int rate, nframes_t bufferSize)
 	device = dev;
 	frame_rate = rate;
 	frames_per_cycle = bufferSize;
+	period_usecs = (trav_time_t(frames_per_cycle) / frame_rate) * 1000000.0;
+	m_freewheel = 0;
+	m_nextCycleTime = 0;
 
         read = MakeDelegate(this, &TAudioDriver::_read);
         write = MakeDelegate(this, &TAudioDriver::_write);
@@ -52,15 +60,65 @@ TAudioDriver::~ TAudioDriver( )
 
 int TAudioDriver::_run_cycle( )
 {
-	// * 1000, we want it in millisecond
-	// / 2, 2 bytes (16 bit)
 	device->transport_cycle_end (get_microseconds());
 
-	device->mili_sleep(23);
+	float delayed_usecs = wait_for_next_cycle();
 
 	device->transport_cycle_start (get_microseconds());
 
-	return device->run_cycle( frames_per_cycle, 0);
+	return device->run_cycle( frames_per_cycle, delayed_usecs);
+}
+
+#if defined (Q_WS_X11)
+static inline qint64 monotonic_nsecs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return qint64(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+#endif
+
+/**
+ * Sleeps till the start of the next period, for drivers that have no
+ * hardware to wait for. Periods are scheduled on an absolute clock, so
+ * the time spent processing doesn't add up to the cycle time.
+ * Returns immediately when freewheeling.
+ * @return How late the cycle started, in usecs
+ */
+float TAudioDriver::wait_for_next_cycle()
+{
+	if (is_freewheeling()) {
+		m_nextCycleTime = 0;
+		return 0;
+	}
+
+#if defined (Q_WS_X11)
+	qint64 periodNsecs = qint64(frames_per_cycle) * 1000000000LL / frame_rate;
+	qint64 now = monotonic_nsecs();
+
+	if (m_nextCycleTime == 0 || (now - m_nextCycleTime) > periodNsecs) {
+		// First cycle, or we're more then a period behind schedule.
+		// Don't try to catch up by running the missed cycles back to
+		// back, start a new schedule instead.
+		float delayed_usecs = m_nextCycleTime ? (now - m_nextCycleTime) / 1000.0f : 0.0f;
+		m_nextCycleTime = now + periodNsecs;
+		return delayed_usecs;
+	}
+
+	struct timespec deadline;
+	deadline.tv_sec = m_nextCycleTime / 1000000000LL;
+	deadline.tv_nsec = m_nextCycleTime % 1000000000LL;
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, 0) == EINTR) {}
+
+	float delayed_usecs = (monotonic_nsecs() - m_nextCycleTime) / 1000.0f;
+	m_nextCycleTime += periodNsecs;
+
+	return delayed_usecs;
+#else
+	device->mili_sleep(int(period_usecs / 1000));
+	return 0;
+#endif
 }
 
 int TAudioDriver::_read( nframes_t  )
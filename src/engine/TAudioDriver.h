@@ -67,6 +67,11 @@ public:
         virtual int remove_capture_channel(const QString& ) {return -1;}
         virtual int remove_playback_channel(const QString& ) {return -1;}
 
+        // Only used by drivers running their own cycles (the null and file
+        // driver): run cycles back to back instead of at the period rate
+        void set_freewheel(bool freewheel) {t_atomic_int_set(&m_freewheel, freewheel ? 1 : 0);}
+        bool is_freewheeling() {return t_atomic_int_get(&m_freewheel);}
+
 
         ProcessCallback read;
         ProcessCallback write;
@@ -86,6 +91,12 @@ protected:
         nframes_t                capture_frame_latency;
         nframes_t                playback_frame_latency;
 
+        float wait_for_next_cycle();
+
+private:
+        volatile int		m_freewheel;
+        qint64			m_nextCycleTime;
+
 };
 
 
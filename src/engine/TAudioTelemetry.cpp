@@ -0,0 +1,334 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TAudioTelemetry.h"
+
+#include "Utils.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QObject>
+#include <cmath>
+#include <cstring>
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+// about 20 seconds of cycles at a period size of 256 frames, 44.1 KHz
+#define TELEMETRY_RECORD_COUNT	4096
+
+
+TAudioTelemetry::TAudioTelemetry()
+{
+	m_records = new RingBufferNPT<Record>(TELEMETRY_RECORD_COUNT);
+	m_dropped = 0;
+	reset(0);
+}
+
+TAudioTelemetry::~TAudioTelemetry()
+{
+	delete m_records;
+}
+
+/**
+ * Records one audio cycle, call from the audio thread only
+ * @param wakeupDelay How late the driver woke up, in usecs
+ * @param processTime The time spent processing the cycle, in usecs
+ */
+void TAudioTelemetry::record_cycle(float wakeupDelay, float processTime)
+{
+	Record record;
+	record.wakeupDelay = wakeupDelay;
+	record.processTime = processTime;
+	record.xrunDelay = 0;
+	record.xrun = false;
+	record.time = 0;
+
+	if (m_records->write(&record, 1) != 1) {
+		t_atomic_int_set(&m_dropped, t_atomic_int_get(&m_dropped) + 1);
+	}
+}
+
+/**
+ * Records an xrun, call from the audio thread only
+ * @param time The time the driver recovered from the xrun
+ * @param delay The length of the xrun in usecs, if known by the driver
+ */
+void TAudioTelemetry::record_xrun(trav_time_t time, float delay)
+{
+	Record record;
+	record.wakeupDelay = 0;
+	record.processTime = 0;
+	record.xrunDelay = delay;
+	record.xrun = true;
+	record.time = time;
+
+	if (m_records->write(&record, 1) != 1) {
+		t_atomic_int_set(&m_dropped, t_atomic_int_get(&m_dropped) + 1);
+	}
+}
+
+/**
+ * Moves all records written by the audio thread since the last call
+ * into the histograms. Call this regularly from the GUI thread.
+ */
+void TAudioTelemetry::update()
+{
+	Record record;
+
+	while (m_records->read(&record, 1) == 1) {
+		if (record.xrun) {
+			XrunEvent event;
+			event.time = record.time;
+			event.delay = record.xrunDelay;
+
+			m_xrunEvents.append(event);
+			if (m_xrunEvents.size() > MAX_XRUN_EVENTS) {
+				m_xrunEvents.removeFirst();
+			}
+			m_xrunCount++;
+			continue;
+		}
+
+		add_value(WAKEUP_JITTER, record.wakeupDelay);
+		add_value(PROCESS_TIME, record.processTime);
+		add_value(HEADROOM, m_periodUsecs - record.processTime);
+	}
+
+	m_droppedCount = t_atomic_int_get(&m_dropped);
+}
+
+/**
+ * Clears all collected data, only call this when the audio thread
+ * isn't running!
+ * @param periodUsecs The period time of the (new) driver setup
+ */
+void TAudioTelemetry::reset(float periodUsecs)
+{
+	m_records->reset();
+	m_periodUsecs = periodUsecs;
+	m_xrunEvents.clear();
+	m_xrunCount = 0;
+	m_droppedCount = 0;
+	t_atomic_int_set(&m_dropped, 0);
+
+	for (int i=0; i<METRIC_COUNT; ++i) {
+		Histogram& histogram = m_histograms[i];
+		memset(histogram.buckets, 0, sizeof(histogram.buckets));
+		histogram.min = histogram.max = 0;
+		histogram.count = 0;
+	}
+}
+
+void TAudioTelemetry::add_value(Metric metric, float value)
+{
+	Histogram& histogram = m_histograms[metric];
+
+	if (histogram.count == 0) {
+		histogram.min = histogram.max = value;
+	} else {
+		if (value < histogram.min) {
+			histogram.min = value;
+		}
+		if (value > histogram.max) {
+			histogram.max = value;
+		}
+	}
+
+	histogram.buckets[bucket_index(value)]++;
+	histogram.count++;
+}
+
+int TAudioTelemetry::bucket_index(float value)
+{
+	if (value < LINEAR_BUCKETS) {
+		return value < 0 ? 0 : int(value);
+	}
+
+	int exponent;
+	float mantissa = frexpf(value, &exponent);
+	// value = mantissa * 2^exponent, mantissa in [0.5, 1)
+	int index = LINEAR_BUCKETS + (exponent - 5) * SUB_BUCKETS + int((mantissa - 0.5f) * 2 * SUB_BUCKETS);
+
+	return qMin(index, BUCKET_COUNT - 1);
+}
+
+float TAudioTelemetry::bucket_upper_bound(int index)
+{
+	if (index < LINEAR_BUCKETS) {
+		return index + 1;
+	}
+
+	int exponent = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+	int sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+
+	return ldexpf(1.0f + float(sub + 1) / SUB_BUCKETS, exponent);
+}
+
+/**
+ * @return The upper bound of the bucket holding the value below which
+ *	\a fraction of all values are, clamped to the real min and max.
+ */
+float TAudioTelemetry::percentile(const Histogram& histogram, float fraction) const
+{
+	if (histogram.count == 0) {
+		return 0;
+	}
+
+	qint64 target = qint64(ceil(histogram.count * fraction));
+	qint64 seen = 0;
+
+	for (int i=0; i<BUCKET_COUNT; ++i) {
+		seen += histogram.buckets[i];
+		if (seen >= target) {
+			return qBound(histogram.min, bucket_upper_bound(i), histogram.max);
+		}
+	}
+
+	return histogram.max;
+}
+
+TAudioTelemetry::Summary TAudioTelemetry::get_summary(Metric metric) const
+{
+	const Histogram& histogram = m_histograms[metric];
+	Summary summary;
+
+	summary.count = histogram.count;
+	summary.min = histogram.min;
+	summary.max = histogram.max;
+	summary.p50 = percentile(histogram, 0.50f);
+	// for the headroom the interesting part is the low end
+	summary.p99 = percentile(histogram, metric == HEADROOM ? 0.01f : 0.99f);
+
+	return summary;
+}
+
+const char* TAudioTelemetry::metric_name(Metric metric)
+{
+	switch(metric) {
+		case WAKEUP_JITTER: return "wakeup_jitter";
+		case PROCESS_TIME: return "process_time";
+		case HEADROOM: return "headroom";
+		default: return "unknown";
+	}
+}
+
+QString TAudioTelemetry::get_summary_text() const
+{
+	Summary jitter = get_summary(WAKEUP_JITTER);
+	Summary process = get_summary(PROCESS_TIME);
+	Summary headroom = get_summary(HEADROOM);
+
+	QString text;
+	text += QObject::tr("Cycles: %1, xruns: %2").arg(process.count).arg(m_xrunCount);
+	text += "\n" + QObject::tr("Wakeup jitter (p50/p99/max): %1 / %2 / %3 us")
+		.arg(jitter.p50, 0, 'f', 0).arg(jitter.p99, 0, 'f', 0).arg(jitter.max, 0, 'f', 0);
+	text += "\n" + QObject::tr("Process time (p50/p99/max): %1 / %2 / %3 us")
+		.arg(process.p50, 0, 'f', 0).arg(process.p99, 0, 'f', 0).arg(process.max, 0, 'f', 0);
+	text += "\n" + QObject::tr("Headroom (p50/p1/min): %1 / %2 / %3 us of %4 us")
+		.arg(headroom.p50, 0, 'f', 0).arg(headroom.p99, 0, 'f', 0).arg(headroom.min, 0, 'f', 0).arg(m_periodUsecs, 0, 'f', 0);
+
+	return text;
+}
+
+/**
+ * Writes the summaries, histograms and xrun events to \a fileName, as JSON
+ * if its suffix is .json, as CSV otherwise.
+ * @return 1 on success, -1 if the file couldn't be written
+ */
+int TAudioTelemetry::dump(const QString& fileName) const
+{
+	QFile file(fileName);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		PERROR("Could not open %s for writing", QS_C(fileName));
+		return -1;
+	}
+
+	QTextStream out(&file);
+	bool json = fileName.endsWith(".json", Qt::CaseInsensitive);
+
+	if (json) {
+		out << "{\n";
+		out << "  \"periodUsecs\": " << m_periodUsecs << ",\n";
+		out << "  \"droppedRecords\": " << m_droppedCount << ",\n";
+		out << "  \"metrics\": {\n";
+	} else {
+		out << "# period_usecs," << m_periodUsecs << "\n";
+		out << "# dropped_records," << m_droppedCount << "\n";
+		out << "metric,p50_usecs,p99_usecs,min_usecs,max_usecs,cycles\n";
+	}
+
+	for (int m=0; m<METRIC_COUNT; ++m) {
+		Metric metric = Metric(m);
+		Summary summary = get_summary(metric);
+
+		if (json) {
+			out << "    \"" << metric_name(metric) << "\": {"
+			    << "\"p50\": " << summary.p50 << ", \"p99\": " << summary.p99
+			    << ", \"min\": " << summary.min << ", \"max\": " << summary.max
+			    << ", \"cycles\": " << summary.count << ", \"histogram\": [";
+
+			bool first = true;
+			for (int i=0; i<BUCKET_COUNT; ++i) {
+				if (m_histograms[m].buckets[i] == 0) {
+					continue;
+				}
+				out << (first ? "" : ", ") << "[" << bucket_upper_bound(i) << ", " << m_histograms[m].buckets[i] << "]";
+				first = false;
+			}
+
+			out << "]}" << (m < METRIC_COUNT - 1 ? "," : "") << "\n";
+		} else {
+			out << metric_name(metric) << "," << summary.p50 << "," << summary.p99 << ","
+			    << summary.min << "," << summary.max << "," << summary.count << "\n";
+		}
+	}
+
+	if (json) {
+		out << "  },\n";
+		out << "  \"xruns\": [";
+		for (int i=0; i<m_xrunEvents.size(); ++i) {
+			out << (i ? ", " : "") << "{\"time\": " << qint64(m_xrunEvents.at(i).time)
+			    << ", \"delayUsecs\": " << m_xrunEvents.at(i).delay << "}";
+		}
+		out << "]\n}\n";
+	} else {
+		out << "\nmetric,bucket_upper_usecs,cycles\n";
+		for (int m=0; m<METRIC_COUNT; ++m) {
+			for (int i=0; i<BUCKET_COUNT; ++i) {
+				if (m_histograms[m].buckets[i]) {
+					out << metric_name(Metric(m)) << "," << bucket_upper_bound(i) << "," << m_histograms[m].buckets[i] << "\n";
+				}
+			}
+		}
+
+		out << "\nxrun_time_usecs,xrun_delay_usecs\n";
+		foreach(const XrunEvent& event, m_xrunEvents) {
+			out << qint64(event.time) << "," << event.delay << "\n";
+		}
+	}
+
+	return file.error() == QFile::NoError ? 1 : -1;
+}
+
+//eof
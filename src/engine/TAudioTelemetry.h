@@ -0,0 +1,121 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TAUDIO_TELEMETRY_H
+#define TAUDIO_TELEMETRY_H
+
+#include <QList>
+#include <QString>
+
+#include "RingBufferNPT.h"
+#include "defines.h"
+
+/**
+ * Collects timing information of each audio cycle: how late the driver
+ * woke up (wakeup jitter), how long processing took and how much of the
+ * period was left (headroom), plus xrun events.
+ *
+ * The audio thread only writes fixed size records into a lock free ring
+ * buffer, the GUI thread calls update() to move them into histograms,
+ * from which percentiles are reported.
+ * When nobody calls update() the ring buffer fills up and new records are
+ * dropped (and counted), the audio thread never waits or allocates.
+ */
+class TAudioTelemetry
+{
+public:
+	TAudioTelemetry();
+	~TAudioTelemetry();
+
+	enum Metric {
+		WAKEUP_JITTER,
+		PROCESS_TIME,
+		HEADROOM,
+		METRIC_COUNT
+	};
+
+	struct Summary {
+		float	p50;
+		float	p99;
+		float	min;
+		float	max;
+		qint64	count;
+	};
+
+	struct XrunEvent {
+		trav_time_t	time;
+		float		delay;
+	};
+
+	// audio thread
+	void record_cycle(float wakeupDelay, float processTime);
+	void record_xrun(trav_time_t time, float delay);
+
+	// gui thread
+	void update();
+	void reset(float periodUsecs);
+	Summary get_summary(Metric metric) const;
+	qint64 get_xrun_count() const {return m_xrunCount;}
+	qint64 get_dropped_count() const {return m_droppedCount;}
+	QString get_summary_text() const;
+	int dump(const QString& fileName) const;
+
+private:
+	// 16 linear buckets for values < 16 usecs, then 8 buckets per
+	// power of 2 up to 2^24 usecs (~16 seconds)
+	static const int LINEAR_BUCKETS = 16;
+	static const int SUB_BUCKETS = 8;
+	static const int BUCKET_COUNT = LINEAR_BUCKETS + (24 - 4) * SUB_BUCKETS;
+	static const int MAX_XRUN_EVENTS = 256;
+
+	struct Record {
+		float	wakeupDelay;
+		float	processTime;
+		float	xrunDelay;
+		bool	xrun;
+		trav_time_t time;
+	};
+
+	struct Histogram {
+		qint64	buckets[BUCKET_COUNT];
+		float	min;
+		float	max;
+		qint64	count;
+	};
+
+	RingBufferNPT<Record>*	m_records;
+	Histogram		m_histograms[METRIC_COUNT];
+	QList<XrunEvent>	m_xrunEvents;
+	float			m_periodUsecs;
+	qint64			m_xrunCount;
+	qint64			m_droppedCount;
+	volatile int		m_dropped;
+
+	void add_value(Metric metric, float value);
+	float percentile(const Histogram& histogram, float fraction) const;
+	static int bucket_index(float value);
+	static float bucket_upper_bound(int index);
+	static const char* metric_name(Metric metric);
+};
+
+#endif
+
+//eof
@@ -0,0 +1,225 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TFileDriver.h"
+
+#include "AudioDevice.h"
+#include "AudioChannel.h"
+#include "Utils.h"
+#include "Mixer.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+#define FILE_DRIVER_PLAYBACK_CHANNELS	2
+
+
+TFileDriver::TFileDriver(AudioDevice* dev, int rate, nframes_t bufferSize)
+	: TAudioDriver(dev, rate, bufferSize)
+{
+	read = MakeDelegate(this, &TFileDriver::_read);
+	write = MakeDelegate(this, &TFileDriver::_write);
+
+	m_inputFile = 0;
+	m_outputFile = 0;
+	m_inputChannels = 0;
+	m_buffer = 0;
+	m_channelBuffers = 0;
+}
+
+TFileDriver::~TFileDriver()
+{
+	PENTERDES;
+	close_files();
+	delete [] m_buffer;
+	delete [] m_channelBuffers;
+}
+
+int TFileDriver::setup(bool capture, bool playback, const QString& cardDevice)
+{
+	Q_UNUSED(cardDevice);
+
+	set_freewheel(device->get_driver_property("filedriverfreewheel", false).toBool());
+
+	if (capture) {
+		m_inputFileName = device->get_driver_property("filedriverinput", "").toString();
+	}
+	if (playback) {
+		m_outputFileName = device->get_driver_property("filedriveroutput", "").toString();
+	}
+
+	if (!m_inputFileName.isEmpty()) {
+		SF_INFO info;
+		memset(&info, 0, sizeof(info));
+
+		m_inputFile = sf_open(QS_C(m_inputFileName), SFM_READ, &info);
+		if (!m_inputFile) {
+			device->message(QObject::tr("File Driver: Could not open %1 (%2)").arg(m_inputFileName).arg(sf_strerror(0)), AudioDevice::WARNING);
+			return -1;
+		}
+
+		if (info.samplerate != int(frame_rate)) {
+			device->message(QObject::tr("File Driver: %1 has a sample rate of %2 Hz, it will be played at %3 Hz")
+					.arg(m_inputFileName).arg(info.samplerate).arg(frame_rate), AudioDevice::WARNING);
+		}
+
+		m_inputChannels = info.channels;
+	}
+
+	if (!m_outputFileName.isEmpty()) {
+		SF_INFO info;
+		memset(&info, 0, sizeof(info));
+		info.samplerate = frame_rate;
+		info.channels = FILE_DRIVER_PLAYBACK_CHANNELS;
+		info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+		m_outputFile = sf_open(QS_C(m_outputFileName), SFM_WRITE, &info);
+		if (!m_outputFile) {
+			device->message(QObject::tr("File Driver: Could not create %1 (%2)").arg(m_outputFileName).arg(sf_strerror(0)), AudioDevice::WARNING);
+			close_files();
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+int TFileDriver::attach()
+{
+	char buf[32];
+	AudioChannel* chan;
+
+	device->set_buffer_size (frames_per_cycle);
+	device->set_sample_rate (frame_rate);
+
+	int captureChannels = m_inputFile ? m_inputChannels : 2;
+
+	for (int chn=0; chn<captureChannels; chn++) {
+		snprintf (buf, sizeof(buf) - 1, "capture_%d", chn+1);
+
+		chan = add_capture_channel(buf);
+		chan->set_latency(frames_per_cycle);
+	}
+
+	for (int chn=0; chn<FILE_DRIVER_PLAYBACK_CHANNELS; chn++) {
+		snprintf (buf, sizeof(buf) - 1, "playback_%d", chn+1);
+
+		chan = add_playback_channel(buf);
+		chan->set_latency(frames_per_cycle);
+	}
+
+	delete [] m_buffer;
+	delete [] m_channelBuffers;
+	m_buffer = new audio_sample_t[frames_per_cycle * qMax(captureChannels, FILE_DRIVER_PLAYBACK_CHANNELS)];
+	m_channelBuffers = new audio_sample_t*[qMax(captureChannels, FILE_DRIVER_PLAYBACK_CHANNELS)];
+
+	return 1;
+}
+
+int TFileDriver::_read(nframes_t nframes)
+{
+	if (!m_inputFile) {
+		foreach(AudioChannel* chan, m_captureChannels) {
+			chan->silence_buffer(nframes);
+		}
+		return 1;
+	}
+
+	sf_count_t read = sf_readf_float(m_inputFile, m_buffer, nframes);
+	int channels = m_captureChannels.size();
+	audio_sample_t** buffers = m_channelBuffers;
+
+	for (int c=0; c<channels; ++c) {
+		buffers[c] = m_captureChannels.at(c)->get_buffer(nframes);
+	}
+
+	Mixer::deinterleave(buffers, m_buffer, channels, nframes_t(read));
+
+	// silence after the end of the input file
+	for (int c=0; c<channels; ++c) {
+		for (nframes_t i=read; i<nframes; ++i) {
+			buffers[c][i] = 0.0f;
+		}
+	}
+
+	return 1;
+}
+
+int TFileDriver::_write(nframes_t nframes)
+{
+	int channels = m_playbackChannels.size();
+
+	if (m_outputFile) {
+		audio_sample_t** buffers = m_channelBuffers;
+
+		for (int c=0; c<channels; ++c) {
+			buffers[c] = m_playbackChannels.at(c)->get_buffer(nframes);
+		}
+
+		Mixer::interleave(m_buffer, buffers, channels, nframes);
+
+		if (sf_writef_float(m_outputFile, m_buffer, nframes) != sf_count_t(nframes)) {
+			PERROR("File Driver: could only write part of the cycle to %s", QS_C(m_outputFileName));
+		}
+	}
+
+	foreach(AudioChannel* chan, m_playbackChannels) {
+		chan->silence_buffer(nframes);
+	}
+
+	return 1;
+}
+
+int TFileDriver::stop()
+{
+	if (m_outputFile) {
+		sf_write_sync(m_outputFile);
+	}
+
+	return 1;
+}
+
+void TFileDriver::close_files()
+{
+	if (m_inputFile) {
+		sf_close(m_inputFile);
+		m_inputFile = 0;
+	}
+	if (m_outputFile) {
+		sf_close(m_outputFile);
+		m_outputFile = 0;
+	}
+}
+
+QString TFileDriver::get_device_name()
+{
+	return "File Audio Device";
+}
+
+QString TFileDriver::get_device_longname()
+{
+	return QString("File Audio Device (%1 -> %2)")
+		.arg(m_inputFileName.isEmpty() ? "silence" : m_inputFileName)
+		.arg(m_outputFileName.isEmpty() ? "none" : m_outputFileName);
+}
+
+//eof
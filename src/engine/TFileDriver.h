@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef T_FILE_DRIVER_H
+#define T_FILE_DRIVER_H
+
+#include "TAudioDriver.h"
+
+#include <sndfile.h>
+
+/**
+ * Audio driver without sound hardware: the capture channels are read from
+ * an audio file, the playback channels are written to a 32 bit float WAV
+ * file. Cycles are paced like the null driver, or run back to back when
+ * freewheeling, which makes engine runs reproducible on machines without
+ * a sound card.
+ *
+ * The files are taken from the driver properties "filedriverinput" and
+ * "filedriveroutput", both are optional. Without input file 2 silent
+ * capture channels are created. "filedriverfreewheel" starts the driver
+ * freewheeling.
+ */
+class TFileDriver : public TAudioDriver
+{
+public:
+	TFileDriver(AudioDevice* dev, int rate, nframes_t bufferSize);
+	~TFileDriver();
+
+	int _read(nframes_t nframes);
+	int _write(nframes_t nframes);
+	int setup(bool capture=true, bool playback=true, const QString& cardDevice="none");
+	int attach();
+	int stop();
+
+	QString get_device_name();
+	QString get_device_longname();
+
+private:
+	QString		m_inputFileName;
+	QString		m_outputFileName;
+	SNDFILE*	m_inputFile;
+	SNDFILE*	m_outputFile;
+	int		m_inputChannels;
+	// interleaved buffer shared by _read() and _write()
+	audio_sample_t*	m_buffer;
+	// the channel buffers (de)interleaved by _read() and _write()
+	audio_sample_t** m_channelBuffers;
+
+	void close_files();
+};
+
+#endif
+
+//eof
@@ -0,0 +1,177 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TScratchArena.h"
+
+#include <QtGlobal>
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+#if defined (_MSC_VER)
+#define SCRATCH_THREAD_LOCAL __declspec(thread)
+#else
+#define SCRATCH_THREAD_LOCAL __thread
+#endif
+
+// The arena of the cycle the calling thread is processing, if any
+static SCRATCH_THREAD_LOCAL TScratchArena* currentArena = 0;
+
+
+static inline size_t align_size(size_t size)
+{
+	return (size + TScratchArena::ALIGNMENT - 1) & ~(TScratchArena::ALIGNMENT - 1);
+}
+
+
+/**
+ * @param realtime true for the arena of the audio thread, in which
+ *	case the process() functions are checked to not allocate memory
+ *	in debug builds.
+ */
+TScratchArena::TScratchArena(bool realtime)
+{
+	m_memory = m_data = 0;
+	m_capacity = m_offset = m_highWaterMark = 0;
+	m_overflowCount = 0;
+	m_realtime = realtime;
+}
+
+TScratchArena::~TScratchArena()
+{
+	Q_ASSERT(currentArena != this);
+	delete [] m_memory;
+}
+
+/**
+ * (Re)allocates the arena for cycles of at most \a bufferSize frames,
+ * call this only when the thread using it isn't processing.
+ */
+void TScratchArena::reserve(nframes_t bufferSize)
+{
+	Q_ASSERT_X(currentArena != this, "TScratchArena::reserve", "Called within a process cycle");
+
+	// room for the deepest chain, so it can't run out in release builds
+	size_t capacity = BUFFER_COUNT * align_size(bufferSize * sizeof(audio_sample_t))
+			+ ARRAY_COUNT * align_size(MAX_CHANNELS * sizeof(audio_sample_t*));
+
+	if (capacity == m_capacity) {
+		return;
+	}
+
+	delete [] m_memory;
+
+	m_memory = new char[capacity + ALIGNMENT];
+	m_data = m_memory + (ALIGNMENT - (size_t(m_memory) % ALIGNMENT)) % ALIGNMENT;
+	m_capacity = capacity;
+	m_offset = m_highWaterMark = 0;
+	m_overflowCount = 0;
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+void TScratchArena::begin_cycle()
+{
+	m_offset = 0;
+	currentArena = this;
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+void TScratchArena::end_cycle()
+{
+	Q_ASSERT(m_offset == 0);
+	currentArena = 0;
+}
+
+void* TScratchArena::allocate(size_t size)
+{
+	size = align_size(size);
+
+	if (m_offset + size > m_capacity) {
+		Q_ASSERT_X(false, "TScratchArena::allocate", "Out of scratch memory");
+		m_overflowCount++;
+		return 0;
+	}
+
+	void* memory = m_data + m_offset;
+	m_offset += size;
+
+	if (m_offset > m_highWaterMark) {
+		m_highWaterMark = m_offset;
+	}
+
+	return memory;
+}
+
+/**
+ * @return The arena of the cycle the calling thread is processing, 0 if
+ *	the calling thread isn't processing
+ */
+TScratchArena* TScratchArena::current()
+{
+	return currentArena;
+}
+
+/**
+ * @return true if the calling thread is processing an audio thread cycle,
+ *	use it to assert that a function that allocates memory or blocks isn't
+ *	called from the audio processing path.
+ */
+bool TScratchArena::in_realtime_cycle()
+{
+	return currentArena && currentArena->m_realtime;
+}
+
+
+TScratchArena::Scope::Scope()
+{
+	m_arena = currentArena;
+	m_offset = m_arena ? m_arena->m_offset : 0;
+}
+
+TScratchArena::Scope::~Scope()
+{
+	if (m_arena) {
+		m_arena->m_offset = m_offset;
+	}
+}
+
+/**
+ * @return \a size bytes of cache line aligned memory, valid till this Scope
+ *	is destroyed, or 0 if the calling thread isn't processing or the
+ *	arena ran out of memory.
+ */
+void* TScratchArena::Scope::allocate(size_t size)
+{
+	Q_ASSERT_X(m_arena, "TScratchArena::Scope::allocate", "Not called within a process cycle");
+
+	if (!m_arena) {
+		return 0;
+	}
+
+	return m_arena->allocate(size);
+}
+
+//eof
@@ -0,0 +1,110 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TSCRATCH_ARENA_H
+#define TSCRATCH_ARENA_H
+
+#include <cstddef>
+
+#include "defines.h"
+
+/**
+ * Preallocated scratch memory for the process() functions of one processing
+ * thread (the audio thread, or the export thread when not freewheeling).
+ *
+ * The thread calls begin_cycle() at the start of each cycle, which resets
+ * the arena and makes it the current() arena of that thread, and end_cycle()
+ * when done. Within the cycle, process() functions take their temporary
+ * buffers from it through a Scope, which hands the memory back when it goes
+ * out of scope, so nested process() calls only need as much memory as the
+ * deepest call chain.
+ *
+ * All allocations are aligned to a cache line. The memory is reserved with
+ * reserve() whenever the buffer size changes, never within a cycle.
+ */
+class TScratchArena
+{
+public:
+	TScratchArena(bool realtime);
+	~TScratchArena();
+
+	static const size_t ALIGNMENT = 64;
+	// The most channels a process() function takes buffers for,
+	// AudioClip doesn't render clips with more channels
+	static const int MAX_CHANNELS = 32;
+	// The number of period sized buffers, and of per channel arrays, the
+	// deepest process() chain can have in use at the same time, plus one
+	// to spare: an AudioClip renders into MAX_CHANNELS buffers wrapped by
+	// 2 arrays, a FadeCurve inside it takes another buffer and array. The
+	// fader and sends of a Track need less than that.
+	static const int BUFFER_COUNT = MAX_CHANNELS + 2;
+	static const int ARRAY_COUNT = 4;
+
+	void reserve(nframes_t bufferSize);
+	void begin_cycle();
+	void end_cycle();
+
+	size_t get_capacity() const {return m_capacity;}
+	size_t get_high_water_mark() const {return m_highWaterMark;}
+	int get_overflow_count() const {return m_overflowCount;}
+
+	static TScratchArena* current();
+	static bool in_realtime_cycle();
+
+	class Scope
+	{
+	public:
+		Scope();
+		~Scope();
+
+		void* allocate(size_t size);
+
+		template<typename T>
+		T* allocate(size_t count) {return static_cast<T*>(allocate(count * sizeof(T)));}
+
+	private:
+		TScratchArena*	m_arena;
+		size_t		m_offset;
+
+		Scope(const Scope&);
+		Scope& operator=(const Scope&);
+	};
+
+private:
+	char*		m_memory;
+	char*		m_data;
+	size_t		m_capacity;
+	size_t		m_offset;
+	size_t		m_highWaterMark;
+	int		m_overflowCount;
+	bool		m_realtime;
+
+	void* allocate(size_t size);
+
+	friend class Scope;
+
+	TScratchArena(const TScratchArena&);
+	TScratchArena& operator=(const TScratchArena&);
+};
+
+#endif
+
+//eof
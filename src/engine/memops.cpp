@@ -39,13 +39,29 @@
 #define f_round(f) lrintf(f)
 
 
+#define FAST_RAND_MUL	96314165U
+#define FAST_RAND_ADD	907633515U
+
+// shared by all dither functions (and their SIMD versions), so the
+// noise sequence doesn't depend on which ones are used
+static unsigned int fast_rand_seed = 22222;
+
 inline unsigned int fast_rand() {
-	static unsigned int seed = 22222;
-	seed = (seed * 96314165) + 907633515;
+	fast_rand_seed = (fast_rand_seed * FAST_RAND_MUL) + FAST_RAND_ADD;
 
-	return seed;
+	return fast_rand_seed;
 } 
 
+unsigned int memops_get_dither_seed()
+{
+	return fast_rand_seed;
+}
+
+void memops_set_dither_seed(unsigned int seed)
+{
+	fast_rand_seed = seed;
+}
+
 void sample_move_d32u24_sSs (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
 
 {
@@ -1203,3 +1219,358 @@ memcpy_interleave_d32_s32 (char *dst, char *src, unsigned long src_bytes,
 		src_bytes -= 4;
 	}
 }
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+#include <immintrin.h>
+
+/* SSE2 versions of the native byte order float to integer conversions.
+   For finite samples with a magnitude below 65536 (beyond that the 16 bit
+   scalar code wraps around, these saturate) the output is bit for bit the
+   same as the scalar versions above, and fast_rand_seed is advanced the
+   same way, so the dither noise doesn't depend on which one is used.
+   Remaining samples (less than 4) are handed to the scalar versions.
+   There are no versions of the noise shaped dither: the error of each
+   sample feeds into the next one, so it can't be split over lanes without
+   changing the order (and thus the rounding) of the filter. */
+
+/* fast_rand() multipliers and increments for 1, 2, 3 and 4 steps, to
+   compute 4 consecutive values at once */
+static const unsigned int fast_rand_lane_mul[4] = {
+	FAST_RAND_MUL,
+	FAST_RAND_MUL * FAST_RAND_MUL,
+	FAST_RAND_MUL * FAST_RAND_MUL * FAST_RAND_MUL,
+	FAST_RAND_MUL * FAST_RAND_MUL * FAST_RAND_MUL * FAST_RAND_MUL
+};
+
+static const unsigned int fast_rand_lane_add[4] = {
+	FAST_RAND_ADD,
+	FAST_RAND_ADD * FAST_RAND_MUL + FAST_RAND_ADD,
+	(FAST_RAND_ADD * FAST_RAND_MUL + FAST_RAND_ADD) * FAST_RAND_MUL + FAST_RAND_ADD,
+	((FAST_RAND_ADD * FAST_RAND_MUL + FAST_RAND_ADD) * FAST_RAND_MUL + FAST_RAND_ADD) * FAST_RAND_MUL + FAST_RAND_ADD
+};
+
+typedef struct {
+	__m128i seed;
+	__m128i mul;
+	__m128i add;
+} sse2_fast_rand_t;
+
+__attribute__((target("sse2")))
+static inline __m128i x86_sse2_mullo_epi32(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+__attribute__((target("sse2")))
+static inline void x86_sse2_fast_rand_init(sse2_fast_rand_t* rand)
+{
+	rand->seed = _mm_set1_epi32(fast_rand_seed);
+	rand->mul = _mm_loadu_si128((const __m128i*) fast_rand_lane_mul);
+	rand->add = _mm_loadu_si128((const __m128i*) fast_rand_lane_add);
+}
+
+/* The next 4 fast_rand() values. The first call advances each lane of the
+   start seed by 1 to 4 steps, after that all lanes advance 4 steps. */
+__attribute__((target("sse2")))
+static inline __m128i x86_sse2_fast_rand(sse2_fast_rand_t* rand)
+{
+	rand->seed = _mm_add_epi32(x86_sse2_mullo_epi32(rand->seed, rand->mul), rand->add);
+	rand->mul = _mm_set1_epi32(fast_rand_lane_mul[3]);
+	rand->add = _mm_set1_epi32(fast_rand_lane_add[3]);
+
+	return rand->seed;
+}
+
+__attribute__((target("sse2")))
+static inline void x86_sse2_fast_rand_finish(sse2_fast_rand_t* rand)
+{
+	fast_rand_seed = _mm_cvtsi128_si32(_mm_shuffle_epi32(rand->seed, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+/* (float)u for unsigned u, converted through double so it's rounded only
+   once, like the scalar conversion */
+__attribute__((target("sse2")))
+static inline __m128 x86_sse2_uint_to_float(__m128i u)
+{
+	__m128i s = _mm_xor_si128(u, _mm_set1_epi32(0x80000000));
+	__m128d bias = _mm_set1_pd(2147483648.0);
+	__m128d lo = _mm_add_pd(_mm_cvtepi32_pd(s), bias);
+	__m128d hi = _mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2))), bias);
+
+	return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+/* (float)fast_rand() / (float)INT_MAX */
+__attribute__((target("sse2")))
+static inline __m128 x86_sse2_rect_noise(sse2_fast_rand_t* rand)
+{
+	return _mm_mul_ps(x86_sse2_uint_to_float(x86_sse2_fast_rand(rand)), _mm_set1_ps(1.0f / (float)INT_MAX));
+}
+
+/* 2.0f * (float)fast_rand() / (float)INT_MAX - 1.0f */
+__attribute__((target("sse2")))
+static inline __m128 x86_sse2_tri_noise(sse2_fast_rand_t* rand)
+{
+	__m128 f = x86_sse2_uint_to_float(x86_sse2_fast_rand(rand));
+
+	return _mm_sub_ps(_mm_mul_ps(f, _mm_set1_ps(2.0f / (float)INT_MAX)), _mm_set1_ps(1.0f));
+}
+
+/* r - rm1 for each lane, with rm1 the noise value of the previous sample */
+__attribute__((target("sse2")))
+static inline __m128 x86_sse2_tri_noise_diff(__m128 r, float* rm1)
+{
+	__m128 prev = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(r), 4));
+	prev = _mm_move_ss(prev, _mm_set_ss(*rm1));
+	*rm1 = _mm_cvtss_f32(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+
+	return _mm_sub_ps(r, prev);
+}
+
+/* f_round(x), x is limited to a range that can't overflow but still
+   saturates all output formats */
+__attribute__((target("sse2")))
+static inline __m128i x86_sse2_round(__m128 x)
+{
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-65536.0f)), _mm_set1_ps(65536.0f));
+
+	return _mm_cvtps_epi32(x);
+}
+
+__attribute__((target("sse2")))
+static inline void x86_sse2_store_d32 (char *dst, __m128i z, unsigned long dst_skip)
+{
+	if (dst_skip == 4) {
+		_mm_storeu_si128((__m128i*) dst, z);
+		return;
+	}
+
+	int values[4];
+	_mm_storeu_si128((__m128i*) values, z);
+	for (int i = 0; i < 4; i++) {
+		*((int *) (dst + i * dst_skip)) = values[i];
+	}
+}
+
+__attribute__((target("sse2")))
+static inline void x86_sse2_store_d24 (char *dst, __m128i z, unsigned long dst_skip)
+{
+	int values[4];
+	_mm_storeu_si128((__m128i*) values, z);
+	for (int i = 0; i < 4; i++) {
+		memcpy (dst + i * dst_skip, &values[i], 3);
+	}
+}
+
+/* stores the 4 shorts in the low half of z */
+__attribute__((target("sse2")))
+static inline void x86_sse2_store_d16 (char *dst, __m128i z, unsigned long dst_skip)
+{
+	if (dst_skip == 2) {
+		_mm_storel_epi64((__m128i*) dst, z);
+		return;
+	}
+
+	*((short *) dst) = (short) _mm_extract_epi16(z, 0);
+	*((short *) (dst + dst_skip)) = (short) _mm_extract_epi16(z, 1);
+	*((short *) (dst + 2 * dst_skip)) = (short) _mm_extract_epi16(z, 2);
+	*((short *) (dst + 3 * dst_skip)) = (short) _mm_extract_epi16(z, 3);
+}
+
+/* the rounded 16 bit values y, shifted and saturated like the scalar
+   dither functions do */
+__attribute__((target("sse2")))
+static inline void x86_sse2_store_rounded_d32u24 (char *dst, __m128i y, unsigned long dst_skip)
+{
+	__m128i over = _mm_cmpgt_epi32(y, _mm_set1_epi32(SHRT_MAX));
+	__m128i z = _mm_unpacklo_epi16(_mm_setzero_si128(), _mm_packs_epi32(y, y));
+
+	x86_sse2_store_d32(dst, _mm_or_si128(z, _mm_srli_epi32(over, 16)), dst_skip);
+}
+
+__attribute__((target("sse2")))
+static inline void x86_sse2_store_rounded_d24 (char *dst, __m128i y, unsigned long dst_skip)
+{
+	__m128i over = _mm_cmpgt_epi32(y, _mm_set1_epi32(SHRT_MAX));
+	__m128i z = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), _mm_packs_epi32(y, y)), 8);
+
+	x86_sse2_store_d24(dst, _mm_or_si128(z, _mm_srli_epi32(over, 24)), dst_skip);
+}
+
+__attribute__((target("sse2")))
+static inline void x86_sse2_store_rounded_d16 (char *dst, __m128i y, unsigned long dst_skip)
+{
+	x86_sse2_store_d16(dst, _mm_packs_epi32(y, y), dst_skip);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_d32u24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_24BIT));
+		/* like the 64 bit conversion: >= 2^23 becomes INT_MAX, NaN INT_MIN */
+		__m128i over = _mm_castps_si128(_mm_cmpge_ps(x, _mm_set1_ps(SAMPLE_MAX_24BIT)));
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-SAMPLE_MAX_24BIT)), _mm_set1_ps(SAMPLE_MAX_24BIT - 0.5f));
+		__m128i z = _mm_slli_epi32(_mm_cvttps_epi32(x), 8);
+
+		x86_sse2_store_d32(dst, _mm_or_si128(z, _mm_srli_epi32(over, 24)), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d32u24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_dither_rect_d32u24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	sse2_fast_rand_t rand;
+	x86_sse2_fast_rand_init(&rand);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+		x = _mm_sub_ps(x, x86_sse2_rect_noise(&rand));
+
+		x86_sse2_store_rounded_d32u24(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	x86_sse2_fast_rand_finish(&rand);
+	sample_move_dither_rect_d32u24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_dither_tri_d32u24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	float rm1 = state->rm1;
+	sse2_fast_rand_t rand;
+	x86_sse2_fast_rand_init(&rand);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+		x = _mm_add_ps(x, x86_sse2_tri_noise_diff(x86_sse2_tri_noise(&rand), &rm1));
+
+		x86_sse2_store_rounded_d32u24(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	x86_sse2_fast_rand_finish(&rand);
+	state->rm1 = rm1;
+	sample_move_dither_tri_d32u24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_d24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_24BIT));
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-SAMPLE_MAX_24BIT)), _mm_set1_ps(SAMPLE_MAX_24BIT - 1.0f));
+
+		x86_sse2_store_d24(dst, _mm_cvttps_epi32(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_dither_rect_d24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	sse2_fast_rand_t rand;
+	x86_sse2_fast_rand_init(&rand);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+		x = _mm_sub_ps(x, x86_sse2_rect_noise(&rand));
+
+		x86_sse2_store_rounded_d24(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	x86_sse2_fast_rand_finish(&rand);
+	sample_move_dither_rect_d24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_dither_tri_d24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	float rm1 = state->rm1;
+	sse2_fast_rand_t rand;
+	x86_sse2_fast_rand_init(&rand);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+		x = _mm_add_ps(x, x86_sse2_tri_noise_diff(x86_sse2_tri_noise(&rand), &rm1));
+
+		x86_sse2_store_rounded_d24(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	x86_sse2_fast_rand_finish(&rand);
+	state->rm1 = rm1;
+	sample_move_dither_tri_d24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_d16_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+
+		x86_sse2_store_rounded_d16(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d16_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_dither_rect_d16_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	sse2_fast_rand_t rand;
+	x86_sse2_fast_rand_init(&rand);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+		x = _mm_sub_ps(x, x86_sse2_rect_noise(&rand));
+
+		x86_sse2_store_rounded_d16(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	x86_sse2_fast_rand_finish(&rand);
+	sample_move_dither_rect_d16_sS(dst, src, nsamples, dst_skip, state);
+}
+
+__attribute__((target("sse2")))
+void x86_sse2_sample_move_dither_tri_d16_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+{
+	float rm1 = state->rm1;
+	sse2_fast_rand_t rand;
+	x86_sse2_fast_rand_init(&rand);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(SAMPLE_MAX_16BIT));
+		x = _mm_add_ps(x, x86_sse2_tri_noise_diff(x86_sse2_tri_noise(&rand), &rm1));
+
+		x86_sse2_store_rounded_d16(dst, x86_sse2_round(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	x86_sse2_fast_rand_finish(&rand);
+	state->rm1 = rm1;
+	sample_move_dither_tri_d16_sS(dst, src, nsamples, dst_skip, state);
+}
+
+#endif
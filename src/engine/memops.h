@@ -75,9 +75,26 @@ void sample_move_dS_s24s             (audio_sample_t *dst, char *src, unsigned l
 void sample_move_dS_s16              (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
 void sample_move_dS_s16s             (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
 
+/* the random generator state of the dither functions, lets the tests replay a conversion */
+void memops_set_dither_seed          (unsigned int seed);
+unsigned int memops_get_dither_seed  ();
+
 void sample_merge_d16_sS             (char *dst,  audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
 void sample_merge_d32u24_sS          (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
 
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+/* SSE2 versions of the native byte order conversions, select at runtime with FPU::has_sse2() */
+void x86_sse2_sample_move_d32u24_sS              (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_d24_sS                 (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_d16_sS                 (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_rect_d32u24_sS  (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_tri_d32u24_sS   (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_rect_d24_sS     (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_tri_d24_sS      (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_rect_d16_sS     (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_tri_d16_sS      (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+#endif
+
 static __inline__ void
 sample_merge (audio_sample_t *dst, audio_sample_t *src, unsigned long cnt)
 
@@ -52,6 +52,9 @@ enum PortType {
 LV2Plugin::LV2Plugin(TSession* session, bool slave)
         : Plugin(session)
 	, m_plugin(0)
+	, m_instance(0)
+	, m_latencyPortIndex(-1)
+	, m_worker(0)
 {
 	m_isSlave = slave;
 }
@@ -61,13 +64,21 @@ LV2Plugin::LV2Plugin(TSession* session, char* pluginUri)
         : Plugin(session)
 	, m_pluginUri((char*) pluginUri)
 	, m_plugin(0)
+	, m_instance(0)
 	, m_isSlave(false)
+	, m_latencyPortIndex(-1)
+	, m_worker(0)
 {
 }
 
 
 LV2Plugin::~LV2Plugin()
 {
+	// stop the worker first, work() may not run during deactivate(),
+	// which is in the same threading class as instantiate()
+	delete m_worker;
+	m_worker = 0;
+
 	/* Deactivate and free plugin instance */
 	if (m_instance) {
 		lilv_instance_deactivate(m_instance);
@@ -230,9 +241,26 @@ int LV2Plugin::create_instance()
 		return -1;
 	}
 	
+	/* Set up the features we support */
+	m_uridMapFeature.URI = LV2_URID__map;
+	m_uridMapFeature.data = PluginManager::instance()->get_urid_map();
+	m_uridUnmapFeature.URI = LV2_URID__unmap;
+	m_uridUnmapFeature.data = PluginManager::instance()->get_urid_unmap();
+	// the worker is only created when the plugin turns out to have
+	// a worker interface, so schedule_work() goes through us.
+	m_workerSchedule.handle = this;
+	m_workerSchedule.schedule_work = schedule_work;
+	m_workerFeature.URI = LV2_WORKER__schedule;
+	m_workerFeature.data = &m_workerSchedule;
+
+	m_features[0] = &m_uridMapFeature;
+	m_features[1] = &m_uridUnmapFeature;
+	m_features[2] = &m_workerFeature;
+	m_features[3] = NULL;
+
 	/* Instantiate the plugin */
 	int samplerate = audiodevice().get_sample_rate();
-	m_instance = lilv_plugin_instantiate(m_plugin, samplerate, NULL);
+	m_instance = lilv_plugin_instantiate(m_plugin, samplerate, m_features);
 
 	if (! m_instance) {
 		printf("Failed to instantiate plugin.\n");
@@ -240,11 +268,55 @@ int LV2Plugin::create_instance()
 	} else {
 // 		printf("Succesfully instantiated plugin.\n\n");
 	}
+
+	const LV2_Worker_Interface* workerInterface = (const LV2_Worker_Interface*)
+			lilv_instance_get_extension_data(m_instance, LV2_WORKER__interface);
+	if (workerInterface) {
+		m_worker = new LV2Worker();
+		m_worker->set_interface(workerInterface, lilv_instance_get_handle(m_instance));
+	}
+
+	if (lilv_plugin_has_latency(m_plugin)) {
+		m_latencyPortIndex = lilv_plugin_get_latency_port_index(m_plugin);
+	}
 	
 	return 1;
 }
 
 
+LV2_Worker_Status LV2Plugin::schedule_work(LV2_Worker_Schedule_Handle handle, uint32_t size, const void* data)
+{
+	LV2Plugin* plugin = static_cast<LV2Plugin*>(handle);
+
+	if (!plugin->m_worker) {
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	return plugin->m_worker->schedule(size, data);
+}
+
+
+/**
+ * @return The latency the plugin reports through its latency port, in
+ *	frames. Updated by the plugin each time it's run.
+ */
+nframes_t LV2Plugin::get_latency()
+{
+	if (m_latencyPortIndex < 0 || is_bypassed()) {
+		return 0;
+	}
+
+	PluginControlPort* port = get_control_port_by_index(m_latencyPortIndex);
+	if (!port) {
+		return 0;
+	}
+
+	float latency = port->get_control_value();
+
+	return latency > 0 ? nframes_t(latency) : 0;
+}
+
+
 void LV2Plugin::process(AudioBus* bus, unsigned long nframes)
 {
 	if ( is_bypassed() ) {
@@ -269,6 +341,10 @@ void LV2Plugin::process(AudioBus* bus, unsigned long nframes)
 	
 	/* Run plugin for this cycle */
 	lilv_instance_run(m_instance, nframes);
+
+	if (m_worker) {
+		m_worker->deliver_responses();
+	}
 	
 	// If we have a slave, and the bus has 2 channels, process the slave too!
 	if (m_slave && bus->get_channel_count() == 2) {
@@ -467,14 +543,13 @@ TCommand * LV2Plugin::toggle_bypass()
 	return  0;
 }
 
-PluginInfo LV2Plugin::get_plugin_info(const LilvPlugin* plugin)
+PluginInfo LV2Plugin::get_plugin_info(LilvWorld* world, const LilvPlugin* plugin)
 {
 	PluginInfo info;
 	info.name = lilv_node_as_string(lilv_plugin_get_name(plugin));
 	info.uri = lilv_node_as_string(lilv_plugin_get_uri(plugin));
 	
 	
-	LilvWorld* world = PluginManager::instance()->get_lilv_world();
 	LilvNode* input = lilv_new_uri(world, LILV_URI_INPUT_PORT);
 	LilvNode* output = lilv_new_uri(world, LILV_URI_OUTPUT_PORT);
 	LilvNode* audio = lilv_new_uri(world, LILV_URI_AUDIO_PORT);
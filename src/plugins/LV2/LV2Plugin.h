@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QObject>
 
 #include "Plugin.h"
+#include "LV2Worker.h"
 
 class AudioBus;
 class LV2ControlPort;
@@ -47,6 +48,7 @@ public:
 	~LV2Plugin();
 
 	void process(AudioBus* bus, unsigned long nframes);
+	nframes_t get_latency();
 
 	LilvInstance*  get_instance() const {return m_instance; }
 	const LilvPlugin* get_slv2_plugin() const {return m_plugin; }
@@ -58,7 +60,7 @@ public:
 	int init();
 	int set_state(const QDomNode & node );
 	
-	static PluginInfo get_plugin_info(const LilvPlugin* plugin);
+	static PluginInfo get_plugin_info(LilvWorld* world, const LilvPlugin* plugin);
 
 private:
 	QString		m_pluginUri;
@@ -73,10 +75,18 @@ private:
 	LilvNode*      m_event_class;   /**< Event port class (URI) */
 	LilvNode*      optional;        /**< lv2:connectionOptional port property */
 	bool 		m_isSlave;
+	int		m_latencyPortIndex;
+	LV2Worker*	m_worker;
+	LV2_Worker_Schedule	m_workerSchedule;
+	LV2_Feature	m_uridMapFeature;
+	LV2_Feature	m_uridUnmapFeature;
+	LV2_Feature	m_workerFeature;
+	const LV2_Feature*	m_features[4];
 	
 	LV2ControlPort* create_port(int portIndex, float defaultValue);
 
 	int create_instance();
+	static LV2_Worker_Status schedule_work(LV2_Worker_Schedule_Handle handle, uint32_t size, const void* data);
 
 public slots:
 	TCommand* toggle_bypass();
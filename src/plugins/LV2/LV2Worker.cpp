@@ -0,0 +1,197 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "LV2Worker.h"
+
+#include "Utils.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+// room for the requests (or responses) of a few cycles, each message
+// is stored as its size followed by the data
+#define WORKER_BUFFER_SIZE	8192
+
+
+LV2Worker::LV2Worker()
+{
+	m_iface = 0;
+	m_handle = 0;
+	m_stop = false;
+	m_pendingRequestSize = 0;
+	m_pendingResponseSize = 0;
+	m_requests = new RingBufferNPT<char>(WORKER_BUFFER_SIZE);
+	m_responses = new RingBufferNPT<char>(WORKER_BUFFER_SIZE);
+	m_requestData = new char[WORKER_BUFFER_SIZE];
+	m_responseData = new char[WORKER_BUFFER_SIZE];
+
+	// unnamed semaphores aren't supported everywhere (OS X), the
+	// worker thread polls for requests in that case
+	m_semaphoreValid = (sem_init(&m_semaphore, 0, 0) == 0);
+}
+
+LV2Worker::~LV2Worker()
+{
+	m_stop = true;
+	if (m_semaphoreValid) {
+		sem_post(&m_semaphore);
+	}
+	wait();
+
+	if (m_semaphoreValid) {
+		sem_destroy(&m_semaphore);
+	}
+
+	delete m_requests;
+	delete m_responses;
+	delete [] m_requestData;
+	delete [] m_responseData;
+}
+
+/**
+ * Sets the worker interface of the plugin instance, and starts the worker
+ * thread. Call before the plugin instance is activated.
+ */
+void LV2Worker::set_interface(const LV2_Worker_Interface* iface, LV2_Handle handle)
+{
+	m_iface = iface;
+	m_handle = handle;
+
+	start();
+}
+
+bool LV2Worker::write_message(RingBufferNPT<char>* ringbuffer, uint32_t size, const void* data)
+{
+	if (ringbuffer->write_space() < sizeof(size) + size) {
+		return false;
+	}
+
+	ringbuffer->write((char*)&size, sizeof(size));
+	ringbuffer->write((char*)data, size);
+
+	return true;
+}
+
+/**
+ * Reads one message into \a data. The writer stores the size and the data
+ * with 2 writes, so if only the size made it, it's kept in \a pendingSize
+ * until the data follows.
+ * @return true if a complete message was read
+ */
+bool LV2Worker::read_message(RingBufferNPT<char>* ringbuffer, uint32_t& pendingSize, char* data)
+{
+	if (!pendingSize) {
+		if (ringbuffer->read_space() < sizeof(pendingSize)) {
+			return false;
+		}
+		ringbuffer->read((char*)&pendingSize, sizeof(pendingSize));
+	}
+
+	if (ringbuffer->read_space() < pendingSize) {
+		return false;
+	}
+
+	ringbuffer->read(data, pendingSize);
+
+	return true;
+}
+
+/**
+ * Called by the plugin from its run() function in the audio thread
+ */
+LV2_Worker_Status LV2Worker::schedule(uint32_t size, const void* data)
+{
+	if (!m_iface || size == 0) {
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	if (!write_message(m_requests, size, data)) {
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
+
+	if (m_semaphoreValid) {
+		sem_post(&m_semaphore);
+	}
+
+	return LV2_WORKER_SUCCESS;
+}
+
+/**
+ * Called by the plugin from its work() function in the worker thread
+ */
+LV2_Worker_Status LV2Worker::respond(uint32_t size, const void* data)
+{
+	if (size == 0) {
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	if (!write_message(m_responses, size, data)) {
+		return LV2_WORKER_ERR_NO_SPACE;
+	}
+
+	return LV2_WORKER_SUCCESS;
+}
+
+LV2_Worker_Status LV2Worker::respond_work(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data)
+{
+	return static_cast<LV2Worker*>(handle)->respond(size, data);
+}
+
+/**
+ * Hands the responses of finished work to the plugin, call from the
+ * audio thread after the plugin's run() function.
+ */
+void LV2Worker::deliver_responses()
+{
+	if (!m_iface) {
+		return;
+	}
+
+	while (read_message(m_responses, m_pendingResponseSize, m_responseData)) {
+		if (m_iface->work_response) {
+			m_iface->work_response(m_handle, m_pendingResponseSize, m_responseData);
+		}
+		m_pendingResponseSize = 0;
+	}
+
+	if (m_iface->end_run) {
+		m_iface->end_run(m_handle);
+	}
+}
+
+void LV2Worker::run()
+{
+	while (!m_stop) {
+		if (m_semaphoreValid) {
+			sem_wait(&m_semaphore);
+		} else {
+			msleep(10);
+		}
+
+		while (!m_stop && read_message(m_requests, m_pendingRequestSize, m_requestData)) {
+			m_iface->work(m_handle, respond_work, this, m_pendingRequestSize, m_requestData);
+			m_pendingRequestSize = 0;
+		}
+	}
+}
+
+//eof
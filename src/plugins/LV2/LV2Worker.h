@@ -0,0 +1,77 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef LV2_WORKER_H
+#define LV2_WORKER_H
+
+#include <QThread>
+#include <semaphore.h>
+#include <lilv/lilv.h>
+#include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+
+#include "RingBufferNPT.h"
+
+/**
+ * Implements the LV2 worker extension for one plugin instance.
+ *
+ * The plugin schedules work from its run() function in the audio thread,
+ * the request is copied into a lock free ring buffer and a (non realtime)
+ * worker thread is woken up to call the plugin's work() function.
+ * The responses go back through a second ring buffer, and are handed to
+ * the plugin by deliver_responses() in the audio thread, right after run().
+ */
+class LV2Worker : public QThread
+{
+public:
+	LV2Worker();
+	~LV2Worker();
+
+	void set_interface(const LV2_Worker_Interface* iface, LV2_Handle handle);
+
+	// audio thread
+	LV2_Worker_Status schedule(uint32_t size, const void* data);
+	void deliver_responses();
+
+protected:
+	void run();
+
+private:
+	const LV2_Worker_Interface*	m_iface;
+	LV2_Handle		m_handle;
+	RingBufferNPT<char>*	m_requests;
+	RingBufferNPT<char>*	m_responses;
+	char*			m_requestData;
+	char*			m_responseData;
+	uint32_t		m_pendingRequestSize;
+	uint32_t		m_pendingResponseSize;
+	sem_t			m_semaphore;
+	bool			m_semaphoreValid;
+	volatile bool		m_stop;
+
+	LV2_Worker_Status respond(uint32_t size, const void* data);
+	static LV2_Worker_Status respond_work(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data);
+	static bool read_message(RingBufferNPT<char>* ringbuffer, uint32_t& pendingSize, char* data);
+	static bool write_message(RingBufferNPT<char>* ringbuffer, uint32_t size, const void* data);
+};
+
+#endif
+
+//eof
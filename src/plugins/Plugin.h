@@ -62,6 +62,8 @@ public:
 	virtual int set_state(const QDomNode & node );
 	virtual void process(AudioBus* bus, unsigned long nframes) = 0;
 	virtual QString get_name() = 0;
+	// The delay in frames this plugin adds to the processed audio
+	virtual nframes_t get_latency() {return 0;}
 	
 	PluginControlPort* get_control_port_by_index(int index) const;
 	QList<PluginControlPort* > get_control_ports() const { return m_controlPorts; }
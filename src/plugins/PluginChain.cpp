@@ -142,3 +142,17 @@ void PluginChain::set_session(TSession * session)
         m_fader->set_session(session);
 }
 
+
+/**
+ * @return The summed latency of all plugins in the chain, in frames
+ */
+nframes_t PluginChain::get_latency() const
+{
+	nframes_t latency = 0;
+
+	foreach(Plugin* plugin, m_pluginList) {
+		latency += plugin->get_latency();
+	}
+
+	return latency;
+}
@@ -53,6 +53,8 @@ public:
         void set_session(TSession* session);
 	
 	QList<Plugin* > get_plugin_list() {return m_pluginList;}
+	bool has_plugins() const {return !m_pluginList.isEmpty();}
+	nframes_t get_latency() const;
 	GainEnvelope* get_fader() const {return m_fader;}
 	
 private:
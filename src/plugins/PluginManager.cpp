@@ -29,6 +29,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Utils.h"
 #include "Information.h"
 
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTime>
+#include <QUrl>
+
 #if defined (LV2_SUPPORT)
 #include <LV2Plugin.h>
 #endif
@@ -40,12 +47,15 @@ PluginManager* PluginManager::m_instance = 0;
 
 PluginManager::PluginManager()
 {
+	m_lv2ScanThread = 0;
 	init();
 }
 
 
 PluginManager::~PluginManager()
 {
+	wait_for_lv2_scan();
+	delete m_lv2ScanThread;
 #if defined (LV2_SUPPORT)
 	lilv_world_free(m_lilvWorld);
 #endif
@@ -66,13 +76,193 @@ void PluginManager::init()
 {
 #if defined (LV2_SUPPORT)
 // LV2 part:
+	// Loading the world parses the Turtle data of all installed bundles,
+	// which can take seconds. The plugin list is served from the cache
+	// of the previous run until the scan thread is done, the lilv world
+	// itself isn't touched by us before that.
+	m_lilvWorld = 0;
+	m_lilvPlugins = 0;
+
+	m_uridMap.handle = this;
+	m_uridMap.map = map_uri;
+	m_uridUnmap.handle = this;
+	m_uridUnmap.unmap = unmap_uri;
+
+	load_lv2_cache();
+	foreach(const LV2CacheEntry& entry, m_lv2Cache) {
+		m_lv2PluginInfos.insert(entry.info.uri, entry.info);
+	}
+
+	m_lv2ScanThread = new LV2ScanThread(this);
+	connect(m_lv2ScanThread, SIGNAL(finished()), this, SLOT(lv2_scan_finished()));
+	m_lv2ScanThread->start(QThread::LowPriority);
+#endif
+}
+
+
+bool PluginManager::is_lv2_scan_running() const
+{
+	return m_lv2ScanThread && m_lv2ScanThread->isRunning();
+}
+
+
+void PluginManager::wait_for_lv2_scan()
+{
+	if (m_lv2ScanThread) {
+		m_lv2ScanThread->wait();
+	}
+}
+
+
+/**
+ * Called from the LV2ScanThread. Loads the lilv world, and only asks lilv
+ * for the info of plugins that aren't in the cache, or whose bundle changed
+ * since, which saves lilv from loading the data files of all other plugins.
+ */
+void PluginManager::scan_lv2_plugins()
+{
+#if defined (LV2_SUPPORT)
+	QTime time;
+	time.start();
+
 	m_lilvWorld = lilv_world_new();
 	lilv_world_load_all(m_lilvWorld);
 	m_lilvPlugins = lilv_world_get_all_plugins(m_lilvWorld);
+
+	QHash<QString, LV2CacheEntry> scanned;
+	int rescanned = 0;
+
+	LILV_FOREACH(plugins, i, m_lilvPlugins) {
+		const LilvPlugin* plugin = lilv_plugins_get(m_lilvPlugins, i);
+		QString uri = lilv_node_as_uri(lilv_plugin_get_uri(plugin));
+		QString bundle = QUrl(lilv_node_as_uri(lilv_plugin_get_bundle_uri(plugin))).toLocalFile();
+		qint64 modified = bundle_modification_time(bundle);
+
+		LV2CacheEntry entry = m_lv2Cache.value(uri);
+
+		if (!m_lv2Cache.contains(uri) || entry.bundle != bundle || entry.modified != modified) {
+			entry.info = LV2Plugin::get_plugin_info(m_lilvWorld, plugin);
+			entry.bundle = bundle;
+			entry.modified = modified;
+			rescanned++;
+		}
+
+		scanned.insert(uri, entry);
+	}
+
+	m_lv2Cache = scanned;
+
+	PMESG("LV2 scan: %d plugins, %d (re)read, took %d ms", m_lv2Cache.size(), rescanned, time.elapsed());
 #endif
 }
 
 
+void PluginManager::lv2_scan_finished()
+{
+	m_lv2PluginInfos.clear();
+	foreach(const LV2CacheEntry& entry, m_lv2Cache) {
+		m_lv2PluginInfos.insert(entry.info.uri, entry.info);
+	}
+
+	save_lv2_cache();
+
+	emit lv2PluginsChanged();
+}
+
+
+QString PluginManager::lv2_cache_file_name()
+{
+	return QDir::homePath() + "/.traverso/lv2plugins.xml";
+}
+
+
+/**
+ * @return The modification time of the newest file in \a bundle, an edited
+ *	Turtle file doesn't change the modification time of the directory.
+ */
+qint64 PluginManager::bundle_modification_time(const QString& bundle)
+{
+	QFileInfo dirInfo(bundle);
+	qint64 modified = dirInfo.lastModified().toTime_t();
+
+	QDir dir(bundle);
+	foreach(const QFileInfo& fileInfo, dir.entryInfoList(QDir::Files)) {
+		modified = qMax(modified, qint64(fileInfo.lastModified().toTime_t()));
+	}
+
+	return modified;
+}
+
+
+void PluginManager::load_lv2_cache()
+{
+	QFile file(lv2_cache_file_name());
+
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+
+	QDomDocument doc("LV2PluginCache");
+	QString errorMsg;
+	if (!doc.setContent(&file, &errorMsg)) {
+		PERROR("Could not parse the LV2 plugin cache (%s)", QS_C(errorMsg));
+		return;
+	}
+
+	QDomNode pluginNode = doc.documentElement().firstChild();
+
+	while(!pluginNode.isNull()) {
+		QDomElement e = pluginNode.toElement();
+		LV2CacheEntry entry;
+
+		entry.info.uri = e.attribute("uri", "");
+		entry.info.name = e.attribute("name", "");
+		entry.info.type = e.attribute("type", "");
+		entry.info.audioPortInCount = e.attribute("audioin", "0").toInt();
+		entry.info.audioPortOutCount = e.attribute("audioout", "0").toInt();
+		entry.bundle = e.attribute("bundle", "");
+		entry.modified = e.attribute("modified", "0").toLongLong();
+
+		if (!entry.info.uri.isEmpty()) {
+			m_lv2Cache.insert(entry.info.uri, entry);
+		}
+
+		pluginNode = pluginNode.nextSibling();
+	}
+}
+
+
+void PluginManager::save_lv2_cache()
+{
+	QDomDocument doc("LV2PluginCache");
+	QDomElement root = doc.createElement("LV2PluginCache");
+	doc.appendChild(root);
+
+	foreach(const LV2CacheEntry& entry, m_lv2Cache) {
+		QDomElement e = doc.createElement("Plugin");
+		e.setAttribute("uri", entry.info.uri);
+		e.setAttribute("name", entry.info.name);
+		e.setAttribute("type", entry.info.type);
+		e.setAttribute("audioin", entry.info.audioPortInCount);
+		e.setAttribute("audioout", entry.info.audioPortOutCount);
+		e.setAttribute("bundle", entry.bundle);
+		e.setAttribute("modified", entry.modified);
+		root.appendChild(e);
+	}
+
+	QDir().mkpath(QFileInfo(lv2_cache_file_name()).path());
+
+	QFile file(lv2_cache_file_name());
+	if (!file.open(QIODevice::WriteOnly)) {
+		PERROR("Could not write the LV2 plugin cache %s", QS_C(lv2_cache_file_name()));
+		return;
+	}
+
+	QTextStream stream(&file);
+	doc.save(stream, 4);
+}
+
+
 Plugin* PluginManager::get_plugin(const  QDomNode node )
 {
 	QDomElement e = node.toElement();
@@ -118,9 +308,50 @@ Plugin* PluginManager::get_plugin(const  QDomNode node )
 
 const LilvPlugins* PluginManager::get_lilv_plugins()
 {
+	wait_for_lv2_scan();
 	return m_lilvPlugins;
 }
 
+LilvWorld* PluginManager::get_lilv_world()
+{
+	wait_for_lv2_scan();
+	return m_lilvWorld;
+}
+
+/**
+ * The urid:map feature, plugins call this when instantiated, or from
+ * their worker, not from the audio thread.
+ */
+LV2_URID PluginManager::map_uri(LV2_URID_Map_Handle handle, const char* uri)
+{
+	PluginManager* manager = static_cast<PluginManager*>(handle);
+	QMutexLocker locker(&manager->m_uridMutex);
+
+	QByteArray key(uri);
+	LV2_URID id = manager->m_uridIds.value(key, 0);
+
+	if (!id) {
+		manager->m_uridUris.append(key);
+		// 0 is reserved, so ids start at 1
+		id = manager->m_uridUris.size();
+		manager->m_uridIds.insert(key, id);
+	}
+
+	return id;
+}
+
+const char* PluginManager::unmap_uri(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+{
+	PluginManager* manager = static_cast<PluginManager*>(handle);
+	QMutexLocker locker(&manager->m_uridMutex);
+
+	if (urid == 0 || int(urid) > manager->m_uridUris.size()) {
+		return 0;
+	}
+
+	return manager->m_uridUris.at(urid - 1).constData();
+}
+
 Plugin* PluginManager::create_lv2_plugin(const QString& uri)
 {
         TSession* session = pm().get_project()->get_current_session();
@@ -136,4 +367,15 @@ Plugin* PluginManager::create_lv2_plugin(const QString& uri)
 }
 #endif
 
+
+LV2ScanThread::LV2ScanThread(PluginManager* manager)
+{
+	m_manager = manager;
+}
+
+void LV2ScanThread::run()
+{
+	m_manager->scan_lv2_plugins();
+}
+
 //eof
@@ -25,14 +25,24 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #if defined (LV2_SUPPORT)
 #include <lilv/lilv.h>
+#include <lv2/lv2plug.in/ns/ext/urid/urid.h>
 #endif
 
+#include <QObject>
+#include <QMutex>
+#include <QByteArray>
+#include <QThread>
 #include <QDomDocument>
+#include <QHash>
+#include <QList>
 
-class Plugin;
+#include "Plugin.h"
 
-class PluginManager
+class LV2ScanThread;
+
+class PluginManager : public QObject
 {
+	Q_OBJECT
 
 public:
 	~PluginManager();
@@ -41,21 +51,76 @@ public:
 
 	Plugin* get_plugin(const QDomNode node);
 
+	QList<PluginInfo> get_lv2_plugin_infos() const {return m_lv2PluginInfos.values();}
+	bool is_lv2_scan_running() const;
+
 #if defined (LV2_SUPPORT)
 	const LilvPlugins* get_lilv_plugins();
-	LilvWorld* get_lilv_world() {return m_lilvWorld;}
+	LilvWorld* get_lilv_world();
 	Plugin* create_lv2_plugin(const QString& uri);
+	LV2_URID_Map* get_urid_map() {return &m_uridMap;}
+	LV2_URID_Unmap* get_urid_unmap() {return &m_uridUnmap;}
 #endif
 
 private:
 	PluginManager();
 
+	// what we know of a plugin without asking lilv
+	struct LV2CacheEntry {
+		PluginInfo	info;
+		QString		bundle;
+		qint64		modified;
+	};
+
 	static PluginManager* m_instance;
 #if defined (LV2_SUPPORT)
 	LilvWorld* 	m_lilvWorld;
 	const LilvPlugins*	m_lilvPlugins;
+	LV2_URID_Map		m_uridMap;
+	LV2_URID_Unmap		m_uridUnmap;
+	QHash<QByteArray, LV2_URID>	m_uridIds;
+	QList<QByteArray>	m_uridUris;
+	QMutex			m_uridMutex;
+
+	static LV2_URID map_uri(LV2_URID_Map_Handle handle, const char* uri);
+	static const char* unmap_uri(LV2_URID_Unmap_Handle handle, LV2_URID urid);
 #endif
+	LV2ScanThread*	m_lv2ScanThread;
+	QHash<QString, LV2CacheEntry>	m_lv2Cache;
+	QHash<QString, PluginInfo>	m_lv2PluginInfos;
+
 	void init();
+	void wait_for_lv2_scan();
+	void scan_lv2_plugins();
+	void load_lv2_cache();
+	void save_lv2_cache();
+	static QString lv2_cache_file_name();
+	static qint64 bundle_modification_time(const QString& bundle);
+
+	friend class LV2ScanThread;
+
+private slots:
+	void lv2_scan_finished();
+
+signals:
+	void lv2PluginsChanged();
+};
+
+
+/**
+ * Loads the LV2 world and (re)reads the info of new and changed plugin
+ * bundles, so the GUI thread doesn't have to wait for it.
+ */
+class LV2ScanThread : public QThread
+{
+public:
+	LV2ScanThread(PluginManager* manager);
+
+protected:
+	void run();
+
+private:
+	PluginManager* m_manager;
 };
 
 #endif
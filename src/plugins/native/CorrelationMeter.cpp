@@ -24,6 +24,7 @@ $Id: CorrelationMeter.cpp,v 1.6 2008/02/10 23:47:06 n_doebelin Exp $
 #include "CorrelationMeter.h"
 #include <AudioBus.h>
 #include <AudioDevice.h>
+#include <Mixer.h>
 #include <Debugger.h>
 #include <math.h>
 #include <limits.h>
@@ -104,21 +105,12 @@ void CorrelationMeter::process(AudioBus* bus, unsigned long nframes)
 	audio_sample_t* bufferRight = bus->get_buffer(1, nframes);
 
 
-        // Variables we need to calculate the correlation and averages/levels
-	float a1, a2, a1a2 = 0, a1sq = 0, a2sq = 0, r, levelLeft = 0, levelRight = 0;
+        // Sums we need to calculate the correlation and averages/levels
+	float a1a2, a1sq, a2sq, r, levelLeft, levelRight;
 	
-	// calculate coefficient
-	for (uint i = 0; i < nframes; ++i) {
-		a1 = bufferLeft[i];
-		a2 = bufferRight[i];
-
-		a1a2 += a1 * a2;
-		a1sq += a1 * a1;
-		a2sq += a2 * a2;
-
-		levelLeft += a1sq;
-		levelRight += a2sq;
-	}
+	// calculate the sums of the products and squares with the
+	// (vectorized) Mixer routine selected at startup
+	Mixer::compute_stereo_correlation(bufferLeft, bufferRight, nframes, &a1a2, &a1sq, &a2sq);
 
 	// We have all data to calculate the correlation coefficient
 	// for the processed buffer (but check for division by 0 first)
@@ -128,9 +120,9 @@ void CorrelationMeter::process(AudioBus* bus, unsigned long nframes)
 		r = a1a2 / (sqrtf(a1sq) * sqrtf(a2sq));
 	}
 
-	// calculate RMS of the levels
-	levelLeft = sqrtf(levelLeft / nframes);
-	levelRight = sqrtf(levelRight / nframes);
+	// calculate RMS of the levels, the sums of squares are all we need
+	levelLeft = sqrtf(a1sq / nframes);
+	levelRight = sqrtf(a2sq / nframes);
 
 	// And we store this in a CorrelationMeterData struct
 	// and write this struct into the data ringbuffer,
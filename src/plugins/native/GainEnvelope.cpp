@@ -24,9 +24,24 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Curve.h"
 #include "Mixer.h"
 #include "AudioBus.h"
+#include "TScratchArena.h"
+
+static inline float pan_factor(float pan, uint channel)
+{
+        if (channel == 0 && pan > 0) {
+                return 1 - pan;
+        }
+        if (channel == 1 && pan < 0) {
+                return 1 + pan;
+        }
+        return 1.0f;
+}
 
 GainEnvelope::GainEnvelope(TSession* session)
         : Plugin(session)
+        , m_gain(1.0f)
+        , m_appliedGain(-1.0f)
+        , m_appliedPan(0.0f)
 {
 	PluginControlPort* port = new PluginControlPort(this, 0, 1.0);
 	port->set_index(0);
@@ -117,3 +132,50 @@ void GainEnvelope::process_gain(audio_sample_t** buffer, const TimeRef& startloc
         }
 }
 
+// Applies pan law and fader gain in one pass per channel. Without automation the
+// gain ramps linearly over the block from the value applied in the previous cycle
+// so fader and pan changes don't cause zipper noise.
+void GainEnvelope::process_gain_and_pan(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, float pan)
+{
+        PluginControlPort* port = m_controlPorts.at(0);
+        float gain = m_gain;
+
+        if (port->use_automation()) {
+                TScratchArena::Scope scratch;
+                float* channelgains = scratch.allocate<float>(channels);
+                if (channelgains) {
+                        for (uint chan=0; chan<channels; ++chan) {
+                                channelgains[chan] = pan_factor(pan, chan);
+                        }
+                        port->get_curve()->process(buffer, startlocation, endlocation, nframes, channels, gain, channelgains);
+                } else {
+                        // never skip the pan, apply it after the automation
+                        port->get_curve()->process(buffer, startlocation, endlocation, nframes, channels, gain);
+                        for (uint chan=0; chan<channels; ++chan) {
+                                if (pan_factor(pan, chan) != 1.0f) {
+                                        Mixer::apply_gain_to_buffer(buffer[chan], nframes, pan_factor(pan, chan));
+                                }
+                        }
+                }
+        } else {
+                bool ramp = (m_appliedGain >= 0.0f) && (m_appliedGain != gain || m_appliedPan != pan);
+
+                for (uint chan=0; chan<channels; ++chan) {
+                        float channelgain = gain * pan_factor(pan, chan);
+                        if (ramp) {
+                                float previous = m_appliedGain * pan_factor(m_appliedPan, chan);
+                                if (previous != channelgain) {
+                                        Mixer::apply_gain_ramp_to_buffer(buffer[chan], nframes, previous, channelgain);
+                                        continue;
+                                }
+                        }
+                        if (channelgain != 1.0f) {
+                                Mixer::apply_gain_to_buffer(buffer[chan], nframes, channelgain);
+                        }
+                }
+        }
+
+        m_appliedGain = gain;
+        m_appliedPan = pan;
+}
+
@@ -40,6 +40,7 @@ public:
 	int set_state(const QDomNode & node );
 	void process(AudioBus* bus, unsigned long nframes);
 	void process_gain(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels);
+	void process_gain_and_pan(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, float pan);
 	
         void set_session(TSession* session);
 	void set_gain(float gain) {m_gain = gain;}
@@ -50,6 +51,10 @@ public:
 	
 private:
 	float m_gain;
+	// fader gain and pan applied in the previous process cycle, the start
+	// point of the next gain ramp, m_appliedGain < 0 means nothing applied yet
+	float m_appliedGain;
+	float m_appliedPan;
 };
 
 #endif
@@ -24,8 +24,13 @@ $Id: SpectralMeter.cpp,v 1.9 2008/02/15 15:58:57 n_doebelin Exp $
 #include "SpectralMeter.h"
 #include <AudioBus.h>
 #include <QVector>
+#include <QMutexLocker>
 #include <math.h>
 
+#if defined (USE_XMMINTRIN)
+#include <xmmintrin.h>
+#endif
+
 #include <Debugger.h>
 
 // Always put me below _all_ includes, this is needed
@@ -35,23 +40,104 @@ $Id: SpectralMeter.cpp,v 1.9 2008/02/15 15:58:57 n_doebelin Exp $
 #define PI 3.141592653589
 #define BUFFER_READOUT_TOLERANCE 2 // recommended: 1-10
 
+
+// power spectrum (re² + im²) of count complex values
+static void compute_power_spectrum(const fftwf_complex* spec, float* power, int count)
+{
+	int i = 0;
+#if defined (USE_XMMINTRIN)
+	const float* in = (const float*) spec;
+	for (; i + 4 <= count; i += 4) {
+		__m128 a = _mm_loadu_ps(in + 2*i);	// re0 im0 re1 im1
+		__m128 b = _mm_loadu_ps(in + 2*i + 4);	// re2 im2 re3 im3
+		a = _mm_mul_ps(a, a);
+		b = _mm_mul_ps(b, b);
+		__m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(power + i, _mm_add_ps(re, im));
+	}
+#endif
+	for (; i < count; ++i) {
+		power[i] = spec[i][0] * spec[i][0] + spec[i][1] * spec[i][1];
+	}
+}
+
+
+/**
+ * \class SpectralMeterWorker
+ * \brief Runs the FFT of the SpectralMeter outside the GUI thread.
+ *
+ * The GUI requests a new spectrum on each meter tick, the worker computes
+ * it from the data the audio thread collected and publishes the result
+ * in the SpectralMeter's TripleBuffer, to be picked up on the next tick.
+ */
+
+SpectralMeterWorker::SpectralMeterWorker(SpectralMeter* meter)
+	: QThread(meter)
+	, m_meter(meter)
+	, m_requested(false)
+	, m_stop(false)
+{
+}
+
+void SpectralMeterWorker::request_spectrum()
+{
+	QMutexLocker locker(&m_mutex);
+	m_requested = true;
+	m_wait.wakeOne();
+}
+
+void SpectralMeterWorker::stop()
+{
+	QMutexLocker locker(&m_mutex);
+	m_stop = true;
+	m_wait.wakeOne();
+}
+
+void SpectralMeterWorker::run()
+{
+	while (true) {
+		m_mutex.lock();
+		while (!m_requested && !m_stop) {
+			m_wait.wait(&m_mutex);
+		}
+		if (m_stop) {
+			m_mutex.unlock();
+			return;
+		}
+		m_requested = false;
+		m_mutex.unlock();
+
+		m_meter->compute_spectrum();
+	}
+}
+
+
 SpectralMeter::SpectralMeter()
 	: Plugin()
 {
 	m_frlen = 2048;
 	m_windowingFunction = 1;
 	m_bufferreadouts = 0;
+	fftsigl = fftsigr = win = 0;
+	fftspecl = fftspecr = 0;
 
 	(int) init();
 
 	// constructs a ringbuffer that can hold 16384 samples
 	m_databufferL = new RingBufferNPT<float>(16384);
 	m_databufferR = new RingBufferNPT<float>(16384);
+
+	m_worker = new SpectralMeterWorker(this);
 }
 
 
 SpectralMeter::~SpectralMeter()
 {
+	m_worker->stop();
+	m_worker->wait();
+
+	free_fft_data();
 	delete m_databufferL;
 	delete m_databufferR;
 }
@@ -75,16 +161,38 @@ int SpectralMeter::set_state(const QDomNode & node )
 }
 
 
+void SpectralMeter::free_fft_data()
+{
+	if (!fftsigl) {
+		return;
+	}
+
+	fftwf_destroy_plan(pfegl);
+	fftwf_destroy_plan(pfegr);
+	fftwf_free(fftsigl);
+	fftwf_free(fftsigr);
+	fftwf_free(fftspecl);
+	fftwf_free(fftspecr);
+	fftwf_free(win);
+	fftsigl = 0;
+}
+
+
 int SpectralMeter::init()
 {
-	fftsigl  = NDArray(m_frlen);		// array of input values (windowed samples)
-	fftsigr  = NDArray(m_frlen);		// array of input values (windowed samples)
+	// the worker thread may be running an fft right now
+	QMutexLocker locker(&m_fftMutex);
+
+	free_fft_data();
+
+	fftsigl  = NFArray(m_frlen);		// array of input values (windowed samples)
+	fftsigr  = NFArray(m_frlen);		// array of input values (windowed samples)
 	fftspecl = NFFTWArray(m_frlen/2 + 1);	// array of output values (complex numbers)
 	fftspecr = NFFTWArray(m_frlen/2 + 1);	// array of output values (complex numbers)
-	pfegl = fftw_plan_dft_r2c_1d(m_frlen, fftsigl, fftspecl, FFTW_ESTIMATE);
-	pfegr = fftw_plan_dft_r2c_1d(m_frlen, fftsigr, fftspecr, FFTW_ESTIMATE);
+	pfegl = fftwf_plan_dft_r2c_1d(m_frlen, fftsigl, fftspecl, FFTW_ESTIMATE);
+	pfegr = fftwf_plan_dft_r2c_1d(m_frlen, fftsigr, fftspecr, FFTW_ESTIMATE);
 
-	win = NDArray(m_frlen);
+	win = NFArray(m_frlen);
 	switch (m_windowingFunction)
 	{
 		case 0: // rectangle
@@ -160,11 +268,18 @@ QString SpectralMeter::get_name( )
         return QString(tr("Spectral Meter"));
 }
 
-// writes the fft output into two qvector<float> (left and right channel).
-int SpectralMeter::get_data(QVector<float> &specl, QVector<float> &specr)
+// Runs in the SpectralMeterWorker thread. Computes the power spectrum
+// of the next FFT window and publishes it for get_data().
+void SpectralMeter::compute_spectrum()
 {
+	QMutexLocker locker(&m_fftMutex);
+
 	int readcount = m_databufferL->read_space();
-	
+	int bins = m_frlen/2;
+	SpectralMeterSpectrum& spectrum = m_spectra.write_buffer();
+	spectrum.left.resize(bins);
+	spectrum.right.resize(bins);
+
 	// If there is not enough new data for an FFT window in the ringbuffer,
 	// decide if the cycle should be ignored or if the fft spectrum should
 	// be filled with 0. Ignore it as long as the number of readouts is 
@@ -177,73 +292,81 @@ int SpectralMeter::get_data(QVector<float> &specl, QVector<float> &specr)
 
 		if (m_bufferreadouts >= BUFFER_READOUT_TOLERANCE) {
 			// return spectra filled with 0	
-			specl.clear();
-			specr.clear();
-			for (int i = 1; i < m_frlen/2 + 1; ++i) {
-				specl.push_back(0.0);
-				specr.push_back(0.0);
-			}
-			return -1; // return -1 to inform the receiver about silence
-		} else {
-			return 0;
+			spectrum.left.fill(0.0f);
+			spectrum.right.fill(0.0f);
+			spectrum.status = -1; // inform the receiver about silence
+			m_spectra.publish();
 		}
+		return;
 	} else {
 		m_bufferreadouts = 0;
 	}
 
-	specl.clear();
-	specr.clear();
-
-	// Create an empty SpectralMeterData struct data,
-	float left = 0.0;
-	float right = 0.0;
-
-	// read samples (in chunks of buffer_size) from the ringbuffer until the FFT window is filled
-	m_databufferL->read(&left, 1);
-	m_databufferR->read(&right, 1);
+	// read the FFT window from the ringbuffer and apply the windowing function
+	m_databufferL->read(fftsigl, m_frlen);
+	m_databufferR->read(fftsigr, m_frlen);
 
 	for (int i = 0; i < m_frlen; ++i) {
-		m_databufferL->read(&left, 1);
-		m_databufferR->read(&right, 1);
-		fftsigl[i] = (double)left * win[i];
-		fftsigr[i] = (double)right * win[i];
+		fftsigl[i] *= win[i];
+		fftsigr[i] *= win[i];
 	}
 
 	// do the FFT calculations for the left and right channel
-	fftw_execute(pfegl);
-	fftw_execute(pfegr);
+	fftwf_execute(pfegl);
+	fftwf_execute(pfegr);
+
+	// skip the DC bin, like before
+	float* specl = spectrum.left.data();
+	float* specr = spectrum.right.data();
+	compute_power_spectrum(fftspecl + 1, specl, bins);
+	compute_power_spectrum(fftspecr + 1, specr, bins);
 
-	float tmp;
 	bool isNullL = true,
 	     isNullR = true;
 
-	// send the fft spectrum to the caller
-	for (int i = 1; i < m_frlen/2 + 1; ++i) {
-		tmp = pow((float)fftspecl[i][0],2.0f) + pow((float)fftspecl[i][1],2.0f);
-		specl.push_back(tmp);
-		if (tmp != 0.0) {
+	for (int i = 0; i < bins; ++i) {
+		if (specl[i] != 0.0f) {
 			isNullL = false;
+			break;
 		}
-		tmp = pow((float)fftspecr[i][0],2.0f) + pow((float)fftspecr[i][1],2.0f);
-		specr.push_back(tmp);
-		if (tmp != 0.0) {
+	}
+	for (int i = 0; i < bins; ++i) {
+		if (specr[i] != 0.0f) {
 			isNullR = false;
+			break;
 		}
 	}
 
-	if (isNullL && isNullR) {
-		return 1;
+	// if one of the spectra only contains 0.0, we switch to mono by copying the other one
+	if (isNullL && !isNullR) {
+		spectrum.left = spectrum.right;
+	}
+	if (isNullR && !isNullL) {
+		spectrum.right = spectrum.left;
 	}
 
+	spectrum.status = 1;
+	m_spectra.publish();
+}
 
-	// if one of the spectra only contains 0.0, we switch to mono by copying the other one
-	if (isNullL) {
-		specl = specr;
+// writes the fft output into two qvector<float> (left and right channel).
+// The FFT itself runs in the worker thread, this only picks up the last
+// published spectrum and asks the worker to prepare the next one.
+int SpectralMeter::get_data(QVector<float> &specl, QVector<float> &specr)
+{
+	if (!m_worker->isRunning()) {
+		m_worker->start(QThread::LowPriority);
 	}
-	if (isNullR) {
-		specr = specl;
+	m_worker->request_spectrum();
+
+	if (!m_spectra.update()) {
+		return 0;
 	}
 
-	return 1;
+	const SpectralMeterSpectrum& spectrum = m_spectra.read_buffer();
+	specl = spectrum.left;
+	specr = spectrum.right;
+
+	return spectrum.status;
 }
 
@@ -28,9 +28,14 @@ $Id: SpectralMeter.h,v 1.5 2008/02/07 12:52:57 n_doebelin Exp $
 #include "defines.h"
 #include <fftw3.h>
 #include <RingBufferNPT.h>
+#include <TripleBuffer.h>
 #include <QVector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 
 class AudioBus;
+class SpectralMeter;
 
 struct SpectralMeterData
 {
@@ -38,6 +43,34 @@ struct SpectralMeterData
 	audio_sample_t*	bufferRight;
 };
 
+struct SpectralMeterSpectrum
+{
+	SpectralMeterSpectrum() : status(0) {}
+
+	QVector<float>	left;
+	QVector<float>	right;
+	int		status;
+};
+
+class SpectralMeterWorker : public QThread
+{
+public:
+	SpectralMeterWorker(SpectralMeter* meter);
+
+	void request_spectrum();
+	void stop();
+
+protected:
+	void run();
+
+private:
+	SpectralMeter*	m_meter;
+	QMutex		m_mutex;
+	QWaitCondition	m_wait;
+	bool		m_requested;
+	bool		m_stop;
+};
+
 class SpectralMeter : public Plugin
 {
 	Q_OBJECT
@@ -64,31 +97,31 @@ private:
 	int	m_windowingFunction;
 	int	m_bufferreadouts;
 
-	// FFTW globals
-	fftw_plan pfegl, pfegr;
-	fftw_complex *fftspecl,*fftspecr;
-	double *fftsigl,*fftsigr,*win;
+	// FFTW globals, only touched by the worker thread and init()
+	QMutex	m_fftMutex;
+	fftwf_plan pfegl, pfegr;
+	fftwf_complex *fftspecl,*fftspecr;
+	float *fftsigl,*fftsigr,*win;
 	RingBufferNPT<float>*	m_databufferL;
 	RingBufferNPT<float>*	m_databufferR;
 
+	SpectralMeterWorker*			m_worker;
+	TripleBuffer<SpectralMeterSpectrum>	m_spectra;
+
+	void free_fft_data();
+	void compute_spectrum();
+
+	friend class SpectralMeterWorker;
+
 	float   *NFArray(int size){
 		float *p;
-		p = (float *)calloc(size,sizeof(*p));
-		return p;
-	}
-	double  *NDArray(int size){
-		double *p;
-		p = (double *)calloc(size,sizeof(*p));
-		return p;
-	}
-	int     *NIArray(int size){
-		int *p;
-		p = (int *)calloc(size,sizeof(*p));
+		p = (float *)fftwf_malloc(size*sizeof(*p));
+		memset(p, 0, size*sizeof(*p));
 		return p;
 	}
-	fftw_complex  *NFFTWArray(int size){
-		fftw_complex *p;
-		p = (fftw_complex *)fftw_malloc(size*sizeof(*p));
+	fftwf_complex  *NFFTWArray(int size){
+		fftwf_complex *p;
+		p = (fftwf_complex *)fftwf_malloc(size*sizeof(*p));
 		return p;
 	}
 };
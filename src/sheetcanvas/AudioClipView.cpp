@@ -29,6 +29,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TTrackLaneView.h"
 #include "FadeCurveView.h"
 #include "CurveView.h"
+#include "TWaveformTileCache.h"
+#include "TWaveformRenderer.h"
 
 #include "AudioClip.h"
 #include "ReadSource.h"
@@ -46,6 +48,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TMainWindow.h"
 #include "PluginChain.h"
 #include "Mixer.h"
+#include "AudioTrack.h"
 
 #include <QFileDialog>
 #include <QLinearGradient>
@@ -70,6 +73,9 @@ AudioClipView::AudioClipView(SheetView* sv, AudioTrackView* parent, AudioClip* c
 
         m_sv = sv;
         m_sheet = m_clip->get_sheet();
+        m_waveformRevision = TWaveformTileCache::new_revision();
+        m_height = 0;
+        m_classicView = false;
 
         load_theme_data();
 
@@ -90,6 +96,19 @@ AudioClipView::AudioClipView(SheetView* sv, AudioTrackView* parent, AudioClip* c
         m_gainCurveView->set_start_offset(m_clip->get_source_start_location());
         connect(m_gainCurveView, SIGNAL(curveModified()), m_sv, SLOT(stop_follow_play_head()));
 
+        // anything that changes the waveform shape renders the cached tiles obsolete
+        QList<Curve*> curves;
+        curves << m_clip->get_plugin_chain()->get_fader()->get_curve();
+        curves << m_tv->get_track()->get_plugin_chain()->get_fader()->get_curve();
+        foreach(Curve* curve, curves) {
+                connect(curve, SIGNAL(stateChanged()), this, SLOT(invalidate_waveform()));
+                connect(curve, SIGNAL(nodeAdded(CurveNode*)), this, SLOT(invalidate_waveform()));
+                connect(curve, SIGNAL(nodeRemoved(CurveNode*)), this, SLOT(invalidate_waveform()));
+                connect(curve, SIGNAL(nodePositionChanged()), this, SLOT(invalidate_waveform()));
+        }
+        connect(m_tv->get_track(), SIGNAL(stateChanged()), this, SLOT(invalidate_waveform()));
+        connect(TWaveformRenderer::instance(), SIGNAL(tileRendered(qint64,int)), this, SLOT(waveform_tile_rendered(qint64,int)));
+
         connect(m_clip, SIGNAL(muteChanged()), this, SLOT(repaint()));
         connect(m_clip, SIGNAL(stateChanged()), this, SLOT(clip_state_changed()));
         connect(m_clip, SIGNAL(activeContextChanged()), this, SLOT(active_context_changed()));
@@ -113,6 +132,10 @@ AudioClipView::~ AudioClipView()
 
 void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+	static ThemeElement invalidreadsourceColor("AudioClip:invalidreadsource");
+	static ThemeElement contourColor("AudioClip:contour");
+	static ThemeElement titleFont("AudioClip:fontscale:title");
+
         PENTER2;
         Q_UNUSED(widget);
 
@@ -132,12 +155,12 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
 	QRectF fillRect = QRectF(xstart, 0.0f, pixelcount, float(m_height));
 
         if (m_clip->is_readsource_invalid()) {
-		painter->fillRect(fillRect, themer()->get_color("AudioClip:invalidreadsource"));
+		painter->fillRect(fillRect, invalidreadsourceColor.color());
                 draw_clipinfo_area(painter, xstart, pixelcount);
-		painter->setPen(themer()->get_color("AudioClip:contour"));
+		painter->setPen(contourColor.color());
 		painter->drawRect(xstart, 0, pixelcount, m_height - 1);
                 painter->setPen(Qt::black);
-                painter->setFont( themer()->get_font("AudioClip:fontscale:title") );
+                painter->setFont( titleFont.font() );
                 painter->drawText(30, 0, 300, m_height, Qt::AlignVCenter, tr("Click to reset AudioFile !"));
                 painter->restore();
                 return;
@@ -183,7 +206,7 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
                         // Progress info, I think so....
                         painter->setPen(Qt::black);
                         QRect r(10, 0, 150, m_height);
-                        painter->setFont( themer()->get_font("AudioClip:fontscale:title") );
+                        painter->setFont( titleFont.font() );
                         QString si;
                         si.setNum((int)m_progress);
                         if (m_progress == 100) m_progress = 0;
@@ -192,7 +215,7 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
 
                 } else if (m_clip->recording_state() == AudioClip::NO_RECORDING) {
 //                        PROFILE_START;
-                        draw_peaks(painter, option->exposedRect.x(), pixelcount);
+                        draw_waveform_tiles(painter, xstart, pixelcount, mousehover);
 //                        PROFILE_END("draw peaks");
                 }
         }
@@ -205,7 +228,7 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
         }
 
         // Draw the contour
-        painter->setPen(themer()->get_color("AudioClip:contour"));
+        painter->setPen(contourColor.color());
 	painter->drawRect(m_boundingRect.adjusted(0, 0, -1.5, -1));
 
         // Paint a pixmap if the clip is locked
@@ -217,12 +240,76 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
         painter->restore();
 }
 
-void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
+// Composites the waveform from cached tiles. Missing tiles are requested from
+// the TWaveformRenderer, until they arrive only a placeholder is painted.
+void AudioClipView::draw_waveform_tiles(QPainter* painter, qreal xstart, int pixelcount, bool mousehover)
 {
+        TWaveformTileCache* cache = TWaveformTileCache::instance();
+        TWaveformRenderer* renderer = TWaveformRenderer::instance();
+        TWaveformTileCache::Key key;
+        key.revision = m_waveformRevision;
+        key.scalefactor = m_sv->timeref_scalefactor;
+        key.height = m_height;
+        // the wave brush, pen and channel seperator color depend on these
+        key.style = int(mousehover) | (int(m_clip->is_muted()) << 1) | (int(m_clip->is_selected()) << 2)
+                    | (int(m_sheet->get_mode()) << 3);
+
+        int tilewidth = TWaveformTileCache::TILE_WIDTH;
+        int clipwidth = int(ceil(m_boundingRect.width()));
+        int firsttile = int(xstart) / tilewidth;
+        int lasttile = int(xstart + pixelcount) / tilewidth;
+
+        for (int tile = firsttile; tile <= lasttile; ++tile) {
+                int tilex = tile * tilewidth;
+                int width = qMin(tilewidth, clipwidth - tilex);
+                if (width <= 0) {
+                        break;
+                }
+
+                key.tile = tile;
+                const QImage* cached = cache->find(key);
+                if (cached) {
+                        painter->drawImage(tilex, 0, *cached);
+                        continue;
+                }
+
+                if (!renderer->is_pending(key)) {
+                        TWaveformRenderRequest request;
+                        request.key = key;
+                        if (!fill_render_request(request, tilex, width)) {
+                                return;
+                        }
+                        renderer->request(request);
+                }
+
+                draw_waveform_placeholder(painter, tilex, width);
+        }
+}
+
+// Collects everything the TWaveformRenderer needs to render the tile at tilex.
+// The curve and fade views can only be used from the GUI thread, so their
+// combined gain is calculated here.
+bool AudioClipView::fill_render_request(TWaveformRenderRequest& request, int tilex, int tilewidth)
+{
+	static ThemeElement wavemicroviewColor("AudioClip:wavemicroview");
+	static ThemeElement channelseperatorSelectedColor("AudioClip:channelseperator:selected");
+	static ThemeElement channelseperatorColor("AudioClip:channelseperator");
+	static ThemeElement wavemacroviewOutlineMutedColor("AudioClip:wavemacroview:outline:muted");
+	static ThemeElement wavemacroviewOutlineColor("AudioClip:wavemacroview:outline");
+	static ThemeElement wavemacroviewOutlineCurvemodeColor("AudioClip:wavemacroview:outline:curvemode");
+
 	PENTER4;
 
         Peak* peak = m_clip->get_peak();
 
+        if (!peak) {
+                PERROR("No Peak object available for clip %s", QS_C(m_clip->get_name()));
+                return false;
+        }
+
+        int xstart = tilex;
+        int pixelcount = tilewidth;
+
         // clip away the outline which are painted again vertically
         // in Qt 4.6.x, it doesn't happen in Qt 4.5.x
         // FIXME: find out why?
@@ -231,16 +318,7 @@ void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
                 pixelcount += 2;
         }
 
-        if (!peak) {
-                PERROR("No Peak object available for clip %s", QS_C(m_clip->get_name()));
-                return;
-        }
-
-        bool microView = m_sheet->get_hzoom() < 64 ? 1 : 0;
         TimeRef clipstartoffset = m_clip->get_source_start_location();
-        int channels = m_clip->get_channel_count();
-        int peakdatacount = microView ? pixelcount : pixelcount * 2;
-        float* pixeldata[channels];
         float curveDefaultValue = 1.0;
 	int mixCurveData = 0;
 	int mixAudioClipCurveData = 0;
@@ -256,42 +334,43 @@ void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
 		curveDefaultValue *= trackAutomationView->get_default_value();
         }
 
-        float curvemixdown[peakdatacount];
+        request.curve.resize(pixelcount);
+        float* curvemixdown = request.curve.data();
 
 	if (mixAudioClipCurveData) {
-		mixAudioClipCurveData |= m_gainCurveView->get_vector(xstart + offset, peakdatacount, curvemixdown);
+		mixAudioClipCurveData |= m_gainCurveView->get_vector(xstart + offset, pixelcount, curvemixdown);
 		mixCurveData |= mixAudioClipCurveData;
 	}
 
 	if (mixTrackAutomationData) {
 		if (mixAudioClipCurveData) {
-			float trackmixdown[peakdatacount];
-			int trackCurveMix = trackAutomationView->get_vector(xstart + pos().x(), peakdatacount, trackmixdown);
+			float trackmixdown[pixelcount];
+			int trackCurveMix = trackAutomationView->get_vector(xstart + pos().x(), pixelcount, trackmixdown);
 			if (trackCurveMix) {
-				for (int j=0; j<peakdatacount; ++j) {
+				for (int j=0; j<pixelcount; ++j) {
 					curvemixdown[j] *= trackmixdown[j];
 				}
 				mixCurveData |= trackCurveMix;
 			}
 		} else {
-			mixTrackAutomationData |= trackAutomationView->get_vector(xstart + pos().x(), peakdatacount, curvemixdown);
+			mixTrackAutomationData |= trackAutomationView->get_vector(xstart + pos().x(), pixelcount, curvemixdown);
 			mixCurveData |= mixTrackAutomationData;
 		}
 	}
 
         for (int i = 0; i < m_FadeCurveViews.size(); ++i) {
                 FadeCurveView* view = m_FadeCurveViews.at(i);
-                float fademixdown[peakdatacount];
+                float fademixdown[pixelcount];
                 int fademix = 0;
 
 		if (mixCurveData) {
-			fademix = view->get_vector(xstart, peakdatacount, fademixdown);
+			fademix = view->get_vector(xstart, pixelcount, fademixdown);
                 } else {
-			fademix = view->get_vector(xstart, peakdatacount, curvemixdown);
+			fademix = view->get_vector(xstart, pixelcount, curvemixdown);
                 }
 
 		if (mixCurveData && fademix) {
-                        for (int j=0; j<peakdatacount; ++j) {
+                        for (int j=0; j<pixelcount; ++j) {
                                 curvemixdown[j] *= fademixdown[j];
                         }
                 }
@@ -299,233 +378,73 @@ void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
 		mixCurveData |= fademix;
         }
 
-        // Load peak data, mix curvedata and start painting it
-        // if no peakdata is returned for a certain Peak object, schedule it for loading.
-        for (int chan=0; chan < channels; ++chan) {
-
-                int availpeaks = peak->calculate_peaks(
-                                chan,
-                                &pixeldata[chan],
-                                TimeRef(xstart * m_sv->timeref_scalefactor) + clipstartoffset,
-                                peakdatacount,
-                                m_sheet->get_hzoom());
-
-
-                if (peakdatacount != availpeaks) {
-// 			PWARN("peakdatacount != availpeaks (%d, %d)", peakdatacount, availpeaks);
-                }
-
-                if (availpeaks == Peak::NO_PEAK_FILE) {
-                        connect(peak, SIGNAL(progress(int)), this, SLOT(update_progress_info(int)));
-                        connect(peak, SIGNAL(finished()), this, SLOT (peak_creation_finished()));
-                        m_waitingForPeaks = true;
-                        peak->start_peak_loading();
-                        return;
-                }
-
-                if (availpeaks == Peak::PERMANENT_FAILURE || availpeaks == Peak::NO_PEAKDATA_FOUND) {
-                        return;
-                }
-
-                if (m_mergedView && channels == 2 && chan == 0) continue;
-
-
-// 		pixelcount = std::min(pixelcount, availpeaks);
-
-                // ClassicView uses both positive and negative values,
-                // rectified view: pick the highest value of both
-                // Merged view: calculate highest value for all channels,
-                // and store it in the first channels pixeldata.
-                if (!microView) {
-                        // if Rectified View, calculate max of the minimum and maximum value.
-                        if (!m_classicView) {
-                                for (int i=0, j=0; i < (pixelcount*2); i+=2, ++j) {
-                                        pixeldata[chan][j] = - fabs(f_max(pixeldata[chan][i], - pixeldata[chan][i+1]));
-                                }
-                        }
-
-                        if (m_mergedView && channels == 2) {
-                                for (int i = 0; i < (pixelcount*2); ++i) {
-                                        pixeldata[0][i] = f_max(pixeldata[chan - 1][i], pixeldata[chan][i]);
-                                }
-                        }
-                }
-
-		if (mixCurveData) {
-                        int curvemixdownpos = 0;
-                        if (m_classicView) {
-                                for (int i = 0; i < (pixelcount*2); ++i) {
-                                        pixeldata[chan][i++] *= curvemixdown[curvemixdownpos];
-                                        pixeldata[chan][i] *= curvemixdown[curvemixdownpos];
-                                        curvemixdownpos++;
-                                }
-                        } else {
-                                for (int i = 0; i < pixelcount; i++) {
-                                        pixeldata[chan][i] *= curvemixdown[curvemixdownpos];
-                                        curvemixdownpos++;
-                                }
-                        }
-                }
-
-                p->save();
-
-                // calculate the height of the area available for peak drawing
-                // and if the infoarea is displayed, translate the painter
-                // drawing by dy = m_infoAreaHeight
-		int height = m_height / channels;
-
-
-                float scaleFactor = ( (float) height * 0.90 / 2) * m_clip->get_gain() * curveDefaultValue;
-                float ytrans;
-
-
-                // Draw channel seperator horizontal lines, if needed.
-                if (channels >= 2 && ! m_mergedView && m_classicView && chan >=1 ) {
-                        p->save();
-
-                        if (m_clip->is_selected()) {
-                                p->setPen(themer()->get_color("AudioClip:channelseperator:selected"));
-                        } else {
-                                p->setPen(themer()->get_color("AudioClip:channelseperator"));
-                        }
-
-                        ytrans = height * chan;
-                        p->setMatrix(matrix().translate(xstart, ytrans), true);
-                        p->drawLine(0, 0, pixelcount, 0);
-                        p->restore();
-                }
-
-
-                // Microview, paint waveform as polyline
-                if (microView) {
-
-                        m_polygon.clear();
-                        m_polygon.reserve(pixelcount);
-
-                        int bufferPos = 0;
+        if (!mixCurveData) {
+                request.curve.clear();
+        }
 
-                        if (m_mergedView) {
-                                ytrans = (height / 2) * channels;
-                                scaleFactor *= channels;
-                        } else {
-                                ytrans = (height / 2) + (chan * height);
-                        }
+        request.peak = peak;
+        request.startLocation = TimeRef(xstart * m_sv->timeref_scalefactor) + clipstartoffset;
+        request.framesPerPeak = m_sheet->get_hzoom();
+        request.tileX = tilex;
+        request.tileWidth = tilewidth;
+        request.xstart = xstart;
+        request.pixelcount = pixelcount;
+        request.height = m_height;
+        request.channels = m_clip->get_channel_count();
+        request.microView = m_sheet->get_hzoom() < 64 ? 1 : 0;
+        request.classicView = m_classicView;
+        request.mergedView = m_mergedView;
+        request.fillWave = m_fillwave;
+        request.paintWithOutline = m_paintWithOutline;
+        request.antialiased = m_microViewAntialiased;
+        request.gain = m_clip->get_gain() * curveDefaultValue;
+        request.waveBrush = m_waveBrush;
+        request.minINFLineColor = minINFLineColor;
+        request.microViewColor = wavemicroviewColor.color();
+
+        if (m_clip->is_selected()) {
+                request.seperatorColor = channelseperatorSelectedColor.color();
+        } else {
+                request.seperatorColor = channelseperatorColor.color();
+        }
 
-                        p->setMatrix(matrix().translate(xstart, ytrans), true);
+        if (m_clip->is_muted()) {
+                request.outlineColor = wavemacroviewOutlineMutedColor.color();
+        } else if (m_sheet->get_mode() == Sheet::EDIT) {
+                request.outlineColor = wavemacroviewOutlineColor.color();
+        } else  {
+                request.outlineColor = wavemacroviewOutlineCurvemodeColor.color();
+        }
 
-                        if (m_clip->is_selected()) {
-                                p->setPen(themer()->get_color("AudioClip:channelseperator:selected"));
-                        } else {
-                                p->setPen(themer()->get_color("AudioClip:channelseperator"));
-                        }
+        return true;
+}
 
-                        p->drawLine(0, 0, pixelcount, 0);
+// Cheap stand in for a tile that is still being rendered, the zero line of each channel
+void AudioClipView::draw_waveform_placeholder(QPainter* p, int tilex, int tilewidth)
+{
+        bool microView = m_sheet->get_hzoom() < 64 ? 1 : 0;
+        int channels = m_clip->get_channel_count();
 
-                        for (int x = 0; x < pixelcount; x++) {
-                                m_polygon.append( QPointF(x, -scaleFactor * pixeldata[chan][bufferPos++]) );
-                        }
+        if (m_mergedView) {
+                channels = 1;
+        }
 
-                        if (themer()->get_property("AudioClip:wavemicroview:antialiased", 0).toInt()) {
-                                p->setRenderHints(QPainter::Antialiasing);
-                        }
+        int height = m_height / channels;
 
-                        p->setPen(themer()->get_color("AudioClip:wavemicroview"));
-                        p->drawPolyline(m_polygon);
+        p->save();
+        p->setPen(minINFLineColor);
 
-                // Macroview, paint waveform with painter
+        for (int chan = 0; chan < channels; ++chan) {
+                int y;
+                if (m_classicView || microView) {
+                        y = (height / 2) + (chan * height);
                 } else {
-                        if (m_fillwave) {
-                                p->setBrush(m_waveBrush);
-                        }
-
-                        if (m_paintWithOutline) {
-                                if (m_sheet->get_mode() == Sheet::EDIT) {
-                                        p->setPen(themer()->get_color("AudioClip:wavemacroview:outline"));
-                                } else  {
-                                        p->setPen(themer()->get_color("AudioClip:wavemacroview:outline:curvemode"));
-                                }
-                                if (m_clip->is_muted()) {
-                                        p->setPen(themer()->get_color("AudioClip:wavemacroview:outline:muted"));
-                                }
-                        } else {
-                                p->setPen(Qt::NoPen);
-                        }
-
-                        scaleFactor = ( (float) height * 0.90 / (Peak::MAX_DB_VALUE * 2)) * m_clip->get_gain() * curveDefaultValue;
-
-                        if (m_mergedView) {
-                                if (m_classicView) {
-                                        ytrans = (height / 2) * channels;
-                                        scaleFactor *= channels;
-                                } else {
-                                        ytrans = height * channels;
-                                        scaleFactor *= channels;
-                                }
-                        }
-
-                        int bufferpos = 0;
-
-                        if (m_classicView) {
-
-                                if (m_mergedView) {
-                                        ytrans = (height / 2) * channels;
-                                } else {
-                                        ytrans = (height / 2) + (chan * height);
-                                }
-
-                                p->setMatrix(matrix().translate(xstart, ytrans), true);
-
-                                m_polygon.clear();
-                                m_polygon.reserve(pixelcount*2);
-
-                                for (int x = 0; x < pixelcount; x++) {
-                                        m_polygon.append( QPointF(x, -scaleFactor * pixeldata[chan][bufferpos]) );
-                                        bufferpos+=2;
-                                }
-
-                                bufferpos -= 1;
-
-                                for (int x = pixelcount - 1; x >= 0; x--) {
-                                        m_polygon.append( QPointF(x, scaleFactor * pixeldata[chan][bufferpos]) );
-                                        bufferpos-=2;
-                                }
-
-//                                PROFILE_START;
-                                p->drawPolygon(m_polygon);
-//                                PROFILE_END("draw wave");
-
-                                // Draw 'the' -INF line
-                                p->setPen(minINFLineColor);
-                                p->drawLine(0, 0, pixelcount, 0);
-
-                        } else {
-                                scaleFactor =  (float) height * 0.95 * m_clip->get_gain() / Peak::MAX_DB_VALUE * curveDefaultValue;
-                                ytrans = height + (chan * height);
-
-                                if (m_mergedView) {
-                                        ytrans = height * channels;
-                                        scaleFactor *= channels;
-                                }
-
-                                p->setMatrix(matrix().translate(xstart, ytrans), true);
-
-                                m_polygon.clear();
-                                m_polygon.reserve(pixelcount + 2);
-
-                                for (int x=0; x<pixelcount; x++) {
-                                        m_polygon.append( QPointF(x, scaleFactor * pixeldata[chan][bufferpos++]) );
-                                }
-
-                                m_polygon.append(QPointF(pixelcount, 0));
-                                m_polygon.append(QPointF(0,0));
-
-                                p->drawPolygon(m_polygon);
-
-                        }
+                        y = height + (chan * height) - 1;
                 }
-
-                p->restore();
+                p->drawLine(tilex, y, tilex + tilewidth, y);
         }
+
+        p->restore();
 }
 
 void AudioClipView::draw_clipinfo_area(QPainter* p, int xstart, int pixelcount)
@@ -536,6 +455,9 @@ void AudioClipView::draw_clipinfo_area(QPainter* p, int xstart, int pixelcount)
 
 void AudioClipView::draw_db_lines(QPainter* p, qreal xstart, int pixelcount)
 {
+	static ThemeElement dbGridColor("AudioClip:db-grid");
+	static ThemeElement dblinesFont("AudioClip:fontscale:dblines");
+
         p->save();
 
 	int channels = m_clip->get_channel_count();
@@ -550,8 +472,8 @@ void AudioClipView::draw_db_lines(QPainter* p, qreal xstart, int pixelcount)
         // calculate the height of one channel
 	int height = m_height / channels;
 
-        p->setPen(themer()->get_color("AudioClip:db-grid"));
-        p->setFont( themer()->get_font("AudioClip:fontscale:dblines") );
+        p->setPen(dbGridColor.color());
+        p->setFont( dblinesFont.font() );
 
         if (m_classicView || microView) { // classicView = non-rectified
 
@@ -674,7 +596,7 @@ void AudioClipView::update_progress_info( int progress )
 void AudioClipView::peak_creation_finished()
 {
         m_waitingForPeaks = false;
-        update();
+        invalidate_waveform();
 }
 
 void AudioClipView::add_new_fade_curve_view( FadeCurve * fade )
@@ -683,6 +605,9 @@ void AudioClipView::add_new_fade_curve_view( FadeCurve * fade )
         FadeCurveView* view = new FadeCurveView(m_sv, this, fade);
         m_FadeCurveViews.append(view);
         connect(view, SIGNAL(fadeModified()), m_sv, SLOT(stop_follow_play_head()));
+        connect(fade, SIGNAL(stateChanged()), this, SLOT(invalidate_waveform()));
+        connect(fade, SIGNAL(rangeChanged()), this, SLOT(invalidate_waveform()));
+        invalidate_waveform();
 }
 
 void AudioClipView::remove_fade_curve_view( FadeCurve * fade )
@@ -693,6 +618,8 @@ void AudioClipView::remove_fade_curve_view( FadeCurve * fade )
                         m_FadeCurveViews.takeAt(i);
                         scene()->removeItem(view);
                         delete view;
+                        disconnect(fade, 0, this, 0);
+                        invalidate_waveform();
                         break;
                 }
         }
@@ -703,6 +630,9 @@ void AudioClipView::calculate_bounding_rect()
         PENTER4;
         prepareGeometryChange();
 
+	int oldHeight = m_height;
+	bool oldClassicView = m_classicView;
+
 	m_height = m_parentViewItem->get_height();
 	m_boundingRect = QRectF(0, 0, (double(m_clip->get_length().universal_frame()) / m_sv->timeref_scalefactor), m_height);
 
@@ -716,6 +646,10 @@ void AudioClipView::calculate_bounding_rect()
 		m_classicView = ! config().get_property("Themer", "paintaudiorectified", false).toBool();
 	}
 
+	if (m_height != oldHeight || m_classicView != oldClassicView) {
+		invalidate_waveform();
+	}
+
         update_start_pos();
         ViewItem::calculate_bounding_rect();
 }
@@ -785,6 +719,8 @@ void AudioClipView::position_changed()
         // the CurveView and it's nodes get updated as well, no need to set
         // the start offset for those manually!
         m_gainCurveView->set_start_offset(m_clip->get_source_start_location());
+        // the source start offset and the track automation under the clip may have changed
+        invalidate_waveform();
         calculate_bounding_rect();
 }
 
@@ -796,9 +732,11 @@ void AudioClipView::load_theme_data()
         m_classicView = ! config().get_property("Themer", "paintaudiorectified", false).toBool();
         m_mergedView = config().get_property("Themer", "paintstereoaudioasmono", false).toBool();
         m_fillwave = themer()->get_property("AudioClip:fillwave", 1).toInt();
+        m_microViewAntialiased = themer()->get_property("AudioClip:wavemicroview:antialiased", 0).toInt();
         minINFLineColor = themer()->get_color("AudioClip:channelseperator");
         m_paintWithOutline = config().get_property("Themer", "paintwavewithoutline", true).toBool();
         m_drawDbGrid = config().get_property("Themer", "drawdbgrid", false).toBool();
+        invalidate_waveform();
         calculate_bounding_rect();
 
         QFont dblfont = themer()->get_font("AudioClip:fontscale:dblines");
@@ -855,7 +793,7 @@ void AudioClipView::finish_recording()
         prepareGeometryChange();
         m_boundingRect = QRectF(0, 0, (m_clip->get_length() / m_sv->timeref_scalefactor), m_height);
         m_gainCurveView->calculate_bounding_rect();
-        update();
+        invalidate_waveform();
 }
 
 void AudioClipView::update_recording()
@@ -923,6 +861,31 @@ TCommand * AudioClipView::edit_properties()
 void AudioClipView::clip_state_changed()
 {
         create_clipinfo_string();
+        invalidate_waveform();
+}
+
+void AudioClipView::waveform_tile_rendered(qint64 revision, int status)
+{
+        if (revision != m_waveformRevision) {
+                return;
+        }
+
+        if (status == Peak::NO_PEAK_FILE && !m_waitingForPeaks) {
+                Peak* peak = m_clip->get_peak();
+                connect(peak, SIGNAL(progress(int)), this, SLOT(update_progress_info(int)));
+                connect(peak, SIGNAL(finished()), this, SLOT (peak_creation_finished()));
+                m_waitingForPeaks = true;
+                peak->start_peak_loading();
+        }
+
+        update();
+}
+
+void AudioClipView::invalidate_waveform()
+{
+        // tiles of the old revision are never looked up again and
+        // will be evicted from the cache eventually
+        m_waveformRevision = TWaveformTileCache::new_revision();
         update();
 }
 
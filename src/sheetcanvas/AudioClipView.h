@@ -37,6 +37,7 @@ class SheetView;
 class AudioTrackView;
 class FadeCurveView;
 class Peak;
+struct TWaveformRenderRequest;
 
 
 class AudioClipView : public ViewItem
@@ -64,7 +65,6 @@ private:
 	AudioClip* 	m_clip;
 	Sheet*		m_sheet;
         CurveView* 	m_gainCurveView;
-	QPolygonF 	m_polygon;
 	QPixmap 	m_clipInfo;
 	QTimer 		m_recordingTimer;
 
@@ -82,10 +82,12 @@ private:
 	int m_lineOffset;
 	int m_lineVOffset;
 	TimeRef m_oldRecordingPos;
+	qint64	m_waveformRevision;
 	
 	// theme data
 	int m_drawbackground;
 	int m_fillwave;
+	int m_microViewAntialiased;
 	QColor m_backgroundColorTop;
 	QColor m_backgroundColorBottom;
 	QColor m_backgroundColorMouseHoverTop;
@@ -109,7 +111,9 @@ private:
 
 	void draw_clipinfo_area(QPainter* painter, int xstart, int pixelcount);
 	void draw_db_lines(QPainter* painter, qreal xstart, int pixelcount);
-	void draw_peaks(QPainter* painter, qreal xstart, int pixelcount);
+	void draw_waveform_tiles(QPainter* painter, qreal xstart, int pixelcount, bool mousehover);
+	void draw_waveform_placeholder(QPainter* painter, int tilex, int tilewidth);
+	bool fill_render_request(TWaveformRenderRequest& request, int tilex, int tilewidth);
 	void create_brushes();
 
 	friend class FadeCurveView;
@@ -138,6 +142,8 @@ private slots:
 	void update_recording();
 	void clip_state_changed();
         void active_context_changed();
+        void invalidate_waveform();
+        void waveform_tile_rendered(qint64 revision, int status);
 };
 
 #endif
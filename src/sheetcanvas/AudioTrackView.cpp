@@ -68,6 +68,8 @@ AudioTrackView::AudioTrackView(SheetView* sv, AudioTrack * track)
 
 void AudioTrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement backgroundColor("Track:background");
+
 	Q_UNUSED(widget);
 
         TrackView::paint(painter, option, widget);
@@ -78,7 +80,7 @@ void AudioTrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* op
 	int pixelcount = (int)option->exposedRect.width();
 	
 	if (m_paintBackground) {
-		QColor color = themer()->get_color("Track:background");
+		QColor color = backgroundColor.color();
                 painter->fillRect(xstart, m_topborderwidth, pixelcount+1, m_sv->get_track_height(m_track) - m_bottomborderwidth, color);
 	}
 }
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include "SheetWidget.h"
 #include "SheetView.h"
+#include "Cursors.h"
 #include "AudioTrackView.h"
 #include "ViewItem.h"
 #include <libtraversocore.h>
@@ -47,6 +48,10 @@ ClipsViewPort::ClipsViewPort(QGraphicsScene* scene, SheetWidget* sw)
 {
 	m_sw = sw;
 	viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+	// scrolling blits the viewport content and only repaints the
+	// newly exposed strip, which needs the minimal update mode.
+	setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+	setCacheMode(QGraphicsView::CacheBackground);
 
 	setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 	setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -66,6 +71,16 @@ void ClipsViewPort::paintEvent(QPaintEvent * e)
 	QGraphicsView::paintEvent(e);
 }
 
+void ClipsViewPort::scrollContentsBy(int dx, int dy)
+{
+	ViewPort::scrollContentsBy(dx, dy);
+
+	// the playhead overlay isn't part of the scene, keep it in place.
+	if (m_sv) {
+		m_sv->get_play_cursor()->update_overlay();
+	}
+}
+
 
 void ClipsViewPort::dragEnterEvent( QDragEnterEvent * event )
 {
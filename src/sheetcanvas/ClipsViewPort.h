@@ -43,6 +43,7 @@ public:
 protected:
         void resizeEvent(QResizeEvent* e);
 	void paintEvent( QPaintEvent* e);
+	void scrollContentsBy(int dx, int dy);
 	void dragEnterEvent(QDragEnterEvent *event);
 	void dropEvent(QDropEvent *event);
         void dragMoveEvent(QDragMoveEvent *event);
@@ -28,8 +28,9 @@
 #include <Themer.h>
 
 #include <QPen>
+#include <QPainter>
+#include <QPaintEvent>
 #include <QScrollBar>
-#include <QApplication>
 		
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -37,6 +38,39 @@
 
 #define ANIME_DURATION		1000
 #define AUTO_SCROLL_MARGIN	0.05  // autoscroll when within 5% of the clip view port
+#define MAX_UPDATE_INTERVAL	100   // ms, upper bound for the playhead update timer
+
+
+/**
+ * Paints the PlayHead on top of the ClipsViewPort's viewport.
+ *
+ * The PlayHead itself stays in the scene for positioning, but has no
+ * contents, so moving it doesn't dirty the scene. Only the few pixels
+ * below the old and new overlay position are repainted, and scrolling
+ * the viewport simply moves the overlay along with the blitted content.
+ */
+class PlayHeadOverlay : public QWidget
+{
+public:
+	PlayHeadOverlay(PlayHead* playhead, QWidget* parent)
+		: QWidget(parent)
+		, m_playhead(playhead)
+	{
+		setAttribute(Qt::WA_TransparentForMouseEvents);
+		setAttribute(Qt::WA_NoSystemBackground);
+		hide();
+	}
+
+protected:
+	void paintEvent(QPaintEvent* e)
+	{
+		QPainter painter(this);
+		painter.fillRect(e->rect(), m_playhead->get_brush());
+	}
+
+private:
+	PlayHead*	m_playhead;
+};
 
 
 PlayHead::PlayHead(SheetView* sv, TSession* session, ClipsViewPort* vp)
@@ -45,6 +79,7 @@ PlayHead::PlayHead(SheetView* sv, TSession* session, ClipsViewPort* vp)
 	, m_vp(vp)
 {
 	m_sv = sv;
+	m_overlay = new PlayHeadOverlay(this, m_vp->viewport());
 	check_config();
 	connect(&(config()), SIGNAL(configChanged()), this, SLOT(check_config()));
 	
@@ -63,11 +98,17 @@ PlayHead::PlayHead(SheetView* sv, TSession* session, ClipsViewPort* vp)
         load_theme_data();
 
 	setZValue(99);
+	setFlag(ItemHasNoContents);
+	setFlag(ItemSendsGeometryChanges);
 }
 
 PlayHead::~PlayHead( )
 {
         PENTERDES2;
+	// the viewport owns the overlay, and might already be gone.
+	if (m_overlay) {
+		delete m_overlay;
+	}
 }
 
 void PlayHead::check_config( )
@@ -75,21 +116,69 @@ void PlayHead::check_config( )
 	m_mode = (PlayHeadMode) config().get_property("PlayHead", "Scrollmode", ANIMATED_FLIP_PAGE).toInt();
 	m_follow = config().get_property("PlayHead", "Follow", true).toBool();
 	m_followDisabled = false;
+
+	// There is no portable way to sync to the display refresh, so
+	// never update faster then the (configurable) refresh rate.
+	int refreshRate = qBound(10, config().get_property("PlayHead", "RefreshRate", 60).toInt(), 250);
+	m_refreshInterval = 1000 / refreshRate;
 }
 
 void PlayHead::paint( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget )
 {
+	// We have no contents, the PlayHeadOverlay does the painting.
+	Q_UNUSED(painter);
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
-        QBrush brush;
-	
+}
+
+QBrush PlayHead::get_brush() const
+{
 	if (m_session->is_transport_rolling()) {
-                brush = m_brushActive;
-	} else {
-                brush = m_brushInactive;
+		return m_brushActive;
 	}
-	
-        painter->fillRect(1, 0, (int)m_boundingRect.width() - 2, (int)m_boundingRect.height(), brush);
+
+	return m_brushInactive;
+}
+
+QVariant PlayHead::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+	if (change == ItemPositionHasChanged || change == ItemVisibleHasChanged) {
+		update_overlay();
+	}
+
+	return ViewItem::itemChange(change, value);
+}
+
+void PlayHead::update_overlay()
+{
+	if (!m_overlay) {
+		return;
+	}
+
+	if (!isVisible()) {
+		m_overlay->hide();
+		return;
+	}
+
+	QPoint vppoint = m_vp->mapFromScene(scenePos());
+	QRect geometry(vppoint.x() + 1, 0, qMax(1, (int)m_boundingRect.width() - 2), m_vp->viewport()->height());
+
+	if (m_overlay->geometry() != geometry) {
+		m_overlay->setGeometry(geometry);
+	}
+
+	if (m_overlay->isHidden()) {
+		m_overlay->show();
+	}
+}
+
+int PlayHead::update_interval() const
+{
+	// Updating more often then the playhead moves a pixel is pointless,
+	// taking half that time keeps the movement steady.
+	int pixelInterval = int(m_sv->timeref_scalefactor * 1000 / UNIVERSAL_SAMPLE_RATE) / 2;
+
+	return qBound(m_refreshInterval, pixelInterval, MAX_UPDATE_INTERVAL);
 }
 
 void PlayHead::play_start()
@@ -98,7 +187,7 @@ void PlayHead::play_start()
 
 	m_followDisabled = false;
 
-	m_playTimer.start(20);
+	m_playTimer.start(update_interval());
 	
 	if (m_animation.state() == QTimeLine::Running) {
 		m_animation.stop();
@@ -116,7 +205,9 @@ void PlayHead::play_stop()
 	
 	// just one more update so the playhead can paint itself
 	// in the correct color.
-	update();
+	if (m_overlay) {
+		m_overlay->update();
+	}
 
 }
 
@@ -148,6 +239,11 @@ void PlayHead::update_position()
 	}
 	newPos.setX(newXPos);
 	
+	// follow zoom changes while rolling
+	int interval = update_interval();
+	if (m_playTimer.isActive() && m_playTimer.interval() != interval) {
+		m_playTimer.setInterval(interval);
+	}
 	
 	if (int(newPos.x()) != int(pos().x()) && (m_animation.state() != QTimeLine::Running)) {
 		setPos(newPos);
@@ -164,13 +260,6 @@ void PlayHead::update_position()
 	// When timeref_scalefactor is below 5120, the playhead moves faster then teh view scrolls
 	// so it's better to keep the view centered around the playhead.
 	if (m_mode == CENTERED || (m_sv->timeref_scalefactor <= 10280) ) {
-                // For some reason on some systems the event of
-                // setting the new position doesn't result in
-                // updating the area of the old cursor position
-                // when directly updating the scrollbars afterwards.
-                // processing the event stack manually solves this.
-                qApp->processEvents();
-
                 m_sv->set_hscrollbar_value(int(scenePos().x()) - (int)(0.5 * vpWidth));
 		return;
 	}
@@ -231,12 +320,6 @@ void PlayHead::set_animation_value(int value)
 	}
 	
 	if (m_sv->hscrollbar_value() != newXPos) {
-                // For some reason on some systems the event of
-                // setting the new position doesn't result in
-                // updating the area of the old cursor position
-                // when directly updating the scrollbars afterwards.
-                // processing the event stack manually solves this.
-                qApp->processEvents();
 		m_sv->set_hscrollbar_value(newXPos);
 	}
 }
@@ -252,6 +335,7 @@ void PlayHead::animation_finished()
 void PlayHead::set_bounding_rect( QRectF rect )
 {
 	m_boundingRect = rect;
+	update_overlay();
 }
 
 bool PlayHead::is_active()
@@ -282,6 +366,9 @@ void PlayHead::load_theme_data()
 {
     m_brushActive = themer()->get_brush("Playhead:active");
     m_brushInactive = themer()->get_brush("Playhead:inactive");
+    if (m_overlay) {
+            m_overlay->update();
+    }
 }
 
 /**************************************************************/
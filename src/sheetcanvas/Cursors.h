@@ -26,10 +26,12 @@
 #include <QTimer>
 #include <QTimeLine>
 #include <QBrush>
+#include <QPointer>
 
 class TSession;
 class SheetView;
 class ClipsViewPort;
+class PlayHeadOverlay;
 		
 class PlayHead : public ViewItem
 {
@@ -53,10 +55,17 @@ public:
 	
 	void set_mode(PlayHeadMode mode);
 	void toggle_follow();
+	void update_overlay();
+
+	QBrush get_brush() const;
+
+protected:
+	QVariant itemChange(GraphicsItemChange change, const QVariant& value);
 
 private:
         TSession*	m_session;
         QTimer		m_playTimer;
+        QPointer<PlayHeadOverlay> m_overlay;
         QTimeLine	m_animation;
         ClipsViewPort*	m_vp;
         bool 		m_follow;
@@ -67,6 +76,9 @@ private:
 	qreal		m_animScaleFactor;
         QBrush          m_brushActive;
         QBrush          m_brushInactive;
+	int		m_refreshInterval;
+
+	int update_interval() const;
 	
 private slots:
 	void check_config();
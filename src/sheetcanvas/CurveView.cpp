@@ -85,6 +85,8 @@ static bool smallerpoint(const QPointF& left, const QPointF& right) {
 
 void CurveView::paint( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget )
 {
+	static ThemeElement activeColor("Curve:active");
+
 	Q_UNUSED(widget);
 	PENTER2;
 
@@ -100,7 +102,7 @@ void CurveView::paint( QPainter * painter, const QStyleOptionGraphicsItem * opti
 
 	QPen pen;
 	
-        pen.setColor(themer()->get_color("Curve:active"));
+        pen.setColor(activeColor.color());
 	
         if (m_boundingRect.height() > 40) {
                 pen.setWidth(2);
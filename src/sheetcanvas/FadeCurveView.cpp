@@ -79,6 +79,9 @@ FadeCurveView::~ FadeCurveView( )
 
 void FadeCurveView::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+	static ThemeElement bypassedColor("Fade:bypassed");
+	static ThemeElement defaultColor("Fade:default");
+
 	Q_UNUSED(widget);
 	
 	
@@ -121,8 +124,8 @@ void FadeCurveView::paint(QPainter *painter, const QStyleOptionGraphicsItem *opt
 	painter->setPen(Qt::NoPen);
 	
 	QColor color = m_fadeCurve->is_bypassed() ? 
-			themer()->get_color("Fade:bypassed") :
-			themer()->get_color("Fade:default");
+			bypassedColor.color() :
+			defaultColor.color();
 	
         if (has_active_context()) {
 		color.setAlpha(color.alpha() + 10);
@@ -63,6 +63,10 @@ MarkerView::MarkerView(Marker* marker, SheetView* sv, ViewItem* parentView)
 
 void MarkerView::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
+	static ThemeElement markerFont("Timeline:fontscale:marker");
+	static ThemeElement outlineColor("Marker:outline");
+	static ThemeElement textColor("Timeline:text");
+
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 	
@@ -75,10 +79,10 @@ void MarkerView::paint(QPainter * painter, const QStyleOptionGraphicsItem * opti
 	}
 
 	painter->setRenderHint(QPainter::Antialiasing);
-	painter->setFont(themer()->get_font("Timeline:fontscale:marker"));
+	painter->setFont(markerFont.font());
 	
 	painter->setBrush(m_fillColor);
-	painter->setPen(themer()->get_color("Marker:outline"));
+	painter->setPen(outlineColor.color());
 
 	const QPointF pts[3] = {
 			QPointF(0, 0),
@@ -87,7 +91,7 @@ void MarkerView::paint(QPainter * painter, const QStyleOptionGraphicsItem * opti
 
 	painter->drawPolygon(pts, 3);
 
-	painter->setPen(themer()->get_color("Timeline:text"));
+	painter->setPen(textColor.color());
 
 	if (m_marker->get_type() == Marker::ENDMARKER) {
 		painter->drawText(m_width + 1, m_ascent-2, m_marker->get_description());
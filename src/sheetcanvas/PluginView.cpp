@@ -72,14 +72,19 @@ PluginView::~PluginView( )
 
 void PluginView::paint(QPainter* painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+	static ThemeElement backgroundBypassedColor("Plugin:background:bypassed");
+	static ThemeElement backgroundColor("Plugin:background");
+	static ThemeElement textColor("Plugin:text");
+	static ThemeElement nameFont("Plugin:fontscale:name");
+
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 	
 	QColor color;
 	if (m_plugin->is_bypassed()) {
-		color = themer()->get_color("Plugin:background:bypassed");
+		color = backgroundBypassedColor.color();
 	} else {
-		color = themer()->get_color("Plugin:background");
+		color = backgroundColor.color();
 	}
 
 	int height, width;
@@ -95,8 +100,8 @@ void PluginView::paint(QPainter* painter, const QStyleOptionGraphicsItem *option
 	QBrush brush(color);
 	QRect rect(0, 0, width, height); 
 	painter->fillRect(rect, brush);
-	painter->setPen(themer()->get_color("Plugin:text"));
-	painter->setFont(themer()->get_font("Plugin:fontscale:name"));
+	painter->setPen(textColor.color());
+	painter->setFont(nameFont.font());
 	painter->drawText(rect, Qt::AlignCenter, m_name);
 }
 
@@ -36,12 +36,14 @@ PositionIndicator::PositionIndicator(ViewItem* parentView)
 
 void PositionIndicator::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
+	static ThemeElement nameFont("TrackPanel:fontscale:name");
+
 	Q_UNUSED(option);
 	Q_UNUSED(widget);
 	
 	painter->drawPixmap(0, 0, m_background);
 	painter->setPen(Qt::black);
-	painter->setFont(themer()->get_font("TrackPanel:fontscale:name"));
+	painter->setFont(nameFont.font());
         painter->drawText(m_boundingRect, Qt::AlignHCenter, m_value);
 }
 
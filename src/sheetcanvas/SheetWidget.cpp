@@ -53,7 +53,9 @@ SheetPanelView::SheetPanelView(QGraphicsScene* scene, TSession* sheet)
 
 void SheetPanelView::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
-        painter->fillRect(-3, 0, 3, -TIMELINE_HEIGHT - 1, themer()->get_color("TrackPanel:trackseparation"));
+	static ThemeElement trackseparationColor("TrackPanel:trackseparation");
+
+        painter->fillRect(-3, 0, 3, -TIMELINE_HEIGHT - 1, trackseparationColor.color());
 }
 
 SheetPanelViewPort::SheetPanelViewPort(QGraphicsScene * scene, SheetWidget * sw)
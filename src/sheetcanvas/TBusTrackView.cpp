@@ -47,6 +47,8 @@ TBusTrackView::TBusTrackView(SheetView* sv, TBusTrack* group)
 
 void TBusTrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement backgroundColor("BusTrack:background");
+
         Q_UNUSED(widget);
 
         TrackView::paint(painter, option, widget);
@@ -57,7 +59,7 @@ void TBusTrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* opt
         int pixelcount = (int)option->exposedRect.width();
 
 //        if (m_paintBackground) {
-                QColor color = themer()->get_color("BusTrack:background");
+                QColor color = backgroundColor.color();
                 painter->fillRect(xstart, m_topborderwidth, pixelcount+1, m_sv->get_track_height(m_track) - m_bottomborderwidth, color);
 //        }
 }
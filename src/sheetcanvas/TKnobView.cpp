@@ -37,6 +37,8 @@ TKnobView::TKnobView(ViewItem *parent)
 
 void TKnobView::paint( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget )
 {
+	static ThemeElement nameFont("TrackPanel:fontscale:name");
+
 	Q_UNUSED(widget);
 
 	int borderWidth = 3;
@@ -77,7 +79,7 @@ void TKnobView::paint( QPainter * painter, const QStyleOptionGraphicsItem * opti
 			xm - int(rint(sa * re)),
 			ym - int(rint(ca * re)));
 
-	QFont font = themer()->get_font("TrackPanel:fontscale:name");
+	QFont font = nameFont.font();
 	font.setPixelSize(8);
 	painter->setFont(font);
 	painter->drawText(m_boundingRect.width() / 2 - 3, -1, "0");
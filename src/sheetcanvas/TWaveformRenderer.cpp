@@ -0,0 +1,444 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TWaveformRenderer.h"
+
+#include <QPainter>
+#include <QPolygonF>
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+
+#include "Peak.h"
+#include "Mixer.h"
+
+#if defined (USE_XMMINTRIN)
+#include <xmmintrin.h>
+#endif
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+
+class TWaveformRenderJob : public QRunnable
+{
+public:
+	TWaveformRenderJob(TWaveformRenderer* renderer, const TWaveformRenderRequest& request)
+		: m_renderer(renderer)
+		, m_request(request)
+		, m_cancelled(false)
+	{}
+
+	void run() {
+		if (!m_renderer->begin_job(this)) {
+			return;
+		}
+		QImage image;
+		int status = TWaveformRenderer::render(m_request, image);
+		m_renderer->end_job(this, image, status);
+	}
+
+	TWaveformRenderer*	m_renderer;
+	TWaveformRenderRequest	m_request;
+	bool			m_cancelled;
+};
+
+
+// Peak data for the macro view comes in (upper, lower) pairs per pixel,
+// the rectified view draws one value per pixel, the negated largest of both.
+// Writing j while reading 2j and 2j+1 is save to do in place.
+static void rectify_peaks(float* data, int pixelcount)
+{
+	int j = 0;
+#if defined (USE_XMMINTRIN)
+	const __m128 signmask = _mm_set1_ps(-0.0f);
+	for (; j + 4 <= pixelcount; j += 4) {
+		__m128 a = _mm_loadu_ps(data + 2*j);
+		__m128 b = _mm_loadu_ps(data + 2*j + 4);
+		__m128 upper = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 lower = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 m = _mm_max_ps(upper, _mm_xor_ps(lower, signmask));
+		_mm_storeu_ps(data + j, _mm_or_ps(m, signmask));
+	}
+#endif
+	for (; j < pixelcount; ++j) {
+		data[j] = - fabs(f_max(data[2*j], - data[2*j+1]));
+	}
+}
+
+// dst = max(dst, src), used to merge the channels for the merged view
+static void merge_peaks(float* dst, const float* src, int count)
+{
+	int i = 0;
+#if defined (USE_XMMINTRIN)
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(dst + i, _mm_max_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	}
+#endif
+	for (; i < count; ++i) {
+		dst[i] = f_max(dst[i], src[i]);
+	}
+}
+
+// Multiply the peak data with the per pixel curve gain, if pairs is
+// true there are 2 values (upper, lower) per pixel.
+static void apply_curve(float* data, const float* curve, int pixelcount, bool pairs)
+{
+	int i = 0;
+#if defined (USE_XMMINTRIN)
+	for (; i + 4 <= pixelcount; i += 4) {
+		__m128 c = _mm_loadu_ps(curve + i);
+		if (pairs) {
+			_mm_storeu_ps(data + 2*i, _mm_mul_ps(_mm_loadu_ps(data + 2*i), _mm_unpacklo_ps(c, c)));
+			_mm_storeu_ps(data + 2*i + 4, _mm_mul_ps(_mm_loadu_ps(data + 2*i + 4), _mm_unpackhi_ps(c, c)));
+		} else {
+			_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), c));
+		}
+	}
+#endif
+	for (; i < pixelcount; ++i) {
+		if (pairs) {
+			data[2*i] *= curve[i];
+			data[2*i + 1] *= curve[i];
+		} else {
+			data[i] *= curve[i];
+		}
+	}
+}
+
+
+static void cancel_render_jobs(Peak* peak)
+{
+	TWaveformRenderer::instance()->cancel(peak);
+}
+
+TWaveformRenderer* TWaveformRenderer::instance()
+{
+	static TWaveformRenderer renderer;
+	return &renderer;
+}
+
+TWaveformRenderer::TWaveformRenderer()
+{
+	m_requestCount = 0;
+	// leave one core for the GUI (and audio) thread
+	m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+
+	// a Peak that is closed or deleted (clip removed, or it's audio source
+	// replaced) may not be freed while render jobs still use it
+	Peak::set_release_function(cancel_render_jobs);
+}
+
+TWaveformRenderer::~TWaveformRenderer()
+{
+	Peak::set_release_function(0);
+	m_pool.waitForDone();
+}
+
+void TWaveformRenderer::request(const TWaveformRenderRequest& request)
+{
+	if (m_pending.contains(request.key)) {
+		return;
+	}
+	m_pending.insert(request.key);
+
+	TWaveformRenderJob* job = new TWaveformRenderJob(this, request);
+
+	m_mutex.lock();
+	m_queued.append(job);
+	m_mutex.unlock();
+
+	// most recent requests are the ones visible right now, render them first
+	m_pool.start(job, ++m_requestCount);
+}
+
+/**
+ * Drops the queued requests for \a peak, and waits for the running ones to
+ * finish, after which the Peak may be deleted.
+ */
+void TWaveformRenderer::cancel(Peak* peak)
+{
+	QMutexLocker locker(&m_mutex);
+
+	foreach(TWaveformRenderJob* job, m_queued) {
+		if (job->m_request.peak == peak) {
+			job->m_cancelled = true;
+		}
+	}
+
+	bool running = true;
+	while (running) {
+		running = false;
+		foreach(TWaveformRenderJob* job, m_running) {
+			if (job->m_request.peak == peak) {
+				running = true;
+				m_jobFinished.wait(&m_mutex);
+				break;
+			}
+		}
+	}
+}
+
+bool TWaveformRenderer::begin_job(TWaveformRenderJob* job)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_queued.removeAll(job);
+
+	if (job->m_cancelled) {
+		Result result;
+		result.key = job->m_request.key;
+		result.status = CANCELLED;
+		m_results.append(result);
+		QMetaObject::invokeMethod(this, "process_results", Qt::QueuedConnection);
+		return false;
+	}
+
+	m_running.append(job);
+	return true;
+}
+
+void TWaveformRenderer::end_job(TWaveformRenderJob* job, const QImage& image, int status)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_running.removeAll(job);
+
+	Result result;
+	result.key = job->m_request.key;
+	result.image = image;
+	result.status = status;
+	m_results.append(result);
+
+	m_jobFinished.wakeAll();
+	QMetaObject::invokeMethod(this, "process_results", Qt::QueuedConnection);
+}
+
+void TWaveformRenderer::process_results()
+{
+	m_mutex.lock();
+	QList<Result> results = m_results;
+	m_results.clear();
+	m_mutex.unlock();
+
+	foreach(const Result& result, results) {
+		m_pending.remove(result.key);
+
+		// Without peak file the AudioClipView starts building it, and
+		// renews it's revision once done. Other failures are cached as
+		// empty tiles, there is nothing to draw for them anyway.
+		if (result.status != Peak::NO_PEAK_FILE && result.status != CANCELLED) {
+			TWaveformTileCache::instance()->insert(result.key, result.image);
+		}
+
+		emit tileRendered(result.key.revision, result.status);
+	}
+}
+
+/**
+ * Reads the peak data and rasterizes it into \a image, called from the
+ * render threads, only uses the data in \a r.
+ * @return The status as returned by Peak::read_peaks() for the last channel
+ */
+int TWaveformRenderer::render(const TWaveformRenderRequest& r, QImage& image)
+{
+	image = QImage(r.tileWidth, r.height, QImage::Format_ARGB32_Premultiplied);
+	image.fill(0);
+
+	int channels = r.channels;
+	int pixelcount = r.pixelcount;
+	int peakdatacount = r.microView ? pixelcount : pixelcount * 2;
+
+	if (channels <= 0 || pixelcount <= 0) {
+		return Peak::NO_PEAKDATA_FOUND;
+	}
+
+	QVector<float> data(channels * peakdatacount);
+	float* pixeldata[channels];
+	int availpeaks = 0;
+
+	for (int chan=0; chan < channels; ++chan) {
+		pixeldata[chan] = data.data() + chan * peakdatacount;
+
+		availpeaks = r.peak->read_peaks(chan, pixeldata[chan], r.startLocation, peakdatacount, r.framesPerPeak);
+
+		if (availpeaks == Peak::NO_PEAK_FILE || availpeaks == Peak::PERMANENT_FAILURE || availpeaks == Peak::NO_PEAKDATA_FOUND) {
+			return availpeaks;
+		}
+	}
+
+	bool merged = r.mergedView && channels == 2;
+
+	// ClassicView uses both positive and negative values,
+	// rectified view: pick the highest value of both
+	// Merged view: calculate highest value for all channels,
+	// and store it in the last channels pixeldata, which is the one drawn.
+	if (!r.microView) {
+		if (merged) {
+			merge_peaks(pixeldata[1], pixeldata[0], peakdatacount);
+		}
+		if (!r.classicView) {
+			for (int chan=0; chan < channels; ++chan) {
+				rectify_peaks(pixeldata[chan], pixelcount);
+			}
+		}
+	}
+
+	if (!r.curve.isEmpty()) {
+		bool pairs = r.classicView && !r.microView;
+		for (int chan=0; chan < channels; ++chan) {
+			apply_curve(pixeldata[chan], r.curve.constData(), pixelcount, pairs);
+		}
+	}
+
+	QPainter p(&image);
+	p.translate(-r.tileX, 0);
+
+	// calculate the height of the area available for peak drawing
+	int height = r.height / channels;
+	QPolygonF polygon;
+
+	for (int chan=0; chan < channels; ++chan) {
+		if (merged && chan == 0) {
+			continue;
+		}
+
+		p.save();
+
+		float scaleFactor = ( (float) height * 0.90 / 2) * r.gain;
+		float ytrans;
+
+		// Draw channel seperator horizontal lines, if needed.
+		if (channels >= 2 && ! r.mergedView && r.classicView && chan >=1 ) {
+			p.save();
+			p.setPen(r.seperatorColor);
+			p.translate(r.xstart, height * chan);
+			p.drawLine(0, 0, pixelcount, 0);
+			p.restore();
+		}
+
+		// Microview, paint waveform as polyline
+		if (r.microView) {
+			polygon.clear();
+			polygon.reserve(pixelcount);
+
+			if (r.mergedView) {
+				ytrans = (height / 2) * channels;
+				scaleFactor *= channels;
+			} else {
+				ytrans = (height / 2) + (chan * height);
+			}
+
+			p.translate(r.xstart, ytrans);
+
+			p.setPen(r.seperatorColor);
+			p.drawLine(0, 0, pixelcount, 0);
+
+			for (int x = 0; x < pixelcount; x++) {
+				polygon.append( QPointF(x, -scaleFactor * pixeldata[chan][x]) );
+			}
+
+			if (r.antialiased) {
+				p.setRenderHints(QPainter::Antialiasing);
+			}
+
+			p.setPen(r.microViewColor);
+			p.drawPolyline(polygon);
+
+		// Macroview, paint waveform with painter
+		} else {
+			if (r.fillWave) {
+				p.setBrush(r.waveBrush);
+			}
+
+			if (r.paintWithOutline) {
+				p.setPen(r.outlineColor);
+			} else {
+				p.setPen(Qt::NoPen);
+			}
+
+			if (r.classicView) {
+				scaleFactor = ( (float) height * 0.90 / (Peak::MAX_DB_VALUE * 2)) * r.gain;
+
+				if (r.mergedView) {
+					ytrans = (height / 2) * channels;
+					scaleFactor *= channels;
+				} else {
+					ytrans = (height / 2) + (chan * height);
+				}
+
+				p.translate(r.xstart, ytrans);
+
+				polygon.clear();
+				polygon.reserve(pixelcount*2);
+
+				int bufferpos = 0;
+				for (int x = 0; x < pixelcount; x++) {
+					polygon.append( QPointF(x, -scaleFactor * pixeldata[chan][bufferpos]) );
+					bufferpos+=2;
+				}
+
+				bufferpos -= 1;
+
+				for (int x = pixelcount - 1; x >= 0; x--) {
+					polygon.append( QPointF(x, scaleFactor * pixeldata[chan][bufferpos]) );
+					bufferpos-=2;
+				}
+
+				p.drawPolygon(polygon);
+
+				// Draw 'the' -INF line
+				p.setPen(r.minINFLineColor);
+				p.drawLine(0, 0, pixelcount, 0);
+
+			} else {
+				scaleFactor =  (float) height * 0.95 * r.gain / Peak::MAX_DB_VALUE;
+				ytrans = height + (chan * height);
+
+				if (r.mergedView) {
+					ytrans = height * channels;
+					scaleFactor *= channels;
+				}
+
+				p.translate(r.xstart, ytrans);
+
+				polygon.clear();
+				polygon.reserve(pixelcount + 2);
+
+				for (int x=0; x<pixelcount; x++) {
+					polygon.append( QPointF(x, scaleFactor * pixeldata[chan][x]) );
+				}
+
+				polygon.append(QPointF(pixelcount, 0));
+				polygon.append(QPointF(0,0));
+
+				p.drawPolygon(polygon);
+			}
+		}
+
+		p.restore();
+	}
+
+	return availpeaks;
+}
+
+//eof
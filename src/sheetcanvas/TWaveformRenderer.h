@@ -0,0 +1,135 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TWAVEFORM_RENDERER_H
+#define TWAVEFORM_RENDERER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QBrush>
+#include <QColor>
+#include <QImage>
+#include <QSet>
+#include <QList>
+
+#include "defines.h"
+#include "TWaveformTileCache.h"
+
+class Peak;
+class TWaveformRenderJob;
+
+/**
+ * Everything needed to rasterize one waveform tile without touching
+ * any GUI object, filled in by AudioClipView on the GUI thread.
+ */
+struct TWaveformRenderRequest
+{
+	TWaveformRenderRequest()
+		: peak(0), framesPerPeak(0), tileX(0), tileWidth(0), xstart(0), pixelcount(0), height(0), channels(0)
+		, microView(false), classicView(true), mergedView(false), fillWave(true)
+		, paintWithOutline(true), antialiased(false), gain(1.0f) {}
+
+	TWaveformTileCache::Key	key;
+	Peak*		peak;
+	TimeRef		startLocation;	// source location of the first pixel (xstart)
+	qreal		framesPerPeak;	// the sheets hzoom
+	int		tileX;		// clip x coordinate of the tile image origin
+	int		tileWidth;
+	int		xstart;		// clip x coordinate of the first pixel to draw
+	int		pixelcount;
+	int		height;
+	int		channels;
+	bool		microView;
+	bool		classicView;
+	bool		mergedView;
+	bool		fillWave;
+	bool		paintWithOutline;
+	bool		antialiased;
+	float		gain;		// clip gain times the default (non automated) curve values
+	QVector<float>	curve;		// per pixel gain of the curves and fades, empty if none
+	QBrush		waveBrush;
+	QColor		outlineColor;
+	QColor		seperatorColor;
+	QColor		minINFLineColor;
+	QColor		microViewColor;
+};
+
+/**
+ * Renders waveform tiles on a pool of worker threads.
+ *
+ * Finished tiles are put into the TWaveformTileCache on the GUI thread,
+ * after which tileRendered() is emitted so the AudioClipView with the
+ * matching revision can repaint. Newer requests are rendered first.
+ */
+class TWaveformRenderer : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum {
+		CANCELLED = -100
+	};
+
+	static TWaveformRenderer* instance();
+
+	bool is_pending(const TWaveformTileCache::Key& key) const {return m_pending.contains(key);}
+	void request(const TWaveformRenderRequest& request);
+	void cancel(Peak* peak);
+
+	static int render(const TWaveformRenderRequest& request, QImage& image);
+
+private:
+	TWaveformRenderer();
+	~TWaveformRenderer();
+
+	struct Result {
+		TWaveformTileCache::Key	key;
+		QImage			image;
+		int			status;
+	};
+
+	QThreadPool			m_pool;
+	QMutex				m_mutex;
+	QWaitCondition			m_jobFinished;
+	QList<TWaveformRenderJob*>	m_queued;
+	QList<TWaveformRenderJob*>	m_running;
+	QList<Result>			m_results;
+	QSet<TWaveformTileCache::Key>	m_pending;
+	int				m_requestCount;
+
+	bool begin_job(TWaveformRenderJob* job);
+	void end_job(TWaveformRenderJob* job, const QImage& image, int status);
+
+	friend class TWaveformRenderJob;
+
+private slots:
+	void process_results();
+
+signals:
+	void tileRendered(qint64 revision, int status);
+};
+
+#endif
+
+//eof
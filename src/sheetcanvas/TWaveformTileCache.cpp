@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TWaveformTileCache.h"
+
+#include "TConfig.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+qint64 TWaveformTileCache::s_revision = 0;
+
+TWaveformTileCache* TWaveformTileCache::instance()
+{
+	static TWaveformTileCache cache;
+	return &cache;
+}
+
+qint64 TWaveformTileCache::new_revision()
+{
+	return ++s_revision;
+}
+
+TWaveformTileCache::TWaveformTileCache()
+{
+	set_budget(config().get_property("Themer", "waveformcachesize", 64).toInt());
+}
+
+void TWaveformTileCache::set_budget(int megabytes)
+{
+	// the cost of a tile is it's size in KiB
+	m_tiles.setMaxCost(qMax(1, megabytes) * 1024);
+}
+
+void TWaveformTileCache::insert(const Key& key, const QImage& image)
+{
+	m_tiles.insert(key, new QImage(image), qMax(1, image.byteCount() / 1024));
+}
+
+//eof
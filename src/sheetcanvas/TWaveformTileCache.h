@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TWAVEFORM_TILE_CACHE_H
+#define TWAVEFORM_TILE_CACHE_H
+
+#include <QCache>
+#include <QImage>
+
+/**
+ * Cache of rendered waveform tiles, shared by all AudioClipViews.
+ *
+ * A tile is a TILE_WIDTH pixels wide, transparent image with the waveform
+ * of a clip, painted in clip local coordinates starting at tile * TILE_WIDTH.
+ * Tiles are keyed by a revision which the AudioClipView renews whenever
+ * anything that influences the waveform changes (gain, curves, fades, view
+ * mode, theme, height), so stale tiles are never found again and simply age
+ * out. The total memory is bounded, least recently used tiles are evicted first.
+ */
+
+class TWaveformTileCache
+{
+public:
+	enum {
+		TILE_WIDTH = 256
+	};
+
+	struct Key {
+		Key() : revision(0), scalefactor(0), tile(0), height(0), style(0) {}
+
+		qint64	revision;
+		qint64	scalefactor;
+		int	tile;
+		int	height;
+		int	style;
+
+		bool operator==(const Key& other) const {
+			return revision == other.revision && scalefactor == other.scalefactor && tile == other.tile
+				&& height == other.height && style == other.style;
+		}
+	};
+
+	static TWaveformTileCache* instance();
+	static qint64 new_revision();
+
+	const QImage* find(const Key& key) {return m_tiles.object(key);}
+	void insert(const Key& key, const QImage& image);
+
+	void set_budget(int megabytes);
+
+private:
+	TWaveformTileCache();
+
+	QCache<Key, QImage>	m_tiles;
+	static qint64		s_revision;
+};
+
+inline uint qHash(const TWaveformTileCache::Key& key)
+{
+	return uint(key.revision * 31 + key.scalefactor) ^ uint(key.tile << 8) ^ uint(key.height << 20) ^ uint(key.style << 28);
+}
+
+#endif
+
+//eof
@@ -118,6 +118,12 @@ void TimeLineView::hzoom_changed( )
 
 void TimeLineView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement timelineBackgroundColor("Timeline:background");
+	static ThemeElement minorticksColor("Timeline:minorticks");
+	static ThemeElement majorticksColor("Timeline:majorticks");
+	static ThemeElement textColor("Timeline:text");
+	static ThemeElement labelFont("Timeline:fontscale:label");
+
 	PENTER3;
 	Q_UNUSED(widget);
 	
@@ -136,7 +142,7 @@ void TimeLineView::paint(QPainter* painter, const QStyleOptionGraphicsItem* opti
 	
 	int height = TIMELINE_HEIGHT;
 	
-        QColor backgroundColor = themer()->get_color("Timeline:background");
+        QColor backgroundColor = timelineBackgroundColor.color();
         if (m_timeline->has_active_context()) {
 		backgroundColor = backgroundColor.lighter(130);
         }
@@ -182,21 +188,21 @@ void TimeLineView::paint(QPainter* painter, const QStyleOptionGraphicsItem* opti
 	}
 
 	// Draw minor ticks
-	painter->setPen(themer()->get_color("Timeline:minorticks"));
+	painter->setPen(minorticksColor.color());
 	for(int i=0; i<minorTicks.size(); ++i) {
 		int x = minorTicks.at(i);
 		painter->drawLine(x, height - 5, x, height - 1);
 	}
 
-	painter->setPen(themer()->get_color("Timeline:majorticks"));
+	painter->setPen(majorticksColor.color());
 	// Draw major ticks
 	for (int i=0; i<majorTicks.size(); ++i) {
 		int x = majorTicks.at(i);
 		painter->drawLine(x, height - 16, x, height - 1);
 	}
 
-	painter->setPen(themer()->get_color("Timeline:text"));
-	painter->setFont( themer()->get_font("Timeline:fontscale:label") );
+	painter->setPen(textColor.color());
+	painter->setFont( labelFont.font() );
 	// Draw text
 	for (int i=0; i<majorTicks.size(); ++i) {
 		int x = majorTicks.at(i);
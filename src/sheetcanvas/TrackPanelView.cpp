@@ -124,6 +124,11 @@ TrackPanelView::~TrackPanelView( )
 
 void TrackPanelView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement mousehoverColor("Track:mousehover");
+	static ThemeElement cliptopoffsetColor("Track:cliptopoffset");
+	static ThemeElement clipbottomoffsetColor("Track:clipbottomoffset");
+	static ThemeElement trackseparationColor("TrackPanel:trackseparation");
+
         Q_UNUSED(widget);
 
         int xstart = (int)option->exposedRect.x();
@@ -140,23 +145,23 @@ void TrackPanelView::paint(QPainter* painter, const QStyleOptionGraphicsItem* op
 
 
         if (m_trackView->is_moving() || m_track->has_active_context()) {
-                QColor color = themer()->get_color("Track:mousehover");
+                QColor color = mousehoverColor.color();
                 painter->fillRect(boundingRect(), color);
         }
 
 
 
         if (m_trackView->m_topborderwidth > 0) {
-                QColor color = themer()->get_color("Track:cliptopoffset");
+                QColor color = cliptopoffsetColor.color();
                 painter->fillRect(xstart, 0, pixelcount, m_trackView->m_topborderwidth, color);
         }
 
         if (m_trackView->m_bottomborderwidth > 0) {
-                QColor color = themer()->get_color("Track:clipbottomoffset");
+                QColor color = clipbottomoffsetColor.color();
 		painter->fillRect(xstart, m_trackView->get_total_height() - m_trackView->m_bottomborderwidth, pixelcount, m_trackView->m_bottomborderwidth, color);
         }
 
-	painter->fillRect(m_viewPort->width() - 3, 0, 3, m_trackView->get_total_height() - 1, themer()->get_color("TrackPanel:trackseparation"));
+	painter->fillRect(m_viewPort->width() - 3, 0, 3, m_trackView->get_total_height() - 1, trackseparationColor.color());
 
         if (xstart < 180) {
                 draw_panel_name(painter);
@@ -176,17 +181,21 @@ void TrackPanelView::update_gain()
 
 void TrackPanelView::draw_panel_name(QPainter* painter)
 {
+	static ThemeElement headerBackgroundColor("TrackPanel:header:background");
+	static ThemeElement textColor("TrackPanel:text");
+	static ThemeElement nameFont("TrackPanel:fontscale:name");
+
 	painter->save();
 	painter->setRenderHint(QPainter::Antialiasing);
 
-	QColor color = themer()->get_color("TrackPanel:header:background");
+	QColor color = headerBackgroundColor.color();
 	painter->setPen(color.darker(180));
 	painter->setBrush(color);
 	int corner = 5;
 	painter->drawRoundedRect(INDENT, 3, 175, 15, corner, corner);
 
-        painter->setPen(themer()->get_color("TrackPanel:text"));
-        painter->setFont(themer()->get_font("TrackPanel:fontscale:name"));
+        painter->setPen(textColor.color());
+        painter->setFont(nameFont.font());
 	painter->drawText(INDENT + 8, 14, m_track->get_name());
 
 	painter->restore();
@@ -295,13 +304,15 @@ TBusTrackPanelView::~TBusTrackPanelView( )
 
 void TBusTrackPanelView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement backgroundColor("BusTrack:background");
+
         Q_UNUSED(widget);
         Q_UNUSED(option);
 
         int xstart = (int)option->exposedRect.x();
         int pixelcount = (int)option->exposedRect.width();
 
-        QColor color = themer()->get_color("BusTrack:background");
+        QColor color = backgroundColor.color();
         painter->fillRect(xstart, m_trackView->m_topborderwidth, pixelcount, m_sv->get_track_height(m_track) - m_trackView->m_bottomborderwidth, color);
 
         TrackPanelView::paint(painter, option, widget);
@@ -332,14 +343,18 @@ TTrackLanePanelView::~TTrackLanePanelView( )
 
 void TTrackLanePanelView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement backgroundColor("BusTrack:background");
+	static ThemeElement textColor("TrackPanel:text");
+	static ThemeElement nameFont("TrackPanel:fontscale:name");
+
 	Q_UNUSED(widget);
 	Q_UNUSED(option);
 
-	QColor color = themer()->get_color("BusTrack:background");
+	QColor color = backgroundColor.color();
 	painter->fillRect(m_boundingRect, color);
 
-	painter->setPen(themer()->get_color("TrackPanel:text"));
-	painter->setFont(themer()->get_font("TrackPanel:fontscale:name"));
+	painter->setPen(textColor.color());
+	painter->setFont(nameFont.font());
 	painter->drawText(20, 20, m_parentViewItem->get_name());
 
 
@@ -380,10 +395,15 @@ TrackPanelGain::TrackPanelGain(TrackPanelView *parent, Track *track)
 
 void TrackPanelGain::paint( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget )
 {
+	static ThemeElement sliderBackgroundColor("TrackPanel:slider:background");
+	static ThemeElement textColor("TrackPanel:text");
+	static ThemeElement gainFont("TrackPanel:fontscale:gain");
+	static ThemeElement sliderBorderColor("TrackPanel:slider:border");
+
 	Q_UNUSED(widget);
         const int height = 6;
 
-        QColor color = themer()->get_color("TrackPanel:slider:background");
+        QColor color = sliderBackgroundColor.color();
         if (has_active_context()) {
                 color = color.light(110);
         }
@@ -410,8 +430,8 @@ void TrackPanelGain::paint( QPainter * painter, const QStyleOptionGraphicsItem *
 	
 	painter->save();
 	
-	painter->setPen(themer()->get_color("TrackPanel:text"));
-	painter->setFont(themer()->get_font("TrackPanel:fontscale:gain"));
+	painter->setPen(textColor.color());
+	painter->setFont(gainFont.font());
         painter->drawText(0, height + 1, "Gain");
         painter->fillRect(30, 0, sliderWidth, height, color);
 
@@ -423,7 +443,7 @@ void TrackPanelGain::paint( QPainter * painter, const QStyleOptionGraphicsItem *
         painter->fillRect(31, 1, sliderdbx, height-1, m_gradient2D);
 	painter->drawText(sliderWidth + 35, height, sgain);
 	
-        painter->setPen(themer()->get_color("TrackPanel:slider:border"));
+        painter->setPen(sliderBorderColor.color());
         painter->drawRect(30, 0, sliderWidth, height);
 
         painter->restore();
@@ -472,12 +492,18 @@ TrackPanelLed::TrackPanelLed(TrackPanelView* view, QObject *obj, const QString&
 	, m_name(name)
 	, m_toggleslot(toggleslot)
 	, m_isOn(false)
+	, m_onColor("TrackPanel:" + name + "led")
 {
 	m_object = obj;
 }
 
 void TrackPanelLed::paint(QPainter* painter, const QStyleOptionGraphicsItem * option, QWidget * widget )
 {
+	static ThemeElement ledInactiveColor("TrackPanel:led:inactive");
+	static ThemeElement ledFont("TrackPanel:fontscale:led");
+	static ThemeElement ledMarginInactiveColor("TrackPanel:led:margin:inactive");
+	static ThemeElement ledFontInactiveColor("TrackPanel:led:font:inactive");
+
 	Q_UNUSED(widget);
 
 	painter->save();
@@ -485,8 +511,8 @@ void TrackPanelLed::paint(QPainter* painter, const QStyleOptionGraphicsItem * op
 	painter->setRenderHint(QPainter::Antialiasing);
 	
 	if (m_isOn) {
-		QColor background = themer()->get_color("TrackPanel:led:inactive");
-		QColor color = themer()->get_color("TrackPanel:" + m_name + "led");
+		QColor background = ledInactiveColor.color();
+		QColor color = m_onColor.color();
                 if (has_active_context()) {
 			color = color.light(110);
 		}
@@ -495,28 +521,28 @@ void TrackPanelLed::paint(QPainter* painter, const QStyleOptionGraphicsItem * op
 		painter->setBrush(background);
 		painter->drawEllipse(m_boundingRect);
 
-		painter->setFont(themer()->get_font("TrackPanel:fontscale:led"));
+		painter->setFont(ledFont.font());
 		
                 QString shortString = m_name.left(1).toUpper();
                 painter->drawText(m_boundingRect, Qt::AlignCenter, shortString);
 	} else {
-		QColor color = themer()->get_color("TrackPanel:led:inactive");
+		QColor color = ledInactiveColor.color();
                 if (has_active_context()) {
 			color = color.light(110);
 		}
 		
-		painter->setPen(themer()->get_color("TrackPanel:led:margin:inactive"));
+		painter->setPen(ledMarginInactiveColor.color());
 		painter->setBrush(color);
 		painter->drawEllipse(m_boundingRect);
 		
-		painter->setFont(themer()->get_font("TrackPanel:fontscale:led"));
-		painter->setPen(themer()->get_color("TrackPanel:led:font:inactive"));
+		painter->setFont(ledFont.font());
+		painter->setPen(ledFontInactiveColor.color());
 
 		if (m_name == "I") {
-			painter->setPen(themer()->get_color("TrackPanel:led:margin:inactive"));
+			painter->setPen(ledMarginInactiveColor.color());
 			painter->setBrush(QColor(255, 255, 255, 50));
 			painter->drawEllipse(m_boundingRect);
-			painter->setPen(themer()->get_color("TrackPanel:led:font:inactive"));
+			painter->setPen(ledFontInactiveColor.color());
 			painter->drawText(m_boundingRect, Qt::AlignCenter, m_name);
 		} else {
 			painter->drawText(m_boundingRect, Qt::AlignCenter, m_name);
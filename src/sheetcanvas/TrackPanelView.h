@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #define TRACK_PANEL_VIEW_H
 
 #include "ViewItem.h"
+#include "Themer.h"
 
 class Track;
 class AudioTrack;
@@ -73,6 +74,7 @@ private:
         QString m_name;
 	QString m_toggleslot;
         bool    m_isOn;
+	ThemeElement m_onColor;
 
 public slots:
         void ison_changed(bool isOn);
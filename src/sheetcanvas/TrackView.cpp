@@ -84,6 +84,11 @@ TrackView:: ~ TrackView( )
 
 void TrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+	static ThemeElement cliptopoffsetColor("Track:cliptopoffset");
+	static ThemeElement clipbottomoffsetColor("Track:clipbottomoffset");
+	static ThemeElement mousehoverColor("Track:mousehover");
+	static ThemeElement laneseperatorColor("Track:laneseperator");
+
         Q_UNUSED(widget);
 
 // 	printf("TrackView:: PAINT :: exposed rect is: x=%f, y=%f, w=%f, h=%f\n", option->exposedRect.x(), option->exposedRect.y(), option->exposedRect.width(), option->exposedRect.height());
@@ -92,12 +97,12 @@ void TrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
 	int pixelcount = (int)option->exposedRect.width();
 
 	if (m_topborderwidth > 0) {
-		QColor color = themer()->get_color("Track:cliptopoffset");
+		QColor color = cliptopoffsetColor.color();
 		painter->fillRect(xstart, 0, pixelcount+1, m_topborderwidth, color);
 	}
 
 	if (m_bottomborderwidth > 0) {
-		QColor color = themer()->get_color("Track:clipbottomoffset");
+		QColor color = clipbottomoffsetColor.color();
 		painter->fillRect(xstart, get_total_height() - m_bottomborderwidth, pixelcount+1, m_bottomborderwidth, color);
 	}
 
@@ -105,7 +110,7 @@ void TrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
 		QPen pen;
 		int penwidth = 1;
 		pen.setWidth(penwidth);
-		pen.setColor(themer()->get_color("Track:mousehover"));
+		pen.setColor(mousehoverColor.color());
 		painter->setPen(pen);
 		painter->drawLine(xstart, m_topborderwidth, xstart+pixelcount, m_topborderwidth);
 		painter->drawLine(xstart, get_total_height() - m_bottomborderwidth - 1, xstart+pixelcount, get_total_height() - m_bottomborderwidth - 1);
@@ -113,7 +118,7 @@ void TrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
 
 	if (m_visibleLanes > 1) {
 		QPen pen;
-		pen.setColor(themer()->get_color("Track:laneseperator"));
+		pen.setColor(laneseperatorColor.color());
 		painter->setPen(pen);
 		for (int i = 1; i<m_laneViews.size(); ++i) {
 			TTrackLaneView* laneView = m_laneViews.at(i);
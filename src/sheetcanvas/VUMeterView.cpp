@@ -80,9 +80,11 @@ VUMeterView::~ VUMeterView( )
 
 void VUMeterView::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+	static ThemeElement levelseparatorColor("VUMeter:levelseparator");
+
         PENTER3;
 
-	QPen pen(themer()->get_color("VUMeter:levelseparator"));
+	QPen pen(levelseparatorColor.color());
 	pen.setWidth(m_vulevelspacing);
 	painter->setPen(pen);
         if (m_orientation == Qt::Vertical) {
@@ -279,6 +281,7 @@ VUMeterLevelView::VUMeterLevelView(ViewItem* parent, VUMonitor* monitor)
         m_tailDeltaY = m_peakHoldValue = m_rms = -120.0;
         m_overCount = m_rmsIndex = 0;
         m_peakHoldFalling = false;
+        m_peakHoldTime.start();
         m_peak = 0.0;
         m_orientation = Qt::Vertical;
 
@@ -332,9 +335,9 @@ void VUMeterLevelView::paint(QPainter* painter, const QStyleOptionGraphicsItem *
                 m_peakHoldFalling = false;
                 m_peakHoldValue = dBVal;
 
-                // ehm, oops, this timer was moved to Interface
+                // every new peak is held PEAK_HOLD_TIME, see update_peak()
                 if (PEAK_HOLD_MODE == 1) {
-//                        phTimer.start(PEAK_HOLD_TIME);
+                        m_peakHoldTime.start();
                 }
         }
 
@@ -408,6 +411,7 @@ void VUMeterLevelView::set_orientation(Qt::Orientation orientation)
 
 void VUMeterLevelView::update_peak( )
 {
+        float previousPeak = m_peak;
         m_peak = m_monitor->get_peak_value();
 
         // if the meter drops to -inf, reset the 'over LED' and peak hold values
@@ -446,6 +450,18 @@ void VUMeterLevelView::update_peak( )
                 m_overCount = 0;
         }
 
+        // release the held peak once it's been held long enough
+        if (PEAK_HOLD_MODE == 1 && !m_peakHoldFalling && m_peakHoldTime.elapsed() >= PEAK_HOLD_TIME) {
+                m_peakHoldFalling = true;
+        }
+
+        // only repaint when the level, its falloff or the peak hold line moves
+        float dBVal = qMin(coefficient_to_dB(m_peak), 6.0f);
+        if (m_peak == previousPeak && m_tailDeltaY == dBVal
+            && !(m_peakHoldFalling && m_peakHoldValue >= -120.0)) {
+                return;
+        }
+
         update(m_boundingRect);
 }
 
@@ -460,11 +476,6 @@ void VUMeterLevelView::set_bounding_rect(QRectF rect)
 }
 
 
-void VUMeterLevelView::reset_peak_hold_value()
-{
-        m_peakHoldFalling = true;
-}
-
 void VUMeterLevelView::load_theme_data()
 {
         float zeroDB = 1.0 - 100.0/115.0;  // 0 dB position
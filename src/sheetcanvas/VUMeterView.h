@@ -21,6 +21,8 @@
 #ifndef VUMeterView_H
 #define VUMeterView_H
 
+#include <QTime>
+
 #include "ViewItem.h"
 #include "TMainWindow.h"
 
@@ -122,10 +124,10 @@ public:
         void set_orientation(Qt::Orientation orientation);
 
         void update_peak();
-        void reset_peak_hold_value();
 
 private:
         bool		m_peakHoldFalling;
+        QTime		m_peakHoldTime;
         VUMonitor*      m_monitor;
         // TODO: the variables below could be shared globally by
         // all the VUMeterLevelView's ?
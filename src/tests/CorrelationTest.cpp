@@ -0,0 +1,212 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTestUtils.h"
+#include "Mixer.h"
+#include "fpu.h"
+
+#include <cmath>
+
+
+/**
+ * Checks the sums the CorrelationMeter gets from each compute_stereo_correlation
+ * variant this cpu can run. Mono input (left == right) has to give three
+ * identical sums, inverted input (right == -left) the negated product sum
+ * and silence three zeros, exactly, since each variant does the same
+ * operations on all three sums. Noise is compared to a double precision
+ * reference, the vectorized variants add in another order so only within
+ * a relative tolerance.
+ */
+
+struct Variant {
+	const char*				name;
+	Mixer::compute_stereo_correlation_t	correlation;
+};
+
+static const int MAX_VARIANTS = 3;
+
+static int get_variants(Variant* variants)
+{
+	int count = 0;
+	variants[count].name = "default";
+	variants[count++].correlation = default_compute_stereo_correlation;
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+	FPU fpu;
+	if (fpu.has_sse()) {
+		variants[count].name = "sse";
+		variants[count++].correlation = x86_sse_compute_stereo_correlation;
+	}
+	if (fpu.has_avx()) {
+		variants[count].name = "avx";
+		variants[count++].correlation = x86_avx_compute_stereo_correlation;
+	}
+#endif
+
+	return count;
+}
+
+// the correlation coefficient as CorrelationMeter::process() derives it
+static float coefficient(float lr, float ll, float rr)
+{
+	if (ll == 0.0f || rr == 0.0f) {
+		return 1.0f;
+	}
+	return lr / (sqrtf(ll) * sqrtf(rr));
+}
+
+static bool close_to(double value, double reference, double scale)
+{
+	return fabs(value - reference) <= 1e-5 * scale + 1e-30;
+}
+
+static void check_variant(const Variant& variant, nframes_t nframes, int offset)
+{
+	unsigned int seed = nframes * 31 + offset;
+	audio_sample_t* left = new audio_sample_t[nframes + offset];
+	audio_sample_t* right = new audio_sample_t[nframes + offset];
+	audio_sample_t* l = left + offset;
+	audio_sample_t* r = right + offset;
+	float lr, ll, rr;
+
+	// mono
+	t_fill_noise(l, nframes, seed);
+	memcpy(r, l, nframes * sizeof(audio_sample_t));
+	variant.correlation(l, r, nframes, &lr, &ll, &rr);
+	T_CHECK(lr == ll && ll == rr,
+		"%s mono sums differ: %g %g %g, %u frames", variant.name, lr, ll, rr, nframes);
+	T_CHECK(nframes == 0 || fabsf(coefficient(lr, ll, rr) - 1.0f) < 1e-6f,
+		"%s mono correlation is %g, %u frames", variant.name, coefficient(lr, ll, rr), nframes);
+
+	// inverted
+	for (nframes_t i=0; i<nframes; ++i) {
+		r[i] = -l[i];
+	}
+	variant.correlation(l, r, nframes, &lr, &ll, &rr);
+	T_CHECK(lr == -ll && ll == rr,
+		"%s inverted sums don't match: %g %g %g, %u frames", variant.name, lr, ll, rr, nframes);
+	T_CHECK(nframes == 0 || fabsf(coefficient(lr, ll, rr) + 1.0f) < 1e-6f,
+		"%s inverted correlation is %g, %u frames", variant.name, coefficient(lr, ll, rr), nframes);
+
+	// silence
+	memset(l, 0, nframes * sizeof(audio_sample_t));
+	memset(r, 0, nframes * sizeof(audio_sample_t));
+	variant.correlation(l, r, nframes, &lr, &ll, &rr);
+	T_CHECK(lr == 0.0f && ll == 0.0f && rr == 0.0f,
+		"%s silence gives %g %g %g, %u frames", variant.name, lr, ll, rr, nframes);
+	T_CHECK(coefficient(lr, ll, rr) == 1.0f,
+		"%s silence correlation is %g, %u frames", variant.name, coefficient(lr, ll, rr), nframes);
+
+	// uncorrelated noise
+	t_fill_noise(l, nframes, seed);
+	t_fill_noise(r, nframes, seed);
+	variant.correlation(l, r, nframes, &lr, &ll, &rr);
+	double refLR = 0.0, refLL = 0.0, refRR = 0.0, scale = 0.0;
+	for (nframes_t i=0; i<nframes; ++i) {
+		refLR += double(l[i]) * r[i];
+		refLL += double(l[i]) * l[i];
+		refRR += double(r[i]) * r[i];
+		scale += fabs(double(l[i]) * r[i]);
+	}
+	T_CHECK(close_to(lr, refLR, scale) && close_to(ll, refLL, refLL) && close_to(rr, refRR, refRR),
+		"%s noise sums %g %g %g, expected %g %g %g, %u frames", variant.name, lr, ll, rr, refLR, refLL, refRR, nframes);
+
+	delete [] left;
+	delete [] right;
+}
+
+
+struct BenchData {
+	Mixer::compute_stereo_correlation_t	correlation;
+	audio_sample_t*				left;
+	audio_sample_t*				right;
+	nframes_t				nframes;
+	float					sums[3];
+};
+
+static void correlate(BenchData& data)
+{
+	data.correlation(data.left, data.right, data.nframes, &data.sums[0], &data.sums[1], &data.sums[2]);
+}
+
+static void run_bench(Variant* variants, int variantCount)
+{
+	const nframes_t frameCounts[] = {256, 1024, 4096};
+
+	printf("stereo correlation sums, usecs per call\n");
+
+	for (int i=0; i<3; ++i) {
+		BenchData data;
+		data.nframes = frameCounts[i];
+		data.left = new audio_sample_t[data.nframes];
+		data.right = new audio_sample_t[data.nframes];
+		unsigned int seed = 1;
+		t_fill_noise(data.left, data.nframes, seed);
+		t_fill_noise(data.right, data.nframes, seed);
+
+		int repetitions = 4000000 / data.nframes;
+		double generic = 0.0;
+
+		printf("%5u frames:", data.nframes);
+		for (int v=0; v<variantCount; ++v) {
+			data.correlation = variants[v].correlation;
+			double usecs = t_time_per_call(correlate, data, repetitions);
+			if (v == 0) {
+				generic = usecs;
+				printf("  %s %.2f", variants[v].name, usecs);
+			} else {
+				printf("  %s %.2f (%.0f%% less)", variants[v].name, usecs, 100.0 * (generic - usecs) / generic);
+			}
+		}
+		printf("\n");
+
+		delete [] data.left;
+		delete [] data.right;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	Variant variants[MAX_VARIANTS];
+	int variantCount = get_variants(variants);
+
+	if (t_bench_requested(argc, argv)) {
+		run_bench(variants, variantCount);
+		return 0;
+	}
+
+	const nframes_t frameCounts[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 1023, 4096};
+
+	for (int v=0; v<variantCount; ++v) {
+		for (int f=0; f<13; ++f) {
+			for (int offset=0; offset<2; ++offset) {
+				check_variant(variants[v], frameCounts[f], offset);
+			}
+		}
+	}
+
+	printf("correlationtest: %d variants checked, %d failures\n", variantCount, testFailures);
+
+	return testFailures;
+}
+
+//eof
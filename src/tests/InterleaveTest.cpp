@@ -0,0 +1,215 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTestUtils.h"
+#include "Mixer.h"
+#include "fpu.h"
+
+
+/**
+ * Checks every Mixer (de)interleave kernel this cpu can run against a plain
+ * loop, for 1, 2, 8 and 32 channels and the leftover channel paths (3 and 5),
+ * with frame counts that leave a partial vector at the end. The kernels
+ * only move samples, so the results have to be bit exact. Nothing may be
+ * written beyond the requested frames.
+ */
+
+struct Variant {
+	const char*		name;
+	Mixer::interleave_t	interleave;
+	Mixer::deinterleave_t	deinterleave;
+};
+
+static const int MAX_VARIANTS = 3;
+static const int GUARD = 16;
+static const audio_sample_t GUARD_VALUE = 1234.5f;
+
+static void add_variant(Variant* variants, int& count, const char* name, Mixer::interleave_t interleave, Mixer::deinterleave_t deinterleave)
+{
+	variants[count].name = name;
+	variants[count].interleave = interleave;
+	variants[count].deinterleave = deinterleave;
+	count++;
+}
+
+static int get_variants(Variant* variants)
+{
+	int count = 0;
+	add_variant(variants, count, "default", default_interleave, default_deinterleave);
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+	FPU fpu;
+	if (fpu.has_sse()) {
+		add_variant(variants, count, "sse", x86_sse_interleave, x86_sse_deinterleave);
+	}
+	if (fpu.has_avx()) {
+		add_variant(variants, count, "avx", x86_avx_interleave, x86_avx_deinterleave);
+	}
+#endif
+
+	return count;
+}
+
+static bool guard_intact(const audio_sample_t* guard)
+{
+	for (int i=0; i<GUARD; ++i) {
+		if (guard[i] != GUARD_VALUE) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void check_variant(const Variant& variant, int channels, nframes_t nframes)
+{
+	unsigned int seed = channels * 7919 + nframes;
+	audio_sample_t** src = new audio_sample_t*[channels];
+	audio_sample_t** result = new audio_sample_t*[channels];
+	audio_sample_t* reference = new audio_sample_t[channels * nframes];
+	audio_sample_t* interleaved = new audio_sample_t[channels * nframes + GUARD];
+
+	for (int c=0; c<channels; ++c) {
+		src[c] = new audio_sample_t[nframes];
+		result[c] = new audio_sample_t[nframes + GUARD];
+		t_fill_noise(src[c], nframes, seed);
+		for (nframes_t f=0; f<nframes; ++f) {
+			reference[f * channels + c] = src[c][f];
+		}
+		for (nframes_t f=0; f<nframes + GUARD; ++f) {
+			result[c][f] = GUARD_VALUE;
+		}
+	}
+	for (nframes_t i=0; i<channels * nframes + GUARD; ++i) {
+		interleaved[i] = GUARD_VALUE;
+	}
+
+	variant.interleave(interleaved, src, channels, nframes);
+
+	T_CHECK(t_equal_bits(interleaved, reference, channels * nframes * sizeof(audio_sample_t)),
+		"%s interleave differs, %d channels, %u frames", variant.name, channels, nframes);
+	T_CHECK(guard_intact(interleaved + channels * nframes),
+		"%s interleave wrote past the end, %d channels, %u frames", variant.name, channels, nframes);
+
+	variant.deinterleave(result, reference, channels, nframes);
+
+	for (int c=0; c<channels; ++c) {
+		T_CHECK(t_equal_bits(result[c], src[c], nframes * sizeof(audio_sample_t)),
+			"%s deinterleave differs in channel %d, %d channels, %u frames", variant.name, c, channels, nframes);
+		T_CHECK(guard_intact(result[c] + nframes),
+			"%s deinterleave wrote past the end of channel %d, %d channels, %u frames", variant.name, c, channels, nframes);
+	}
+
+	for (int c=0; c<channels; ++c) {
+		delete [] src[c];
+		delete [] result[c];
+	}
+	delete [] src;
+	delete [] result;
+	delete [] reference;
+	delete [] interleaved;
+}
+
+
+struct BenchData {
+	Variant			variant;
+	int			channels;
+	nframes_t		nframes;
+	audio_sample_t**	planar;
+	audio_sample_t*		interleaved;
+};
+
+static void round_trip(BenchData& data)
+{
+	data.variant.interleave(data.interleaved, data.planar, data.channels, data.nframes);
+	data.variant.deinterleave(data.planar, data.interleaved, data.channels, data.nframes);
+}
+
+static void run_bench(Variant* variants, int variantCount)
+{
+	const int channelCounts[] = {1, 2, 8, 32};
+	const nframes_t nframes = 4096;
+
+	printf("(de)interleave round trip of %u frames, usecs per call\n", nframes);
+
+	for (int i=0; i<4; ++i) {
+		BenchData data;
+		data.channels = channelCounts[i];
+		data.nframes = nframes;
+		data.planar = new audio_sample_t*[data.channels];
+		data.interleaved = new audio_sample_t[data.channels * nframes];
+		unsigned int seed = 1;
+		for (int c=0; c<data.channels; ++c) {
+			data.planar[c] = new audio_sample_t[nframes];
+			t_fill_noise(data.planar[c], nframes, seed);
+		}
+
+		int repetitions = qMax(20, 20000 / data.channels);
+		double generic = 0.0;
+
+		printf("%2d channels:", data.channels);
+		for (int v=0; v<variantCount; ++v) {
+			data.variant = variants[v];
+			double usecs = t_time_per_call(round_trip, data, repetitions);
+			if (v == 0) {
+				generic = usecs;
+				printf("  %s %.2f", variants[v].name, usecs);
+			} else {
+				printf("  %s %.2f (%.0f%% less)", variants[v].name, usecs, 100.0 * (generic - usecs) / generic);
+			}
+		}
+		printf("\n");
+
+		for (int c=0; c<data.channels; ++c) {
+			delete [] data.planar[c];
+		}
+		delete [] data.planar;
+		delete [] data.interleaved;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	Variant variants[MAX_VARIANTS];
+	int variantCount = get_variants(variants);
+
+	if (t_bench_requested(argc, argv)) {
+		run_bench(variants, variantCount);
+		return 0;
+	}
+
+	const int channelCounts[] = {1, 2, 3, 5, 8, 32};
+	const nframes_t frameCounts[] = {0, 1, 3, 4, 7, 8, 9, 31, 1023};
+
+	for (int v=0; v<variantCount; ++v) {
+		for (int c=0; c<6; ++c) {
+			for (int f=0; f<9; ++f) {
+				check_variant(variants[v], channelCounts[c], frameCounts[f]);
+			}
+		}
+	}
+
+	printf("interleavetest: %d variants checked, %d failures\n", variantCount, testFailures);
+
+	return testFailures;
+}
+
+//eof
@@ -0,0 +1,216 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTestUtils.h"
+#include "memops.h"
+#include "fpu.h"
+
+
+/**
+ * Checks the SSE2 sample format conversions of memops against the scalar
+ * ones they replace, for 32 bit (24 in 32), 24 and 16 bit output, with
+ * and without dither. The output bytes, the bytes in between the
+ * interleaved samples, the dither state and the random generator state
+ * all have to be identical. Lengths and source offsets are chosen so the
+ * vector loops get unaligned heads and partial tails, the input mixes
+ * noise with values on and beyond the clipping points and on the
+ * rounding edges of each format.
+ */
+
+typedef void (*convert_t) (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+
+struct Conversion {
+	const char*	name;
+	convert_t	generic;
+	convert_t	sse2;
+	int		bytes;
+};
+
+static const Conversion conversions[] = {
+	{"d32u24", sample_move_d32u24_sS, x86_sse2_sample_move_d32u24_sS, 4},
+	{"dither_rect_d32u24", sample_move_dither_rect_d32u24_sS, x86_sse2_sample_move_dither_rect_d32u24_sS, 4},
+	{"dither_tri_d32u24", sample_move_dither_tri_d32u24_sS, x86_sse2_sample_move_dither_tri_d32u24_sS, 4},
+	{"d24", sample_move_d24_sS, x86_sse2_sample_move_d24_sS, 3},
+	{"dither_rect_d24", sample_move_dither_rect_d24_sS, x86_sse2_sample_move_dither_rect_d24_sS, 3},
+	{"dither_tri_d24", sample_move_dither_tri_d24_sS, x86_sse2_sample_move_dither_tri_d24_sS, 3},
+	{"d16", sample_move_d16_sS, x86_sse2_sample_move_d16_sS, 2},
+	{"dither_rect_d16", sample_move_dither_rect_d16_sS, x86_sse2_sample_move_dither_rect_d16_sS, 2},
+	{"dither_tri_d16", sample_move_dither_tri_d16_sS, x86_sse2_sample_move_dither_tri_d16_sS, 2},
+};
+
+static const int CONVERSION_COUNT = sizeof(conversions) / sizeof(conversions[0]);
+static const int MAX_FRAMES = 1027;
+static const int MAX_OFFSET = 3;
+static const char FILL_BYTE = 0x55;
+
+// clipping points and rounding edges of the 16 and 24 bit formats
+static const audio_sample_t edgeValues[] = {
+	0.0f, -0.0f, 1.0f, -1.0f, 0.99999994f, -0.99999994f, 1.0000001f, -1.0000001f,
+	1.5f, -1.5f, 1999.0f, -1999.0f, 1.5e-45f, -1.5e-45f,
+	8388607.5f / 8388608.0f, -8388608.5f / 8388608.0f,
+	32767.5f / 32768.0f, -32768.5f / 32768.0f, 65535.0f / 32768.0f,
+	0.5f / 8388608.0f, -0.5f / 8388608.0f, 0.5f / 32768.0f, -0.5f / 32768.0f
+};
+
+static const int EDGE_COUNT = sizeof(edgeValues) / sizeof(edgeValues[0]);
+
+// noise, with every third sample replaced by one of the edge values
+static void fill_input(audio_sample_t* buf, int nframes, unsigned int& seed)
+{
+	t_fill_noise(buf, nframes, seed);
+	for (int i=0; i<nframes; i += 3) {
+		seed = seed * 1103515245U + 12345U;
+		buf[i] = edgeValues[(seed >> 16) % EDGE_COUNT];
+	}
+}
+
+static void fill_dither_state(dither_state_t* state, unsigned int& seed)
+{
+	memset(state, 0, sizeof(dither_state_t));
+	t_fill_noise(state->e, DITHER_BUF_SIZE, seed);
+	t_fill_noise(&state->rm1, 1, seed);
+	state->idx = seed % DITHER_BUF_SIZE;
+	state->depth = 16;
+}
+
+static void check_conversion(const Conversion& conversion, audio_sample_t* input, int nframes, int channels, unsigned int& seed)
+{
+	unsigned long skip = conversion.bytes * channels;
+	int bytes = nframes * skip + 16;
+	char* expected = new char[bytes];
+	char* result = new char[bytes];
+	memset(expected, FILL_BYTE, bytes);
+	memset(result, FILL_BYTE, bytes);
+
+	dither_state_t expectedState, resultState;
+	fill_dither_state(&expectedState, seed);
+	resultState = expectedState;
+
+	unsigned int ditherSeed = seed;
+
+	memops_set_dither_seed(ditherSeed);
+	conversion.generic(expected, input, nframes, skip, &expectedState);
+	unsigned int expectedSeed = memops_get_dither_seed();
+
+	memops_set_dither_seed(ditherSeed);
+	conversion.sse2(result, input, nframes, skip, &resultState);
+	unsigned int resultSeed = memops_get_dither_seed();
+
+	T_CHECK(t_equal_bits(expected, result, bytes),
+		"%s output differs, %d frames, %d channels", conversion.name, nframes, channels);
+	T_CHECK(t_equal_bits(&expectedState, &resultState, sizeof(dither_state_t)),
+		"%s dither state differs, %d frames, %d channels", conversion.name, nframes, channels);
+	T_CHECK(expectedSeed == resultSeed,
+		"%s used %s random numbers, %d frames, %d channels", conversion.name,
+		expectedSeed == ditherSeed ? "more" : "other", nframes, channels);
+
+	delete [] expected;
+	delete [] result;
+}
+
+
+struct BenchData {
+	convert_t		convert;
+	audio_sample_t*		input;
+	char*			output;
+	unsigned long		nframes;
+	unsigned long		skip;
+	dither_state_t		state;
+};
+
+static void convert(BenchData& data)
+{
+	data.convert(data.output, data.input, data.nframes, data.skip, &data.state);
+}
+
+static void run_bench()
+{
+	const unsigned long nframes = 1024;
+	audio_sample_t* input = new audio_sample_t[nframes];
+	char* output = new char[nframes * 4 * 2];
+	unsigned int seed = 1;
+	t_fill_noise(input, nframes, seed);
+
+	printf("conversion of %lu frames into a stereo interleaved buffer, usecs per call\n", nframes);
+
+	for (int i=0; i<CONVERSION_COUNT; ++i) {
+		BenchData data;
+		data.input = input;
+		data.output = output;
+		data.nframes = nframes;
+		data.skip = conversions[i].bytes * 2;
+		memset(&data.state, 0, sizeof(dither_state_t));
+
+		data.convert = conversions[i].generic;
+		double generic = t_time_per_call(convert, data, 2000);
+		data.convert = conversions[i].sse2;
+		double sse2 = t_time_per_call(convert, data, 2000);
+
+		printf("%-20s default %.2f  sse2 %.2f (%.0f%% less)\n", conversions[i].name,
+		       generic, sse2, 100.0 * (generic - sse2) / generic);
+	}
+
+	delete [] input;
+	delete [] output;
+}
+
+
+int main(int argc, char** argv)
+{
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+	FPU fpu;
+	if (!fpu.has_sse2()) {
+		printf("memopstest: no SSE2 on this cpu, nothing to check\n");
+		return 0;
+	}
+
+	if (t_bench_requested(argc, argv)) {
+		run_bench();
+		return 0;
+	}
+
+	audio_sample_t buffer[MAX_FRAMES + MAX_OFFSET];
+	unsigned int seed = 1;
+	int checks = 0;
+
+	for (int i=0; i<CONVERSION_COUNT; ++i) {
+		for (int channels=1; channels<=3; ++channels) {
+			for (int offset=0; offset<=MAX_OFFSET; ++offset) {
+				for (int nframes=0; nframes<=MAX_FRAMES; nframes += (nframes < 20 ? 1 : 101)) {
+					fill_input(buffer + offset, nframes, seed);
+					check_conversion(conversions[i], buffer + offset, nframes, channels, seed);
+					checks++;
+				}
+			}
+		}
+	}
+
+	printf("memopstest: %d conversions checked, %d failures\n", checks, testFailures);
+#else
+	Q_UNUSED(argc);
+	Q_UNUSED(argv);
+	printf("memopstest: built without SSE optimizations, nothing to check\n");
+#endif
+
+	return testFailures;
+}
+
+//eof
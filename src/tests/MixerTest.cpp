@@ -0,0 +1,328 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTestUtils.h"
+#include "Mixer.h"
+#include "fpu.h"
+
+#include <cmath>
+
+
+/**
+ * Cross checks the SSE, AVX and FMA variants of the Mixer gain, mix, pan
+ * and peak functions against the default ones Traverso::init_sse() would
+ * otherwise select. The SSE and AVX variants do the same operations per
+ * sample and have to be bit exact, the FMA ones round once instead of
+ * twice and are allowed to differ by a couple of float epsilons. Nothing
+ * may be written beyond nframes. Started with --bench each variant is
+ * timed for buffer sizes of 64 up to 8192 frames.
+ */
+
+struct Buffers {
+	audio_sample_t*		dst;
+	audio_sample_t*		dst2;
+	const audio_sample_t*	src;
+	const audio_sample_t*	src2;
+	nframes_t		nframes;
+	float			gain;
+	float			endGain;
+	float			peak;
+};
+
+typedef void (*run_t) (Buffers& buffers);
+
+template<Mixer::compute_peak_t F> static void run_peak(Buffers& b)
+{
+	b.peak = F(b.src, b.nframes, 0.25f);
+}
+
+template<Mixer::apply_gain_to_buffer_t F> static void run_apply_gain(Buffers& b)
+{
+	F(b.dst, b.nframes, b.gain);
+}
+
+template<Mixer::mix_buffers_with_gain_t F> static void run_mix_with_gain(Buffers& b)
+{
+	F(b.dst, b.src, b.nframes, b.gain);
+}
+
+template<Mixer::mix_buffers_no_gain_t F> static void run_mix_no_gain(Buffers& b)
+{
+	F(b.dst, b.src, b.nframes);
+}
+
+template<Mixer::mix_buffers_with_gain_ramp_t F> static void run_mix_with_gain_ramp(Buffers& b)
+{
+	F(b.dst, b.src, b.nframes, b.gain, b.endGain);
+}
+
+template<Mixer::apply_gain_ramp_to_buffer_t F> static void run_apply_gain_ramp(Buffers& b)
+{
+	F(b.dst, b.nframes, b.endGain, b.gain);
+}
+
+template<Mixer::pan_and_mix_stereo_t F> static void run_pan_and_mix(Buffers& b)
+{
+	F(b.dst, b.dst2, b.src, b.src2, b.nframes, b.gain, b.endGain);
+}
+
+struct Variant {
+	const char*	name;
+	run_t		run;
+	bool		exact;
+};
+
+struct Kernel {
+	const char*	name;
+	Variant		variants[4];
+	int		count;
+};
+
+static void add_variant(Kernel& kernel, const char* name, run_t run, bool exact = true)
+{
+	kernel.variants[kernel.count].name = name;
+	kernel.variants[kernel.count].run = run;
+	kernel.variants[kernel.count].exact = exact;
+	kernel.count++;
+}
+
+static const int KERNEL_COUNT = 7;
+
+static void get_kernels(Kernel* kernels)
+{
+	const char* names[KERNEL_COUNT] = {"compute_peak", "apply_gain_to_buffer", "mix_buffers_with_gain",
+		"mix_buffers_no_gain", "mix_buffers_with_gain_ramp", "apply_gain_ramp_to_buffer", "pan_and_mix_stereo"};
+
+	for (int i=0; i<KERNEL_COUNT; ++i) {
+		kernels[i].name = names[i];
+		kernels[i].count = 0;
+	}
+
+	add_variant(kernels[0], "default", run_peak<default_compute_peak>);
+	add_variant(kernels[1], "default", run_apply_gain<default_apply_gain_to_buffer>);
+	add_variant(kernels[2], "default", run_mix_with_gain<default_mix_buffers_with_gain>);
+	add_variant(kernels[3], "default", run_mix_no_gain<default_mix_buffers_no_gain>);
+	add_variant(kernels[4], "default", run_mix_with_gain_ramp<default_mix_buffers_with_gain_ramp>);
+	add_variant(kernels[5], "default", run_apply_gain_ramp<default_apply_gain_ramp_to_buffer>);
+	add_variant(kernels[6], "default", run_pan_and_mix<default_pan_and_mix_stereo>);
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+	FPU fpu;
+
+	if (fpu.has_sse()) {
+		add_variant(kernels[0], "sse", run_peak<x86_sse_compute_peak>);
+		add_variant(kernels[1], "sse", run_apply_gain<x86_sse_apply_gain_to_buffer>);
+		add_variant(kernels[2], "sse", run_mix_with_gain<x86_sse_mix_buffers_with_gain>);
+		add_variant(kernels[3], "sse", run_mix_no_gain<x86_sse_mix_buffers_no_gain>);
+		add_variant(kernels[4], "sse", run_mix_with_gain_ramp<x86_sse_mix_buffers_with_gain_ramp>);
+		add_variant(kernels[5], "sse", run_apply_gain_ramp<x86_sse_apply_gain_ramp_to_buffer>);
+		add_variant(kernels[6], "sse", run_pan_and_mix<x86_sse_pan_and_mix_stereo>);
+	}
+
+	if (fpu.has_avx()) {
+		add_variant(kernels[0], "avx", run_peak<x86_avx_compute_peak>);
+		add_variant(kernels[1], "avx", run_apply_gain<x86_avx_apply_gain_to_buffer>);
+		add_variant(kernels[2], "avx", run_mix_with_gain<x86_avx_mix_buffers_with_gain>);
+		add_variant(kernels[3], "avx", run_mix_no_gain<x86_avx_mix_buffers_no_gain>);
+		add_variant(kernels[4], "avx", run_mix_with_gain_ramp<x86_avx_mix_buffers_with_gain_ramp>);
+		add_variant(kernels[5], "avx", run_apply_gain_ramp<x86_avx_apply_gain_ramp_to_buffer>);
+		add_variant(kernels[6], "avx", run_pan_and_mix<x86_avx_pan_and_mix_stereo>);
+	}
+
+	if (fpu.has_avx2() && fpu.has_fma()) {
+		add_variant(kernels[2], "fma", run_mix_with_gain<x86_fma_mix_buffers_with_gain>, false);
+		add_variant(kernels[6], "fma", run_pan_and_mix<x86_fma_pan_and_mix_stereo>, false);
+	}
+#endif
+}
+
+
+static const int GUARD = 16;
+static const audio_sample_t GUARD_VALUE = 1234.5f;
+
+// a plain array of nframes samples followed by GUARD guard values
+static audio_sample_t* create_buffer(int offset, nframes_t nframes, unsigned int& seed)
+{
+	audio_sample_t* buf = new audio_sample_t[offset + nframes + GUARD];
+	t_fill_noise(buf, offset + nframes, seed);
+	for (int i=0; i<GUARD; ++i) {
+		buf[offset + nframes + i] = GUARD_VALUE;
+	}
+	return buf;
+}
+
+static bool guard_intact(const audio_sample_t* guard)
+{
+	for (int i=0; i<GUARD; ++i) {
+		if (guard[i] != GUARD_VALUE) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// the largest difference, or -1 when the bits differ and \a exact is set
+static float difference(const audio_sample_t* a, const audio_sample_t* b, nframes_t nframes, bool exact)
+{
+	if (exact) {
+		return t_equal_bits(a, b, nframes * sizeof(audio_sample_t)) ? 0.0f : -1.0f;
+	}
+
+	float largest = 0.0f;
+	for (nframes_t i=0; i<nframes; ++i) {
+		largest = qMax(largest, fabsf(a[i] - b[i]));
+	}
+	return largest;
+}
+
+static bool acceptable(float difference)
+{
+	// inputs and outputs stay within [-2, 2], two roundings of those
+	return difference >= 0.0f && difference <= 4 * 2.0f * 1.2e-7f;
+}
+
+static void check_variant(const Kernel& kernel, const Variant& variant, nframes_t nframes, int offset)
+{
+	unsigned int seed = nframes * 13 + offset;
+	audio_sample_t* src = create_buffer(offset, nframes, seed);
+	audio_sample_t* src2 = create_buffer(offset, nframes, seed);
+	audio_sample_t* dst = create_buffer(offset, nframes, seed);
+	audio_sample_t* dst2 = create_buffer(offset, nframes, seed);
+	audio_sample_t* ref = new audio_sample_t[offset + nframes];
+	audio_sample_t* ref2 = new audio_sample_t[offset + nframes];
+	memcpy(ref, dst, (offset + nframes) * sizeof(audio_sample_t));
+	memcpy(ref2, dst2, (offset + nframes) * sizeof(audio_sample_t));
+
+	Buffers reference = {ref + offset, ref2 + offset, src + offset, src2 + offset, nframes, 0.7f, 0.3f, 0.0f};
+	Buffers result = {dst + offset, dst2 + offset, src + offset, src2 + offset, nframes, 0.7f, 0.3f, 0.0f};
+
+	kernel.variants[0].run(reference);
+	variant.run(result);
+
+	float left = difference(result.dst, reference.dst, nframes, variant.exact);
+	float right = difference(result.dst2, reference.dst2, nframes, variant.exact);
+
+	T_CHECK(acceptable(left) && acceptable(right),
+		"%s %s differs from default by %g %g, %u frames, offset %d", kernel.name, variant.name, left, right, nframes, offset);
+	T_CHECK(result.peak == reference.peak,
+		"%s %s peak is %g instead of %g, %u frames, offset %d", kernel.name, variant.name, result.peak, reference.peak, nframes, offset);
+	T_CHECK(guard_intact(result.dst + nframes) && guard_intact(result.dst2 + nframes),
+		"%s %s wrote past the end, %u frames, offset %d", kernel.name, variant.name, nframes, offset);
+
+	delete [] src;
+	delete [] src2;
+	delete [] dst;
+	delete [] dst2;
+	delete [] ref;
+	delete [] ref2;
+}
+
+
+struct BenchData {
+	run_t		run;
+	Buffers		buffers;
+};
+
+static void run_variant(BenchData& data)
+{
+	data.run(data.buffers);
+}
+
+static void run_bench(Kernel* kernels)
+{
+	const nframes_t maxFrames = 8192;
+	unsigned int seed = 1;
+	audio_sample_t* src = create_buffer(0, maxFrames, seed);
+	audio_sample_t* src2 = create_buffer(0, maxFrames, seed);
+	audio_sample_t* dst = create_buffer(0, maxFrames, seed);
+	audio_sample_t* dst2 = create_buffer(0, maxFrames, seed);
+
+	// unity gains, repeatedly applying smaller ones would end in denormals
+	Buffers buffers = {dst, dst2, src, src2, 0, 1.0f, 1.0f, 0.0f};
+	BenchData data;
+
+	printf("usecs per call, reduction against default between brackets\n");
+
+	for (int k=0; k<KERNEL_COUNT; ++k) {
+		printf("%s\n", kernels[k].name);
+
+		for (nframes_t nframes=64; nframes<=maxFrames; nframes *= 2) {
+			buffers.nframes = nframes;
+			int repetitions = qMax(100, int(2000000 / nframes));
+			double generic = 0.0;
+
+			printf("%6u frames:", nframes);
+			for (int v=0; v<kernels[k].count; ++v) {
+				// keep the mixed values from growing without bound
+				for (nframes_t i=0; i<maxFrames; ++i) {
+					dst[i] = dst2[i] = 0.0f;
+				}
+				data.run = kernels[k].variants[v].run;
+				data.buffers = buffers;
+				double usecs = t_time_per_call(run_variant, data, repetitions);
+				if (v == 0) {
+					generic = usecs;
+					printf("  %s %.3f", kernels[k].variants[v].name, usecs);
+				} else {
+					printf("  %s %.3f (%.0f%%)", kernels[k].variants[v].name, usecs, 100.0 * (generic - usecs) / generic);
+				}
+			}
+			printf("\n");
+		}
+	}
+
+	delete [] src;
+	delete [] src2;
+	delete [] dst;
+	delete [] dst2;
+}
+
+
+int main(int argc, char** argv)
+{
+	Kernel kernels[KERNEL_COUNT];
+	get_kernels(kernels);
+
+	if (t_bench_requested(argc, argv)) {
+		run_bench(kernels);
+		return 0;
+	}
+
+	const nframes_t frameCounts[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 64, 1023, 4096};
+	int checks = 0;
+
+	for (int k=0; k<KERNEL_COUNT; ++k) {
+		for (int v=1; v<kernels[k].count; ++v) {
+			for (int f=0; f<16; ++f) {
+				for (int offset=0; offset<4; ++offset) {
+					check_variant(kernels[k], kernels[k].variants[v], frameCounts[f], offset);
+					checks++;
+				}
+			}
+		}
+	}
+
+	printf("mixertest: %d checks, %d failures\n", checks, testFailures);
+
+	return testFailures;
+}
+
+//eof
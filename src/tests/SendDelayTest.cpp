@@ -0,0 +1,230 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTestUtils.h"
+
+#include <QCoreApplication>
+#include <cmath>
+
+#include "AudioBus.h"
+#include "TBusTrack.h"
+#include "TScratchArena.h"
+#include "TSend.h"
+#include "TSession.h"
+
+
+/**
+ * Runs a real TBusTrack with a delayed post send through cycles with audio,
+ * cycles in which its process bus is silent and cycles in which it is muted.
+ * What arrives in the bus the send mixes into has to be the input, delayed
+ * by the send delay, with silence for the silent and muted cycles: the delay
+ * line has to keep running while the track skips its processing, so the
+ * audio still in it comes out in time and isn't played again later.
+ * Started with --bench it reports the cost of a cycle with and without audio.
+ */
+
+static const nframes_t NFRAMES = 256;
+// more than a cycle, and not a multiple of it
+static const nframes_t DELAY = 300;
+
+enum {
+	AUDIO,
+	SILENT,
+	MUTED
+};
+
+// silences shorter and longer than the delay, and muted cycles
+static const int pattern[] = {
+	AUDIO, AUDIO, SILENT, SILENT, SILENT, AUDIO, AUDIO, SILENT,
+	AUDIO, MUTED, MUTED, AUDIO, SILENT, SILENT, SILENT, SILENT
+};
+
+static const int CYCLES = sizeof(pattern) / sizeof(pattern[0]);
+
+struct Setup {
+	TSession*	session;
+	TBusTrack*	track;
+	AudioBus*	receiver;
+	TSend*		send;
+	TScratchArena*	arena;
+};
+
+static void create_setup(Setup& setup)
+{
+	setup.session = new TSession();
+	setup.track = new TBusTrack(setup.session, "source", 2);
+
+	BusConfig config;
+	config.name = "receiver";
+	config.channelcount = 2;
+	config.type = "output";
+	config.isInternalBus = true;
+	setup.receiver = new AudioBus(config);
+
+	setup.send = new TSend(setup.track, setup.receiver);
+	QMetaObject::invokeMethod(setup.track, "private_add_post_send", Q_ARG(TSend*, setup.send));
+	setup.send->set_delay(DELAY);
+
+	setup.arena = new TScratchArena(false);
+	setup.arena->reserve(NFRAMES);
+}
+
+static void delete_setup(Setup& setup)
+{
+	delete setup.arena;
+	delete setup.track;
+	delete setup.send;
+	delete setup.receiver;
+	delete setup.session;
+}
+
+// one cycle the way Sheet::process_tracks() runs it, \a input 0 for a silent cycle
+static void run_cycle(Setup& setup, audio_sample_t** input, bool muted)
+{
+	AudioBus* processBus = setup.track->get_process_bus();
+
+	setup.receiver->silence_buffers(NFRAMES);
+	processBus->silence_buffers(NFRAMES);
+
+	if (input) {
+		for (int c=0; c<2; ++c) {
+			memcpy(processBus->get_buffer(c, NFRAMES), input[c], NFRAMES * sizeof(audio_sample_t));
+		}
+	}
+
+	setup.track->set_muted(muted);
+
+	setup.arena->begin_cycle();
+	setup.track->process(NFRAMES);
+	setup.arena->end_cycle();
+}
+
+static void check_send_delay()
+{
+	Setup setup;
+	create_setup(setup);
+
+	nframes_t total = CYCLES * NFRAMES;
+	audio_sample_t* input[2];
+	audio_sample_t* expected[2];
+	unsigned int seed = 1;
+
+	for (int c=0; c<2; ++c) {
+		input[c] = new audio_sample_t[total];
+		expected[c] = new audio_sample_t[total];
+		t_fill_noise(input[c], total, seed);
+		memset(expected[c], 0, total * sizeof(audio_sample_t));
+	}
+
+	// only the audio cycles reach the send
+	for (int cycle=0; cycle<CYCLES; ++cycle) {
+		if (pattern[cycle] != AUDIO) {
+			continue;
+		}
+		for (int c=0; c<2; ++c) {
+			for (nframes_t i=cycle * NFRAMES; i<(cycle + 1) * NFRAMES && i + DELAY < total; ++i) {
+				expected[c][i + DELAY] = input[c][i];
+			}
+		}
+	}
+
+	for (int cycle=0; cycle<CYCLES; ++cycle) {
+		audio_sample_t* cycleInput[2] = {input[0] + cycle * NFRAMES, input[1] + cycle * NFRAMES};
+
+		// muted cycles get audio too, the send may not pick it up
+		run_cycle(setup, pattern[cycle] == SILENT ? 0 : cycleInput, pattern[cycle] == MUTED);
+
+		for (int c=0; c<2; ++c) {
+			audio_sample_t* output = setup.receiver->get_buffer(c, NFRAMES);
+			audio_sample_t* reference = expected[c] + cycle * NFRAMES;
+			nframes_t wrong = 0;
+			for (nframes_t i=0; i<NFRAMES; ++i) {
+				if (fabsf(output[i] - reference[i]) > 1e-6f) {
+					wrong++;
+				}
+			}
+			T_CHECK(wrong == 0, "%u frames of channel %d differ in cycle %d", wrong, c, cycle);
+		}
+	}
+
+	for (int c=0; c<2; ++c) {
+		delete [] input[c];
+		delete [] expected[c];
+	}
+	delete_setup(setup);
+}
+
+
+struct BenchData {
+	Setup			setup;
+	audio_sample_t**	input;
+};
+
+static void process_cycle(BenchData& data)
+{
+	run_cycle(data.setup, data.input, false);
+}
+
+static void run_bench()
+{
+	BenchData data;
+	create_setup(data.setup);
+
+	audio_sample_t* input[2];
+	unsigned int seed = 1;
+	for (int c=0; c<2; ++c) {
+		input[c] = new audio_sample_t[NFRAMES];
+		t_fill_noise(input[c], NFRAMES, seed);
+	}
+
+	printf("bus track with a post send delayed by %u frames, %u frames, usecs per cycle\n", DELAY, NFRAMES);
+
+	data.input = input;
+	printf("audio:   %.2f\n", t_time_per_call(process_cycle, data, 20000));
+	data.input = 0;
+	printf("silence: %.2f\n", t_time_per_call(process_cycle, data, 20000));
+
+	for (int c=0; c<2; ++c) {
+		delete [] input[c];
+	}
+	delete_setup(data.setup);
+}
+
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	t_init_generic_mixer();
+
+	if (t_bench_requested(argc, argv)) {
+		run_bench();
+		return 0;
+	}
+
+	check_send_delay();
+
+	printf("senddelaytest: %d cycles checked, %d failures\n", CYCLES, testFailures);
+
+	return testFailures;
+}
+
+//eof
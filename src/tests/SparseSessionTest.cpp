@@ -0,0 +1,477 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTestUtils.h"
+
+#include <QCoreApplication>
+
+#include "AudioBus.h"
+#include "Mixer.h"
+#include "TBusTrack.h"
+#include "TScratchArena.h"
+#include "TSend.h"
+#include "TSession.h"
+#include "fpu.h"
+
+
+/**
+ * Runs one Sheet::process_tracks() cycle for a session of 100 stereo audio
+ * tracks with 10 clips each, sending in groups of 25 to 4 bus tracks which
+ * send to the master out. Only some tracks have a clip under the transport.
+ *
+ * The bus tracks and the master out are real TBusTracks with real post
+ * sends, all buffers are real AudioBuses, so their silence rules are the
+ * ones under test. The audio tracks and their clips are modelled on
+ * AudioTrack::process() and AudioClip::process(), a Sheet would need
+ * audio files to play. The reference is the same session processed the
+ * way it was done before silent buffers were tracked, on plain buffers:
+ * every buffer zeroed and faded, every clip rendered into zeroed buffers.
+ * Both have to produce the same master out, bit exact.
+ *
+ * Started with --bench it reports the cycle times of both.
+ */
+
+static const int TRACK_COUNT = 100;
+static const int CLIPS_PER_TRACK = 10;
+static const int BUS_COUNT = 4;
+
+static const float CLIP_GAIN = 0.8f;
+static const float TRACK_GAIN_LEFT = 0.9f * 0.7f;
+static const float TRACK_GAIN_RIGHT = 0.9f * 0.6f;
+static const float BUS_GAIN = 0.95f;
+
+struct Buffers {
+	audio_sample_t*	channels[2];
+};
+
+// the session as it was processed before, on plain buffers
+struct Reference {
+	nframes_t	nframes;
+	Buffers		tracks[TRACK_COUNT];
+	Buffers		buses[BUS_COUNT];
+	Buffers		master;
+	bool		playing[TRACK_COUNT];
+	audio_sample_t*	source[2];
+	audio_sample_t*	scratch[2];
+	audio_sample_t*	output[2];
+};
+
+// the session on real AudioBuses and TBusTracks
+struct Session {
+	nframes_t	nframes;
+	AudioBus*	tracks[TRACK_COUNT];
+	TBusTrack*	buses[BUS_COUNT];
+	TBusTrack*	master;
+	AudioBus*	output;
+	TSend*		sends[BUS_COUNT + 1];
+	bool		playing[TRACK_COUNT];
+	audio_sample_t*	source[2];
+	audio_sample_t*	scratch[2];
+};
+
+static TSession* session = 0;
+static TScratchArena* arena = 0;
+
+
+static bool is_playing(int track, int playingTracks)
+{
+	// spread the playing tracks over the buses
+	return playingTracks && (track % (TRACK_COUNT / playingTracks)) == 0;
+}
+
+static void init_buffers(Buffers& buffers, nframes_t nframes)
+{
+	for (int c=0; c<2; ++c) {
+		buffers.channels[c] = new audio_sample_t[nframes];
+		memset(buffers.channels[c], 0, nframes * sizeof(audio_sample_t));
+	}
+}
+
+static void free_buffers(Buffers& buffers)
+{
+	delete [] buffers.channels[0];
+	delete [] buffers.channels[1];
+}
+
+static void init_source(audio_sample_t** source, audio_sample_t** scratch, nframes_t nframes)
+{
+	unsigned int seed = 1;
+	for (int c=0; c<2; ++c) {
+		source[c] = new audio_sample_t[nframes];
+		scratch[c] = new audio_sample_t[nframes];
+		t_fill_noise(source[c], nframes, seed);
+	}
+}
+
+static void free_source(audio_sample_t** source, audio_sample_t** scratch)
+{
+	for (int c=0; c<2; ++c) {
+		delete [] source[c];
+		delete [] scratch[c];
+	}
+}
+
+static AudioBus* create_bus(const QString& name)
+{
+	BusConfig config;
+	config.name = name;
+	config.channelcount = 2;
+	config.type = "output";
+	config.isInternalBus = true;
+	return new AudioBus(config);
+}
+
+static TBusTrack* create_bus_track(const QString& name)
+{
+	TBusTrack* busTrack = new TBusTrack(session, name, 2);
+	busTrack->set_gain(BUS_GAIN);
+	return busTrack;
+}
+
+static TSend* add_post_send(Track* track, AudioBus* bus)
+{
+	TSend* send = new TSend(track, bus);
+	QMetaObject::invokeMethod(track, "private_add_post_send", Q_ARG(TSend*, send));
+	return send;
+}
+
+static Reference* create_reference(nframes_t nframes, int playingTracks)
+{
+	Reference* ref = new Reference;
+	ref->nframes = nframes;
+
+	for (int t=0; t<TRACK_COUNT; ++t) {
+		init_buffers(ref->tracks[t], nframes);
+		ref->playing[t] = is_playing(t, playingTracks);
+	}
+	for (int b=0; b<BUS_COUNT; ++b) {
+		init_buffers(ref->buses[b], nframes);
+	}
+	init_buffers(ref->master, nframes);
+	init_source(ref->source, ref->scratch, nframes);
+	for (int c=0; c<2; ++c) {
+		ref->output[c] = new audio_sample_t[nframes];
+	}
+
+	return ref;
+}
+
+static void delete_reference(Reference* ref)
+{
+	for (int t=0; t<TRACK_COUNT; ++t) {
+		free_buffers(ref->tracks[t]);
+	}
+	for (int b=0; b<BUS_COUNT; ++b) {
+		free_buffers(ref->buses[b]);
+	}
+	free_buffers(ref->master);
+	free_source(ref->source, ref->scratch);
+	for (int c=0; c<2; ++c) {
+		delete [] ref->output[c];
+	}
+	delete ref;
+}
+
+static Session* create_session(nframes_t nframes, int playingTracks)
+{
+	Session* s = new Session;
+	s->nframes = nframes;
+
+	for (int t=0; t<TRACK_COUNT; ++t) {
+		s->tracks[t] = create_bus("track");
+		s->playing[t] = is_playing(t, playingTracks);
+	}
+
+	s->master = create_bus_track("master");
+	s->output = create_bus("output");
+	s->sends[BUS_COUNT] = add_post_send(s->master, s->output);
+
+	for (int b=0; b<BUS_COUNT; ++b) {
+		s->buses[b] = create_bus_track("bus");
+		s->sends[b] = add_post_send(s->buses[b], s->master->get_process_bus());
+	}
+
+	init_source(s->source, s->scratch, nframes);
+
+	return s;
+}
+
+static void delete_session(Session* s)
+{
+	for (int t=0; t<TRACK_COUNT; ++t) {
+		delete s->tracks[t];
+	}
+	for (int b=0; b<BUS_COUNT; ++b) {
+		delete s->buses[b];
+	}
+	delete s->master;
+	for (int i=0; i<=BUS_COUNT; ++i) {
+		delete s->sends[i];
+	}
+	delete s->output;
+	free_source(s->source, s->scratch);
+	delete s;
+}
+
+
+// AudioClip::process() before, every clip rendered into zeroed buffers
+static int reference_clip(Reference& ref, Buffers& track, bool underTransport)
+{
+	memset(ref.scratch[0], 0, ref.nframes * sizeof(audio_sample_t));
+	memset(ref.scratch[1], 0, ref.nframes * sizeof(audio_sample_t));
+
+	if (!underTransport) {
+		return 0;
+	}
+
+	for (int c=0; c<2; ++c) {
+		memcpy(ref.scratch[c], ref.source[c], ref.nframes * sizeof(audio_sample_t));
+		Mixer::apply_gain_to_buffer(ref.scratch[c], ref.nframes, CLIP_GAIN);
+		Mixer::mix_buffers_no_gain(track.channels[c], ref.scratch[c], ref.nframes);
+	}
+
+	return 1;
+}
+
+// AudioTrack::process() before, without plugins
+static void reference_track(Reference& ref, int index)
+{
+	Buffers& track = ref.tracks[index];
+	int processResult = 0;
+
+	memset(track.channels[0], 0, ref.nframes * sizeof(audio_sample_t));
+	memset(track.channels[1], 0, ref.nframes * sizeof(audio_sample_t));
+
+	for (int clip=0; clip<CLIPS_PER_TRACK; ++clip) {
+		processResult |= reference_clip(ref, track, ref.playing[index] && clip == 0);
+	}
+
+	Mixer::apply_gain_to_buffer(track.channels[0], ref.nframes, TRACK_GAIN_LEFT);
+	Mixer::apply_gain_to_buffer(track.channels[1], ref.nframes, TRACK_GAIN_RIGHT);
+
+	if (processResult) {
+		Buffers& bus = ref.buses[index % BUS_COUNT];
+		for (int c=0; c<2; ++c) {
+			Mixer::compute_peak(track.channels[c], ref.nframes, 0.0f);
+			Mixer::mix_buffers_no_gain(bus.channels[c], track.channels[c], ref.nframes);
+		}
+	}
+}
+
+// TBusTrack::process() before, without plugins
+static void reference_bus_track(Reference& ref, Buffers& bus, audio_sample_t** target)
+{
+	for (int c=0; c<2; ++c) {
+		Mixer::apply_gain_to_buffer(bus.channels[c], ref.nframes, BUS_GAIN);
+		Mixer::compute_peak(bus.channels[c], ref.nframes, 0.0f);
+		Mixer::mix_buffers_no_gain(target[c], bus.channels[c], ref.nframes);
+		memset(bus.channels[c], 0, ref.nframes * sizeof(audio_sample_t));
+	}
+}
+
+static void reference_cycle(Reference& ref)
+{
+	for (int c=0; c<2; ++c) {
+		memset(ref.master.channels[c], 0, ref.nframes * sizeof(audio_sample_t));
+		memset(ref.output[c], 0, ref.nframes * sizeof(audio_sample_t));
+		for (int b=0; b<BUS_COUNT; ++b) {
+			memset(ref.buses[b].channels[c], 0, ref.nframes * sizeof(audio_sample_t));
+		}
+	}
+
+	for (int t=0; t<TRACK_COUNT; ++t) {
+		reference_track(ref, t);
+	}
+
+	for (int b=0; b<BUS_COUNT; ++b) {
+		reference_bus_track(ref, ref.buses[b], ref.master.channels);
+	}
+	reference_bus_track(ref, ref.master, ref.output);
+}
+
+
+// AudioClip::process(), the first clip of a playing track is under the transport
+static int process_clip(Session& s, AudioBus* track, bool underTransport)
+{
+	if (!underTransport) {
+		return 0;
+	}
+
+	memset(s.scratch[0], 0, s.nframes * sizeof(audio_sample_t));
+	memset(s.scratch[1], 0, s.nframes * sizeof(audio_sample_t));
+
+	// ReadSource::rb_read() and the clip fader
+	for (int c=0; c<2; ++c) {
+		memcpy(s.scratch[c], s.source[c], s.nframes * sizeof(audio_sample_t));
+		Mixer::apply_gain_to_buffer(s.scratch[c], s.nframes, CLIP_GAIN);
+		Mixer::mix_buffers_no_gain(track->get_buffer(c, s.nframes), s.scratch[c], s.nframes);
+	}
+
+	return 1;
+}
+
+// AudioTrack::process(), without plugins
+static void process_track(Session& s, int index)
+{
+	AudioBus* track = s.tracks[index];
+	int processResult = 0;
+
+	track->silence_buffers(s.nframes);
+
+	for (int clip=0; clip<CLIPS_PER_TRACK; ++clip) {
+		processResult |= process_clip(s, track, s.playing[index] && clip == 0);
+	}
+
+	if (track->is_silent(s.nframes)) {
+		return;
+	}
+
+	Mixer::apply_gain_to_buffer(track->get_buffer(0, s.nframes), s.nframes, TRACK_GAIN_LEFT);
+	Mixer::apply_gain_to_buffer(track->get_buffer(1, s.nframes), s.nframes, TRACK_GAIN_RIGHT);
+
+	if (processResult) {
+		AudioBus* bus = s.buses[index % BUS_COUNT]->get_process_bus();
+		for (int c=0; c<2; ++c) {
+			Mixer::compute_peak(track->get_buffer(c, s.nframes), s.nframes, 0.0f);
+			Mixer::mix_buffers_no_gain(bus->get_buffer(c, s.nframes), track->get_buffer(c, s.nframes), s.nframes);
+		}
+	}
+}
+
+// Sheet::process_tracks(), the driver silences the output each cycle
+static void process_cycle(Session& s)
+{
+	s.output->silence_buffers(s.nframes);
+	s.master->get_process_bus()->silence_buffers(s.nframes);
+	for (int b=0; b<BUS_COUNT; ++b) {
+		s.buses[b]->get_process_bus()->silence_buffers(s.nframes);
+	}
+
+	arena->begin_cycle();
+
+	for (int t=0; t<TRACK_COUNT; ++t) {
+		process_track(s, t);
+	}
+
+	for (int b=0; b<BUS_COUNT; ++b) {
+		s.buses[b]->process(s.nframes);
+	}
+	s.master->process(s.nframes);
+
+	arena->end_cycle();
+}
+
+
+static void check_session(nframes_t nframes, int playingTracks)
+{
+	Reference* ref = create_reference(nframes, playingTracks);
+	Session* s = create_session(nframes, playingTracks);
+
+	// a couple of cycles, so the skipped silencing of untouched buffers counts
+	for (int cycle=0; cycle<3; ++cycle) {
+		reference_cycle(*ref);
+		process_cycle(*s);
+
+		T_CHECK(t_equal_bits(ref->output[0], s->output->get_buffer(0, nframes), nframes * sizeof(audio_sample_t))
+			&& t_equal_bits(ref->output[1], s->output->get_buffer(1, nframes), nframes * sizeof(audio_sample_t)),
+			"master out differs, %d playing tracks, %u frames, cycle %d", playingTracks, nframes, cycle);
+	}
+
+	delete_reference(ref);
+	delete_session(s);
+}
+
+static void run_bench()
+{
+	const nframes_t frameCounts[] = {256, 1024};
+	const int playingCounts[] = {0, 5, 10, 25, 100};
+
+	printf("%d tracks with %d clips each, usecs per cycle\n", TRACK_COUNT, CLIPS_PER_TRACK);
+
+	for (int f=0; f<2; ++f) {
+		for (int p=0; p<5; ++p) {
+			Reference* ref = create_reference(frameCounts[f], playingCounts[p]);
+			Session* s = create_session(frameCounts[f], playingCounts[p]);
+
+			int repetitions = 200000 / frameCounts[f];
+			double before = t_time_per_call(reference_cycle, *ref, repetitions);
+			double after = t_time_per_call(process_cycle, *s, repetitions);
+
+			printf("%5u frames, %3d playing: every buffer %7.1f  silence aware %7.1f (%.0f%% less)\n",
+			       frameCounts[f], playingCounts[p], before, after, 100.0 * (before - after) / before);
+
+			delete_reference(ref);
+			delete_session(s);
+		}
+	}
+}
+
+
+static void init_mixer()
+{
+	t_init_generic_mixer();
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
+	FPU fpu;
+	if (fpu.has_avx()) {
+		Mixer::compute_peak = x86_avx_compute_peak;
+		Mixer::apply_gain_to_buffer = x86_avx_apply_gain_to_buffer;
+		Mixer::mix_buffers_no_gain = x86_avx_mix_buffers_no_gain;
+		Mixer::pan_and_mix_stereo = x86_avx_pan_and_mix_stereo;
+	} else if (fpu.has_sse()) {
+		Mixer::compute_peak = x86_sse_compute_peak;
+		Mixer::apply_gain_to_buffer = x86_sse_apply_gain_to_buffer;
+		Mixer::mix_buffers_no_gain = x86_sse_mix_buffers_no_gain;
+		Mixer::pan_and_mix_stereo = x86_sse_pan_and_mix_stereo;
+	}
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	init_mixer();
+
+	session = new TSession();
+	arena = new TScratchArena(false);
+	arena->reserve(1024);
+
+	if (t_bench_requested(argc, argv)) {
+		run_bench();
+	} else {
+		const int playingCounts[] = {0, 1, 10, 100};
+
+		for (int p=0; p<4; ++p) {
+			check_session(64, playingCounts[p]);
+			check_session(1024, playingCounts[p]);
+		}
+
+		printf("sparsesessiontest: %d failures\n", testFailures);
+	}
+
+	delete arena;
+	delete session;
+
+	return testFailures;
+}
+
+//eof
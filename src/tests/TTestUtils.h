@@ -0,0 +1,113 @@
+/*
+Copyright (C) 2011 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TTEST_UTILS_H
+#define TTEST_UTILS_H
+
+#include "defines.h"
+#include "Mixer.h"
+
+#include <cstdio>
+#include <cstring>
+
+/**
+ * Minimal helpers shared by the tests in this directory. A test is a plain
+ * executable whose main() returns the number of failed checks, started
+ * with --bench it runs its benchmarks instead.
+ */
+
+static int testFailures = 0;
+
+#define T_CHECK(condition, args...) \
+	if (!(condition)) { \
+		printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+		printf(args); \
+		printf("\n"); \
+		testFailures++; \
+	}
+
+static inline bool t_bench_requested(int argc, char** argv)
+{
+	for (int i=1; i<argc; ++i) {
+		if (strcmp(argv[i], "--bench") == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// reproducible noise in [-1, 1)
+static inline void t_fill_noise(audio_sample_t* buf, nframes_t nframes, unsigned int& seed)
+{
+	for (nframes_t i=0; i<nframes; ++i) {
+		seed = seed * 1103515245U + 12345U;
+		buf[i] = float(int(seed >> 8) - (1 << 23)) / float(1 << 23);
+	}
+}
+
+// bitwise compare, also catches -0.0f vs 0.0f and NaN differences
+static inline bool t_equal_bits(const void* a, const void* b, size_t bytes)
+{
+	return memcmp(a, b, bytes) == 0;
+}
+
+// the generic Mixer functions, tests running real Tracks and buses need them
+// all, Traverso::init_sse() does this for the application
+static inline void t_init_generic_mixer()
+{
+	Mixer::compute_peak = default_compute_peak;
+	Mixer::apply_gain_to_buffer = default_apply_gain_to_buffer;
+	Mixer::mix_buffers_with_gain = default_mix_buffers_with_gain;
+	Mixer::mix_buffers_no_gain = default_mix_buffers_no_gain;
+	Mixer::compute_stereo_correlation = default_compute_stereo_correlation;
+	Mixer::mix_buffers_with_gain_ramp = default_mix_buffers_with_gain_ramp;
+	Mixer::pan_and_mix_stereo = default_pan_and_mix_stereo;
+	Mixer::apply_gain_ramp_to_buffer = default_apply_gain_ramp_to_buffer;
+	Mixer::interleave = default_interleave;
+	Mixer::deinterleave = default_deinterleave;
+}
+
+/**
+ * Times \a repetitions calls of \a function with \a data, repeated 5 times,
+ * @return The fastest of those 5 runs in microseconds per call.
+ */
+template<typename Function, typename Data>
+double t_time_per_call(Function function, Data& data, int repetitions)
+{
+	double best = 0.0;
+
+	for (int run=0; run<5; ++run) {
+		trav_time_t start = get_microseconds();
+		for (int i=0; i<repetitions; ++i) {
+			function(data);
+		}
+		double elapsed = (get_microseconds() - start) / repetitions;
+		if (run == 0 || elapsed < best) {
+			best = elapsed;
+		}
+	}
+
+	return best;
+}
+
+#endif
+
+//eof
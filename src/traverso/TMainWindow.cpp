@@ -346,7 +346,6 @@ TMainWindow::TMainWindow()
 //	setUnifiedTitleAndToolBarOnMac(true);
 
 	m_vuLevelUpdateTimer.start(m_vuLevelUpdateFrequency, this);
-	m_vuLevelPeakholdTimer.start(1000, this);
 }
 
 TMainWindow::~TMainWindow()
@@ -361,6 +360,13 @@ TMainWindow::~TMainWindow()
 	config().set_property("Interface", "fullScreen", isFullScreen());
 	config().set_property("Interface", "pos", pos());
 	config().set_property("Interface", "windowstate", saveState());
+
+	// The meters unregister from m_vuLevels on destruction, so delete
+	// them here instead of leaving it to the QWidget destructor.
+	m_vuLevelUpdateTimer.stop();
+	delete m_busMonitorDW;
+	delete m_correlationMeterDW;
+	delete m_spectralMeterDW;
 }
 
 
@@ -586,9 +592,6 @@ void TMainWindow::timerEvent(QTimerEvent *event)
 	if (event->timerId() == m_vuLevelUpdateTimer.timerId()) {
 		update_vu_levels_peak();
 	}
-	if (event->timerId() == m_vuLevelPeakholdTimer.timerId()) {
-		reset_vu_levels_peak_hold_value();
-	}
 }
 
 void TMainWindow::keyPressEvent( QKeyEvent * e)
@@ -1857,15 +1860,16 @@ void TMainWindow::unregister_vumeter_level(AbstractVUMeterLevel *level)
 
 void TMainWindow::update_vu_levels_peak()
 {
-	if (!m_project) {
-		return;
-	}
-
-
+	// One tick for all meters: each level only repaints itself if
+	// the audio thread published a changed snapshot for it.
 	for(int i=0; i<m_vuLevels.size(); i++) {
 		m_vuLevels.at(i)->update_peak();
 	}
 
+	if (!m_project) {
+		return;
+	}
+
 	QList<Track*> tracks = m_project->get_sheet_tracks();
 	tracks.append(m_project->get_tracks());
 	tracks.append(m_project->get_master_out());
@@ -1876,11 +1880,3 @@ void TMainWindow::update_vu_levels_peak()
 		}
 	}
 }
-
-
-void TMainWindow::reset_vu_levels_peak_hold_value()
-{
-	for(int i=0; i<m_vuLevels.size(); i++) {
-		m_vuLevels.at(i)->reset_peak_hold_value();
-	}
-}
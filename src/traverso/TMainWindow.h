@@ -87,7 +87,6 @@ public:
         virtual ~AbstractVUMeterLevel() {}
 
         virtual void update_peak() = 0;
-        virtual void reset_peak_hold_value() = 0;
 };
 
 class TMainWindow : public QMainWindow
@@ -179,7 +178,6 @@ private:
 
         QList<AbstractVUMeterLevel*> m_vuLevels;
         QBasicTimer                  m_vuLevelUpdateTimer;
-        QBasicTimer                  m_vuLevelPeakholdTimer;
 
 	
 	void create_menus();
@@ -192,7 +190,6 @@ private:
 	QMenu* create_fade_selector_menu(const QString& fadeTypeName);
 
         void update_vu_levels_peak();
-        void reset_vu_levels_peak_hold_value();
 
 
 public slots :
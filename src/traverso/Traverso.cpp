@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "ContextPointer.h"
 #include "Information.h"
 #include "TShortcutManager.h"
+#include "PluginManager.h"
 #include "widgets/SpectralMeterWidget.h"
 #include "widgets/CorrelationMeterWidget.h"
 
@@ -134,6 +135,9 @@ void Traverso::create_interface( )
         TMainWindow* tMainWindow = TMainWindow::instance();
         tMainWindow->show();
 
+	// starts scanning for plugins in the background
+	PluginManager::instance();
+
 	QString projectToLoad = "";
 	
 	foreach(QString string, QCoreApplication::arguments ()) {
@@ -206,6 +210,37 @@ void Traverso::init_sse( )
 		Mixer::mix_buffers_with_gain 	= x86_sse_mix_buffers_with_gain;
 		Mixer::mix_buffers_no_gain 	= x86_sse_mix_buffers_no_gain;
 
+		Mixer::compute_stereo_correlation = x86_sse_compute_stereo_correlation;
+		Mixer::mix_buffers_with_gain_ramp = x86_sse_mix_buffers_with_gain_ramp;
+		Mixer::pan_and_mix_stereo	= x86_sse_pan_and_mix_stereo;
+		Mixer::apply_gain_ramp_to_buffer = x86_sse_apply_gain_ramp_to_buffer;
+		Mixer::interleave		= x86_sse_interleave;
+		Mixer::deinterleave		= x86_sse_deinterleave;
+
+		if (fpu.has_avx()) {
+			printf("Using AVX optimized routines\n");
+
+			// AVX SET
+			Mixer::compute_peak		= x86_avx_compute_peak;
+			Mixer::apply_gain_to_buffer 	= x86_avx_apply_gain_to_buffer;
+			Mixer::mix_buffers_with_gain 	= x86_avx_mix_buffers_with_gain;
+			Mixer::mix_buffers_no_gain 	= x86_avx_mix_buffers_no_gain;
+			Mixer::compute_stereo_correlation = x86_avx_compute_stereo_correlation;
+			Mixer::mix_buffers_with_gain_ramp = x86_avx_mix_buffers_with_gain_ramp;
+			Mixer::pan_and_mix_stereo	= x86_avx_pan_and_mix_stereo;
+			Mixer::apply_gain_ramp_to_buffer = x86_avx_apply_gain_ramp_to_buffer;
+			Mixer::interleave		= x86_avx_interleave;
+			Mixer::deinterleave		= x86_avx_deinterleave;
+		}
+
+		if (fpu.has_avx2() && fpu.has_fma()) {
+			printf("Using AVX2/FMA optimized routines\n");
+
+			// FMA SET
+			Mixer::mix_buffers_with_gain 	= x86_fma_mix_buffers_with_gain;
+			Mixer::pan_and_mix_stereo	= x86_fma_pan_and_mix_stereo;
+		}
+
 		generic_mix_functions = false;
 
 	}
@@ -221,6 +256,12 @@ void Traverso::init_sse( )
 		Mixer::apply_gain_to_buffer   = veclib_apply_gain_to_buffer;
 		Mixer::mix_buffers_with_gain  = veclib_mix_buffers_with_gain;
 		Mixer::mix_buffers_no_gain    = veclib_mix_buffers_no_gain;
+		Mixer::compute_stereo_correlation = veclib_compute_stereo_correlation;
+		Mixer::mix_buffers_with_gain_ramp = default_mix_buffers_with_gain_ramp;
+		Mixer::pan_and_mix_stereo     = default_pan_and_mix_stereo;
+		Mixer::apply_gain_ramp_to_buffer = default_apply_gain_ramp_to_buffer;
+		Mixer::interleave             = default_interleave;
+		Mixer::deinterleave           = default_deinterleave;
 
 		generic_mix_functions = false;
 
@@ -238,6 +279,12 @@ void Traverso::init_sse( )
 		Mixer::apply_gain_to_buffer 	= default_apply_gain_to_buffer;
 		Mixer::mix_buffers_with_gain 	= default_mix_buffers_with_gain;
 		Mixer::mix_buffers_no_gain 	= default_mix_buffers_no_gain;
+		Mixer::compute_stereo_correlation = default_compute_stereo_correlation;
+		Mixer::mix_buffers_with_gain_ramp = default_mix_buffers_with_gain_ramp;
+		Mixer::pan_and_mix_stereo	= default_pan_and_mix_stereo;
+		Mixer::apply_gain_ramp_to_buffer = default_apply_gain_ramp_to_buffer;
+		Mixer::interleave		= default_interleave;
+		Mixer::deinterleave		= default_deinterleave;
 
 		printf("No Hardware specific optimizations in use\n");
 	}
@@ -47,20 +47,25 @@ PluginSelectorDialog::PluginSelectorDialog(QWidget* parent)
 	pluginTreeWidget->header()->resizeSection(0, 250);
 	pluginTreeWidget->header()->setResizeMode(1, QHeaderView::ResizeToContents);
 	pluginTreeWidget->header()->resizeSection(2, 60);
-	
 
-#if defined (LV2_SUPPORT)
-        printf("Getting the list of found lv2 plugins from the PluginManager\n");
-	const LilvPlugins* pluginList = PluginManager::instance()->get_lilv_plugins();
+	populate_plugin_list();
 
-	QMap<QString, PluginInfo> pluginsMap;
+	// the list comes from the cache until the plugin scan is done
+	connect(PluginManager::instance(), SIGNAL(lv2PluginsChanged()), this, SLOT(populate_plugin_list()));
+	connect(pluginTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(plugin_double_clicked()));
+}
 
-	printf("Number of found lv2 plugins: %d\n", lilv_plugins_size(pluginList));
-	
-	LILV_FOREACH(plugins, i, pluginList) {
+PluginSelectorDialog::~PluginSelectorDialog( )
+{}
+
+void PluginSelectorDialog::populate_plugin_list()
+{
+	pluginTreeWidget->clear();
 
-		const LilvPlugin* p = lilv_plugins_get(pluginList, i);
-		PluginInfo pinfo = LV2Plugin::get_plugin_info(p);
+#if defined (LV2_SUPPORT)
+	QMap<QString, PluginInfo> pluginsMap;
+
+	foreach(const PluginInfo& pinfo, PluginManager::instance()->get_lv2_plugin_infos()) {
 		pluginsMap.insertMulti(pinfo.type, pinfo);
 	}
 	
@@ -80,13 +85,8 @@ PluginSelectorDialog::PluginSelectorDialog(QWidget* parent)
 		}
 	}
 #endif
-
-	connect(pluginTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(plugin_double_clicked()));
 }
 
-PluginSelectorDialog::~PluginSelectorDialog( )
-{}
-
 void PluginSelectorDialog::on_cancelButton_clicked( )
 {
 	reject();
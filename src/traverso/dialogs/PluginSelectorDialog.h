@@ -135,6 +135,7 @@ private slots:
 	void on_okButton_clicked();
 	void on_cancelButton_clicked();
 	void plugin_double_clicked();
+	void populate_plugin_list();
 	
 };
 
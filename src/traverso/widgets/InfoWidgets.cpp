@@ -34,6 +34,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "AudioTrack.h"
 #include "Utils.h"
 #include "Mixer.h"
+#include "Information.h"
+#include "Tsar.h"
 
 #include <QPainter>
 #include <QLineEdit>
@@ -43,6 +45,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QLabel>
 #include <QHBoxLayout>
 #include <QAction>
+#include <QFileDialog>
+#include <QDir>
 
 
 #if defined (Q_WS_WIN)
@@ -151,6 +155,14 @@ void SystemResources::update_status( )
 	m_readBufferStatus->set_value(bufReadStatus);
 	m_writeBufferStatus->set_value(bufWriteStatus);
 	m_cpuUsage->set_value(time);
+	
+	// how long the last seek took before playback could start again
+	QString readTip = tr("Read Buffer Status");
+	Sheet* sheet = m_project ? m_project->get_active_sheet() : 0;
+	if (sheet && sheet->get_diskio()->get_last_seek_time() > 0) {
+		readTip += "\n" + tr("Last seek: %1 ms").arg(sheet->get_diskio()->get_last_seek_time() / 1000.0, 0, 'f', 1);
+	}
+	m_readBufferStatus->setToolTip(readTip);
 }
 
 
@@ -177,6 +189,11 @@ DriverInfo::DriverInfo( QWidget * parent )
 	m_driver->setToolTip(tr("Change Audio Device settings"));
 	m_driver->setFlat(true);
 	m_driver->setFocusPolicy(Qt::NoFocus);
+	m_driver->setContextMenuPolicy(Qt::ActionsContextMenu);
+	
+	QAction* saveTelemetry = new QAction(tr("Save Audio Timing Statistics..."), m_driver);
+	m_driver->addAction(saveTelemetry);
+	connect(saveTelemetry, SIGNAL(triggered()), this, SLOT(save_telemetry()));
 	
         QHBoxLayout* lay = new QHBoxLayout(this);
 	lay->addWidget(m_driver);
@@ -188,8 +205,11 @@ DriverInfo::DriverInfo( QWidget * parent )
 	connect(&audiodevice(), SIGNAL(driverParamsChanged()), this, SLOT(update_driver_info()));
 	connect(&audiodevice(), SIGNAL(bufferUnderRun()), this, SLOT(update_xrun_info()));
 	connect(m_driver, SIGNAL(clicked( bool )), this, SLOT(show_driver_config_dialog()));
+	connect(&updateTimer, SIGNAL(timeout()), this, SLOT(update_telemetry()));
 	
 	update_driver_info();
+	
+	updateTimer.start(1000);
 }
 
 void DriverInfo::update_driver_info( )
@@ -225,6 +245,32 @@ void DriverInfo::update_xrun_info( )
 	draw_information();
 }
 
+void DriverInfo::update_telemetry()
+{
+	TAudioTelemetry& telemetry = audiodevice().get_telemetry();
+	telemetry.update();
+	
+	m_driver->setToolTip(tr("Change Audio Device settings") + "\n\n" + telemetry.get_summary_text()
+			+ "\n" + tsar().get_statistics_text());
+}
+
+void DriverInfo::save_telemetry()
+{
+	update_telemetry();
+	
+	QString fileName = QFileDialog::getSaveFileName(0, tr("Save Audio Timing Statistics"),
+			QDir::homePath() + "/traverso-timing.csv",
+			tr("CSV files (*.csv);;JSON files (*.json)"));
+	
+	if (fileName.isEmpty()) {
+		return;
+	}
+	
+	if (audiodevice().get_telemetry().dump(fileName) < 0) {
+		info().critical(tr("Could not write audio timing statistics to %1").arg(fileName));
+	}
+}
+
 QSize DriverInfo::sizeHint() const
 {
 	return QSize(m_driver->width(), SONG_TOOLBAR_HEIGHT);
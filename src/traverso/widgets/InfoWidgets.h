@@ -108,6 +108,8 @@ private:
 private slots:
         void update_driver_info();
         void update_xrun_info();
+	void update_telemetry();
+	void save_telemetry();
 	void show_driver_config_dialog();
 };
 
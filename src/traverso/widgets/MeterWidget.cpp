@@ -103,6 +103,7 @@ MeterView::MeterView(MeterWidget* widget)
         , m_session(0)
 {
         m_project = 0;
+	m_active = false;
 
 	// Nicola: Not sure if we need to initialize here, perhaps a 
 	// call to resize would suffice ?
@@ -110,13 +111,17 @@ MeterView::MeterView(MeterWidget* widget)
 
 	// Connections to core:
 	connect(&pm(), SIGNAL(projectLoaded(Project*)), this, SLOT(set_project(Project*)));
-        connect(&timer, SIGNAL(timeout()), this, SLOT(update_data()));
 	m_delayTimer.setSingleShot(true);
 	connect(&m_delayTimer, SIGNAL(timeout()), this, SLOT(delay_timeout()));
+
+	// Meter data is polled from the shared GUI meter tick in TMainWindow
+	TMainWindow::instance()->register_vumeter_level(this);
 }
 
 MeterView::~MeterView()
 {
+	TMainWindow::instance()->unregister_vumeter_level(this);
+
 	if (m_meter) {
                 delete m_meter;
 	}
@@ -141,7 +146,7 @@ void MeterView::set_project(Project *project)
                 connect(m_project, SIGNAL(transportStopped()), this, SLOT(transport_stopped()));
         } else {
 		m_project = 0;
-		timer.stop();
+		m_active = false;
 	}
 }
 
@@ -157,9 +162,16 @@ void MeterView::show_event()
 //        }
 }
 
+void MeterView::update_peak()
+{
+	if (m_active) {
+		update_data();
+	}
+}
+
 void MeterView::transport_started()
 {
-	timer.start(40);
+	m_active = true;
 	m_delayTimer.stop();
 }
 
@@ -170,7 +182,7 @@ void MeterView::transport_stopped()
 
 void MeterView::delay_timeout()
 {
-	timer.stop();
+	m_active = false;
 }
 
 
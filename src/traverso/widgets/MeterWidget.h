@@ -26,6 +26,7 @@
 
 #include <ViewPort.h>
 #include <ViewItem.h>
+#include "TMainWindow.h"
 
 class MeterView;
 class TSession;
@@ -48,7 +49,7 @@ protected:
 	MeterView* m_item;
 };
 
-class MeterView : public ViewItem
+class MeterView : public ViewItem, public AbstractVUMeterLevel
 {
 	Q_OBJECT
 
@@ -61,12 +62,14 @@ public:
 	void hide_event();
 	void show_event();
 
+	void update_peak();
+
 	
 protected:
 	MeterWidget* 	m_widget;
 	Plugin*		m_meter;
-	QTimer		timer;
 	QTimer		m_delayTimer;
+	bool		m_active;
 	Project*	m_project;
         TSession*	m_session;
 
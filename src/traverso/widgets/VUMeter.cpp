@@ -467,7 +467,6 @@ void VUMeterOverLed::load_theme_data()
 
 static const int OVER_SAMPLES_COUNT = 2;	// sensitivity of the 'over' indicator
 static const int RMS_SAMPLES = 50;		// number of updates to be stored for RMS calculation
-static const int UPDATE_FREQ = 40;		// frame rate of the level meter (update interval in ms)
 static const int PEAK_HOLD_TIME = 1000;		// peak hold time (ms)
 static const int PEAK_HOLD_MODE = 1;		// 0 = no peak hold, 1 = dynamic, 2 = constant
 static const bool SHOW_RMS = false;		// toggle RMS lines on / off
@@ -483,10 +482,11 @@ VUMeterLevel::VUMeterLevel(QWidget* parent, AudioChannel* chan)
 	tailDeltaY = peakHoldValue = rms = -120.0;
 	overCount = rmsIndex = 0;
 	peakHoldFalling = false;
+	peakHoldTime.start();
 	peak = 0.0;
 	
 	// falloff speed, according to IEC 60268-18: 20 dB in 1.7 sec.
-	maxFalloff = 20.0 / (1700.0 / (float)UPDATE_FREQ);
+	maxFalloff = 20.0 / (1700.0 / (float)TMainWindow::instance()->get_vulevel_update_frequency());
 	
 	for (int i = 0; i < RMS_SAMPLES; i++) {
 		peakHistory[i] = 0.0;
@@ -496,20 +496,18 @@ VUMeterLevel::VUMeterLevel(QWidget* parent, AudioChannel* chan)
 	setAutoFillBackground(false);
 
 	connect(&audiodevice(), SIGNAL(stopped()), this, SLOT(stop()));
-	connect(&timer, SIGNAL(timeout()), this, SLOT(update_peak()));
-	connect(&phTimer, SIGNAL(timeout()), this, SLOT(reset_peak_hold_value()));
 	connect(themer(), SIGNAL(themeLoaded()), this, SLOT(load_theme_data()), Qt::QueuedConnection);
 	load_theme_data();
 
-	timer.start(UPDATE_FREQ);
-	
-	if (PEAK_HOLD_MODE == 1) {
-		phTimer.start(PEAK_HOLD_TIME);
-	}
+	// peak updates are driven by the one GUI meter tick in
+	// TMainWindow, shared by all meters.
+	TMainWindow::instance()->register_vumeter_level(this);
 }
 
 VUMeterLevel::~VUMeterLevel()
 {
+	TMainWindow::instance()->unregister_vumeter_level(this);
+
         // FIXME crashes when loading a project!
 //        delete m_monitor;
 }
@@ -544,14 +542,10 @@ void VUMeterLevel::paintEvent( QPaintEvent*  )
 	if (peakHoldValue <= dBVal) {
 		peakHoldFalling = false;
 		peakHoldValue = dBVal;
-		
-		// Comment by Remon: EHH?? The phTimer is still running since it _is_ allready started from the 
-		// constructor, right? We don't stop the timer anywhere...
-		// Reply by Nic: The timer is REstarted here, which is done by QTimer::start(int) as well.
-		//	We want the new peak hold value to be held for 1 sec., so we restart the timer
-		//	as soon as a new phvalue was detected.
+
+		// every new peak is held PEAK_HOLD_TIME, see update_peak()
 		if (PEAK_HOLD_MODE == 1) {
-			phTimer.start(PEAK_HOLD_TIME);
+			peakHoldTime.start();
 		}
 	}
 
@@ -621,6 +615,7 @@ void VUMeterLevel::resize_level_pixmap( )
 
 void VUMeterLevel::update_peak( )
 {
+	float previousPeak = peak;
         peak = m_monitor->get_peak_value();
         m_monitor->set_read();
 
@@ -660,19 +655,26 @@ void VUMeterLevel::update_peak( )
 		overCount = 0;
 	}
 
+	// release the held peak once it's been held long enough
+	if (PEAK_HOLD_MODE == 1 && !peakHoldFalling && peakHoldTime.elapsed() >= PEAK_HOLD_TIME) {
+		peakHoldFalling = true;
+	}
+
+	// only repaint when the level, its falloff or the peak hold line moves
+	float dBVal = qMin(coefficient_to_dB(peak), 6.0f);
+	if (peak == previousPeak && tailDeltaY == dBVal
+	    && !(peakHoldFalling && peakHoldValue >= -120.0)) {
+		return;
+	}
+
 	update();
 }
 
 void VUMeterLevel::stop( )
 {
-	timer.stop();
 	emit activate_over_led(false);
 }
 
-void VUMeterLevel::start( )
-{
-}
-
 void VUMeterLevel::resizeEvent(QResizeEvent *)
 {
 	resize_level_pixmap();
@@ -689,11 +691,6 @@ QSize VUMeterLevel::minimumSizeHint() const
 	return QSize(10, 40);
 }
 
-void VUMeterLevel::reset_peak_hold_value()
-{
-	peakHoldFalling = true;
-}
-
 void VUMeterLevel::load_theme_data()
 {
 	float zeroDB = 1.0 - 100.0/115.0;  // 0 dB position
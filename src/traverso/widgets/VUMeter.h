@@ -26,7 +26,9 @@
 #include <QWidget>
 #include <QString>
 #include <QVector>
-#include <QTimer>
+#include <QTime>
+
+#include "TMainWindow.h"
 
 class AudioBus;
 class AudioChannel;
@@ -160,7 +162,7 @@ private slots:
 };
 
 
-class VUMeterLevel : public QWidget
+class VUMeterLevel : public QWidget, public AbstractVUMeterLevel
 {
 	Q_OBJECT
 	
@@ -170,6 +172,8 @@ public:
 	
 	void reset();
 
+        void update_peak();
+
 protected:
         void paintEvent( QPaintEvent* e);
         void resizeEvent( QResizeEvent * );
@@ -180,14 +184,13 @@ protected:
 private:
         bool 		activeTail;
 	bool		peakHoldFalling;
+	QTime		peakHoldTime;
         AudioChannel*	m_channel;
         VUMonitor*      m_monitor;
         QBrush		levelClearColor,
 			m_colBg;
         QPixmap		levelPixmap;
         QPixmap		clearPixmap;
-        QTimer 		timer,
-			phTimer;
 	QLinearGradient	gradient2D;
 	QColor		m_colOverLed;
 
@@ -207,9 +210,6 @@ private:
 
 private slots:
 	void stop();
-	void start();
-        void update_peak();
-	void reset_peak_hold_value();
 	void load_theme_data();
 
 signals: